@@ -1,23 +1,32 @@
 package org.kgajjar.mobileai
 
+import android.content.Context
 import android.os.Bundle
 import androidx.activity.ComponentActivity
 import androidx.activity.compose.setContent
 import androidx.activity.enableEdgeToEdge
 import androidx.compose.runtime.Composable
 import androidx.compose.ui.tooling.preview.Preview
+import org.kgajjar.mobileai.storage.FileStorage
 
 class MainActivity : ComponentActivity() {
     override fun onCreate(savedInstanceState: Bundle?) {
         enableEdgeToEdge()
         super.onCreate(savedInstanceState)
 
+        val services = appServices(this)
         setContent {
-            App()
+            App(services)
         }
     }
 }
 
+private var processServices: AppServices? = null
+
+/** One [AppServices] per process, so activity recreation never reopens the stores. */
+private fun appServices(context: Context): AppServices =
+    processServices ?: AppServices(FileStorage(context.filesDir.resolve("mobileai"))).also { processServices = it }
+
 @Preview
 @Composable
 fun AppAndroidPreview() {
@@ -4,23 +4,64 @@ import androidx.compose.foundation.layout.*
 import androidx.compose.material3.*
 import androidx.compose.runtime.*
 import androidx.compose.ui.Modifier
+import kotlinx.coroutines.launch
 import org.jetbrains.compose.ui.tooling.preview.Preview
+import org.kgajjar.mobileai.chat.ConversationStore
+import org.kgajjar.mobileai.feed.FeedItem
 import org.kgajjar.mobileai.navigation.NavigationItem
+import org.kgajjar.mobileai.ocr.PhotoTextIndex
+import org.kgajjar.mobileai.personalization.Personalizer
+import org.kgajjar.mobileai.search.ChatHistorySearch
+import org.kgajjar.mobileai.settings.UserSettings
 import org.kgajjar.mobileai.navigation.getAllNavigationItems
 import org.kgajjar.mobileai.screens.HomeScreen
 import org.kgajjar.mobileai.screens.SearchScreen
 import org.kgajjar.mobileai.screens.ProfileScreen
+import org.kgajjar.mobileai.storage.MemoryStorage
 import org.kgajjar.mobileai.theme.DarkColorScheme
+import org.kgajjar.mobileai.trace.Trace
+import org.kgajjar.mobileai.vision.Photo
+import org.kgajjar.mobileai.vision.PhotoIndex
+import org.kgajjar.mobileai.vision.ThumbnailCache
 
 @Composable
 @Preview
-fun App() {
+fun App(services: AppServices = remember { AppServices(MemoryStorage()) }) {
     MaterialTheme(
         colorScheme = DarkColorScheme
     ) {
+        val conversations by produceState<ConversationStore?>(null, services) {
+            value = services.conversations.await()
+        }
+        val history by produceState<ChatHistorySearch?>(null, services) {
+            value = services.history.await()
+        }
+        val settings by produceState<UserSettings?>(null, services) {
+            value = services.settings.await()
+        }
+        val personalizer by produceState<Personalizer?>(null, services) {
+            value = services.personalizer.await()
+        }
+        val feed by produceState(emptyList<FeedItem>(), services) {
+            value = services.feed.await()
+        }
+        val photos by produceState<PhotoIndex?>(null, services) {
+            value = services.photos.await()
+        }
+        val photoText by produceState<PhotoTextIndex?>(null, services) {
+            value = services.photoText.await()
+        }
+        val thumbnails by produceState<ThumbnailCache?>(null, services) {
+            value = services.thumbnails.await()
+        }
+        var openConversation by remember { mutableStateOf<Long?>(null) }
+        var attachment by remember { mutableStateOf<Photo?>(null) }
+        var tracing by remember { mutableStateOf(Trace.enabled) }
         var selectedItem by remember { mutableStateOf<NavigationItem>(NavigationItem.Home) }
         val navigationItems = getAllNavigationItems()
 
+        TraceFrames(tracing)
+
         Scaffold(
             bottomBar = {
                 NavigationBar(
@@ -56,9 +97,47 @@ fun App() {
                     .padding(paddingValues)
             ) {
                 when (selectedItem) {
-                    NavigationItem.Home -> HomeScreen()
-                    NavigationItem.Search -> SearchScreen()
-                    NavigationItem.Profile -> ProfileScreen()
+                    NavigationItem.Home -> HomeScreen(
+                        store = conversations,
+                        personalizer = personalizer,
+                        feed = feed,
+                        voice = services.voice,
+                        speech = services.speech,
+                        thumbnails = thumbnails,
+                        attachment = attachment,
+                        onAttachmentChange = { attachment = it },
+                        openConversation = openConversation,
+                        onOpenConversation = { openConversation = it }
+                    )
+                    NavigationItem.Search -> SearchScreen(
+                        history = history,
+                        personalizer = personalizer,
+                        photos = photos,
+                        photoText = photoText,
+                        thumbnails = thumbnails,
+                        voice = services.voice,
+                        onOpenConversation = {
+                            openConversation = it
+                            selectedItem = NavigationItem.Home
+                        },
+                        onAskAboutPhoto = {
+                            attachment = it
+                            openConversation = null
+                            selectedItem = NavigationItem.Home
+                        }
+                    )
+                    NavigationItem.Profile -> ProfileScreen(
+                        settings = settings,
+                        tracing = tracing,
+                        onTracingChange = {
+                            if (it) Trace.clear()
+                            Trace.enabled = it
+                            tracing = it
+                        },
+                        onSaveTrace = {
+                            services.scope.launch { Trace.save(services.storage, "trace-${epochMillis()}.json") }
+                        }
+                    )
                 }
             }
         }
@@ -0,0 +1,78 @@
+package org.kgajjar.mobileai
+
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Deferred
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.async
+import kotlinx.coroutines.launch
+import org.kgajjar.mobileai.audio.SpeechOutput
+import org.kgajjar.mobileai.audio.VoiceInput
+import org.kgajjar.mobileai.chat.ConversationStore
+import org.kgajjar.mobileai.feed.FeedItem
+import org.kgajjar.mobileai.feed.HomeFeed
+import org.kgajjar.mobileai.metrics.Metrics
+import org.kgajjar.mobileai.ocr.OcrPipeline
+import org.kgajjar.mobileai.ocr.PhotoTextIndex
+import org.kgajjar.mobileai.personalization.Personalizer
+import org.kgajjar.mobileai.search.ChatHistorySearch
+import org.kgajjar.mobileai.settings.UserSettings
+import org.kgajjar.mobileai.storage.KeyValueStore
+import org.kgajjar.mobileai.storage.Storage
+import org.kgajjar.mobileai.vision.ImageEncoder
+import org.kgajjar.mobileai.vision.PhotoIndex
+import org.kgajjar.mobileai.vision.PhotoLibrary
+import org.kgajjar.mobileai.vision.ThumbnailCache
+
+/**
+ * Process-wide services, created once per app process by the platform entry point. Stores are
+ * opened in the background so that recovering them never delays the first frame. [voice] and
+ * [speech] are supplied by platforms that ship the speech models and can record or play audio.
+ */
+class AppServices(
+    val storage: Storage,
+    val voice: VoiceInput? = null,
+    val speech: SpeechOutput? = null,
+    private val photoLibrary: PhotoLibrary? = null,
+    private val imageEncoder: ImageEncoder? = null,
+    private val ocr: OcrPipeline? = null,
+) {
+    val scope = CoroutineScope(SupervisorJob() + Dispatchers.Default)
+
+    val conversations: Deferred<ConversationStore> = scope.async { ConversationStore.open(storage, scope) }
+
+    val history: Deferred<ChatHistorySearch> = scope.async {
+        ChatHistorySearch.open(conversations.await(), storage, scope)
+    }
+
+    val settings: Deferred<UserSettings> = scope.async { UserSettings(KeyValueStore.open(storage, scope)) }
+
+    val personalizer: Deferred<Personalizer> = scope.async { Personalizer.open(storage, scope, settings.await()) }
+
+    /** Computed once per launch, in parallel with the first frames. */
+    val feed: Deferred<List<FeedItem>> = scope.async {
+        HomeFeed(conversations.await(), personalizer.await(), storage).compute()
+    }
+
+    /** Searchable as soon as it opens; new photos are indexed in the background after that. */
+    val photos: Deferred<PhotoIndex?> = scope.async {
+        if (photoLibrary == null || imageEncoder == null) return@async null
+        PhotoIndex.open(storage, imageEncoder).also { index ->
+            scope.launch { index.sync(photoLibrary) }
+        }
+    }
+
+    /** Text read from photos, screenshots above all; reading runs at low priority after open. */
+    val photoText: Deferred<PhotoTextIndex?> = scope.async {
+        if (photoLibrary == null || ocr == null) return@async null
+        PhotoTextIndex.open(storage, ocr).also { index ->
+            scope.launch { index.sync(photoLibrary) }
+        }
+    }
+
+    val thumbnails: Deferred<ThumbnailCache?> = scope.async {
+        photoLibrary?.let { ThumbnailCache(it, file = storage.open("thumbnails.pack")) }?.also { cache ->
+            Metrics.registry.gauge("memory.thumbnails_bytes") { cache.memoryUsedBytes }
+        }
+    }
+}
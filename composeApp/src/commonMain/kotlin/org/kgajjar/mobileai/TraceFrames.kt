@@ -0,0 +1,24 @@
+package org.kgajjar.mobileai
+
+import androidx.compose.runtime.Composable
+import androidx.compose.runtime.LaunchedEffect
+import androidx.compose.runtime.withFrameNanos
+import org.kgajjar.mobileai.trace.Trace
+
+/**
+ * While [enabled], records each frame as a "frame" slice on the UI thread's track, so slow
+ * frames line up with the work that caused them. Waiting on every frame keeps the app drawing,
+ * which is why this runs only while a trace is being recorded.
+ */
+@Composable
+internal fun TraceFrames(enabled: Boolean) {
+    LaunchedEffect(enabled) {
+        if (!enabled) return@LaunchedEffect
+        var last = withFrameNanos { Trace.now() }
+        while (true) {
+            val now = withFrameNanos { Trace.now() }
+            Trace.record("frame", "ui", last, now - last)
+            last = now
+        }
+    }
+}
@@ -1,23 +1,184 @@
 package org.kgajjar.mobileai.screens
 
+import androidx.compose.foundation.clickable
 import androidx.compose.foundation.layout.*
+import androidx.compose.foundation.lazy.LazyColumn
+import androidx.compose.foundation.lazy.items
+import androidx.compose.material3.HorizontalDivider
 import androidx.compose.material3.Icon
+import androidx.compose.material3.IconButton
 import androidx.compose.material3.MaterialTheme
+import androidx.compose.material3.OutlinedTextField
 import androidx.compose.material3.Text
-import androidx.compose.runtime.Composable
+import androidx.compose.runtime.*
 import androidx.compose.ui.Alignment
 import androidx.compose.ui.Modifier
 import androidx.compose.ui.text.style.TextAlign
+import androidx.compose.ui.text.style.TextOverflow
 import androidx.compose.ui.unit.dp
 import androidx.compose.material.icons.Icons
+import androidx.compose.material.icons.automirrored.filled.ArrowBack
+import androidx.compose.material.icons.automirrored.filled.Send
+import androidx.compose.material.icons.filled.Close
 import androidx.compose.material.icons.filled.Home
+import androidx.compose.material.icons.filled.PlayArrow
+import androidx.compose.material.icons.filled.ThumbUp
+import kotlinx.coroutines.Job
+import kotlinx.coroutines.launch
+import org.kgajjar.mobileai.audio.SpeechOutput
+import org.kgajjar.mobileai.audio.VoiceInput
+import org.kgajjar.mobileai.chat.ConversationChange
+import org.kgajjar.mobileai.chat.ConversationStore
+import org.kgajjar.mobileai.chat.ConversationSummary
+import org.kgajjar.mobileai.chat.Message
+import org.kgajjar.mobileai.chat.MessageImages
+import org.kgajjar.mobileai.chat.Role
+import org.kgajjar.mobileai.feed.FeedItem
+import org.kgajjar.mobileai.json.JsonString
+import org.kgajjar.mobileai.json.StructuredReply
+import org.kgajjar.mobileai.personalization.Interaction
+import org.kgajjar.mobileai.personalization.Personalizer
+import org.kgajjar.mobileai.trace.Trace
+import org.kgajjar.mobileai.vision.Photo
+import org.kgajjar.mobileai.vision.ThumbnailCache
 
 @Composable
-fun HomeScreen() {
+fun HomeScreen(
+    store: ConversationStore?,
+    personalizer: Personalizer?,
+    feed: List<FeedItem>,
+    voice: VoiceInput?,
+    speech: SpeechOutput?,
+    thumbnails: ThumbnailCache?,
+    attachment: Photo?,
+    onAttachmentChange: (Photo?) -> Unit,
+    openConversation: Long?,
+    onOpenConversation: (Long?) -> Unit
+) {
+    val scope = rememberCoroutineScope()
+    var recent by remember { mutableStateOf(emptyList<ConversationSummary>()) }
+    val messages = remember { mutableStateListOf<Message>() }
+    var draft by remember { mutableStateOf("") }
+    var revision by remember { mutableStateOf(0) }
+    var speaking by remember { mutableStateOf<Message?>(null) }
+    var speakJob by remember { mutableStateOf<Job?>(null) }
+
+    LaunchedEffect(store, openConversation, revision) {
+        if (store == null) return@LaunchedEffect
+        // Kept in recency order; personalization shapes the feed above it instead.
+        recent = store.recent()
+        val loaded = openConversation?.let { store.messages(it) } ?: emptyList()
+        messages.clear()
+        messages.addAll(loaded)
+    }
+
+    // Follow replies while they stream into the open conversation: streamed text is appended to
+    // the one message it belongs to, and only new messages (or ones that missed a change) are read
+    // from the store.
+    LaunchedEffect(store, openConversation) {
+        if (store == null || openConversation == null) return@LaunchedEffect
+        store.changes.collect { change ->
+            if (change !is ConversationChange.MessageChanged || change.conversationId != openConversation) return@collect
+            val current = messages.getOrNull(change.messageIndex)
+            val known = current?.text?.length ?: 0
+            when {
+                // Already part of the text loaded with the conversation.
+                current != null && known >= change.length -> Unit
+                current != null && change.follows(known) ->
+                    messages[change.messageIndex] = current.copy(text = current.text + change.appended)
+                // New message, or a change was missed or came out of order: read it again.
+                else -> {
+                    val message = store.message(change.conversationId, change.messageIndex) ?: return@collect
+                    if (message.index < messages.size) {
+                        messages[message.index] = message
+                    } else if (message.index == messages.size) {
+                        messages += message
+                    }
+                }
+            }
+        }
+    }
+
     Column(
         modifier = Modifier
             .fillMaxSize()
-            .padding(16.dp),
+            .padding(16.dp)
+    ) {
+        Box(modifier = Modifier.weight(1f).fillMaxWidth()) {
+            when {
+                openConversation != null -> ConversationView(
+                    messages = messages,
+                    thumbnails = thumbnails,
+                    speaking = speaking,
+                    onSpeak = if (speech == null || store == null) null else { message ->
+                        speakJob?.cancel()
+                        if (speaking?.index == message.index) {
+                            speaking = null
+                        } else {
+                            speaking = message
+                            speakJob = scope.launch {
+                                try {
+                                    // Follows the reply while it is still streaming in.
+                                    speech.speak(store.follow(message.conversationId, message.index))
+                                } finally {
+                                    if (speaking == message) speaking = null
+                                }
+                            }
+                        }
+                    },
+                    onBack = {
+                        speakJob?.cancel()
+                        onOpenConversation(null)
+                    },
+                    onLike = { message ->
+                        scope.launch { personalizer?.record(Interaction.LikedAnswer, message.text) }
+                    }
+                )
+                recent.isEmpty() && feed.isEmpty() -> Welcome()
+                else -> FeedAndRecent(
+                    feed = feed,
+                    conversations = recent,
+                    onOpen = { conversation ->
+                        onOpenConversation(conversation.id)
+                        scope.launch { personalizer?.record(Interaction.OpenedResult, conversation.title) }
+                    },
+                    onPrompt = { draft = it }
+                )
+            }
+        }
+        Spacer(modifier = Modifier.height(8.dp))
+        Composer(
+            draft = draft,
+            attachment = attachment,
+            thumbnails = thumbnails,
+            enabled = store != null,
+            voice = voice,
+            onDraftChange = { draft = it },
+            onRemoveAttachment = { onAttachmentChange(null) },
+            onSend = {
+                val text = draft.trim()
+                if (text.isNotEmpty() && store != null) {
+                    Trace.instant("send", "ui")
+                    val photos = listOfNotNull(attachment)
+                    draft = ""
+                    onAttachmentChange(null)
+                    scope.launch {
+                        val id = openConversation ?: store.create(text.take(48))
+                        store.appendMessage(id, Role.User, MessageImages.attach(photos, text))
+                        onOpenConversation(id)
+                        revision++
+                        personalizer?.record(Interaction.SentMessage, text)
+                    }
+                }
+            }
+        )
+    }
+}
+
+@Composable
+private fun Welcome() {
+    Column(
+        modifier = Modifier.fillMaxSize(),
         horizontalAlignment = Alignment.CenterHorizontally,
         verticalArrangement = Arrangement.Center
     ) {
@@ -43,3 +204,246 @@ fun HomeScreen() {
         )
     }
 }
+
+@Composable
+private fun FeedAndRecent(
+    feed: List<FeedItem>,
+    conversations: List<ConversationSummary>,
+    onOpen: (ConversationSummary) -> Unit,
+    onPrompt: (String) -> Unit
+) {
+    LazyColumn(modifier = Modifier.fillMaxSize()) {
+        if (feed.isNotEmpty()) {
+            item { SectionTitle("For you") }
+            items(feed, key = { it.key() }) { item ->
+                when (item) {
+                    is FeedItem.Conversation -> ConversationRow(item.summary, onOpen)
+                    is FeedItem.Prompt -> Text(
+                        text = item.text,
+                        style = MaterialTheme.typography.bodyLarge,
+                        color = MaterialTheme.colorScheme.primary,
+                        modifier = Modifier
+                            .fillMaxWidth()
+                            .clickable { onPrompt(item.text) }
+                            .padding(vertical = 12.dp)
+                    )
+                }
+                HorizontalDivider()
+            }
+        }
+        if (conversations.isNotEmpty()) {
+            item { SectionTitle("Recent chats") }
+            items(conversations, key = { it.id }) { conversation ->
+                ConversationRow(conversation, onOpen)
+                HorizontalDivider()
+            }
+        }
+    }
+}
+
+private fun FeedItem.key(): String = when (this) {
+    is FeedItem.Conversation -> "feed:${summary.id}"
+    is FeedItem.Prompt -> "prompt:$text"
+}
+
+@Composable
+private fun SectionTitle(text: String) {
+    Text(
+        text = text,
+        style = MaterialTheme.typography.titleMedium,
+        color = MaterialTheme.colorScheme.onBackground,
+        modifier = Modifier.padding(vertical = 8.dp)
+    )
+}
+
+@Composable
+private fun ConversationRow(
+    conversation: ConversationSummary,
+    onOpen: (ConversationSummary) -> Unit
+) {
+    Column(
+        modifier = Modifier
+            .fillMaxWidth()
+            .clickable { onOpen(conversation) }
+            .padding(vertical = 12.dp)
+    ) {
+        Text(
+            text = conversation.title,
+            style = MaterialTheme.typography.bodyLarge,
+            color = MaterialTheme.colorScheme.onBackground,
+            maxLines = 1,
+            overflow = TextOverflow.Ellipsis
+        )
+        Text(
+            text = "${conversation.messageCount} messages",
+            style = MaterialTheme.typography.bodySmall,
+            color = MaterialTheme.colorScheme.onBackground.copy(alpha = 0.7f)
+        )
+    }
+}
+
+@Composable
+private fun ConversationView(
+    messages: List<Message>,
+    thumbnails: ThumbnailCache?,
+    speaking: Message?,
+    onSpeak: ((Message) -> Unit)?,
+    onBack: () -> Unit,
+    onLike: (Message) -> Unit
+) {
+    Column(modifier = Modifier.fillMaxSize()) {
+        IconButton(onClick = onBack) {
+            Icon(
+                imageVector = Icons.AutoMirrored.Filled.ArrowBack,
+                contentDescription = "Back",
+                tint = MaterialTheme.colorScheme.onBackground
+            )
+        }
+        LazyColumn(
+            modifier = Modifier.fillMaxSize(),
+            verticalArrangement = Arrangement.spacedBy(12.dp)
+        ) {
+            items(messages, key = { it.index }) { message ->
+                Row(verticalAlignment = Alignment.CenterVertically) {
+                    if (message.role == Role.Assistant && StructuredReply.looksStructured(message.text)) {
+                        StructuredMessage(message, modifier = Modifier.weight(1f))
+                    } else {
+                        MessageText(message, thumbnails, modifier = Modifier.weight(1f))
+                    }
+                    if (message.role == Role.Assistant && onSpeak != null) {
+                        val active = speaking != null && speaking.conversationId == message.conversationId && speaking.index == message.index
+                        IconButton(onClick = { onSpeak(message) }) {
+                            Icon(
+                                imageVector = if (active) Icons.Default.Close else Icons.Default.PlayArrow,
+                                contentDescription = if (active) "Stop reading" else "Read aloud",
+                                tint = MaterialTheme.colorScheme.primary
+                            )
+                        }
+                    }
+                    if (message.role == Role.Assistant) {
+                        var liked by remember(message.conversationId, message.index) { mutableStateOf(false) }
+                        IconButton(
+                            onClick = {
+                                liked = true
+                                onLike(message)
+                            },
+                            enabled = !liked
+                        ) {
+                            Icon(
+                                imageVector = Icons.Default.ThumbUp,
+                                contentDescription = "Like",
+                                tint = MaterialTheme.colorScheme.primary
+                            )
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+@Composable
+private fun MessageText(message: Message, thumbnails: ThumbnailCache?, modifier: Modifier = Modifier) {
+    val (photos, text) = remember(message.text) { MessageImages.split(message.text) }
+    Column(modifier = modifier, verticalArrangement = Arrangement.spacedBy(6.dp)) {
+        if (photos.isNotEmpty()) {
+            Row(horizontalArrangement = Arrangement.spacedBy(6.dp)) {
+                for (photo in photos) PhotoThumbnail(photo, thumbnails, size = 120.dp)
+            }
+        }
+        Text(
+            text = text,
+            style = MaterialTheme.typography.bodyLarge,
+            color = if (message.role == Role.User) {
+                MaterialTheme.colorScheme.primary
+            } else {
+                MaterialTheme.colorScheme.onBackground
+            }
+        )
+    }
+}
+
+/**
+ * A JSON reply shown field by field as it streams. The reply object lives as long as the
+ * message, and each recomposition only parses the text appended since the last one.
+ */
+@Composable
+private fun StructuredMessage(message: Message, modifier: Modifier = Modifier) {
+    val reply = remember(message.conversationId, message.index) { StructuredReply() }
+    val progress = remember(message.text) {
+        reply.update(message.text)
+        reply.fields.size to reply.streaming
+    }
+    if (reply.isBroken) {
+        MessageText(message, thumbnails = null, modifier = modifier)
+        return
+    }
+    val (fieldCount, streaming) = progress
+    Column(modifier = modifier, verticalArrangement = Arrangement.spacedBy(6.dp)) {
+        for (i in 0 until fieldCount) StructuredField(reply.fields[i])
+        streaming?.let { StructuredField(it) }
+    }
+}
+
+@Composable
+private fun StructuredField(field: StructuredReply.Field) {
+    Column {
+        if (field.path.isNotEmpty()) {
+            Text(
+                text = field.path,
+                style = MaterialTheme.typography.labelSmall,
+                color = MaterialTheme.colorScheme.onBackground.copy(alpha = 0.7f)
+            )
+        }
+        Text(
+            text = (field.value as? JsonString)?.value ?: field.value.toJson(),
+            style = MaterialTheme.typography.bodyLarge,
+            color = MaterialTheme.colorScheme.onBackground
+        )
+    }
+}
+
+@Composable
+private fun Composer(
+    draft: String,
+    attachment: Photo?,
+    thumbnails: ThumbnailCache?,
+    enabled: Boolean,
+    voice: VoiceInput?,
+    onDraftChange: (String) -> Unit,
+    onRemoveAttachment: () -> Unit,
+    onSend: () -> Unit
+) {
+    Column {
+        if (attachment != null) {
+            Row(verticalAlignment = Alignment.CenterVertically) {
+                PhotoThumbnail(attachment, thumbnails, size = 64.dp)
+                IconButton(onClick = onRemoveAttachment) {
+                    Icon(
+                        imageVector = Icons.Default.Close,
+                        contentDescription = "Remove photo",
+                        tint = MaterialTheme.colorScheme.onBackground
+                    )
+                }
+            }
+            Spacer(modifier = Modifier.height(4.dp))
+        }
+        Row(verticalAlignment = Alignment.CenterVertically) {
+            OutlinedTextField(
+                value = draft,
+                onValueChange = onDraftChange,
+                enabled = enabled,
+                placeholder = { Text(if (attachment != null) "Ask about this photo" else "Ask anything") },
+                modifier = Modifier.weight(1f)
+            )
+            VoiceInputButton(voice = voice, text = draft, enabled = enabled, onTextChange = onDraftChange)
+            IconButton(onClick = onSend, enabled = enabled && draft.isNotBlank()) {
+                Icon(
+                    imageVector = Icons.AutoMirrored.Filled.Send,
+                    contentDescription = "Send",
+                    tint = MaterialTheme.colorScheme.primary
+                )
+            }
+        }
+    }
+}
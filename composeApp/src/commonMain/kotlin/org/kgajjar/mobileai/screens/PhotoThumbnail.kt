@@ -0,0 +1,50 @@
+package org.kgajjar.mobileai.screens
+
+import androidx.compose.foundation.Image
+import androidx.compose.foundation.background
+import androidx.compose.foundation.layout.Box
+import androidx.compose.foundation.layout.size
+import androidx.compose.material3.MaterialTheme
+import androidx.compose.runtime.Composable
+import androidx.compose.runtime.getValue
+import androidx.compose.runtime.produceState
+import androidx.compose.ui.Modifier
+import androidx.compose.ui.graphics.ImageBitmap
+import androidx.compose.ui.layout.ContentScale
+import androidx.compose.ui.unit.Dp
+import androidx.compose.ui.unit.dp
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.withContext
+import org.jetbrains.compose.resources.decodeToImageBitmap
+import org.kgajjar.mobileai.vision.Bmp
+import org.kgajjar.mobileai.vision.Photo
+import org.kgajjar.mobileai.vision.ThumbnailCache
+
+/** A square, center-cropped thumbnail of [photo]; a placeholder until it is loaded. */
+@Composable
+internal fun PhotoThumbnail(
+    photo: Photo,
+    thumbnails: ThumbnailCache?,
+    modifier: Modifier = Modifier,
+    size: Dp = 96.dp
+) {
+    val bitmap by produceState<ImageBitmap?>(null, photo.uri, photo.modifiedAt, thumbnails) {
+        value = withContext(Dispatchers.Default) {
+            thumbnails?.get(photo)?.let { Bmp.encode(it).decodeToImageBitmap() }
+        }
+    }
+    val sized = modifier
+        .size(size)
+        .background(MaterialTheme.colorScheme.surfaceVariant)
+    val image = bitmap
+    if (image == null) {
+        Box(modifier = sized)
+    } else {
+        Image(
+            bitmap = image,
+            contentDescription = photo.uri.substringAfterLast('/'),
+            contentScale = ContentScale.Crop,
+            modifier = sized
+        )
+    }
+}
@@ -1,26 +1,69 @@
 package org.kgajjar.mobileai.screens
 
 import androidx.compose.foundation.layout.*
+import androidx.compose.foundation.rememberScrollState
+import androidx.compose.foundation.verticalScroll
 import androidx.compose.material3.Icon
 import androidx.compose.material3.MaterialTheme
+import androidx.compose.material3.OutlinedTextField
+import androidx.compose.material3.Switch
 import androidx.compose.material3.Text
-import androidx.compose.runtime.Composable
+import androidx.compose.material3.TextButton
+import androidx.compose.runtime.*
 import androidx.compose.ui.Alignment
 import androidx.compose.ui.Modifier
 import androidx.compose.ui.text.style.TextAlign
 import androidx.compose.ui.unit.dp
 import androidx.compose.material.icons.Icons
 import androidx.compose.material.icons.filled.Person
+import kotlinx.coroutines.FlowPreview
+import kotlinx.coroutines.NonCancellable
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.flow.debounce
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.withContext
+import org.kgajjar.mobileai.metrics.Metrics
+import org.kgajjar.mobileai.settings.UserSettings
+import kotlin.math.roundToLong
+import kotlin.time.Duration.Companion.milliseconds
 
+private val NAME_SAVE_DELAY = 500.milliseconds
+
+@OptIn(FlowPreview::class)
 @Composable
-fun ProfileScreen() {
+fun ProfileScreen(
+    settings: UserSettings?,
+    tracing: Boolean,
+    onTracingChange: (Boolean) -> Unit,
+    onSaveTrace: () -> Unit
+) {
+    val scope = rememberCoroutineScope()
+    // Settings reads are in-place lookups, so they can seed state directly during composition.
+    var displayName by remember(settings) { mutableStateOf(settings?.displayName ?: "") }
+    var personalized by remember(settings) { mutableStateOf(settings?.personalizedSuggestions ?: true) }
+
+    // Typing only updates state; the name is saved once it stops changing, and on leaving the screen.
+    LaunchedEffect(settings) {
+        val store = settings ?: return@LaunchedEffect
+        try {
+            snapshotFlow { displayName }
+                .debounce(NAME_SAVE_DELAY)
+                .collect { if (it.trim() != store.displayName) store.setDisplayName(it) }
+        } finally {
+            withContext(NonCancellable) {
+                if (displayName.trim() != store.displayName) store.setDisplayName(displayName)
+            }
+        }
+    }
+
     Column(
         modifier = Modifier
             .fillMaxSize()
+            .verticalScroll(rememberScrollState())
             .padding(16.dp),
-        horizontalAlignment = Alignment.CenterHorizontally,
-        verticalArrangement = Arrangement.Center
+        horizontalAlignment = Alignment.CenterHorizontally
     ) {
+        Spacer(modifier = Modifier.height(32.dp))
         Icon(
             imageVector = Icons.Default.Person,
             contentDescription = "Profile",
@@ -29,7 +72,7 @@ fun ProfileScreen() {
         )
         Spacer(modifier = Modifier.height(16.dp))
         Text(
-            text = "Profile Screen",
+            text = displayName.ifBlank { "Profile" },
             style = MaterialTheme.typography.headlineMedium,
             textAlign = TextAlign.Center,
             color = MaterialTheme.colorScheme.onBackground
@@ -41,5 +84,98 @@ fun ProfileScreen() {
             textAlign = TextAlign.Center,
             color = MaterialTheme.colorScheme.onBackground.copy(alpha = 0.7f)
         )
+        Spacer(modifier = Modifier.height(24.dp))
+        OutlinedTextField(
+            value = displayName,
+            onValueChange = { displayName = it },
+            modifier = Modifier.fillMaxWidth(),
+            enabled = settings != null,
+            singleLine = true,
+            label = { Text("Display name") }
+        )
+        Spacer(modifier = Modifier.height(16.dp))
+        Row(
+            modifier = Modifier.fillMaxWidth(),
+            verticalAlignment = Alignment.CenterVertically
+        ) {
+            Text(
+                text = "Personalized suggestions",
+                style = MaterialTheme.typography.bodyLarge,
+                color = MaterialTheme.colorScheme.onBackground,
+                modifier = Modifier.weight(1f)
+            )
+            Switch(
+                checked = personalized,
+                enabled = settings != null,
+                onCheckedChange = { value ->
+                    personalized = value
+                    scope.launch { settings?.setPersonalizedSuggestions(value) }
+                }
+            )
+        }
+        Spacer(modifier = Modifier.height(24.dp))
+        Text(
+            text = "Diagnostics",
+            style = MaterialTheme.typography.titleSmall,
+            color = MaterialTheme.colorScheme.primary,
+            modifier = Modifier.fillMaxWidth()
+        )
+        Row(
+            modifier = Modifier.fillMaxWidth(),
+            verticalAlignment = Alignment.CenterVertically
+        ) {
+            Text(
+                text = "Record trace",
+                style = MaterialTheme.typography.bodyLarge,
+                color = MaterialTheme.colorScheme.onBackground,
+                modifier = Modifier.weight(1f)
+            )
+            TextButton(onClick = onSaveTrace, enabled = tracing) {
+                Text("Save")
+            }
+            Switch(checked = tracing, onCheckedChange = onTracingChange)
+        }
+        Spacer(modifier = Modifier.height(8.dp))
+        MetricsList()
     }
 }
+
+/** Live metrics, refreshed every second: latency percentiles, counts with their rates, and gauges. */
+@Composable
+private fun MetricsList() {
+    var snapshot by remember { mutableStateOf(Metrics.registry.snapshot()) }
+    var previous by remember { mutableStateOf(snapshot) }
+    LaunchedEffect(Unit) {
+        while (true) {
+            delay(1000)
+            previous = snapshot
+            snapshot = Metrics.registry.snapshot()
+        }
+    }
+    for ((name, h) in snapshot.histograms) {
+        if (h.count > 0) MetricRow(name, "p50 ${millis(h.p50)} · p99 ${millis(h.p99)} · ${h.count}")
+    }
+    for ((name, total) in snapshot.counters) {
+        MetricRow(name, "$total · ${(snapshot.rate(name, previous) * 10).roundToLong() / 10.0}/s")
+    }
+    for ((name, value) in snapshot.gauges) MetricRow(name, "${value shr 10} KiB")
+}
+
+@Composable
+private fun MetricRow(name: String, value: String) {
+    Row(modifier = Modifier.fillMaxWidth().padding(vertical = 2.dp)) {
+        Text(
+            text = name,
+            style = MaterialTheme.typography.bodySmall,
+            color = MaterialTheme.colorScheme.onBackground.copy(alpha = 0.7f),
+            modifier = Modifier.weight(1f)
+        )
+        Text(
+            text = value,
+            style = MaterialTheme.typography.bodySmall,
+            color = MaterialTheme.colorScheme.onBackground
+        )
+    }
+}
+
+private fun millis(micros: Long): String = "${micros / 1000}.${(micros % 1000) / 100} ms"
@@ -1,23 +1,202 @@
 package org.kgajjar.mobileai.screens
 
+import androidx.compose.foundation.clickable
 import androidx.compose.foundation.layout.*
+import androidx.compose.foundation.lazy.LazyColumn
+import androidx.compose.foundation.lazy.LazyRow
+import androidx.compose.foundation.lazy.items
+import androidx.compose.material3.HorizontalDivider
 import androidx.compose.material3.Icon
 import androidx.compose.material3.MaterialTheme
+import androidx.compose.material3.OutlinedTextField
 import androidx.compose.material3.Text
-import androidx.compose.runtime.Composable
+import androidx.compose.runtime.*
 import androidx.compose.ui.Alignment
 import androidx.compose.ui.Modifier
 import androidx.compose.ui.text.style.TextAlign
+import androidx.compose.ui.text.style.TextOverflow
 import androidx.compose.ui.unit.dp
 import androidx.compose.material.icons.Icons
 import androidx.compose.material.icons.filled.Search
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.launch
+import org.kgajjar.mobileai.audio.VoiceInput
+import org.kgajjar.mobileai.ocr.PhotoTextHit
+import org.kgajjar.mobileai.ocr.PhotoTextIndex
+import org.kgajjar.mobileai.personalization.Interaction
+import org.kgajjar.mobileai.personalization.Personalizer
+import org.kgajjar.mobileai.search.ChatHistorySearch
+import org.kgajjar.mobileai.search.ChatSearchHit
+import org.kgajjar.mobileai.vision.Photo
+import org.kgajjar.mobileai.vision.PhotoHit
+import org.kgajjar.mobileai.vision.PhotoIndex
+import org.kgajjar.mobileai.vision.ThumbnailCache
 
 @Composable
-fun SearchScreen() {
+fun SearchScreen(
+    history: ChatHistorySearch?,
+    personalizer: Personalizer?,
+    photos: PhotoIndex?,
+    photoText: PhotoTextIndex?,
+    thumbnails: ThumbnailCache?,
+    voice: VoiceInput?,
+    onOpenConversation: (Long) -> Unit,
+    onAskAboutPhoto: (Photo) -> Unit
+) {
+    val scope = rememberCoroutineScope()
+    var query by remember { mutableStateOf("") }
+    var hits by remember { mutableStateOf(emptyList<ChatSearchHit>()) }
+    var photoHits by remember { mutableStateOf(emptyList<PhotoHit>()) }
+    var textHits by remember { mutableStateOf(emptyList<PhotoTextHit>()) }
+
+    LaunchedEffect(history, query) {
+        if (history == null || query.isBlank()) {
+            hits = emptyList()
+            return@LaunchedEffect
+        }
+        delay(150) // let typing settle
+        val found = history.search(query)
+        hits = personalizer?.rerank(found, relevance = { it.score }, text = { it.snippet }) ?: found
+    }
+
+    LaunchedEffect(photos, query) {
+        if (photos == null || query.isBlank()) {
+            photoHits = emptyList()
+            return@LaunchedEffect
+        }
+        delay(300) // a text-encoder pass costs more than a keyword lookup
+        photoHits = photos.search(query, limit = 12)
+    }
+
+    LaunchedEffect(photoText, query) {
+        if (photoText == null || query.isBlank()) {
+            textHits = emptyList()
+            return@LaunchedEffect
+        }
+        delay(150)
+        textHits = photoText.search(query, limit = 8)
+    }
+
+    val searchable = history != null || photos != null || photoText != null
+
     Column(
         modifier = Modifier
             .fillMaxSize()
-            .padding(16.dp),
+            .padding(16.dp)
+    ) {
+        Row(verticalAlignment = Alignment.CenterVertically) {
+            OutlinedTextField(
+                value = query,
+                onValueChange = { query = it },
+                modifier = Modifier.weight(1f),
+                enabled = searchable,
+                singleLine = true,
+                leadingIcon = { Icon(Icons.Default.Search, contentDescription = null) },
+                placeholder = { Text(if (photos != null || photoText != null) "Search chats and photos" else "Search past chats") }
+            )
+            VoiceInputButton(
+                voice = voice,
+                text = query,
+                enabled = searchable,
+                onTextChange = { query = it }
+            )
+        }
+        Spacer(modifier = Modifier.height(8.dp))
+        if (hits.isEmpty() && photoHits.isEmpty() && textHits.isEmpty()) {
+            EmptyResults(searching = query.isNotBlank())
+        } else {
+            LazyColumn(modifier = Modifier.fillMaxSize()) {
+                if (photoHits.isNotEmpty()) {
+                    item(key = "photos") {
+                        Text(
+                            text = "Photos",
+                            style = MaterialTheme.typography.titleSmall,
+                            color = MaterialTheme.colorScheme.primary,
+                            modifier = Modifier.padding(vertical = 8.dp)
+                        )
+                    }
+                    item(key = "photo-row") {
+                        LazyRow(
+                            horizontalArrangement = Arrangement.spacedBy(8.dp),
+                            modifier = Modifier.padding(bottom = 12.dp)
+                        ) {
+                            items(photoHits, key = { it.uri }) { hit ->
+                                PhotoThumbnail(
+                                    photo = hit.photo,
+                                    thumbnails = thumbnails,
+                                    modifier = Modifier.clickable { onAskAboutPhoto(hit.photo) }
+                                )
+                            }
+                        }
+                    }
+                    item(key = "photos-end") { HorizontalDivider() }
+                }
+                if (textHits.isNotEmpty()) {
+                    item(key = "photo-text") {
+                        Text(
+                            text = "Text in photos",
+                            style = MaterialTheme.typography.titleSmall,
+                            color = MaterialTheme.colorScheme.primary,
+                            modifier = Modifier.padding(vertical = 8.dp)
+                        )
+                    }
+                    items(textHits, key = { "text:${it.uri}" }) { hit ->
+                        Row(
+                            verticalAlignment = Alignment.CenterVertically,
+                            modifier = Modifier
+                                .fillMaxWidth()
+                                .clickable { onAskAboutPhoto(hit.photo) }
+                                .padding(vertical = 8.dp)
+                        ) {
+                            PhotoThumbnail(photo = hit.photo, thumbnails = thumbnails, size = 56.dp)
+                            Spacer(modifier = Modifier.width(12.dp))
+                            Text(
+                                text = hit.snippet,
+                                style = MaterialTheme.typography.bodyMedium,
+                                color = MaterialTheme.colorScheme.onBackground.copy(alpha = 0.7f),
+                                maxLines = 3,
+                                overflow = TextOverflow.Ellipsis
+                            )
+                        }
+                    }
+                    item(key = "photo-text-end") { HorizontalDivider() }
+                }
+                items(hits, key = { "${it.conversationId}:${it.messageIndex}" }) { hit ->
+                    Column(
+                        modifier = Modifier
+                            .fillMaxWidth()
+                            .clickable {
+                                scope.launch { personalizer?.record(Interaction.OpenedResult, hit.snippet) }
+                                onOpenConversation(hit.conversationId)
+                            }
+                            .padding(vertical = 12.dp)
+                    ) {
+                        Text(
+                            text = hit.title,
+                            style = MaterialTheme.typography.titleMedium,
+                            color = MaterialTheme.colorScheme.onBackground,
+                            maxLines = 1,
+                            overflow = TextOverflow.Ellipsis
+                        )
+                        Text(
+                            text = hit.snippet,
+                            style = MaterialTheme.typography.bodyMedium,
+                            color = MaterialTheme.colorScheme.onBackground.copy(alpha = 0.7f),
+                            maxLines = 3,
+                            overflow = TextOverflow.Ellipsis
+                        )
+                    }
+                    HorizontalDivider()
+                }
+            }
+        }
+    }
+}
+
+@Composable
+private fun EmptyResults(searching: Boolean) {
+    Column(
+        modifier = Modifier.fillMaxSize(),
         horizontalAlignment = Alignment.CenterHorizontally,
         verticalArrangement = Arrangement.Center
     ) {
@@ -29,14 +208,14 @@ fun SearchScreen() {
         )
         Spacer(modifier = Modifier.height(16.dp))
         Text(
-            text = "Search Screen",
+            text = if (searching) "No matches" else "Search your chats",
             style = MaterialTheme.typography.headlineMedium,
             textAlign = TextAlign.Center,
             color = MaterialTheme.colorScheme.onBackground
         )
         Spacer(modifier = Modifier.height(8.dp))
         Text(
-            text = "Find what you're looking for",
+            text = if (searching) "Try a different word" else "Find anything you've talked about",
             style = MaterialTheme.typography.bodyLarge,
             textAlign = TextAlign.Center,
             color = MaterialTheme.colorScheme.onBackground.copy(alpha = 0.7f)
@@ -0,0 +1,52 @@
+package org.kgajjar.mobileai.screens
+
+import androidx.compose.material3.Text
+import androidx.compose.material3.TextButton
+import androidx.compose.runtime.*
+import org.kgajjar.mobileai.audio.AudioSource
+import org.kgajjar.mobileai.audio.VoiceInput
+
+/**
+ * Dictates into a text field: words appear in [text] while the user is still speaking, and the
+ * second tap stops recording. Shows nothing when the platform has no [voice] input.
+ */
+@Composable
+internal fun VoiceInputButton(
+    voice: VoiceInput?,
+    text: String,
+    enabled: Boolean,
+    onTextChange: (String) -> Unit
+) {
+    if (voice == null) return
+    var recording by remember { mutableStateOf<AudioSource?>(null) }
+    var before by remember { mutableStateOf("") }
+    val currentOnTextChange by rememberUpdatedState(onTextChange)
+
+    LaunchedEffect(recording) {
+        val source = recording ?: return@LaunchedEffect
+        try {
+            voice.transcribe(source).collect { transcript ->
+                val spoken = transcript.text
+                currentOnTextChange(if (before.isBlank() || spoken.isEmpty()) before + spoken else "${before.trimEnd()} $spoken")
+            }
+        } finally {
+            source.close()
+            recording = null
+        }
+    }
+
+    TextButton(
+        onClick = {
+            val source = recording
+            if (source != null) {
+                source.close()
+            } else {
+                before = text
+                recording = voice.start()
+            }
+        },
+        enabled = enabled || recording != null
+    ) {
+        Text(if (recording != null) "Done" else "Speak")
+    }
+}
@@ -1,13 +1,18 @@
 package org.kgajjar.mobileai
 
+import androidx.compose.runtime.remember
 import androidx.compose.ui.window.Window
 import androidx.compose.ui.window.application
+import org.kgajjar.mobileai.storage.FileStorage
+import java.io.File
 
 fun main() = application {
+    val services = remember { AppServices(FileStorage(File(System.getProperty("user.home"), ".mobileai"))) }
+
     Window(
         onCloseRequest = ::exitApplication,
         title = "MobileAI",
     ) {
-        App()
+        App(services)
     }
 }
\ No newline at end of file
@@ -0,0 +1,24 @@
+package org.kgajjar.mobileai.vision
+
+import android.graphics.Bitmap
+import android.graphics.BitmapFactory
+
+/** [ImageDecoder] over BitmapFactory, whose JPEG path applies power-of-two sample sizes as DCT scaling. */
+class BitmapImageDecoder : ImageDecoder {
+    override fun decode(bytes: ByteArray, minSide: Int): RgbImage? {
+        val options = BitmapFactory.Options().apply { inJustDecodeBounds = true }
+        BitmapFactory.decodeByteArray(bytes, 0, bytes.size, options)
+        if (options.outWidth <= 0 || options.outHeight <= 0) return null
+        options.inJustDecodeBounds = false
+        options.inSampleSize = reductionFor(options.outWidth, options.outHeight, minSide)
+        options.inPreferredConfig = Bitmap.Config.ARGB_8888
+        val bitmap = BitmapFactory.decodeByteArray(bytes, 0, bytes.size, options) ?: return null
+        try {
+            val pixels = IntArray(bitmap.width * bitmap.height)
+            bitmap.getPixels(pixels, 0, bitmap.width, 0, 0, bitmap.width, bitmap.height)
+            return RgbImage(bitmap.width, bitmap.height, pixels)
+        } finally {
+            bitmap.recycle()
+        }
+    }
+}
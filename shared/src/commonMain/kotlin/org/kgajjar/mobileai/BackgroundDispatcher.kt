@@ -0,0 +1,10 @@
+package org.kgajjar.mobileai
+
+import kotlinx.coroutines.CoroutineDispatcher
+
+/**
+ * A dispatcher running one task at a time on a thread of its own at the platform's lowest
+ * priority, for work such as indexing that should only use otherwise idle time. Each call makes
+ * a new thread, so callers keep the dispatcher for the lifetime of the process.
+ */
+internal expect fun backgroundDispatcher(name: String): CoroutineDispatcher
@@ -0,0 +1,7 @@
+package org.kgajjar.mobileai
+
+import kotlin.time.Clock
+import kotlin.time.ExperimentalTime
+
+@OptIn(ExperimentalTime::class)
+fun epochMillis(): Long = Clock.System.now().toEpochMilliseconds()
@@ -0,0 +1,21 @@
+package org.kgajjar.mobileai.audio
+
+/** A recognized word and the frame, relative to the decoded window, where it ends. */
+class AsrWord(val text: String, val endFrame: Int)
+
+/** An encoder-decoder speech recognizer over log-mel features. */
+interface AsrModel {
+    /** Input the features must be computed at; the transcriber resamples to it. */
+    val sampleRate: Int
+
+    val melBins: Int
+
+    /** Longest window the encoder accepts, in frames. */
+    val maxFrames: Int
+
+    /**
+     * Transcribes [frameCount] frames of row-major [features] ([melBins] per frame). [prompt] is
+     * the text already committed before the window, for the decoder to continue from.
+     */
+    suspend fun transcribe(features: FloatArray, frameCount: Int, prompt: String): List<AsrWord>
+}
@@ -0,0 +1,38 @@
+package org.kgajjar.mobileai.audio
+
+import org.kgajjar.mobileai.storage.ByteBuilder
+import org.kgajjar.mobileai.storage.Storage
+
+/** Where synthesized audio goes: the platform's audio output, or a file. */
+interface AudioSink {
+    /** Plays or stores samples, suspending while the output is busy. */
+    suspend fun write(samples: FloatArray, offset: Int = 0, count: Int = samples.size - offset)
+
+    /** Finishes the stream once everything written has been played or stored. */
+    suspend fun close()
+}
+
+/**
+ * Writes 16-bit mono WAV to [name] in [storage]. The file appears, complete, when the sink is
+ * closed.
+ */
+class WavSink(private val storage: Storage, private val name: String, private val sampleRate: Int) : AudioSink {
+    private val data = ByteBuilder(sampleRate)
+
+    override suspend fun write(samples: FloatArray, offset: Int, count: Int) {
+        Wav.putPcm16(data, samples, offset, count)
+    }
+
+    override suspend fun close() {
+        val pcm = data.toByteArray()
+        val header = Wav.header(sampleRate, pcm.size)
+        val tmpName = "$name.tmp"
+        storage.delete(tmpName)
+        val file = storage.open(tmpName)
+        file.append(header)
+        file.append(pcm)
+        file.sync()
+        file.close()
+        storage.rename(tmpName, name)
+    }
+}
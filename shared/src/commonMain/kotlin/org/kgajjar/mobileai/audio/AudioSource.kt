@@ -0,0 +1,35 @@
+package org.kgajjar.mobileai.audio
+
+/** A mono audio stream, such as the microphone or a decoded file. */
+interface AudioSource {
+    val sampleRate: Int
+
+    /**
+     * Reads up to `buffer.size` samples in [-1, 1], suspending until some are available.
+     * Returns -1 once the source is exhausted or [close]d.
+     */
+    suspend fun read(buffer: FloatArray): Int
+
+    /** Stops the stream; a pending or later [read] returns -1. Safe to call more than once. */
+    fun close()
+}
+
+/** Plays back decoded audio, e.g. a WAV file in tests or on desktop. */
+class PcmAudioSource(private val audio: PcmAudio) : AudioSource {
+    override val sampleRate: Int get() = audio.sampleRate
+
+    private var position = 0
+    private var closed = false
+
+    override suspend fun read(buffer: FloatArray): Int {
+        if (closed || position == audio.samples.size) return -1
+        val n = minOf(buffer.size, audio.samples.size - position)
+        audio.samples.copyInto(buffer, 0, position, position + n)
+        position += n
+        return n
+    }
+
+    override fun close() {
+        closed = true
+    }
+}
@@ -0,0 +1,94 @@
+package org.kgajjar.mobileai.audio
+
+import kotlin.math.PI
+import kotlin.math.cos
+import kotlin.math.sin
+
+/**
+ * Power spectrum of real frames of a fixed power-of-two [size].
+ *
+ * A real frame of n samples is packed into a complex one of n/2 (even samples real, odd
+ * imaginary), transformed with an iterative radix-2 FFT, and split back into the n/2 + 1 bins of
+ * the real transform, which halves the work of a complex FFT over zero imaginary parts. Twiddles
+ * and the bit-reversal permutation are computed once. Not thread-safe: the scratch arrays are
+ * reused across calls.
+ */
+class Fft(val size: Int) {
+    init {
+        require(size >= 4 && (size and (size - 1)) == 0) { "FFT size must be a power of two >= 4" }
+    }
+
+    val bins: Int = size / 2 + 1
+
+    private val half = size / 2
+    private val re = FloatArray(half)
+    private val im = FloatArray(half)
+    private val reversed = IntArray(half).also { table ->
+        val bits = half.countTrailingZeroBits()
+        for (i in 0 until half) table[i] = i.reverseBits(bits)
+    }
+
+    // exp(-2πik / half) for the complex transform, exp(-2πik / size) for the split.
+    private val twiddleRe = FloatArray(half / 2) { cos(2 * PI * it / half).toFloat() }
+    private val twiddleIm = FloatArray(half / 2) { -sin(2 * PI * it / half).toFloat() }
+    private val splitRe = FloatArray(half + 1) { cos(2 * PI * it / size).toFloat() }
+    private val splitIm = FloatArray(half + 1) { -sin(2 * PI * it / size).toFloat() }
+
+    /** Writes `|X[k]|²` for k in 0..size/2 into [power]. */
+    fun powerSpectrum(frame: FloatArray, power: FloatArray) {
+        require(frame.size >= size && power.size >= bins) { "frame or output too small" }
+        for (i in 0 until half) {
+            val j = reversed[i]
+            re[j] = frame[2 * i]
+            im[j] = frame[2 * i + 1]
+        }
+        transform()
+        for (k in 0..half) {
+            val a = k % half
+            val b = (half - k) % half
+            // Even and odd halves of the real spectrum from Z[k] and conj(Z[half - k]).
+            val evenRe = 0.5f * (re[a] + re[b])
+            val evenIm = 0.5f * (im[a] - im[b])
+            val oddRe = 0.5f * (im[a] + im[b])
+            val oddIm = -0.5f * (re[a] - re[b])
+            val xRe = evenRe + splitRe[k] * oddRe - splitIm[k] * oddIm
+            val xIm = evenIm + splitRe[k] * oddIm + splitIm[k] * oddRe
+            power[k] = xRe * xRe + xIm * xIm
+        }
+    }
+
+    private fun transform() {
+        var length = 2
+        while (length <= half) {
+            val span = length / 2
+            val stride = half / length
+            var start = 0
+            while (start < half) {
+                for (j in 0 until span) {
+                    val wr = twiddleRe[j * stride]
+                    val wi = twiddleIm[j * stride]
+                    val p = start + j
+                    val q = p + span
+                    val tr = wr * re[q] - wi * im[q]
+                    val ti = wr * im[q] + wi * re[q]
+                    re[q] = re[p] - tr
+                    im[q] = im[p] - ti
+                    re[p] += tr
+                    im[p] += ti
+                }
+                start += length
+            }
+            length *= 2
+        }
+    }
+
+    private fun Int.reverseBits(bits: Int): Int {
+        var x = this
+        var r = 0
+        repeat(bits) {
+            r = (r shl 1) or (x and 1)
+            x = x ushr 1
+        }
+        return r
+    }
+}
@@ -0,0 +1,117 @@
+package org.kgajjar.mobileai.audio
+
+import kotlin.math.PI
+import kotlin.math.cos
+import kotlin.math.ln
+import kotlin.math.log10
+import kotlin.math.max
+import kotlin.math.pow
+
+/**
+ * Streaming log-mel features for speech models: Hann-windowed frames of [windowSize] samples
+ * every [hop] samples, their power spectrum, a triangular mel filterbank and a natural log.
+ *
+ * Defaults match the usual 16 kHz ASR setup (25 ms windows, 10 ms hop, 80 bins up to 8 kHz).
+ * The filterbank is stored sparsely, as the first bin and weights of each triangle, because a
+ * dense bins × mels product is almost all zeros. Not thread-safe.
+ */
+class LogMelFrontend(
+    val sampleRate: Int = 16_000,
+    val windowSize: Int = 400,
+    val hop: Int = 160,
+    val melBins: Int = 80,
+    fftSize: Int = 512,
+    minHz: Float = 0f,
+    maxHz: Float = sampleRate / 2f,
+) {
+    init {
+        require(windowSize in 1..fftSize && hop in 1..windowSize) { "bad frame geometry" }
+    }
+
+    private val fft = Fft(fftSize)
+    private val window = FloatArray(windowSize) { (0.5 - 0.5 * cos(2 * PI * it / windowSize)).toFloat() }
+    private val frame = FloatArray(fftSize)
+    private val power = FloatArray(fft.bins)
+    private val features = FloatArray(melBins)
+
+    private val filterStart = IntArray(melBins)
+    private val filterWeights: Array<FloatArray>
+
+    init {
+        val minMel = mel(minHz)
+        val maxMel = mel(maxHz)
+        val edges = FloatArray(melBins + 2) { hz(minMel + (maxMel - minMel) * it / (melBins + 1)) }
+        val binHz = sampleRate.toFloat() / fftSize
+        filterWeights = Array(melBins) { m ->
+            val lower = edges[m]
+            val center = edges[m + 1]
+            val upper = edges[m + 2]
+            val first = (lower / binHz).toInt() + 1
+            val last = minOf((upper / binHz).toInt(), fft.bins - 1)
+            filterStart[m] = first
+            FloatArray(maxOf(0, last - first + 1)) {
+                val f = (first + it) * binHz
+                max(0f, if (f <= center) (f - lower) / (center - lower) else (upper - f) / (upper - center))
+            }
+        }
+    }
+
+    // Samples of the frame being assembled; the first windowSize - hop are the overlap with the last frame.
+    private val pending = FloatArray(windowSize)
+    private var pendingSize = 0
+    private var unseen = 0
+
+    /**
+     * Adds samples at [sampleRate] and calls [onFrame] with the [melBins] features of every frame
+     * they complete. The array passed to [onFrame] is reused; copy it to keep it.
+     */
+    fun accept(samples: FloatArray, offset: Int = 0, count: Int = samples.size - offset, onFrame: (FloatArray) -> Unit) {
+        var p = offset
+        val end = offset + count
+        while (p < end) {
+            val n = minOf(end - p, windowSize - pendingSize)
+            samples.copyInto(pending, pendingSize, p, p + n)
+            pendingSize += n
+            unseen += n
+            p += n
+            if (pendingSize == windowSize) {
+                onFrame(compute())
+                pending.copyInto(pending, 0, hop, windowSize)
+                pendingSize = windowSize - hop
+                unseen = 0
+            }
+        }
+    }
+
+    /** Emits a last, zero-padded frame if samples are left over, and starts a new stream. */
+    fun flush(onFrame: (FloatArray) -> Unit) {
+        if (unseen > 0) {
+            pending.fill(0f, pendingSize, windowSize)
+            onFrame(compute())
+        }
+        pendingSize = 0
+        unseen = 0
+    }
+
+    private fun compute(): FloatArray {
+        for (i in 0 until windowSize) frame[i] = pending[i] * window[i]
+        frame.fill(0f, windowSize, frame.size)
+        fft.powerSpectrum(frame, power)
+        for (m in 0 until melBins) {
+            val weights = filterWeights[m]
+            val start = filterStart[m]
+            var energy = 0f
+            for (i in weights.indices) energy += weights[i] * power[start + i]
+            features[m] = ln(max(energy, FLOOR))
+        }
+        return features
+    }
+
+    private fun mel(hz: Float): Float = 2595f * log10(1f + hz / 700f)
+
+    private fun hz(mel: Float): Float = 700f * (10f.pow(mel / 2595f) - 1f)
+
+    private companion object {
+        const val FLOOR = 1e-10f
+    }
+}
@@ -0,0 +1,69 @@
+package org.kgajjar.mobileai.audio
+
+import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.sync.Mutex
+import kotlinx.coroutines.sync.withLock
+
+/**
+ * Bounded FIFO of samples between one producer and one consumer coroutine, e.g. a synthesizer
+ * and the playback loop. [write] suspends while the ring is full and [read] while it is empty,
+ * so the producer runs at most [capacity] samples ahead.
+ */
+class PcmRingBuffer(val capacity: Int) {
+    private val ring = FloatArray(capacity)
+    private val mutex = Mutex()
+    private var start = 0
+    private var size = 0
+    private var closed = false
+
+    // Wake-ups for a waiting reader or writer; conflated since only one of each ever waits.
+    private val readable = Channel<Unit>(Channel.CONFLATED)
+    private val writable = Channel<Unit>(Channel.CONFLATED)
+
+    suspend fun write(samples: FloatArray, offset: Int = 0, count: Int = samples.size - offset) {
+        var p = offset
+        val end = offset + count
+        while (p < end) {
+            val n = mutex.withLock {
+                check(!closed) { "write after close" }
+                val n = minOf(end - p, capacity - size)
+                var tail = (start + size) % capacity
+                for (i in 0 until n) {
+                    ring[tail] = samples[p + i]
+                    if (++tail == capacity) tail = 0
+                }
+                size += n
+                n
+            }
+            if (n > 0) readable.trySend(Unit) else writable.receive()
+            p += n
+        }
+    }
+
+    /** Reads up to `count` samples; returns -1 once the ring is closed and drained. */
+    suspend fun read(dst: FloatArray, offset: Int = 0, count: Int = dst.size - offset): Int {
+        while (true) {
+            val n = mutex.withLock {
+                if (size == 0) return@withLock if (closed) -1 else 0
+                val n = minOf(count, size)
+                for (i in 0 until n) {
+                    dst[offset + i] = ring[start]
+                    if (++start == capacity) start = 0
+                }
+                size -= n
+                n
+            }
+            if (n != 0) {
+                if (n > 0) writable.trySend(Unit)
+                return n
+            }
+            readable.receive()
+        }
+    }
+
+    /** Ends the stream; the reader still gets what was written. */
+    suspend fun close() {
+        mutex.withLock { closed = true }
+        readable.trySend(Unit)
+    }
+}
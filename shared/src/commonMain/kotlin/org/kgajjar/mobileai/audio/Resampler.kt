@@ -0,0 +1,115 @@
+package org.kgajjar.mobileai.audio
+
+import kotlin.math.PI
+import kotlin.math.abs
+import kotlin.math.ceil
+import kotlin.math.cos
+import kotlin.math.min
+import kotlin.math.sin
+
+/**
+ * Streaming polyphase resampler with a Hann-windowed sinc low-pass.
+ *
+ * With `inputRate / outputRate` reduced to M / L, every output sample falls on one of L
+ * fractional offsets between input samples, so the filter is tabulated once per offset and
+ * each output is a plain dot product over the input window. The cutoff is the lower Nyquist
+ * rate, so downsampling does not alias. Output lags input by half the filter length until
+ * [flush].
+ */
+class Resampler(val inputRate: Int, val outputRate: Int, zeroCrossings: Int = 16) {
+    private val up: Int
+    private val down: Int
+    private val halfTaps: Int
+    private val taps: Int
+    private val table: FloatArray
+
+    init {
+        require(inputRate > 0 && outputRate > 0) { "sample rates must be positive" }
+        val g = gcd(inputRate, outputRate)
+        up = outputRate / g
+        down = inputRate / g
+        require(up <= 4096) { "unsupported rate ratio $inputRate:$outputRate" }
+        val cutoff = min(1.0, outputRate.toDouble() / inputRate)
+        halfTaps = ceil(zeroCrossings / cutoff).toInt()
+        taps = 2 * halfTaps
+        table = FloatArray(up * taps)
+        for (phase in 0 until up) {
+            val offset = phase.toDouble() / up
+            var sum = 0.0
+            for (k in 0 until taps) {
+                val distance = (k - halfTaps + 1) - offset
+                val x = distance * cutoff
+                val sinc = if (x == 0.0) 1.0 else sin(PI * x) / (PI * x)
+                val window = if (abs(distance) >= halfTaps) 0.0 else 0.5 + 0.5 * cos(PI * distance / halfTaps)
+                val h = sinc * window
+                table[phase * taps + k] = h.toFloat()
+                sum += h
+            }
+            // Unit gain at DC for every phase.
+            for (k in 0 until taps) table[phase * taps + k] = (table[phase * taps + k] / sum).toFloat()
+        }
+    }
+
+    // Input the next outputs still need; history[0] is input sample `base`. Samples before the
+    // start are silence.
+    private var history = FloatArray(maxOf(4096, 2 * taps))
+    private var buffered = halfTaps - 1
+    private var base = -(halfTaps - 1).toLong()
+    private var consumed = 0L
+    private var produced = 0L
+
+    fun process(input: FloatArray, offset: Int = 0, count: Int = input.size - offset): FloatArray {
+        if (buffered + count > history.size) history = history.copyOf(maxOf(history.size * 2, buffered + count))
+        input.copyInto(history, buffered, offset, offset + count)
+        buffered += count
+        consumed += count
+        return drain()
+    }
+
+    /** Emits the remaining output for everything passed to [process], as if followed by silence. Call once, at the end. */
+    fun flush(): FloatArray {
+        val total = (consumed * up + down - 1) / down
+        val tail = FloatArray(halfTaps)
+        val out = ArrayList<FloatArray>()
+        while (produced < total) {
+            if (buffered + tail.size > history.size) history = history.copyOf(history.size * 2)
+            tail.copyInto(history, buffered)
+            buffered += tail.size
+            out += drain(limit = total)
+        }
+        val result = FloatArray(out.sumOf { it.size })
+        var p = 0
+        for (chunk in out) {
+            chunk.copyInto(result, p)
+            p += chunk.size
+        }
+        return result
+    }
+
+    private fun drain(limit: Long = Long.MAX_VALUE): FloatArray {
+        val end = base + buffered
+        // Output j sits at input time j * down / up and needs inputs up to floor(that) + halfTaps.
+        var last = produced
+        while (last < limit && (last * down) / up + halfTaps < end) last++
+        val out = FloatArray((last - produced).toInt())
+        for (i in out.indices) {
+            val position = produced * down
+            val center = position / up
+            val phase = (position % up).toInt()
+            val first = (center - halfTaps + 1 - base).toInt()
+            var acc = 0f
+            val row = phase * taps
+            for (k in 0 until taps) acc += history[first + k] * table[row + k]
+            out[i] = acc
+            produced++
+        }
+        // Keep only what the next output can still reach.
+        val keepFrom = ((produced * down) / up - halfTaps + 1 - base).toInt().coerceIn(0, buffered)
+        history.copyInto(history, 0, keepFrom, buffered)
+        buffered -= keepFrom
+        base += keepFrom
+        return out
+    }
+
+    private fun gcd(a: Int, b: Int): Int = if (b == 0) a else gcd(b, a % b)
+}
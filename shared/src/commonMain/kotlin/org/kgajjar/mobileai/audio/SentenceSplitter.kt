@@ -0,0 +1,99 @@
+package org.kgajjar.mobileai.audio
+
+/**
+ * Cuts streamed reply text into sentences for speech synthesis as soon as each one is complete.
+ *
+ * A sentence ends at `.`, `!`, `?` or `…` (plus any closing quotes or brackets) followed by
+ * whitespace, or at a line break. A period after a common abbreviation, a single initial or a
+ * list number does not end one, and a number like `3.5` never has the whitespace. A sentence
+ * that runs past [maxLength] without ending is cut at its last clause break so synthesis can
+ * start. Markdown emphasis, headings and code marks are dropped, since they would be read out.
+ */
+class SentenceSplitter(private val maxLength: Int = 240) {
+    private val pending = StringBuilder()
+    private var scanned = 0
+
+    /** Adds streamed text and returns the sentences it completed. */
+    fun append(text: CharSequence): List<String> {
+        pending.append(text)
+        val out = ArrayList<String>()
+        var i = scanned
+        while (i < pending.length) {
+            val end = boundaryAfter(i)
+            when {
+                end == NEED_MORE -> break
+                end > 0 -> {
+                    emit(end, out)
+                    i = 0
+                }
+                else -> i++
+            }
+        }
+        scanned = i
+        while (pending.length > maxLength) emit(clauseBreak(), out)
+        return out
+    }
+
+    /** The unfinished last sentence, if any; the splitter is then empty. */
+    fun finish(): String? {
+        val rest = speakable(pending)
+        pending.clear()
+        scanned = 0
+        return rest.ifEmpty { null }
+    }
+
+    /** End of the sentence whose last character may be at [i], 0 if none, [NEED_MORE] if undecided. */
+    private fun boundaryAfter(i: Int): Int {
+        val c = pending[i]
+        if (c == '\n') return i + 1
+        if (c !in TERMINATORS) return 0
+        var j = i + 1
+        while (j < pending.length && (pending[j] in TERMINATORS || pending[j] in CLOSERS)) j++
+        if (j == pending.length) return NEED_MORE
+        if (!pending[j].isWhitespace()) return 0
+        if (c == '.' && isAbbreviation(i)) return 0
+        return j
+    }
+
+    /** Whether the period at [dot] belongs to an abbreviation, an initial or a list marker like `2.`. */
+    private fun isAbbreviation(dot: Int): Boolean {
+        var start = dot
+        while (start > 0 && (pending[start - 1].isLetterOrDigit() || pending[start - 1] == '.')) start--
+        val word = pending.substring(start, dot).lowercase()
+        if (word.isNotEmpty() && word.all { it.isDigit() }) return start == 0 || pending[start - 1] == '\n'
+        return (word.length == 1 && word != "i") || word in ABBREVIATIONS
+    }
+
+    private fun clauseBreak(): Int {
+        for (i in maxLength - 1 downTo maxLength / 2) if (pending[i] in ",;:" && pending[i + 1] == ' ') return i + 1
+        for (i in maxLength - 1 downTo 1) if (pending[i] == ' ') return i + 1
+        return maxLength
+    }
+
+    private fun emit(end: Int, out: MutableList<String>) {
+        val sentence = speakable(pending.subSequence(0, end))
+        pending.deleteRange(0, end)
+        scanned = 0
+        if (sentence.isNotEmpty()) out += sentence
+    }
+
+    private fun speakable(text: CharSequence): String {
+        val out = StringBuilder(text.length)
+        for (c in text) {
+            if (c == '*' || c == '`' || c == '#') continue
+            if (c.isWhitespace()) {
+                if (out.isNotEmpty() && out.last() != ' ') out.append(' ')
+            } else {
+                out.append(c)
+            }
+        }
+        return out.trim().toString()
+    }
+
+    private companion object {
+        const val NEED_MORE = -1
+        const val TERMINATORS = ".!?…"
+        const val CLOSERS = "\"')]”’*_`"
+        val ABBREVIATIONS = setOf("mr", "mrs", "ms", "dr", "prof", "st", "vs", "etc", "e.g", "i.e", "approx", "fig")
+    }
+}
@@ -0,0 +1,12 @@
+package org.kgajjar.mobileai.audio
+
+import kotlinx.coroutines.flow.Flow
+
+/**
+ * Reading replies aloud: a speech synthesizer plus the platform's audio output. Platforms
+ * without either simply don't provide one.
+ */
+class SpeechOutput(private val synthesizer: SpeechSynthesizer, private val openOutput: (sampleRate: Int) -> AudioSink) {
+    /** Speaks [text] as it streams in; cancelling stops playback. */
+    suspend fun speak(text: Flow<CharSequence>) = SpeechPipeline(synthesizer, openOutput(synthesizer.sampleRate)).speak(text)
+}
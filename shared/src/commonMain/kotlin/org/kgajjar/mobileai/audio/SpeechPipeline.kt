@@ -0,0 +1,60 @@
+package org.kgajjar.mobileai.audio
+
+import kotlinx.coroutines.NonCancellable
+import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.coroutineScope
+import kotlinx.coroutines.flow.Flow
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.withContext
+
+/**
+ * Speaks a reply while it is still being generated.
+ *
+ * Three coroutines run side by side: the reply text is cut into sentences as it streams in, the
+ * synthesizer renders each sentence into a [PcmRingBuffer] in small buffers, and the playback
+ * loop drains the ring into the [sink]. The first sentence is heard while the model is still
+ * writing the rest, and later sentences are synthesized while earlier ones play. The ring holds
+ * [bufferSeconds] of audio, which bounds how far synthesis runs ahead.
+ */
+class SpeechPipeline(
+    private val synthesizer: SpeechSynthesizer,
+    private val sink: AudioSink,
+    bufferSeconds: Float = 2f,
+) {
+    private val ring = PcmRingBuffer(maxOf(1, (synthesizer.sampleRate * bufferSeconds).toInt()))
+
+    /** Speaks [text] to the end and closes the sink. */
+    suspend fun speak(text: Flow<CharSequence>) {
+        try {
+            coroutineScope {
+                val sentences = Channel<String>(Channel.UNLIMITED)
+                launch {
+                    val splitter = SentenceSplitter()
+                    try {
+                        text.collect { chunk -> for (sentence in splitter.append(chunk)) sentences.send(sentence) }
+                        splitter.finish()?.let { sentences.send(it) }
+                    } finally {
+                        sentences.close()
+                    }
+                }
+                launch {
+                    try {
+                        for (sentence in sentences) {
+                            synthesizer.synthesize(sentence) { samples, count -> ring.write(samples, 0, count) }
+                        }
+                    } finally {
+                        ring.close()
+                    }
+                }
+                val buffer = FloatArray(maxOf(1, synthesizer.sampleRate / 50))
+                while (true) {
+                    val n = ring.read(buffer)
+                    if (n < 0) break
+                    sink.write(buffer, 0, n)
+                }
+            }
+        } finally {
+            withContext(NonCancellable) { sink.close() }
+        }
+    }
+}
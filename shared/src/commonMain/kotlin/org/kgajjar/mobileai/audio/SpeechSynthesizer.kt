@@ -0,0 +1,12 @@
+package org.kgajjar.mobileai.audio
+
+/** A text-to-speech model that produces audio incrementally. */
+interface SpeechSynthesizer {
+    val sampleRate: Int
+
+    /**
+     * Synthesizes one sentence, passing mono samples to [onAudio] a small buffer at a time as they
+     * are produced. The buffer may be reused once [onAudio] returns.
+     */
+    suspend fun synthesize(sentence: String, onAudio: suspend (samples: FloatArray, count: Int) -> Unit)
+}
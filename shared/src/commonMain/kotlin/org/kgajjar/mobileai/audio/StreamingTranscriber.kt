@@ -0,0 +1,151 @@
+package org.kgajjar.mobileai.audio
+
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.flow.Flow
+import kotlinx.coroutines.flow.flow
+import kotlinx.coroutines.flow.flowOn
+
+/**
+ * Text recognized so far. [committed] no longer changes; [partial] is the current guess for the
+ * audio after it and may still be revised.
+ */
+class Transcript(val committed: String, val partial: String, val final: Boolean) {
+    val text: String get() = if (partial.isEmpty()) committed else if (committed.isEmpty()) partial else "$committed $partial"
+}
+
+/**
+ * Transcribes one utterance while it is being spoken.
+ *
+ * Audio is resampled and turned into log-mel frames as it arrives. Every [chunkFrames] new
+ * frames the model re-decodes the uncommitted window; words on which two consecutive decodes
+ * agree are committed and their audio is dropped from the window, and the rest is shown as a
+ * partial hypothesis. When the speaker stops, only the last uncommitted stretch is left to
+ * decode, instead of the whole utterance.
+ *
+ * With a [vad], only speech reaches the model: frames outside speech are dropped apart from a
+ * short lead-in before each onset, and every pause is decoded straight away since it is the
+ * likeliest place for the hypothesis to be stable.
+ */
+class StreamingTranscriber(
+    private val model: AsrModel,
+    inputRate: Int,
+    private val chunkFrames: Int = 100,
+    private val vad: VoiceActivityDetector? = VoiceActivityDetector(),
+) {
+    private val resampler = if (inputRate == model.sampleRate) null else Resampler(inputRate, model.sampleRate)
+    private val frontend = LogMelFrontend(sampleRate = model.sampleRate, melBins = model.melBins)
+    private val melBins = model.melBins
+
+    // Features of the uncommitted window, row-major.
+    private var window = FloatArray(melBins * (chunkFrames * 4))
+    private var frames = 0
+    private var framesSinceDecode = 0
+    private var pauseDecode = false
+
+    // Frames the VAD has not let through yet, kept so the onset of speech is not clipped.
+    private val leadIn = ArrayDeque<FloatArray>()
+    private val leadInFrames = (vad?.startFrames ?: 0) + LEAD_IN_FRAMES
+
+    /** Set once the VAD has seen the speaker stop; [transcribe] ends there. */
+    var endpointReached: Boolean = false
+        private set
+
+    private val committed = StringBuilder()
+    // The last decode's uncommitted words, with end frames relative to the current window.
+    private var previous = emptyList<AsrWord>()
+
+    /** Adds samples at the input rate; returns a new transcript when they triggered a decode. */
+    suspend fun accept(samples: FloatArray, offset: Int = 0, count: Int = samples.size - offset): Transcript? {
+        val audio = resampler?.process(samples, offset, count)
+        if (audio != null) frontend.accept(audio, onFrame = ::addFrame) else frontend.accept(samples, offset, count, ::addFrame)
+        if (framesSinceDecode < chunkFrames && !pauseDecode) return null
+        return decode(final = false)
+    }
+
+    /** Decodes what is left and returns the final transcript. */
+    suspend fun finish(): Transcript {
+        resampler?.flush()?.let { frontend.accept(it, onFrame = ::addFrame) }
+        frontend.flush(::addFrame)
+        return decode(final = true)
+    }
+
+    /**
+     * Transcribes [source] until it ends or is closed, or with [stopAtEndpoint] until the speaker
+     * stops talking, emitting every update; the last one is final.
+     */
+    fun transcribe(source: AudioSource, stopAtEndpoint: Boolean = true): Flow<Transcript> = flow {
+        try {
+            val buffer = FloatArray(maxOf(1, source.sampleRate / 20))
+            while (!(stopAtEndpoint && endpointReached)) {
+                val n = source.read(buffer)
+                if (n < 0) break
+                accept(buffer, 0, n)?.let { emit(it) }
+            }
+            emit(finish())
+        } finally {
+            source.close()
+        }
+    }.flowOn(Dispatchers.Default)
+
+    private fun addFrame(features: FloatArray) {
+        if (vad == null) return append(features)
+        val event = vad.accept(features)
+        if (event is VadEvent.Endpoint) endpointReached = true
+        when {
+            event is VadEvent.SpeechStart -> {
+                while (leadIn.isNotEmpty()) append(leadIn.removeFirst())
+                append(features)
+            }
+            vad.speaking || event is VadEvent.SpeechEnd -> {
+                append(features)
+                if (event is VadEvent.SpeechEnd) pauseDecode = true
+            }
+            else -> {
+                if (leadIn.size == leadInFrames) leadIn.removeFirst()
+                leadIn.addLast(features.copyOf())
+            }
+        }
+    }
+
+    private fun append(features: FloatArray) {
+        if ((frames + 1) * melBins > window.size) window = window.copyOf(window.size * 2)
+        features.copyInto(window, frames * melBins)
+        frames++
+        framesSinceDecode++
+    }
+
+    private suspend fun decode(final: Boolean): Transcript {
+        framesSinceDecode = 0
+        pauseDecode = false
+        val words = if (frames == 0) emptyList() else model.transcribe(window, frames, committed.takeLast(PROMPT_CHARS).toString())
+        // A window the encoder can no longer grow is committed as is.
+        val full = frames + chunkFrames > model.maxFrames
+        val agreed = if (final || full) {
+            words.size
+        } else {
+            words.indices.firstOrNull { it >= previous.size || previous[it].text != words[it].text } ?: words.size
+        }
+        for (i in 0 until agreed) {
+            if (committed.isNotEmpty()) committed.append(' ')
+            committed.append(words[i].text)
+        }
+        val cut = when {
+            full -> frames
+            agreed > 0 -> words[agreed - 1].endFrame.coerceIn(0, frames)
+            else -> 0
+        }
+        window.copyInto(window, 0, cut * melBins, frames * melBins)
+        frames -= cut
+        previous = words.subList(agreed, words.size).map { AsrWord(it.text, it.endFrame - cut) }
+        val partial = previous.joinToString(" ") { it.text }
+        return Transcript(committed.toString(), if (final) "" else partial, final)
+    }
+
+    private companion object {
+        /** Committed text passed back to the decoder as context. */
+        const val PROMPT_CHARS = 200
+
+        /** Silence kept before each onset, besides the frames that triggered it. */
+        const val LEAD_IN_FRAMES = 10
+    }
+}
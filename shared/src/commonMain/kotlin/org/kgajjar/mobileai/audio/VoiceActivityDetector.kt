@@ -0,0 +1,117 @@
+package org.kgajjar.mobileai.audio
+
+import kotlin.math.exp
+import kotlin.math.ln
+
+/** Speech boundaries found by a [VoiceActivityDetector], as frame numbers since the start. */
+sealed class VadEvent(val frame: Long) {
+    /** Speech begins at [frame]. */
+    class SpeechStart(frame: Long) : VadEvent(frame)
+
+    /** Speech paused after [frame]; more may follow. */
+    class SpeechEnd(frame: Long) : VadEvent(frame)
+
+    /** The speaker has stopped: the pause after [frame] grew long enough to end the utterance. */
+    class Endpoint(frame: Long) : VadEvent(frame)
+}
+
+/**
+ * Energy and spectral-flux voice activity detector over log-mel frames.
+ *
+ * A frame is active when its energy is [thresholdDb] above an adaptive noise floor, or half
+ * that with a spectral-flux onset (energy moving into new bands, as speech does and steady
+ * noise doesn't). Decisions have hysteresis: speech starts after [startFrames] active frames in
+ * a row and ends after [hangoverFrames] inactive ones, so clicks don't open the gate and short
+ * pauses between words don't close it. [endpointFrames] of silence after speech ends the
+ * utterance.
+ */
+class VoiceActivityDetector(
+    val startFrames: Int = 3,
+    val hangoverFrames: Int = 20,
+    val endpointFrames: Int = 80,
+    thresholdDb: Float = 12f,
+    private val fluxThreshold: Float = 1f,
+) {
+    init {
+        require(startFrames > 0 && hangoverFrames in 1 until endpointFrames) { "bad VAD timing" }
+    }
+
+    private val threshold = thresholdDb * ln(10f) / 10f
+
+    private var previous: FloatArray? = null
+    private var noise = Float.NaN
+    private var frame = -1L
+    private var activeRun = 0
+    private var quietRun = 0
+    private var spoke = false
+
+    /** True from a [VadEvent.SpeechStart] until the matching [VadEvent.SpeechEnd]. */
+    var speaking: Boolean = false
+        private set
+
+    /** Classifies the next frame; returns the event it completes, if any. */
+    fun accept(features: FloatArray): VadEvent? {
+        frame++
+        val energy = logEnergy(features)
+        val flux = flux(features)
+        if (noise.isNaN()) noise = energy
+        val margin = energy - noise
+        val active = margin > threshold || (margin > threshold / 2 && flux > fluxThreshold)
+
+        // The floor follows drops quickly and rises slowly, and barely at all during speech.
+        val rate = when {
+            energy < noise -> 0.2f
+            speaking -> 0.0005f
+            else -> 0.005f
+        }
+        noise += rate * (energy - noise)
+
+        if (active) {
+            activeRun++
+            quietRun = 0
+        } else {
+            activeRun = 0
+            quietRun++
+        }
+        return when {
+            !speaking && activeRun >= startFrames -> {
+                speaking = true
+                spoke = true
+                VadEvent.SpeechStart(frame - startFrames + 1)
+            }
+            speaking && quietRun >= hangoverFrames -> {
+                speaking = false
+                VadEvent.SpeechEnd(frame - hangoverFrames)
+            }
+            spoke && !speaking && quietRun == endpointFrames -> {
+                spoke = false
+                VadEvent.Endpoint(frame - endpointFrames)
+            }
+            else -> null
+        }
+    }
+
+    private fun logEnergy(features: FloatArray): Float {
+        var max = Float.NEGATIVE_INFINITY
+        for (x in features) if (x > max) max = x
+        var sum = 0f
+        for (x in features) sum += exp(x - max)
+        return max + ln(sum)
+    }
+
+    /** Mean rise of the log spectrum since the last frame. */
+    private fun flux(features: FloatArray): Float {
+        val last = previous
+        if (last == null) {
+            previous = features.copyOf()
+            return 0f
+        }
+        var rise = 0f
+        for (i in features.indices) {
+            val d = features[i] - last[i]
+            if (d > 0) rise += d
+            last[i] = features[i]
+        }
+        return rise / features.size
+    }
+}
@@ -0,0 +1,14 @@
+package org.kgajjar.mobileai.audio
+
+import kotlinx.coroutines.flow.Flow
+
+/**
+ * Dictation for text fields: a speech model plus the platform's way of opening the microphone.
+ * Platforms without either simply don't provide one.
+ */
+class VoiceInput(private val model: AsrModel, private val openMicrophone: () -> AudioSource) {
+    /** Starts recording; closing the returned source stops it and lets the transcript finish. */
+    fun start(): AudioSource = openMicrophone()
+
+    fun transcribe(source: AudioSource): Flow<Transcript> = StreamingTranscriber(model, source.sampleRate).transcribe(source)
+}
@@ -0,0 +1,111 @@
+package org.kgajjar.mobileai.audio
+
+import org.kgajjar.mobileai.storage.ByteBuilder
+import org.kgajjar.mobileai.storage.getIntLe
+
+/** Mono samples in [-1, 1]. */
+class PcmAudio(val samples: FloatArray, val sampleRate: Int) {
+    val durationSeconds: Float get() = samples.size.toFloat() / sampleRate
+}
+
+/** RIFF/WAVE files: integer PCM of 8 to 32 bits or 32-bit float, any channel count (mixed to mono). */
+object Wav {
+    private const val PCM = 1
+    private const val FLOAT = 3
+    private const val EXTENSIBLE = 0xFFFE
+
+    fun decode(bytes: ByteArray): PcmAudio {
+        require(bytes.size >= 12 && tag(bytes, 0) == "RIFF" && tag(bytes, 8) == "WAVE") { "not a WAV file" }
+        var format = -1
+        var channels = 0
+        var sampleRate = 0
+        var bits = 0
+        var pos = 12
+        while (pos + 8 <= bytes.size) {
+            val id = tag(bytes, pos)
+            val length = bytes.getIntLe(pos + 4)
+            val body = pos + 8
+            require((length >= 0 && body + length <= bytes.size) || id == "data") { "truncated $id chunk" }
+            when (id) {
+                "fmt " -> {
+                    format = u16(bytes, body)
+                    channels = u16(bytes, body + 2)
+                    sampleRate = bytes.getIntLe(body + 4)
+                    bits = u16(bytes, body + 14)
+                    // The extensible header carries the real format in the first two bytes of its GUID.
+                    if (format == EXTENSIBLE && length >= 26) format = u16(bytes, body + 24)
+                }
+                "data" -> {
+                    require(format >= 0) { "data chunk before fmt chunk" }
+                    // Streaming writers leave the length unset; take what is there.
+                    val end = if (length <= 0 || body + length > bytes.size) bytes.size else body + length
+                    return PcmAudio(samples(bytes, body, end, format, channels, bits), sampleRate)
+                }
+            }
+            pos = body + length + (length and 1)
+        }
+        throw IllegalArgumentException("WAV file has no data chunk")
+    }
+
+    /** 16-bit mono PCM. */
+    fun encode(audio: PcmAudio): ByteArray {
+        val out = ByteBuilder(44 + audio.samples.size * 2)
+        out.putBytes(header(audio.sampleRate, audio.samples.size * 2))
+        putPcm16(out, audio.samples)
+        return out.toByteArray()
+    }
+
+    /** The 44-byte header of a 16-bit mono file with [dataSize] bytes of samples. */
+    fun header(sampleRate: Int, dataSize: Int): ByteArray {
+        val out = ByteBuilder(44)
+        out.putBytes("RIFF".encodeToByteArray()).putInt(36 + dataSize).putBytes("WAVE".encodeToByteArray())
+        out.putBytes("fmt ".encodeToByteArray()).putInt(16)
+        out.putByte(PCM).putByte(0).putByte(1).putByte(0) // format, channels
+        out.putInt(sampleRate).putInt(sampleRate * 2)
+        out.putByte(2).putByte(0).putByte(16).putByte(0) // block align, bits
+        out.putBytes("data".encodeToByteArray()).putInt(dataSize)
+        return out.toByteArray()
+    }
+
+    internal fun putPcm16(out: ByteBuilder, samples: FloatArray, offset: Int = 0, count: Int = samples.size - offset) {
+        for (i in offset until offset + count) {
+            val value = (samples[i].coerceIn(-1f, 1f) * 32767f).toInt()
+            out.putByte(value).putByte(value shr 8)
+        }
+    }
+
+    private fun samples(bytes: ByteArray, start: Int, end: Int, format: Int, channels: Int, bits: Int): FloatArray {
+        require(channels > 0) { "no channels" }
+        require((format == PCM && bits in intArrayOf(8, 16, 24, 32)) || (format == FLOAT && bits == 32)) {
+            "unsupported WAV encoding: format $format, $bits bits"
+        }
+        val width = bits / 8
+        val frameSize = width * channels
+        val frames = (end - start) / frameSize
+        val out = FloatArray(frames)
+        val scale = 1f / channels
+        for (f in 0 until frames) {
+            var sum = 0f
+            var p = start + f * frameSize
+            repeat(channels) {
+                sum += when {
+                    format == FLOAT -> Float.fromBits(bytes.getIntLe(p))
+                    width == 1 -> ((bytes[p].toInt() and 0xFF) - 128) / 128f
+                    width == 2 -> ((bytes[p].toInt() and 0xFF) or (bytes[p + 1].toInt() shl 8)) / 32768f
+                    width == 3 -> ((bytes[p].toInt() and 0xFF) or ((bytes[p + 1].toInt() and 0xFF) shl 8) or
+                        (bytes[p + 2].toInt() shl 16)) / 8388608f
+                    else -> bytes.getIntLe(p) / 2147483648f
+                }
+                p += width
+            }
+            out[f] = sum * scale
+        }
+        return out
+    }
+
+    private fun tag(bytes: ByteArray, offset: Int): String =
+        if (offset + 4 <= bytes.size) bytes.decodeToString(offset, offset + 4) else ""
+
+    private fun u16(bytes: ByteArray, offset: Int): Int =
+        (bytes[offset].toInt() and 0xFF) or ((bytes[offset + 1].toInt() and 0xFF) shl 8)
+}
@@ -0,0 +1,48 @@
+package org.kgajjar.mobileai.chat
+
+enum class Role { User, Assistant, System, Tool }
+
+data class ConversationSummary(
+    val id: Long,
+    val title: String,
+    val createdAt: Long,
+    val updatedAt: Long,
+    val messageCount: Int,
+)
+
+data class Message(
+    val conversationId: Long,
+    val index: Int,
+    val role: Role,
+    val text: String,
+    val createdAt: Long,
+)
+
+/** A mutation observed on [ConversationStore.changes]. */
+sealed interface ConversationChange {
+    val conversationId: Long
+
+    /**
+     * A message was appended, or streamed text was appended to it. [appended] is the text this
+     * change added and [length] the message's text length after it, so a copy of the text can be
+     * kept up to date without reading the message again.
+     */
+    data class MessageChanged(
+        override val conversationId: Long,
+        val messageIndex: Int,
+        val appended: String,
+        val length: Int,
+    ) : ConversationChange {
+        /**
+         * Whether [appended] extends a copy of the text that is [known] characters long. If not
+         * (and [length] is beyond it), a change was missed or arrived out of order, and the
+         * message has to be read again.
+         */
+        fun follows(known: Int): Boolean = length - appended.length == known
+    }
+
+    /** A streaming message is complete; see [ConversationStore.finishMessage]. */
+    data class MessageFinished(override val conversationId: Long, val messageIndex: Int) : ConversationChange
+
+    data class Deleted(override val conversationId: Long, val messageCount: Int) : ConversationChange
+}
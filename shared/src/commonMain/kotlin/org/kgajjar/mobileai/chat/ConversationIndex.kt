@@ -0,0 +1,205 @@
+package org.kgajjar.mobileai.chat
+
+import org.kgajjar.mobileai.storage.ByteBuilder
+import org.kgajjar.mobileai.storage.ByteReader
+import org.kgajjar.mobileai.storage.getIntLe
+import org.kgajjar.mobileai.storage.getLongLe
+
+/**
+ * Record layout of the conversation log. Every record is
+ * `length:u32 | crc32:u32 | type:u8 | flags:u8 | conversation:i64 | timestamp:i64 | payload`,
+ * where `length` and the checksum cover everything after the checksum.
+ */
+internal object LogFormat {
+    const val MAGIC = 0x4C43414D // "MACL"
+    const val VERSION = 1
+    const val FILE_HEADER = 16
+
+    const val RECORD_HEADER = 8
+    const val BODY_FIXED = 18
+
+    const val CREATE = 1
+    const val MESSAGE = 2
+    const val CHUNK = 3
+    const val DELETE = 4
+
+    /** Record text is [org.kgajjar.mobileai.storage.DictionaryCodec] output, prefixed by the dictionary id. */
+    const val FLAG_COMPRESSED = 1
+
+    fun type(body: ByteArray, start: Int): Int = body[start].toInt()
+
+    fun flags(body: ByteArray, start: Int): Int = body[start + 1].toInt() and 0xFF
+
+    fun conversation(body: ByteArray, start: Int): Long = body.getLongLe(start + 2)
+
+    fun timestamp(body: ByteArray, start: Int): Long = body.getLongLe(start + 10)
+
+    /** Offset of the record's text within its body, after any type-specific prefix. */
+    fun textStart(type: Int): Int = BODY_FIXED + when (type) {
+        MESSAGE -> 1
+        CHUNK -> 4
+        else -> 0
+    }
+}
+
+/**
+ * In-memory index over the conversation log: conversations by id, their messages as lists of
+ * record offsets, and an intrusive recency list so the most recent chats are found without
+ * scanning or sorting.
+ */
+internal class ConversationIndex {
+    class Entry(val id: Long, val title: String, val createdAt: Long) {
+        var updatedAt = createdAt
+
+        /** Log bytes attributable to this conversation, reclaimed by compaction on delete. */
+        var bytes = 0L
+        val messages = ArrayList<MessageEntry>()
+        var newer: Entry? = null
+        var older: Entry? = null
+
+        fun summary() = ConversationSummary(id, title, createdAt, updatedAt, messages.size)
+    }
+
+    class MessageEntry(val role: Role, val createdAt: Long) {
+        /** The message record followed by its chunk records, in log order. */
+        val records = ArrayList<Long>(1)
+    }
+
+    private val entries = HashMap<Long, Entry>()
+    private var newest: Entry? = null
+    private var oldest: Entry? = null
+
+    /** Never reused, even once the conversation that held an id is deleted and compacted away. */
+    var nextId = 1L
+
+    /** Bytes that compaction would reclaim: chunk records and deleted conversations. */
+    var compactableBytes = 0L
+        private set
+
+    operator fun get(id: Long): Entry? = entries[id]
+
+    val size: Int get() = entries.size
+
+    fun recent(limit: Int): List<Entry> {
+        val result = ArrayList<Entry>(minOf(limit, entries.size))
+        var entry = newest
+        while (entry != null && result.size < limit) {
+            result += entry
+            entry = entry.older
+        }
+        return result
+    }
+
+    /** Oldest first, so that replaying entries in this order reproduces the recency list. */
+    fun oldestFirst(): List<Entry> {
+        val result = ArrayList<Entry>(entries.size)
+        var entry = oldest
+        while (entry != null) {
+            result += entry
+            entry = entry.newer
+        }
+        return result
+    }
+
+    /** Applies the record whose body is `body[start, start + length)` and lives at [offset]. */
+    fun apply(body: ByteArray, start: Int, length: Int, offset: Long) {
+        val type = LogFormat.type(body, start)
+        val id = LogFormat.conversation(body, start)
+        val timestamp = LogFormat.timestamp(body, start)
+        val recordBytes = LogFormat.RECORD_HEADER + length.toLong()
+        val payload = start + LogFormat.BODY_FIXED
+
+        if (type == LogFormat.CREATE) {
+            val title = body.decodeToString(payload, start + length)
+            val entry = Entry(id, title, timestamp)
+            entry.bytes = recordBytes
+            entries[id] = entry
+            touch(entry)
+            if (id >= nextId) nextId = id + 1
+            return
+        }
+
+        val entry = entries[id]
+        if (entry == null) {
+            compactableBytes += recordBytes
+            return
+        }
+        when (type) {
+            LogFormat.MESSAGE -> {
+                val role = Role.entries[body[payload].toInt()]
+                entry.messages += MessageEntry(role, timestamp).also { it.records += offset }
+            }
+            LogFormat.CHUNK -> {
+                val message = entry.messages.getOrNull(body.getIntLe(payload))
+                message?.records?.add(offset)
+                compactableBytes += recordBytes
+            }
+            LogFormat.DELETE -> {
+                entries.remove(id)
+                unlink(entry)
+                compactableBytes += entry.bytes + recordBytes
+                return
+            }
+            else -> error("unknown record type $type at $offset")
+        }
+        entry.bytes += recordBytes
+        entry.updatedAt = maxOf(entry.updatedAt, timestamp)
+        touch(entry)
+    }
+
+    fun writeTo(out: ByteBuilder) {
+        out.putLong(nextId).putLong(compactableBytes).putInt(entries.size)
+        for (entry in oldestFirst()) {
+            out.putLong(entry.id).putLong(entry.createdAt).putLong(entry.updatedAt).putLong(entry.bytes)
+            out.putString(entry.title)
+            out.putInt(entry.messages.size)
+            for (message in entry.messages) {
+                out.putByte(message.role.ordinal).putLong(message.createdAt).putInt(message.records.size)
+                for (record in message.records) out.putLong(record)
+            }
+        }
+    }
+
+    companion object {
+        fun readFrom(input: ByteReader): ConversationIndex {
+            val index = ConversationIndex()
+            index.nextId = input.long()
+            index.compactableBytes = input.long()
+            repeat(input.int()) {
+                val id = input.long()
+                val createdAt = input.long()
+                val updatedAt = input.long()
+                val bytes = input.long()
+                val entry = Entry(id, input.string(), createdAt)
+                entry.updatedAt = updatedAt
+                entry.bytes = bytes
+                repeat(input.int()) {
+                    val message = MessageEntry(Role.entries[input.byte()], input.long())
+                    repeat(input.int()) { message.records += input.long() }
+                    entry.messages += message
+                }
+                index.entries[entry.id] = entry
+                index.touch(entry)
+            }
+            return index
+        }
+    }
+
+    private fun touch(entry: Entry) {
+        if (newest === entry) return
+        unlink(entry)
+        entry.older = newest
+        newest?.newer = entry
+        newest = entry
+        if (oldest == null) oldest = entry
+    }
+
+    private fun unlink(entry: Entry) {
+        entry.newer?.older = entry.older
+        entry.older?.newer = entry.newer
+        if (newest === entry) newest = entry.older
+        if (oldest === entry) oldest = entry.newer
+        entry.newer = null
+        entry.older = null
+    }
+}
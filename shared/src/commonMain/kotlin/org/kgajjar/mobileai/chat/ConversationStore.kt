@@ -0,0 +1,589 @@
+package org.kgajjar.mobileai.chat
+
+import kotlinx.coroutines.CompletableDeferred
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.CoroutineStart
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.Job
+import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.flow.Flow
+import kotlinx.coroutines.flow.MutableSharedFlow
+import kotlinx.coroutines.flow.SharedFlow
+import kotlinx.coroutines.flow.channelFlow
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.sync.Mutex
+import kotlinx.coroutines.sync.withLock
+import kotlinx.coroutines.withContext
+import org.kgajjar.mobileai.epochMillis
+import org.kgajjar.mobileai.storage.ByteBuilder
+import org.kgajjar.mobileai.storage.ByteFile
+import org.kgajjar.mobileai.storage.ByteReader
+import org.kgajjar.mobileai.storage.Crc32
+import org.kgajjar.mobileai.storage.DictionaryCodec
+import org.kgajjar.mobileai.storage.DictionaryTrainer
+import org.kgajjar.mobileai.storage.Storage
+import org.kgajjar.mobileai.storage.getIntLe
+import org.kgajjar.mobileai.storage.getLongLe
+import org.kgajjar.mobileai.storage.putIntLe
+import org.kgajjar.mobileai.storage.putLongLe
+import org.kgajjar.mobileai.storage.readBytes
+import kotlin.random.Random
+import kotlin.time.Duration
+import kotlin.time.Duration.Companion.milliseconds
+
+/**
+ * Log-structured store for chat conversations.
+ *
+ * Every mutation is one checksummed record appended to `<name>.log`; streaming a reply appends
+ * one small chunk record per token batch instead of rewriting the conversation. Appends are
+ * buffered and made durable together by a group commit that runs [commitInterval] after the
+ * first unsynced append. On open the log is replayed from the last index snapshot
+ * (`<name>.idx`) and a torn or corrupt tail is truncated away. A group commit rewrites the
+ * snapshot once a few hundred KiB have been appended past it, so reopening replays little
+ * even though the app is usually killed rather than closing the store.
+ *
+ * Chunk records and deleted conversations are reclaimed by [compact], which also merges each
+ * message's chunks into a single record. It runs in the background once enough of the log is
+ * reclaimable, and only holds the store lock to copy records appended while it was running.
+ *
+ * Message text is compressed per record against a dictionary trained on the store's own
+ * messages (`<name>.dict.<id>`), so every message still decodes on its own. The first
+ * dictionary is trained in the background once the log is large enough to sample from;
+ * compaction then recompresses older records with it.
+ */
+class ConversationStore private constructor(
+    private val storage: Storage,
+    private val name: String,
+    private val scope: CoroutineScope,
+    private val commitInterval: Duration,
+) {
+    private val mutex = Mutex()
+    private val compactionMutex = Mutex()
+    private val logName = "$name.log"
+    private val indexName = "$name.idx"
+
+    private lateinit var log: ByteFile
+    private var generation = 0L
+    private var index = ConversationIndex()
+
+    /** Length of the log covered by the last snapshot written. */
+    private var snapshotEnd = 0L
+
+    private val record = ByteBuilder(256)
+    private var pendingCommit: CompletableDeferred<Unit>? = null
+    private var compaction: Job? = null
+    private var training: Job? = null
+
+    /** Automatic training waits for the log to reach this size, and to grow this much again after each attempt. */
+    private var trainAtLogBytes = TRAINING_MIN_LOG_BYTES
+
+    /** Every dictionary records may reference, by id; replaced wholesale, never mutated. */
+    private var dictionaries: Map<Int, DictionaryCodec> = emptyMap()
+    private var codec: DictionaryCodec? = null
+
+    /**
+     * Text length so far of each message still being streamed into, by (conversation, message
+     * index); never persisted.
+     */
+    private val streaming = HashMap<Pair<Long, Int>, Int>()
+
+    private val _changes = MutableSharedFlow<ConversationChange>(extraBufferCapacity = 64)
+
+    /** Message appends, finishes and deletions, emitted after they are applied; creation is not reported. */
+    val changes: SharedFlow<ConversationChange> = _changes
+
+    suspend fun create(title: String): Long = mutex.withLock {
+        val id = index.nextId
+        append(LogFormat.CREATE, id) {
+            putBytes(title.encodeToByteArray())
+            0
+        }
+        id
+    }
+
+    /**
+     * Appends a message and returns its index within the conversation. A [streaming] message
+     * is still being written: [follow] keeps following it until [finishMessage] is called.
+     */
+    suspend fun appendMessage(conversationId: Long, role: Role, text: String, streaming: Boolean = false): Int {
+        val messageIndex = mutex.withLock {
+            val entry = requireEntry(conversationId)
+            append(LogFormat.MESSAGE, conversationId) {
+                putByte(role.ordinal)
+                putText(text, codec)
+            }
+            (entry.messages.size - 1).also { if (streaming) this.streaming[conversationId to it] = text.length }
+        }
+        _changes.emit(ConversationChange.MessageChanged(conversationId, messageIndex, text, text.length))
+        return messageIndex
+    }
+
+    /** Appends streamed text to the end of an existing message. */
+    suspend fun appendChunk(conversationId: Long, messageIndex: Int, text: String) {
+        val length = mutex.withLock {
+            val entry = requireEntry(conversationId)
+            require(messageIndex in entry.messages.indices) { "no message $messageIndex in $conversationId" }
+            append(LogFormat.CHUNK, conversationId) {
+                putInt(messageIndex)
+                putText(text, codec)
+            }
+            val key = conversationId to messageIndex
+            val known = streaming[key]
+            if (known != null) {
+                (known + text.length).also { streaming[key] = it }
+            } else {
+                // Only streaming messages keep their length; anything else is measured here.
+                readText(log, entry.messages[messageIndex].records, dictionaries).length
+            }
+        }
+        _changes.emit(ConversationChange.MessageChanged(conversationId, messageIndex, text, length))
+    }
+
+    /** Marks a streaming message as complete, which ends every [follow] of it. */
+    suspend fun finishMessage(conversationId: Long, messageIndex: Int) {
+        val finished = mutex.withLock { streaming.remove(conversationId to messageIndex) != null }
+        if (finished) _changes.emit(ConversationChange.MessageFinished(conversationId, messageIndex))
+    }
+
+    suspend fun delete(conversationId: Long) {
+        val messageCount = mutex.withLock {
+            val count = requireEntry(conversationId).messages.size
+            append(LogFormat.DELETE, conversationId) { 0 }
+            streaming.keys.removeAll { it.first == conversationId }
+            count
+        }
+        _changes.emit(ConversationChange.Deleted(conversationId, messageCount))
+    }
+
+    /** Most recently updated conversations first. */
+    suspend fun recent(limit: Int = 50): List<ConversationSummary> = mutex.withLock {
+        index.recent(limit).map { it.summary() }
+    }
+
+    suspend fun conversation(conversationId: Long): ConversationSummary? = mutex.withLock {
+        index[conversationId]?.summary()
+    }
+
+    suspend fun messages(conversationId: Long): List<Message> = mutex.withLock {
+        val entry = index[conversationId] ?: return@withLock emptyList()
+        entry.messages.mapIndexed { i, message ->
+            Message(conversationId, i, message.role, readText(log, message.records, dictionaries), message.createdAt)
+        }
+    }
+
+    suspend fun message(conversationId: Long, index: Int): Message? = mutex.withLock {
+        val message = this.index[conversationId]?.messages?.getOrNull(index) ?: return@withLock null
+        Message(conversationId, index, message.role, readText(log, message.records, dictionaries), message.createdAt)
+    }
+
+    /**
+     * A message's text as it streams in: what it has so far, then each appended piece, taken
+     * from [changes] without reading the message again. The flow completes as soon as the
+     * message is finished (at once if it isn't streaming) or deleted.
+     */
+    fun follow(conversationId: Long, messageIndex: Int): Flow<CharSequence> = follow(conversationId, messageIndex, changes)
+
+    internal fun follow(conversationId: Long, messageIndex: Int, source: Flow<ConversationChange>): Flow<CharSequence> = channelFlow {
+        val updates = Channel<ConversationChange>(Channel.UNLIMITED)
+        val watcher = launch(start = CoroutineStart.UNDISPATCHED) {
+            source.collect { if (it.conversationId == conversationId) updates.send(it) }
+        }
+        try {
+            val (text, open) = mutex.withLock {
+                val message = index[conversationId]?.messages?.getOrNull(messageIndex) ?: return@withLock null
+                readText(log, message.records, dictionaries) to ((conversationId to messageIndex) in streaming)
+            } ?: return@channelFlow
+            if (text.isNotEmpty()) send(text)
+            if (!open) return@channelFlow
+            var sent = text.length
+            for (change in updates) {
+                when (change) {
+                    // Changes applied before the text was read are already part of it.
+                    is ConversationChange.MessageChanged -> if (change.messageIndex == messageIndex && change.length > sent) {
+                        if (change.follows(sent)) {
+                            send(change.appended)
+                            sent = change.length
+                        } else {
+                            // A change was missed or came out of order: catch up from the stored text.
+                            val stored = message(conversationId, messageIndex)?.text ?: break
+                            if (stored.length > sent) send(stored.substring(sent))
+                            sent = maxOf(sent, stored.length)
+                        }
+                    }
+                    is ConversationChange.MessageFinished -> if (change.messageIndex == messageIndex) break
+                    is ConversationChange.Deleted -> break
+                }
+            }
+        } finally {
+            watcher.cancel()
+        }
+    }
+
+    /** Suspends until everything appended so far has been synced to stable storage. */
+    suspend fun awaitDurable() {
+        mutex.withLock { pendingCommit }?.await()
+    }
+
+    /**
+     * Trains a compression dictionary on recent messages, then compacts so that existing
+     * records are recompressed with it.
+     */
+    suspend fun trainDictionary() {
+        val (samples, nextId) = mutex.withLock {
+            val samples = ArrayList<ByteArray>()
+            var sampled = 0
+            sampling@ for (entry in index.recent(Int.MAX_VALUE)) {
+                for (message in entry.messages) {
+                    if (sampled >= MAX_TRAINING_BYTES) break@sampling
+                    val text = readText(log, message.records, dictionaries).encodeToByteArray()
+                    val sample = if (text.size > MAX_TRAINING_BYTES - sampled) text.copyOf(MAX_TRAINING_BYTES - sampled) else text
+                    samples += sample
+                    sampled += sample.size
+                }
+            }
+            samples to (codec?.id ?: 0) + 1
+        }
+        if (samples.isEmpty() || nextId > 255) return
+        val dictionary = withContext(Dispatchers.Default) { DictionaryTrainer.train(samples) }
+        if (dictionary.isEmpty()) return
+
+        mutex.withLock {
+            val fileName = "$name.dict.$nextId"
+            storage.delete(fileName)
+            val file = storage.open(fileName)
+            file.append(dictionary)
+            file.sync()
+            file.close()
+            val trained = DictionaryCodec(nextId, dictionary)
+            dictionaries = dictionaries + (nextId to trained)
+            codec = trained
+        }
+        compact()
+    }
+
+    /**
+     * Rewrites the log with only live conversations, one record per message. Appends made
+     * while the copy runs are carried over at the end.
+     */
+    suspend fun compact() = compactionMutex.withLock {
+        withContext(Dispatchers.Default) { compactLocked() }
+    }
+
+    private suspend fun compactLocked() {
+        val (cutoff, live) = mutex.withLock {
+            log.flush()
+            log.size to index.oldestFirst().map { Snapshot(it) }
+        }
+        val (sourceDictionaries, targetCodec) = mutex.withLock { dictionaries to codec }
+
+        val compactName = "$logName.compact"
+        storage.delete(compactName)
+        val out = storage.open(compactName)
+        val newGeneration = Random.nextLong()
+        out.append(fileHeader(newGeneration))
+        val newIndex = ConversationIndex()
+        val source = storage.open(logName)
+        try {
+            for (conversation in live) {
+                writeRecord(out, newIndex, LogFormat.CREATE, conversation.id, conversation.createdAt) {
+                    putBytes(conversation.title.encodeToByteArray())
+                    0
+                }
+                for (message in conversation.messages) {
+                    val text = readText(source, message.records, sourceDictionaries)
+                    writeRecord(out, newIndex, LogFormat.MESSAGE, conversation.id, message.createdAt) {
+                        putByte(message.role.ordinal)
+                        putText(text, targetCodec)
+                    }
+                }
+                newIndex[conversation.id]?.updatedAt = conversation.updatedAt
+            }
+        } finally {
+            source.close()
+        }
+
+        mutex.withLock {
+            log.flush()
+            replay(log, cutoff) { body, length, _ ->
+                val position = out.append(lengthAndCrc(body, length))
+                out.append(body, 0, length)
+                newIndex.apply(body, 0, length, position)
+            }
+            // Ids of conversations deleted since they were created have no record left to replay.
+            newIndex.nextId = maxOf(newIndex.nextId, index.nextId)
+            out.sync()
+            out.close()
+            log.close()
+            storage.rename(compactName, logName)
+            log = storage.open(logName)
+            generation = newGeneration
+            index = newIndex
+            writeSnapshot()
+        }
+    }
+
+    /** Syncs pending appends, writes an index snapshot for fast reopening and closes the log. */
+    suspend fun close() {
+        training?.join()
+        compaction?.join()
+        mutex.withLock {
+            log.sync()
+            writeSnapshot()
+            log.close()
+            pendingCommit?.complete(Unit)
+            pendingCommit = null
+        }
+    }
+
+    private fun requireEntry(conversationId: Long): ConversationIndex.Entry =
+        requireNotNull(index[conversationId]) { "no conversation $conversationId" }
+
+    /** [payload] writes the record payload and returns its flags. */
+    private inline fun append(type: Int, conversationId: Long, payload: ByteBuilder.() -> Int) {
+        record.clear()
+        record.putInt(0).putInt(0).putByte(type).putByte(0).putLong(conversationId).putLong(epochMillis())
+        record.setByte(LogFormat.RECORD_HEADER + 1, record.payload())
+        val length = record.size - LogFormat.RECORD_HEADER
+        record.setInt(0, length)
+        record.setInt(4, Crc32.of(record.bytes, LogFormat.RECORD_HEADER, length))
+        val offset = log.append(record.bytes, 0, record.size)
+        index.apply(record.bytes, LogFormat.RECORD_HEADER, length, offset)
+        scheduleCommit()
+        maybeCompact()
+        maybeTrain()
+    }
+
+    private fun scheduleCommit() {
+        if (pendingCommit != null) return
+        val commit = CompletableDeferred<Unit>()
+        pendingCommit = commit
+        scope.launch(Dispatchers.Default) {
+            delay(commitInterval)
+            try {
+                mutex.withLock {
+                    // Already synced by close() otherwise.
+                    if (pendingCommit !== commit) return@withLock
+                    // Appends from here on join the next group.
+                    pendingCommit = null
+                    log.sync()
+                    if (log.size - snapshotEnd >= SNAPSHOT_INTERVAL_BYTES) writeSnapshot()
+                }
+                commit.complete(Unit)
+            } catch (e: Throwable) {
+                commit.completeExceptionally(e)
+                throw e
+            }
+        }
+    }
+
+    private fun maybeCompact() {
+        if (compaction?.isActive == true) return
+        if (index.compactableBytes < COMPACTION_MIN_BYTES || index.compactableBytes * 2 < log.size) return
+        compaction = scope.launch { compact() }
+    }
+
+    private fun maybeTrain() {
+        if (codec != null || training?.isActive == true || log.size < trainAtLogBytes) return
+        // Training finds nothing to share in some histories, e.g. a few long messages; it is
+        // retried only once there is substantially more to sample.
+        trainAtLogBytes = log.size + TRAINING_MIN_LOG_BYTES
+        training = scope.launch { trainDictionary() }
+    }
+
+    private fun readText(file: ByteFile, records: List<Long>, dictionaries: Map<Int, DictionaryCodec>): String {
+        val text = StringBuilder()
+        val header = ByteArray(LogFormat.RECORD_HEADER)
+        for (offset in records) {
+            file.read(offset, header)
+            val body = file.readBytes(offset + LogFormat.RECORD_HEADER, header.getIntLe(0))
+            val start = LogFormat.textStart(LogFormat.type(body, 0))
+            if ((LogFormat.flags(body, 0) and LogFormat.FLAG_COMPRESSED) != 0) {
+                val dictionary = dictionaries[body[start].toInt() and 0xFF]
+                    ?: error("record at $offset uses missing dictionary ${body[start]}")
+                text.append(dictionary.decompress(body, start + 1, body.size - start - 1).decodeToString())
+            } else {
+                text.append(body.decodeToString(start, body.size))
+            }
+        }
+        return text.toString()
+    }
+
+    /** Writes [text], compressed when that pays off, and returns the record flags. */
+    private fun ByteBuilder.putText(text: String, codec: DictionaryCodec?): Int {
+        val utf8 = text.encodeToByteArray()
+        if (codec != null && utf8.size >= MIN_COMPRESSED_TEXT) {
+            val compressed = codec.compress(utf8)
+            if (compressed.size + 1 < utf8.size) {
+                putByte(codec.id)
+                putBytes(compressed)
+                return LogFormat.FLAG_COMPRESSED
+            }
+        }
+        putBytes(utf8)
+        return 0
+    }
+
+    private inline fun writeRecord(
+        out: ByteFile,
+        target: ConversationIndex,
+        type: Int,
+        conversationId: Long,
+        timestamp: Long,
+        payload: ByteBuilder.() -> Int,
+    ) {
+        val body = ByteBuilder(64)
+        body.putByte(type).putByte(0).putLong(conversationId).putLong(timestamp)
+        body.setByte(1, body.payload())
+        val position = out.append(lengthAndCrc(body.bytes, body.size))
+        out.append(body.bytes, 0, body.size)
+        target.apply(body.bytes, 0, body.size, position)
+    }
+
+    private fun lengthAndCrc(body: ByteArray, length: Int): ByteArray {
+        val header = ByteArray(LogFormat.RECORD_HEADER)
+        header.putIntLe(0, length)
+        header.putIntLe(4, Crc32.of(body, 0, length))
+        return header
+    }
+
+    private fun recover() {
+        loadDictionaries()
+        log = storage.open(logName)
+        val header = ByteArray(LogFormat.FILE_HEADER)
+        val valid = log.size >= LogFormat.FILE_HEADER && run {
+            log.read(0, header)
+            header.getIntLe(0) == LogFormat.MAGIC && header.getIntLe(4) == LogFormat.VERSION
+        }
+        if (!valid) {
+            log.truncate(0)
+            generation = Random.nextLong()
+            log.append(fileHeader(generation))
+            log.sync()
+            storage.delete(indexName)
+            return
+        }
+        generation = header.getLongLe(8)
+
+        var start = LogFormat.FILE_HEADER.toLong()
+        loadSnapshot()?.let { (snapshot, logEnd) ->
+            index = snapshot
+            start = logEnd
+        }
+        snapshotEnd = start
+        val end = replay(log, start) { body, length, offset -> index.apply(body, 0, length, offset) }
+        if (end < log.size) log.truncate(end)
+    }
+
+    /**
+     * Visits the valid records of [file] from [start] and returns the offset just past the last
+     * one. Stops at the first torn or corrupt record.
+     */
+    private inline fun replay(
+        file: ByteFile,
+        start: Long,
+        visit: (body: ByteArray, length: Int, offset: Long) -> Unit,
+    ): Long {
+        val header = ByteArray(LogFormat.RECORD_HEADER)
+        var body = ByteArray(256)
+        var position = start
+        while (position + LogFormat.RECORD_HEADER <= file.size) {
+            file.read(position, header)
+            val length = header.getIntLe(0)
+            if (length < LogFormat.BODY_FIXED || position + LogFormat.RECORD_HEADER + length > file.size) break
+            if (length > body.size) body = ByteArray(maxOf(length, body.size * 2))
+            file.read(position + LogFormat.RECORD_HEADER, body, 0, length)
+            if (Crc32.of(body, 0, length) != header.getIntLe(4)) break
+            visit(body, length, position)
+            position += LogFormat.RECORD_HEADER + length
+        }
+        return position
+    }
+
+    private fun loadDictionaries() {
+        val loaded = HashMap<Int, DictionaryCodec>()
+        var id = 1
+        while (id <= 255 && storage.exists("$name.dict.$id")) {
+            val file = storage.open("$name.dict.$id")
+            loaded[id] = DictionaryCodec(id, file.readBytes(0, file.size.toInt()))
+            file.close()
+            id++
+        }
+        dictionaries = loaded
+        codec = loaded[id - 1]
+    }
+
+    private fun loadSnapshot(): Pair<ConversationIndex, Long>? {
+        if (!storage.exists(indexName)) return null
+        val file = storage.open(indexName)
+        return try {
+            val bytes = file.readBytes(0, file.size.toInt())
+            if (bytes.size < SNAPSHOT_HEADER + 4) return null
+            val crc = bytes.getIntLe(bytes.size - 4)
+            if (Crc32.of(bytes, 0, bytes.size - 4) != crc) return null
+            val input = ByteReader(bytes, limit = bytes.size - 4)
+            if (input.int() != SNAPSHOT_MAGIC || input.long() != generation) return null
+            val logEnd = input.long()
+            if (logEnd > log.size) return null
+            ConversationIndex.readFrom(input) to logEnd
+        } catch (e: RuntimeException) {
+            null
+        } finally {
+            file.close()
+        }
+    }
+
+    private fun writeSnapshot() {
+        log.flush()
+        val out = ByteBuilder(4096)
+        out.putInt(SNAPSHOT_MAGIC).putLong(generation).putLong(log.size)
+        index.writeTo(out)
+        out.putInt(Crc32.of(out.bytes, 0, out.size))
+
+        val tmpName = "$indexName.tmp"
+        storage.delete(tmpName)
+        val file = storage.open(tmpName)
+        file.append(out.bytes, 0, out.size)
+        file.sync()
+        file.close()
+        storage.rename(tmpName, indexName)
+        snapshotEnd = log.size
+    }
+
+    private fun fileHeader(generation: Long): ByteArray {
+        val header = ByteArray(LogFormat.FILE_HEADER)
+        header.putIntLe(0, LogFormat.MAGIC)
+        header.putIntLe(4, LogFormat.VERSION)
+        header.putLongLe(8, generation)
+        return header
+    }
+
+    private class Snapshot(entry: ConversationIndex.Entry) {
+        val id = entry.id
+        val title = entry.title
+        val createdAt = entry.createdAt
+        val updatedAt = entry.updatedAt
+        val messages = entry.messages.map { MessageRecords(it.role, it.createdAt, it.records.toList()) }
+
+        class MessageRecords(val role: Role, val createdAt: Long, val records: List<Long>)
+    }
+
+    companion object {
+        private const val SNAPSHOT_MAGIC = 0x4943414D // "MACI"
+        private const val SNAPSHOT_HEADER = 20
+        private const val COMPACTION_MIN_BYTES = 1L shl 20
+        private const val SNAPSHOT_INTERVAL_BYTES = 256L shl 10
+        private const val TRAINING_MIN_LOG_BYTES = 256L shl 10
+        private const val MAX_TRAINING_BYTES = 1 shl 20
+        private const val MIN_COMPRESSED_TEXT = 32
+
+        suspend fun open(
+            storage: Storage,
+            scope: CoroutineScope,
+            name: String = "conversations",
+            commitInterval: Duration = 50.milliseconds,
+        ): ConversationStore = withContext(Dispatchers.Default) {
+            ConversationStore(storage, name, scope, commitInterval).also { it.recover() }
+        }
+    }
+}
@@ -0,0 +1,33 @@
+package org.kgajjar.mobileai.chat
+
+import org.kgajjar.mobileai.vision.Photo
+
+/**
+ * Photos attached to a message. They are kept in the message text as leading Markdown image
+ * lines, `![photo](<uri> "modifiedAt")`, so attachments need no change to the store's record
+ * format and survive export as readable text.
+ */
+object MessageImages {
+    private val LINE = Regex("""!\[photo]\(<([^>\n]*)> "(-?\d+)"\)""")
+
+    fun attach(photos: List<Photo>, text: String): String {
+        if (photos.isEmpty()) return text
+        val out = StringBuilder()
+        for (photo in photos) out.append("![photo](<").append(photo.uri).append("> \"").append(photo.modifiedAt).append("\")\n")
+        return out.append(text).toString()
+    }
+
+    /** The photos attached to [text], and the text without them. */
+    fun split(text: String): Pair<List<Photo>, String> {
+        val photos = ArrayList<Photo>()
+        var start = 0
+        while (true) {
+            val end = text.indexOf('\n', start).let { if (it < 0) text.length else it }
+            val match = LINE.matchEntire(text.subSequence(start, end)) ?: break
+            photos += Photo(match.groupValues[1], match.groupValues[2].toLong())
+            start = minOf(end + 1, text.length)
+            if (end == text.length) break
+        }
+        return photos to text.substring(start)
+    }
+}
@@ -0,0 +1,141 @@
+package org.kgajjar.mobileai.collections
+
+import org.kgajjar.mobileai.storage.ByteBuilder
+import org.kgajjar.mobileai.storage.ByteReader
+
+/**
+ * Immutable trie over strings in double-array form.
+ *
+ * Every state is three consecutive ints in one array: `base`, `check` (the parent state, or -1
+ * for a free cell) and the value stored at the state (-1 if no key ends there). Following
+ * character `c` from state `s` goes to `t = base(s) + c + 1`, valid iff `check(t) == s`, so a
+ * step is two reads from the same small array with no pointers or per-node objects.
+ */
+class DoubleArrayTrie private constructor(private val cells: IntArray) {
+    private val stateCount = cells.size / 3
+
+    /** The value of [key], or -1. */
+    operator fun get(key: CharSequence): Int {
+        var state = 0
+        for (c in key) {
+            state = next(state, c)
+            if (state < 0) return -1
+        }
+        return cells[state * 3 + 2]
+    }
+
+    /**
+     * The longest key that is a prefix of `text[start, end)`, as `length shl 32 or value`, or
+     * -1 if there is none.
+     */
+    fun longestMatch(text: CharSequence, start: Int, end: Int): Long {
+        var state = 0
+        var best = -1L
+        var i = start
+        while (i < end) {
+            state = next(state, text[i++])
+            if (state < 0) break
+            val value = cells[state * 3 + 2]
+            if (value >= 0) best = ((i - start).toLong() shl 32) or value.toLong()
+        }
+        return best
+    }
+
+    fun writeTo(out: ByteBuilder) {
+        out.putInt(cells.size)
+        for (cell in cells) out.putInt(cell)
+    }
+
+    private fun next(state: Int, c: Char): Int {
+        val t = cells[state * 3] + c.code + 1
+        return if (t < stateCount && cells[t * 3 + 1] == state) t else -1
+    }
+
+    companion object {
+        fun readFrom(input: ByteReader): DoubleArrayTrie = DoubleArrayTrie(IntArray(input.int()) { input.int() })
+
+        /** Builds a trie mapping `keys[i]` to `values[i]` (non-negative). Keys must be distinct. */
+        fun build(keys: List<String>, values: IntArray): DoubleArrayTrie {
+            require(keys.size == values.size) { "${keys.size} keys, ${values.size} values" }
+            val order = keys.indices.sortedBy { keys[it] }
+            val builder = Builder()
+            if (order.isNotEmpty()) builder.place(0, keys, values, order, 0, order.size, 0)
+            return DoubleArrayTrie(builder.cells.copyOf(builder.used * 3))
+        }
+    }
+
+    private class Builder {
+        var cells = IntArray(3 * 64).also { fillFree(it, 0) }
+        var used = 1
+        private var firstFree = 1
+
+        init {
+            cells[1] = -2 // the root has no parent
+        }
+
+        /** Fills state [state] with the keys `order[from, to)`, which share their first [depth] chars. */
+        fun place(state: Int, keys: List<String>, values: IntArray, order: List<Int>, from: Int, to: Int, depth: Int) {
+            var i = from
+            if (keys[order[i]].length == depth) {
+                cells[state * 3 + 2] = values[order[i]]
+                i++
+            }
+            if (i == to) return
+            val labels = IntArrayList()
+            for (k in i until to) {
+                val label = keys[order[k]][depth].code
+                if (labels.size == 0 || labels.last() != label) labels.add(label)
+            }
+            val base = findBase(labels)
+            cells[state * 3] = base
+            for (l in 0 until labels.size) {
+                val t = base + labels[l] + 1
+                cells[t * 3 + 1] = state
+                used = maxOf(used, t + 1)
+            }
+            while (true) {
+                ensure(firstFree + 1)
+                if (cells[firstFree * 3 + 1] == -1) break
+                firstFree++
+            }
+            var groupStart = i
+            for (l in 0 until labels.size) {
+                var groupEnd = groupStart
+                while (groupEnd < to && keys[order[groupEnd]][depth].code == labels[l]) groupEnd++
+                place(base + labels[l] + 1, keys, values, order, groupStart, groupEnd, depth + 1)
+                groupStart = groupEnd
+            }
+        }
+
+        private fun findBase(labels: IntArrayList): Int {
+            var base = maxOf(0, firstFree - labels[0] - 1)
+            while (true) {
+                ensure(base + labels.last() + 2)
+                var fits = true
+                for (l in 0 until labels.size) {
+                    if (cells[(base + labels[l] + 1) * 3 + 1] != -1) {
+                        fits = false
+                        break
+                    }
+                }
+                if (fits) return base
+                base++
+            }
+        }
+
+        private fun ensure(states: Int) {
+            if (states * 3 <= cells.size) return
+            val old = cells.size
+            cells = cells.copyOf(maxOf(states * 3, old * 2))
+            fillFree(cells, old / 3)
+        }
+
+        private fun fillFree(array: IntArray, fromState: Int) {
+            for (s in fromState until array.size / 3) {
+                array[s * 3] = 0
+                array[s * 3 + 1] = -1
+                array[s * 3 + 2] = -1
+            }
+        }
+    }
+}
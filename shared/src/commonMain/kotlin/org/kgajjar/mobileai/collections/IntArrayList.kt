@@ -0,0 +1,55 @@
+package org.kgajjar.mobileai.collections
+
+/**
+ * Growable list of primitive ints. Used on hot paths (token ids, offsets) where boxing a
+ * `MutableList<Int>` would dominate the cost of the work itself.
+ */
+class IntArrayList(initialCapacity: Int = 16) {
+    private var data = IntArray(maxOf(initialCapacity, 1))
+
+    var size: Int = 0
+        private set
+
+    operator fun get(index: Int): Int {
+        if (index !in 0 until size) throw IndexOutOfBoundsException("index $index, size $size")
+        return data[index]
+    }
+
+    operator fun set(index: Int, value: Int) {
+        if (index !in 0 until size) throw IndexOutOfBoundsException("index $index, size $size")
+        data[index] = value
+    }
+
+    fun add(value: Int) {
+        ensureCapacity(size + 1)
+        data[size++] = value
+    }
+
+    fun addAll(values: IntArray, from: Int = 0, to: Int = values.size) {
+        ensureCapacity(size + (to - from))
+        values.copyInto(data, size, from, to)
+        size += to - from
+    }
+
+    fun last(): Int = get(size - 1)
+
+    fun removeLast(): Int {
+        val value = last()
+        size--
+        return value
+    }
+
+    fun clear() {
+        size = 0
+    }
+
+    fun isEmpty(): Boolean = size == 0
+
+    fun toIntArray(from: Int = 0, to: Int = size): IntArray = data.copyOfRange(from, to)
+
+    private fun ensureCapacity(capacity: Int) {
+        if (capacity > data.size) {
+            data = data.copyOf(maxOf(capacity, data.size * 2))
+        }
+    }
+}
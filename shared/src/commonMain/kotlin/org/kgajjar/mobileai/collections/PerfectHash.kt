@@ -0,0 +1,64 @@
+package org.kgajjar.mobileai.collections
+
+import org.kgajjar.mobileai.storage.ContentHash
+
+/**
+ * Minimal perfect hashing over a fixed set of 64-bit key hashes (hash and displace).
+ *
+ * Keys are split into buckets by the high bits of their hash; buckets are then placed largest
+ * first, each trying displacements until every key in it lands on a free slot. A lookup is one
+ * bucket read and one slot read, with no probing, and the tables are two flat int arrays that
+ * can be stored in a file and used in place. The caller verifies the key found in the slot,
+ * since a hash that was not in the set still maps to some slot.
+ */
+object PerfectHash {
+    /** [displacements] per bucket, and for each slot the index of the key placed there. */
+    class Table(val displacements: IntArray, val keys: IntArray)
+
+    fun bucketCount(keyCount: Int): Int = keyCount / 4 + 1
+
+    fun bucket(hash: Long, bucketCount: Int): Int = ((hash ushr 33) % bucketCount).toInt()
+
+    fun slot(hash: Long, displacement: Int, slotCount: Int): Int =
+        ((ContentHash.mix(hash + displacement * DISPLACEMENT_STEP) ushr 1) % slotCount).toInt()
+
+    /** Fails if two hashes are equal; the caller dedups keys first. */
+    fun build(hashes: LongArray): Table {
+        val n = hashes.size
+        val bucketCount = bucketCount(n)
+        val sorted = hashes.copyOf().also { it.sort() }
+        for (i in 1 until n) require(sorted[i] != sorted[i - 1]) { "duplicate key hash" }
+
+        val members = Array(bucketCount) { IntArrayList(4) }
+        for (k in 0 until n) members[bucket(hashes[k], bucketCount)].add(k)
+        val order = (0 until bucketCount).sortedByDescending { members[it].size }
+
+        val displacements = IntArray(bucketCount)
+        val keys = IntArray(n) { -1 }
+        var tried = IntArray(8)
+        for (b in order) {
+            val bucket = members[b]
+            if (bucket.size == 0) break
+            if (tried.size < bucket.size) tried = IntArray(bucket.size)
+            var d = 0
+            while (true) {
+                var fits = true
+                for (i in 0 until bucket.size) {
+                    val s = slot(hashes[bucket[i]], d, n)
+                    if (keys[s] >= 0 || (0 until i).any { tried[it] == s }) {
+                        fits = false
+                        break
+                    }
+                    tried[i] = s
+                }
+                if (fits) break
+                d++
+            }
+            displacements[b] = d
+            for (i in 0 until bucket.size) keys[tried[i]] = bucket[i]
+        }
+        return Table(displacements, keys)
+    }
+
+    private const val DISPLACEMENT_STEP = -0x61c8864680b583ebL // 2^64 / golden ratio
+}
@@ -0,0 +1,65 @@
+package org.kgajjar.mobileai.collections
+
+/**
+ * Binary heap of `(score, value)` pairs in parallel primitive arrays. With [maxFirst] the
+ * highest score is on top, otherwise the lowest.
+ */
+class ScoredHeap(private val maxFirst: Boolean, initialCapacity: Int = 16) {
+    private var scores = FloatArray(maxOf(initialCapacity, 1))
+    private var values = IntArray(maxOf(initialCapacity, 1))
+
+    var size: Int = 0
+        private set
+
+    fun isEmpty(): Boolean = size == 0
+
+    fun topScore(): Float = scores[0]
+
+    fun topValue(): Int = values[0]
+
+    fun push(score: Float, value: Int) {
+        if (size == scores.size) {
+            scores = scores.copyOf(size * 2)
+            values = values.copyOf(size * 2)
+        }
+        var i = size++
+        while (i > 0) {
+            val parent = (i - 1) ushr 1
+            if (!before(score, scores[parent])) break
+            scores[i] = scores[parent]
+            values[i] = values[parent]
+            i = parent
+        }
+        scores[i] = score
+        values[i] = value
+    }
+
+    /** Removes the top entry and returns its value. */
+    fun pop(): Int {
+        val top = values[0]
+        size--
+        if (size > 0) siftDown(scores[size], values[size])
+        return top
+    }
+
+    fun clear() {
+        size = 0
+    }
+
+    private fun siftDown(score: Float, value: Int) {
+        var i = 0
+        while (true) {
+            var child = 2 * i + 1
+            if (child >= size) break
+            if (child + 1 < size && before(scores[child + 1], scores[child])) child++
+            if (!before(scores[child], score)) break
+            scores[i] = scores[child]
+            values[i] = values[child]
+            i = child
+        }
+        scores[i] = score
+        values[i] = value
+    }
+
+    private fun before(a: Float, b: Float): Boolean = if (maxFirst) a > b else a < b
+}
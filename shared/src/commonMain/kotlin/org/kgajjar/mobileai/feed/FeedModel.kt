@@ -0,0 +1,71 @@
+package org.kgajjar.mobileai.feed
+
+import org.kgajjar.mobileai.ranking.TreeEnsemble
+import org.kgajjar.mobileai.ranking.TreeEnsemble.Leaf
+import org.kgajjar.mobileai.ranking.TreeEnsemble.Split
+
+/** Feature layout shared by [HomeFeed] and the ranking model it scores with. */
+object FeedFeatures {
+    /** Cosine similarity between the candidate and the user's interest vector. */
+    const val AFFINITY = 0
+
+    /** Position in the retrieval result, divided by the number of candidates. */
+    const val RETRIEVAL_RANK = 1
+
+    /** Days since the conversation was last updated; 0 for prompts. */
+    const val AGE_DAYS = 2
+
+    const val IS_PROMPT = 3
+
+    const val MESSAGE_COUNT = 4
+
+    /** Decayed interaction weight behind the interest vector. */
+    const val PROFILE_MASS = 5
+
+    const val COUNT = 6
+}
+
+/**
+ * Default home feed ranker: a small hand-tuned ensemble in the same format a trained model would
+ * use, so one can be dropped in through [HomeFeed]'s constructor once we have logged data.
+ */
+object FeedModel {
+    val default: TreeEnsemble by lazy {
+        with(FeedFeatures) {
+            TreeEnsemble(
+                featureCount = COUNT,
+                trees = listOf(
+                    // Relevance to current interests dominates once there is a profile.
+                    TreeEnsemble.tree(
+                        Split(
+                            AFFINITY, 0.15f,
+                            Split(IS_PROMPT, 0.5f, Leaf(0.1f), Leaf(0.2f)),
+                            Split(AFFINITY, 0.4f, Leaf(0.6f), Leaf(1.0f)),
+                        )
+                    ),
+                    // Fresh conversations are worth resuming, especially with little profile to go on.
+                    TreeEnsemble.tree(
+                        Split(
+                            IS_PROMPT, 0.5f,
+                            Split(
+                                AGE_DAYS, 2f,
+                                Split(PROFILE_MASS, 1f, Leaf(0.5f), Leaf(0.25f)),
+                                Split(AGE_DAYS, 14f, Leaf(0.1f), Leaf(-0.2f)),
+                            ),
+                            Split(PROFILE_MASS, 1f, Leaf(0.3f), Leaf(0.0f)),
+                        )
+                    ),
+                    // Longer threads are likelier to be worth returning to than one-off questions.
+                    TreeEnsemble.tree(
+                        Split(
+                            IS_PROMPT, 0.5f,
+                            Split(MESSAGE_COUNT, 4f, Leaf(-0.05f), Leaf(0.1f)),
+                            Leaf(0f),
+                        )
+                    ),
+                    TreeEnsemble.tree(Split(RETRIEVAL_RANK, 0.25f, Leaf(0.1f), Leaf(0f))),
+                ),
+            )
+        }
+    }
+}
@@ -0,0 +1,196 @@
+package org.kgajjar.mobileai.feed
+
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.sync.Mutex
+import kotlinx.coroutines.sync.withLock
+import kotlinx.coroutines.withContext
+import org.kgajjar.mobileai.chat.ConversationStore
+import org.kgajjar.mobileai.chat.ConversationSummary
+import org.kgajjar.mobileai.epochMillis
+import org.kgajjar.mobileai.personalization.Personalizer
+import org.kgajjar.mobileai.ranking.CompiledEnsemble
+import org.kgajjar.mobileai.ranking.TreeEnsemble
+import org.kgajjar.mobileai.search.VectorIndex
+import org.kgajjar.mobileai.storage.ByteBuilder
+import org.kgajjar.mobileai.storage.ByteReader
+import org.kgajjar.mobileai.storage.ContentHash
+import org.kgajjar.mobileai.storage.Crc32
+import org.kgajjar.mobileai.storage.Storage
+import org.kgajjar.mobileai.storage.getIntLe
+import org.kgajjar.mobileai.storage.readBytes
+
+sealed interface FeedItem {
+    val score: Float
+
+    data class Conversation(val summary: ConversationSummary, override val score: Float) : FeedItem
+
+    data class Prompt(val text: String, override val score: Float) : FeedItem
+}
+
+/**
+ * Builds the home feed in two stages: candidate retrieval and ranking.
+ *
+ * Recent conversations and suggested prompts are embedded into a [VectorIndex] and the
+ * candidates nearest the user's interest vector are retrieved from it; without a profile, the
+ * most recent conversations and every prompt are candidates instead. Each candidate is then
+ * described by [FeedFeatures] and the whole batch is scored by [ranker], compiled once per feed.
+ *
+ * The index is kept in `<name>.vec` along with a hash of the text behind each entry, so a launch
+ * only embeds conversations that are new or renamed since the last one. It is rebuilt once
+ * replaced and removed entries outnumber the live ones.
+ */
+class HomeFeed(
+    private val store: ConversationStore,
+    private val personalizer: Personalizer,
+    private val storage: Storage,
+    private val ranker: TreeEnsemble = FeedModel.default,
+    private val prompts: List<String> = DEFAULT_PROMPTS,
+    private val name: String = "feed",
+) {
+    init {
+        require(ranker.featureCount == FeedFeatures.COUNT) { "ranker expects ${ranker.featureCount} features" }
+    }
+
+    private val compiled = CompiledEnsemble(ranker)
+    private val mutex = Mutex()
+    private var index: VectorIndex? = null
+
+    /** Hash of the text each indexed entry was embedded from, by id. */
+    private val embedded = HashMap<Long, Long>()
+
+    /** Entries replaced or removed since the index was built; they stay in the graph as tombstones. */
+    private var stale = 0
+
+    suspend fun compute(limit: Int = 8, now: Long = epochMillis()): List<FeedItem> {
+        val conversations = store.recent(MAX_CONVERSATIONS)
+        val interest = personalizer.interest()
+        val mass = personalizer.confidence().toFloat()
+
+        // Conversation ids are non-negative; prompt i is stored as -(i + 1).
+        val affinity = HashMap<Long, Float>()
+        val retrieved: List<Long> = if (interest == null) {
+            conversations.take(RETRIEVE).map { it.id } + prompts.indices.map { -(it + 1L) }
+        } else {
+            val candidates = conversations.map { it.id to it.title } + prompts.mapIndexed { i, prompt -> -(i + 1L) to prompt }
+            val nearest = withContext(Dispatchers.Default) {
+                mutex.withLock { update(candidates, interest.size).search(interest, RETRIEVE) }
+            }
+            nearest.map {
+                affinity[it.id] = it.score
+                it.id
+            }
+        }
+
+        val byId = conversations.associateBy { it.id }
+        val stride = FeedFeatures.COUNT
+        val matrix = FloatArray(retrieved.size * stride)
+        retrieved.forEachIndexed { rank, id ->
+            val row = rank * stride
+            matrix[row + FeedFeatures.AFFINITY] = affinity[id] ?: 0f
+            matrix[row + FeedFeatures.RETRIEVAL_RANK] = rank.toFloat() / retrieved.size
+            matrix[row + FeedFeatures.PROFILE_MASS] = mass
+            if (id < 0) {
+                matrix[row + FeedFeatures.IS_PROMPT] = 1f
+            } else {
+                val summary = byId.getValue(id)
+                matrix[row + FeedFeatures.AGE_DAYS] = (now - summary.updatedAt).coerceAtLeast(0) / DAY_MILLIS
+                matrix[row + FeedFeatures.MESSAGE_COUNT] = summary.messageCount.toFloat()
+            }
+        }
+        val scores = FloatArray(retrieved.size)
+        compiled.scoreBatch(matrix, retrieved.size, scores)
+        val items = retrieved.mapIndexed { i, id ->
+            if (id < 0) FeedItem.Prompt(prompts[(-id - 1).toInt()], scores[i])
+            else FeedItem.Conversation(byId.getValue(id), scores[i])
+        }
+        return items.sortedByDescending { it.score }.take(limit)
+    }
+
+    /** Brings the index in line with [candidates], saving it if anything changed. */
+    private fun update(candidates: List<Pair<Long, String>>, dimension: Int): VectorIndex {
+        var current = index ?: load(dimension) ?: VectorIndex(dimension)
+        if (stale > maxOf(current.size, MIN_REBUILD)) {
+            current = VectorIndex(dimension)
+            embedded.clear()
+            stale = 0
+        }
+        var changed = false
+        val present = HashSet<Long>(candidates.size)
+        for ((id, text) in candidates) {
+            present += id
+            val hash = ContentHash.of(text)
+            if (embedded[id] == hash) continue
+            if (id in embedded) stale++
+            current.add(id, personalizer.embed(text))
+            embedded[id] = hash
+            changed = true
+        }
+        for (id in embedded.keys.filter { it !in present }) {
+            current.remove(id)
+            embedded.remove(id)
+            stale++
+            changed = true
+        }
+        index = current
+        if (changed) save(current)
+        return current
+    }
+
+    private fun save(index: VectorIndex) {
+        val out = ByteBuilder(1024 + embedded.size * (16 + 4 * index.dimension))
+        out.putInt(MAGIC).putInt(stale).putInt(embedded.size)
+        for ((id, hash) in embedded) out.putLong(id).putLong(hash)
+        index.writeTo(out)
+        out.putInt(Crc32.of(out.bytes, 0, out.size))
+        val tmpName = "$name.vec.tmp"
+        storage.delete(tmpName)
+        val file = storage.open(tmpName)
+        file.append(out.bytes, 0, out.size)
+        file.sync()
+        file.close()
+        storage.rename(tmpName, "$name.vec")
+    }
+
+    /** The saved index, or null if there is none, it is damaged or it has other dimensions. */
+    private fun load(dimension: Int): VectorIndex? {
+        val fileName = "$name.vec"
+        if (!storage.exists(fileName)) return null
+        val file = storage.open(fileName)
+        val bytes = file.readBytes(0, file.size.toInt())
+        file.close()
+        if (bytes.size < 8 || Crc32.of(bytes, 0, bytes.size - 4) != bytes.getIntLe(bytes.size - 4)) return null
+        val input = ByteReader(bytes, limit = bytes.size - 4)
+        if (input.int() != MAGIC) return null
+        val savedStale = input.int()
+        val saved = HashMap<Long, Long>()
+        repeat(input.int()) { saved[input.long()] = input.long() }
+        val loaded = VectorIndex.readFrom(input)
+        if (loaded.dimension != dimension) return null
+        embedded.putAll(saved)
+        stale = savedStale
+        return loaded
+    }
+
+    companion object {
+        private const val MAX_CONVERSATIONS = 300
+        private const val RETRIEVE = 40
+        private const val DAY_MILLIS = 24f * 60 * 60 * 1000
+        private const val MAGIC = 0x44454546 // "FEED"
+        private const val MIN_REBUILD = 64
+
+        val DEFAULT_PROMPTS = listOf(
+            "Summarize an article for me",
+            "Help me plan my week",
+            "Explain a concept like I'm new to it",
+            "Draft a polite reply to an email",
+            "Suggest a recipe with what's in my fridge",
+            "Quiz me on a topic I'm learning",
+            "Brainstorm names for a project",
+            "Plan a weekend trip",
+            "Review a piece of code",
+            "Make a workout routine for beginners",
+            "Translate a short message",
+            "Write a short story opening",
+        )
+    }
+}
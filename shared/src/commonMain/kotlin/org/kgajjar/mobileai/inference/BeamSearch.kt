@@ -0,0 +1,127 @@
+package org.kgajjar.mobileai.inference
+
+import org.kgajjar.mobileai.collections.IntArrayList
+import org.kgajjar.mobileai.collections.ScoredHeap
+import org.kgajjar.mobileai.metrics.Metrics
+import org.kgajjar.mobileai.sampling.LogitConstraints
+import org.kgajjar.mobileai.trace.Trace
+import kotlin.math.exp
+import kotlin.math.ln
+import kotlin.math.pow
+import kotlin.time.TimeSource
+
+/**
+ * Beam search returning the n best continuations of a prompt.
+ *
+ * The prompt is run once; beams are forks of its KV sequence and share its blocks, and a beam
+ * that survives a step hands its sequence to its first child while further children fork it,
+ * so KV memory grows with divergence rather than with the beam width. Every step scores all
+ * live beams in one batched [LanguageModel.step] and keeps the best [beamWidth] candidates
+ * across them, found with a bounded heap. Scores are summed log-probabilities divided by
+ * `length ^ lengthPenalty`.
+ */
+class BeamSearch(
+    private val model: LanguageModel,
+    private val pool: KvBlockPool,
+    private val beamWidth: Int = 4,
+    private val lengthPenalty: Float = 1f,
+) {
+    class Hypothesis(val tokens: IntArray, val score: Float, val finished: Boolean)
+
+    private class Beam(val sequence: KvSequence, val tokens: IntArrayList, val logProb: Float)
+
+    private val vocabSize = model.vocabSize
+    private val logits = Array(beamWidth) { FloatArray(vocabSize) }
+
+    /** Up to [beamWidth] hypotheses, best first; ones cut off by [maxTokens] are not [Hypothesis.finished]. */
+    fun search(prompt: IntArray, endToken: Int, maxTokens: Int, constraints: LogitConstraints? = null): List<Hypothesis> {
+        require(prompt.isNotEmpty()) { "empty prompt" }
+        val root = pool.newSequence()
+        var beams = listOf(Beam(root, IntArrayList(), 0f))
+        val finished = ArrayList<Hypothesis>()
+        val started = TimeSource.Monotonic.markNow()
+        var lastToken = started
+        try {
+            Trace.span("prefill", "inference") {
+                for (token in prompt) {
+                    pool.append(root)
+                    model.step(listOf(root), intArrayOf(token), logits)
+                }
+            }
+            for (step in 0 until maxTokens) {
+                val candidates = bestCandidates(beams, constraints)
+                val now = TimeSource.Monotonic.markNow()
+                if (step == 0) Metrics.timeToFirstToken.record(now - started) else Metrics.interTokenLatency.record(now - lastToken)
+                lastToken = now
+                val used = BooleanArray(beams.size)
+                val next = ArrayList<Beam>(beamWidth)
+                for (candidate in candidates) {
+                    val p = candidate.first / vocabSize
+                    val parent = beams[p]
+                    val token = candidate.first % vocabSize
+                    val tokens = IntArrayList(parent.tokens.size + 1).apply {
+                        addAll(parent.tokens.toIntArray())
+                        add(token)
+                    }
+                    if (token == endToken) {
+                        finished += Hypothesis(tokens.toIntArray(), normalize(candidate.second, tokens.size), finished = true)
+                        continue
+                    }
+                    if (next.size == beamWidth) continue
+                    val sequence = if (!used[p]) parent.sequence.also { used[p] = true } else pool.fork(parent.sequence)
+                    next += Beam(sequence, tokens, candidate.second)
+                }
+                beams.forEachIndexed { i, beam -> if (!used[i]) pool.release(beam.sequence) }
+                beams = next
+                if (beams.isEmpty() || finished.size >= beamWidth) break
+                if (step == maxTokens - 1) break
+
+                val sequences = beams.map { it.sequence }
+                for (sequence in sequences) pool.append(sequence)
+                Trace.span("decode step", "inference") {
+                    model.step(sequences, IntArray(beams.size) { beams[it].tokens.last() }, logits)
+                }
+            }
+        } finally {
+            for (beam in beams) pool.release(beam.sequence)
+        }
+        for (beam in beams) finished += Hypothesis(beam.tokens.toIntArray(), normalize(beam.logProb, beam.tokens.size), finished = false)
+        return finished.sortedByDescending { it.score }.take(beamWidth)
+    }
+
+    /** `(beam * vocabSize + token, logProb)` of the best continuations of all beams, best first. */
+    private fun bestCandidates(beams: List<Beam>, constraints: LogitConstraints?): List<Pair<Int, Float>> {
+        // Each beam's end token may take a place, so keep enough to still fill the beam.
+        val keep = 2 * beamWidth
+        val heap = ScoredHeap(maxFirst = false, keep + 1)
+        for (b in beams.indices) {
+            val row = logits[b]
+            constraints?.apply(row, beams[b].tokens)
+            var max = Float.NEGATIVE_INFINITY
+            for (x in row) if (x > max) max = x
+            if (max == Float.NEGATIVE_INFINITY) continue
+            var sum = 0.0
+            for (x in row) sum += exp((x - max).toDouble())
+            val offset = beams[b].logProb - max - ln(sum).toFloat()
+            for (t in 0 until vocabSize) {
+                val score = row[t] + offset
+                if (score == Float.NEGATIVE_INFINITY) continue
+                if (heap.size < keep) {
+                    heap.push(score, b * vocabSize + t)
+                } else if (score > heap.topScore()) {
+                    heap.pop()
+                    heap.push(score, b * vocabSize + t)
+                }
+            }
+        }
+        val result = ArrayList<Pair<Int, Float>>(heap.size)
+        while (!heap.isEmpty()) {
+            val score = heap.topScore()
+            result += heap.pop() to score
+        }
+        result.reverse()
+        return result
+    }
+
+    private fun normalize(logProb: Float, length: Int): Float = logProb / length.toFloat().pow(lengthPenalty)
+}
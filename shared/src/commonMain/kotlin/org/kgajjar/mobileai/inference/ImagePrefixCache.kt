@@ -0,0 +1,62 @@
+package org.kgajjar.mobileai.inference
+
+/**
+ * KV cache prefixes of image prompts, keyed by a hash of the images they hold.
+ *
+ * The cache keeps one reference to each prefix's blocks and [acquire] hands out forks, so a
+ * follow-up question about the same image starts from the cached KV entries and shares them
+ * until it appends (see [KvBlockPool.fork]). Least recently used prefixes are released once
+ * the cache holds more than [maxBlocks] blocks; blocks still shared with a live sequence stay
+ * allocated until that sequence is released too. Prefixes of the same leading images share their first
+ * blocks, which count once. Not thread-safe.
+ */
+class ImagePrefixCache(private val pool: KvBlockPool, private val maxBlocks: Int) {
+    /** Iteration order is recency order: hits re-insert their entry at the end. */
+    private val prefixes = LinkedHashMap<Long, KvSequence>()
+    /** Cached prefixes referencing each pool block, and the blocks referenced by any. */
+    private val references = IntArray(pool.capacity)
+    private var blocks = 0
+
+    var hits: Long = 0
+        private set
+    var misses: Long = 0
+        private set
+
+    val size: Int get() = prefixes.size
+
+    /** A fork of the prefix cached under [key], which the caller releases, or null. */
+    fun acquire(key: Long): KvSequence? {
+        val prefix = prefixes.remove(key)
+        if (prefix == null) {
+            misses++
+            return null
+        }
+        prefixes[key] = prefix
+        hits++
+        return pool.fork(prefix)
+    }
+
+    /** Caches the current contents of [sequence] under [key]; the caller keeps [sequence]. */
+    fun put(key: Long, sequence: KvSequence) {
+        prefixes.remove(key)?.let(::drop)
+        val prefix = pool.fork(sequence)
+        prefixes[key] = prefix
+        for (i in 0 until prefix.blocks.size) if (references[prefix.blocks[i]]++ == 0) blocks++
+        val eldest = prefixes.values.iterator()
+        while (blocks > maxBlocks && prefixes.size > 1) {
+            val evicted = eldest.next()
+            eldest.remove()
+            drop(evicted)
+        }
+    }
+
+    fun clear() {
+        prefixes.values.forEach(::drop)
+        prefixes.clear()
+    }
+
+    private fun drop(prefix: KvSequence) {
+        for (i in 0 until prefix.blocks.size) if (--references[prefix.blocks[i]] == 0) blocks--
+        pool.release(prefix)
+    }
+}
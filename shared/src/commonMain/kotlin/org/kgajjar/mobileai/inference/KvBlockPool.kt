@@ -0,0 +1,84 @@
+package org.kgajjar.mobileai.inference
+
+import org.kgajjar.mobileai.collections.IntArrayList
+
+/**
+ * The positions of one sequence in a [KvBlockPool]: a list of blocks, the last possibly
+ * partly filled.
+ */
+class KvSequence internal constructor(internal val blocks: IntArrayList, private val blockSize: Int) {
+    /** Positions written so far. */
+    var length: Int = 0
+        internal set
+
+    /** Pool-wide slot index of [position], for the model to read or write KV entries at. */
+    fun slot(position: Int): Int {
+        require(position in 0 until length) { "position $position outside sequence of $length" }
+        return blocks[position / blockSize] * blockSize + position % blockSize
+    }
+}
+
+/**
+ * Fixed-size KV cache blocks shared between sequences with reference counts.
+ *
+ * [fork] makes a sequence that shares every block of its parent, so beams of one prompt cost
+ * no copies until they diverge. A block is copied (through [copy], which moves the model's KV
+ * entries) only when a sequence appends into a partly filled block that another sequence still
+ * references; full shared blocks are never copied. Not thread-safe.
+ */
+class KvBlockPool(
+    val capacity: Int,
+    val blockSize: Int,
+    private val copy: (fromBlock: Int, toBlock: Int, positions: Int) -> Unit,
+) {
+    private val refCounts = IntArray(capacity)
+    private val free = IntArrayList(capacity).apply { for (b in capacity - 1 downTo 0) add(b) }
+
+    val freeBlocks: Int get() = free.size
+
+    fun newSequence(): KvSequence = KvSequence(IntArrayList(4), blockSize)
+
+    fun fork(parent: KvSequence): KvSequence {
+        val blocks = IntArrayList(parent.blocks.size + 1)
+        for (i in 0 until parent.blocks.size) {
+            val block = parent.blocks[i]
+            refCounts[block]++
+            blocks.add(block)
+        }
+        return KvSequence(blocks, blockSize).also { it.length = parent.length }
+    }
+
+    /** Reserves the next position of [sequence] and returns its slot. */
+    fun append(sequence: KvSequence): Int {
+        val offset = sequence.length % blockSize
+        if (offset == 0) {
+            sequence.blocks.add(allocate())
+        } else {
+            val last = sequence.blocks.last()
+            if (refCounts[last] > 1) {
+                val copyBlock = allocate()
+                copy(last, copyBlock, offset)
+                refCounts[last]--
+                sequence.blocks[sequence.blocks.size - 1] = copyBlock
+            }
+        }
+        sequence.length++
+        return sequence.blocks.last() * blockSize + offset
+    }
+
+    fun release(sequence: KvSequence) {
+        for (i in 0 until sequence.blocks.size) {
+            val block = sequence.blocks[i]
+            if (--refCounts[block] == 0) free.add(block)
+        }
+        sequence.blocks.clear()
+        sequence.length = 0
+    }
+
+    private fun allocate(): Int {
+        check(free.size > 0) { "KV cache is full ($capacity blocks)" }
+        val block = free.removeLast()
+        refCounts[block] = 1
+        return block
+    }
+}
@@ -0,0 +1,17 @@
+package org.kgajjar.mobileai.inference
+
+/** A decoder-only model whose KV cache lives in the blocks of a [KvBlockPool]. */
+interface LanguageModel {
+    val vocabSize: Int
+
+    /**
+     * Runs one decoding step for a batch. Each sequence has already reserved its next position
+     * with [KvBlockPool.append]; the model writes the KV entries of `tokens[i]` at the last
+     * position of `sequences[i]`, attends over all of its positions, and writes the next-token
+     * logits into `logits[i]`.
+     */
+    fun step(sequences: List<KvSequence>, tokens: IntArray, logits: Array<FloatArray>)
+
+    /** Copies the KV entries of the first [positions] positions of one block into another. */
+    fun copyBlock(fromBlock: Int, toBlock: Int, positions: Int)
+}
@@ -0,0 +1,38 @@
+package org.kgajjar.mobileai.inference
+
+/** A [LanguageModel] that also takes input embeddings, e.g. the vision tokens of a [VisionTower]. */
+interface MultimodalModel : LanguageModel {
+    /** Floats per input embedding. */
+    val embeddingSize: Int
+
+    /**
+     * Writes the KV entries of the last [count] positions of [sequence], already reserved with
+     * [KvBlockPool.append], from [count] input embeddings packed in [embeddings]. Produces no
+     * logits: a prompt never ends on an image.
+     */
+    fun prefill(sequence: KvSequence, embeddings: FloatArray, count: Int)
+}
+
+/**
+ * The image side of a vision-language model: a vision encoder plus the projector into the
+ * language model's input space. Every image becomes [tokensPerImage] vision tokens.
+ */
+interface VisionTower {
+    /** Identifies the weights; vision tokens of different model ids are never interchangeable. */
+    val modelId: String
+
+    /** Side of the square input, in pixels. */
+    val inputSize: Int
+
+    /** Per-channel RGB normalization the encoder was trained with, applied to values in [0, 1]. */
+    val mean: FloatArray
+    val std: FloatArray
+
+    val tokensPerImage: Int
+
+    /**
+     * Encodes one preprocessed image (planar RGB, see [org.kgajjar.mobileai.vision.ImagePreprocessor])
+     * into `tokensPerImage × embeddingSize` floats.
+     */
+    suspend fun encode(pixels: FloatArray): FloatArray
+}
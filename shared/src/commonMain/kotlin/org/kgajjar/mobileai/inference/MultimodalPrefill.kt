@@ -0,0 +1,84 @@
+package org.kgajjar.mobileai.inference
+
+import org.kgajjar.mobileai.metrics.Metrics
+import org.kgajjar.mobileai.storage.ContentHash
+import org.kgajjar.mobileai.trace.Trace
+import org.kgajjar.mobileai.vision.ImagePreprocessor
+import org.kgajjar.mobileai.vision.ImageResizer
+import org.kgajjar.mobileai.vision.RgbImage
+import kotlin.time.TimeSource
+
+/**
+ * Prefills prompts made of images followed by text.
+ *
+ * Images come first, so the KV entries of their vision tokens form a prefix that doesn't depend
+ * on the question. Every image prefix is cached in [cache] under a hash chained over the vision
+ * model and the pixels of the images so far: asking again about the same images forks the
+ * cached prefix and only the text is prefilled, and adding an image to a conversation encodes
+ * just the new one. Not thread-safe.
+ */
+class MultimodalPrefill(
+    private val model: MultimodalModel,
+    private val vision: VisionTower,
+    private val pool: KvBlockPool,
+    private val cache: ImagePrefixCache,
+) {
+    private val preprocessor = ImagePreprocessor(vision.inputSize, vision.mean, vision.std)
+    private val pixels = FloatArray(preprocessor.floatsPerImage)
+    private val modelSeed = ContentHash.of(vision.modelId)
+
+    /**
+     * Returns a sequence holding [images] and then [tokens], ready to decode from, with the logits
+     * for the token after [tokens] in [logits]. The caller releases the sequence.
+     */
+    suspend fun prefill(images: List<RgbImage>, tokens: IntArray, logits: FloatArray): KvSequence = Trace.span("prefill", "inference") {
+        require(tokens.isNotEmpty()) { "a prompt must end with text" }
+        val started = TimeSource.Monotonic.markNow()
+        val keys = LongArray(images.size)
+        var key = modelSeed
+        for ((i, image) in images.withIndex()) {
+            key = ContentHash.mix(key xor ContentHash.of(image.pixels, seed = image.width.toLong()))
+            keys[i] = key
+        }
+
+        // Resume from the longest cached run of leading images.
+        var start = 0
+        var cached: KvSequence? = null
+        for (i in images.indices.reversed()) {
+            cached = cache.acquire(keys[i]) ?: continue
+            start = i + 1
+            break
+        }
+        val prompt = cached ?: pool.newSequence()
+        try {
+            for (i in start until images.size) {
+                encode(images[i], prompt)
+                cache.put(keys[i], prompt)
+            }
+            val batch = listOf(prompt)
+            val token = IntArray(1)
+            val out = arrayOf(logits)
+            for (t in tokens) {
+                pool.append(prompt)
+                token[0] = t
+                model.step(batch, token, out)
+            }
+        } catch (e: Throwable) {
+            pool.release(prompt)
+            throw e
+        }
+        Metrics.prefillLatency.record(started.elapsedNow())
+        prompt
+    }
+
+    private suspend fun encode(image: RgbImage, sequence: KvSequence): Unit = Trace.span("encode image", "inference") {
+        preprocessor.process(ImageResizer.fitShorterSide(image, vision.inputSize), pixels)
+        val embeddings = vision.encode(pixels)
+        val count = vision.tokensPerImage
+        check(embeddings.size == count * model.embeddingSize) {
+            "vision tower returned ${embeddings.size} floats for $count tokens of ${model.embeddingSize}"
+        }
+        repeat(count) { pool.append(sequence) }
+        model.prefill(sequence, embeddings, count)
+    }
+}
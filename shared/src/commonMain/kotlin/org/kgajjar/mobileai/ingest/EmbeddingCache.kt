@@ -0,0 +1,162 @@
+package org.kgajjar.mobileai.ingest
+
+import org.kgajjar.mobileai.storage.ByteFile
+import org.kgajjar.mobileai.storage.ContentHash
+import org.kgajjar.mobileai.storage.getFloatLe
+import org.kgajjar.mobileai.storage.getIntLe
+import org.kgajjar.mobileai.storage.getLongLe
+import org.kgajjar.mobileai.storage.putFloatLe
+import org.kgajjar.mobileai.storage.putIntLe
+import org.kgajjar.mobileai.storage.putLongLe
+
+/**
+ * Two-tier cache of chunk embeddings keyed by (model id, hash of whitespace-normalized text).
+ *
+ * The memory tier is an LRU of [memoryCapacity] vectors. The optional disk tier is an
+ * append-only [ByteFile] of fixed-size records, `key:i64 | vector:f32[dimension]`, behind a
+ * small header; on open only the keys are read to rebuild the offset index. A file written for
+ * another model or dimension is discarded. Not thread-safe.
+ */
+class EmbeddingCache(
+    modelId: String,
+    private val dimension: Int,
+    private val memoryCapacity: Int = 4096,
+    private val file: ByteFile? = null,
+) : AutoCloseable {
+    private val modelSeed = ContentHash.of(modelId)
+    private val recordSize = 8 + 4 * dimension
+
+    /** Iteration order is recency order: reads re-insert their entry at the end. */
+    private val memory = LinkedHashMap<Long, FloatArray>()
+
+    /** Key to record index in [file]. */
+    private val diskIndex = HashMap<Long, Int>()
+
+    private val scratch = ByteArray(recordSize)
+
+    var hits: Long = 0
+        private set
+    var misses: Long = 0
+        private set
+
+    init {
+        require(dimension > 0) { "dimension must be positive" }
+        if (file != null) openDiskTier(file)
+    }
+
+    val memoryBytes: Long get() = memory.size.toLong() * dimension * 4
+
+    fun keyOf(text: CharSequence): Long = ContentHash.ofNormalized(text, modelSeed)
+
+    operator fun get(text: CharSequence): FloatArray? = get(keyOf(text))
+
+    fun get(key: Long): FloatArray? {
+        memory.remove(key)?.let {
+            memory[key] = it
+            hits++
+            return it
+        }
+        val record = diskIndex[key]
+        if (record == null || file == null) {
+            misses++
+            return null
+        }
+        file.read(HEADER_SIZE + record.toLong() * recordSize, scratch)
+        val vector = FloatArray(dimension) { scratch.getFloatLe(8 + 4 * it) }
+        remember(key, vector)
+        hits++
+        return vector
+    }
+
+    fun put(text: CharSequence, vector: FloatArray) = put(keyOf(text), vector)
+
+    fun put(key: Long, vector: FloatArray) {
+        require(vector.size == dimension) { "expected $dimension floats, got ${vector.size}" }
+        remember(key, vector)
+        if (file == null || key in diskIndex) return
+        scratch.putLongLe(0, key)
+        for (i in 0 until dimension) scratch.putFloatLe(8 + 4 * i, vector[i])
+        val position = file.append(scratch)
+        diskIndex[key] = ((position - HEADER_SIZE) / recordSize).toInt()
+    }
+
+    /**
+     * Returns embeddings for [texts] in order, calling [encoder] once with only the texts that
+     * are not cached. Texts that normalize to the same content are encoded once.
+     */
+    suspend fun embed(texts: List<String>, encoder: TextEncoder): List<FloatArray> {
+        require(encoder.dimension == dimension) { "encoder dimension ${encoder.dimension} != $dimension" }
+        val keys = LongArray(texts.size) { keyOf(texts[it]) }
+        val results = arrayOfNulls<FloatArray>(texts.size)
+        val missing = LinkedHashMap<Long, String>()
+        for (i in texts.indices) {
+            results[i] = get(keys[i])
+            if (results[i] == null) missing.getOrPut(keys[i]) { texts[i] }
+        }
+        if (missing.isNotEmpty()) {
+            val encoded = encoder.encode(missing.values.toList())
+            check(encoded.size == missing.size) { "encoder returned ${encoded.size} vectors for ${missing.size} texts" }
+            val fresh = HashMap<Long, FloatArray>(missing.size)
+            missing.keys.forEachIndexed { i, key ->
+                put(key, encoded[i])
+                fresh[key] = encoded[i]
+            }
+            for (i in texts.indices) {
+                if (results[i] == null) results[i] = fresh.getValue(keys[i])
+            }
+        }
+        return results.map { it!! }
+    }
+
+    fun flush() {
+        file?.flush()
+    }
+
+    override fun close() {
+        file?.close()
+    }
+
+    private fun remember(key: Long, vector: FloatArray) {
+        memory.remove(key)
+        memory[key] = vector
+        if (memory.size > memoryCapacity) {
+            val eldest = memory.keys.iterator()
+            eldest.next()
+            eldest.remove()
+        }
+    }
+
+    private fun openDiskTier(file: ByteFile) {
+        val header = ByteArray(HEADER_SIZE)
+        val valid = file.size >= HEADER_SIZE && run {
+            file.read(0, header)
+            header.getIntLe(0) == MAGIC && header.getIntLe(4) == VERSION &&
+                header.getIntLe(8) == dimension && header.getLongLe(16) == modelSeed
+        }
+        if (!valid) {
+            file.truncate(0)
+            header.fill(0)
+            header.putIntLe(0, MAGIC)
+            header.putIntLe(4, VERSION)
+            header.putIntLe(8, dimension)
+            header.putLongLe(16, modelSeed)
+            file.append(header)
+            file.sync()
+            return
+        }
+        val records = ((file.size - HEADER_SIZE) / recordSize).toInt()
+        // Drop a record torn by a crash mid-append.
+        val end = HEADER_SIZE + records.toLong() * recordSize
+        if (file.size != end) file.truncate(end)
+        for (i in 0 until records) {
+            file.read(HEADER_SIZE + i.toLong() * recordSize, scratch, 0, 8)
+            diskIndex[scratch.getLongLe(0)] = i
+        }
+    }
+
+    private companion object {
+        const val MAGIC = 0x4345414D // "MAEC"
+        const val VERSION = 1
+        const val HEADER_SIZE = 32
+    }
+}
@@ -0,0 +1,31 @@
+package org.kgajjar.mobileai.ingest
+
+import org.kgajjar.mobileai.search.TextAnalyzer
+import org.kgajjar.mobileai.storage.ContentHash
+import kotlin.math.sqrt
+
+/**
+ * Bag-of-words embedding by feature hashing: each term adds ±1 to one of [dimension] buckets.
+ * Needs no model weights, so it is always available on device; similarity is purely lexical.
+ */
+class HashingTextEncoder(override val dimension: Int = 256) : TextEncoder {
+    override val modelId: String = "hashing-v1-$dimension"
+
+    override suspend fun encode(texts: List<String>): List<FloatArray> = texts.map { embed(it) }
+
+    fun embed(text: CharSequence): FloatArray {
+        val vector = FloatArray(dimension)
+        for (term in TextAnalyzer.terms(text)) {
+            val h = ContentHash.of(term)
+            val bucket = ((h ushr 1) % dimension).toInt()
+            vector[bucket] += if ((h and 1L) == 0L) 1f else -1f
+        }
+        var norm = 0f
+        for (v in vector) norm += v * v
+        if (norm > 0f) {
+            val inverse = 1f / sqrt(norm)
+            for (i in vector.indices) vector[i] *= inverse
+        }
+        return vector
+    }
+}
@@ -0,0 +1,11 @@
+package org.kgajjar.mobileai.ingest
+
+/** Sentence embedding model. Vectors are [dimension] floats, L2-normalized. */
+interface TextEncoder {
+    /** Identifies the weights; embeddings from different model ids are never interchangeable. */
+    val modelId: String
+
+    val dimension: Int
+
+    suspend fun encode(texts: List<String>): List<FloatArray>
+}
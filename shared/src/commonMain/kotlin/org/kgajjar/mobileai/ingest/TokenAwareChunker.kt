@@ -0,0 +1,187 @@
+package org.kgajjar.mobileai.ingest
+
+import org.kgajjar.mobileai.collections.IntArrayList
+import org.kgajjar.mobileai.tokenizer.Tokenizer
+
+/**
+ * A chunk of a [ChunkedDocument]. Token spans index into [ChunkedDocument.tokens]; the first
+ * [overlapTokens] tokens of a chunk are shared with the tail of the previous one.
+ */
+data class Chunk(
+    val index: Int,
+    val textStart: Int,
+    val textEnd: Int,
+    val tokenStart: Int,
+    val tokenEnd: Int,
+    val overlapTokens: Int,
+) {
+    val tokenCount: Int get() = tokenEnd - tokenStart
+}
+
+class ChunkedDocument(
+    val text: String,
+    /** Token ids of the whole document, produced once during chunking. */
+    val tokens: IntArray,
+    val chunks: List<Chunk>,
+) {
+    fun tokensOf(chunk: Chunk): IntArray = tokens.copyOfRange(chunk.tokenStart, chunk.tokenEnd)
+
+    fun textOf(chunk: Chunk): String = text.substring(chunk.textStart, chunk.textEnd)
+}
+
+/**
+ * Splits documents on sentence and section boundaries while tokenizing them in the same pass.
+ *
+ * Each sentence is handed to the [tokenizer] exactly once; chunks and their overlaps are then
+ * expressed as spans over the resulting token stream, so nothing downstream has to tokenize the
+ * chunk text again. Overlaps start on a sentence boundary when one fits within [overlapTokens],
+ * and fall back to a raw token tail otherwise. A markdown heading starts a new section, which
+ * always starts a new chunk without overlap.
+ */
+class TokenAwareChunker(
+    private val tokenizer: Tokenizer,
+    private val maxTokens: Int = 512,
+    private val overlapTokens: Int = 64,
+) {
+    init {
+        require(maxTokens > 0) { "maxTokens must be positive" }
+        require(overlapTokens in 0 until maxTokens) { "overlapTokens must be in [0, maxTokens)" }
+    }
+
+    fun chunk(text: String): ChunkedDocument {
+        val ids = IntArrayList(text.length / 3 + 16)
+        val ends = IntArrayList(text.length / 3 + 16)
+        val state = PackState(ids, ends)
+
+        var pos = 0
+        while (pos < text.length) {
+            val end = sentenceEnd(text, pos)
+            if (startsSection(text, pos)) state.flush(overlap = false)
+
+            val tokenStart = ids.size
+            tokenizer.encode(text, pos, end, ids, ends)
+            check(ends.size == ids.size) { "tokenizer must report an end offset per token" }
+            state.addSentence(tokenStart, ids.size)
+            pos = end
+        }
+        state.flush(overlap = false)
+        return ChunkedDocument(text, ids.toIntArray(), state.chunks)
+    }
+
+    private inner class PackState(val ids: IntArrayList, val ends: IntArrayList) {
+        val chunks = ArrayList<Chunk>()
+
+        /** Token span of the open chunk; [chunkStart] is -1 when no chunk is open. */
+        var chunkStart = -1
+        var chunkEnd = -1
+        var chunkOverlap = 0
+
+        /** Token indices at which sentences of the open chunk begin. */
+        val sentenceStarts = IntArrayList()
+
+        fun addSentence(tokenStart: Int, tokenEnd: Int) {
+            if (tokenStart == tokenEnd) return
+            if (chunkStart >= 0 && tokenEnd - chunkStart > maxTokens) flush(overlap = true)
+            if (chunkStart >= 0 && tokenEnd - chunkStart > maxTokens) {
+                // The overlap carried into the new chunk leaves no room for this sentence.
+                chunkStart = -1
+                sentenceStarts.clear()
+            }
+            if (tokenEnd - tokenStart > maxTokens) {
+                splitLongSentence(tokenStart, tokenEnd)
+                return
+            }
+            if (chunkStart < 0) {
+                chunkStart = tokenStart
+                chunkOverlap = 0
+            }
+            sentenceStarts.add(tokenStart)
+            chunkEnd = tokenEnd
+        }
+
+        fun flush(overlap: Boolean) {
+            if (chunkStart < 0) return
+            val end = chunkEnd
+            if (end > chunkStart + chunkOverlap) emit(chunkStart, end, chunkOverlap)
+
+            val next = if (overlap) overlapStart(end) else end
+            sentenceStarts.clear()
+            if (next < end) {
+                chunkStart = next
+                chunkOverlap = end - next
+                sentenceStarts.add(next)
+            } else {
+                chunkStart = -1
+                chunkOverlap = 0
+            }
+        }
+
+        private fun overlapStart(end: Int): Int {
+            if (overlapTokens == 0) return end
+            val limit = end - overlapTokens
+            for (i in 0 until sentenceStarts.size) {
+                val s = sentenceStarts[i]
+                if (s > chunkStart && s >= limit) return s
+            }
+            return maxOf(limit, chunkStart + 1)
+        }
+
+        private fun splitLongSentence(tokenStart: Int, tokenEnd: Int) {
+            val stride = maxTokens - overlapTokens
+            var start = tokenStart
+            var overlap = 0
+            while (true) {
+                val end = minOf(start + maxTokens, tokenEnd)
+                if (end == tokenEnd) {
+                    // Leave the tail open so following sentences can pack in after it.
+                    chunkStart = start
+                    chunkEnd = tokenEnd
+                    chunkOverlap = overlap
+                    sentenceStarts.clear()
+                    sentenceStarts.add(start)
+                    return
+                }
+                emit(start, end, overlap)
+                start += stride
+                overlap = overlapTokens
+            }
+        }
+
+        private fun emit(tokenStart: Int, tokenEnd: Int, overlap: Int) {
+            val textStart = if (tokenStart == 0) 0 else ends[tokenStart - 1]
+            chunks += Chunk(
+                index = chunks.size,
+                textStart = textStart,
+                textEnd = ends[tokenEnd - 1],
+                tokenStart = tokenStart,
+                tokenEnd = tokenEnd,
+                overlapTokens = overlap,
+            )
+        }
+    }
+
+    private companion object {
+        fun sentenceEnd(text: String, start: Int): Int {
+            var i = start
+            // Leading whitespace belongs to the sentence it precedes.
+            while (i < text.length && text[i].isWhitespace() && text[i] != '\n') i++
+            while (i < text.length) {
+                val c = text[i]
+                if (c == '\n') return i + 1
+                if (c == '.' || c == '!' || c == '?' || c == '。') {
+                    var j = i + 1
+                    while (j < text.length && isClosing(text[j])) j++
+                    if (j == text.length || text[j].isWhitespace()) return j
+                }
+                i++
+            }
+            return text.length
+        }
+
+        fun isClosing(c: Char): Boolean = c == '"' || c == '\'' || c == ')' || c == ']' || c == '”'
+
+        /** A line starting with `#` is a markdown heading and opens a new section. */
+        fun startsSection(text: String, start: Int): Boolean =
+            (start == 0 || text[start - 1] == '\n') && start < text.length && text[start] == '#'
+    }
+}
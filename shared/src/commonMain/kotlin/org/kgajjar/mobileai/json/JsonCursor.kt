@@ -0,0 +1,250 @@
+package org.kgajjar.mobileai.json
+
+/**
+ * A value inside a [JsonDocument]. Cheap to create and decoded only on request; members and
+ * elements that are not visited are skipped without being looked at.
+ */
+class JsonCursor internal constructor(private val doc: JsonDocument, internal val index: Int) {
+    enum class Type { Object, Array, String, Number, Boolean, Null }
+
+    val type: Type
+        get() = when (doc.charAt(index)) {
+            '{' -> Type.Object
+            '[' -> Type.Array
+            '"' -> Type.String
+            't', 'f' -> Type.Boolean
+            'n' -> Type.Null
+            else -> Type.Number
+        }
+
+    val isNull: Boolean get() = literal("null")
+
+    fun string(): String {
+        val start = expect('"') + 1
+        val bytes = doc.bytes
+        var i = start
+        while (true) {
+            if (i >= bytes.size) throw JsonException("unterminated string")
+            val b = bytes[i].toInt()
+            if (b == '"'.code) return bytes.decodeToString(start, i)
+            if (b == '\\'.code) return decodeEscaped(start)
+            if (b in 0 until 0x20) throw JsonException("control character in string at byte $i")
+            i++
+        }
+    }
+
+    fun boolean(): Boolean = when {
+        literal("true") -> true
+        literal("false") -> false
+        else -> throw JsonException("expected a boolean at byte ${doc.position(index)}")
+    }
+
+    fun double(): Double {
+        val start = doc.position(index)
+        val end = numberEnd(start)
+        return doc.bytes.decodeToString(start, end).toDouble()
+    }
+
+    /** The value as a whole number; fails for fractions, exponents and values outside `Long`. */
+    fun long(): Long {
+        val start = doc.position(index)
+        val end = numberEnd(start)
+        val bytes = doc.bytes
+        val negative = bytes[start] == '-'.code.toByte()
+        var value = 0L
+        for (i in (if (negative) start + 1 else start) until end) {
+            val digit = bytes[i] - '0'.code.toByte()
+            if (digit !in 0..9) throw JsonException("expected an integer at byte $start")
+            // Accumulate negatively so that Long.MIN_VALUE fits.
+            if (value < (Long.MIN_VALUE + digit) / 10) throw JsonException("integer out of range at byte $start")
+            value = value * 10 - digit
+        }
+        if (!negative && value == Long.MIN_VALUE) throw JsonException("integer out of range at byte $start")
+        return if (negative) value else -value
+    }
+
+    fun forEachMember(action: (key: String, value: JsonCursor) -> Unit) {
+        expect('{')
+        var i = index + 1
+        if (doc.charAt(i) == '}') return
+        while (true) {
+            if (doc.charAt(i) != '"') throw JsonException("expected a member name at byte ${doc.position(i)}")
+            val key = JsonCursor(doc, i).string()
+            i = member(i)
+            action(key, JsonCursor(doc, i))
+            i = doc.end(i)
+            when (doc.charAt(i)) {
+                ',' -> i++
+                '}' -> return
+                else -> throw JsonException("expected ',' or '}' at byte ${doc.position(i)}")
+            }
+        }
+    }
+
+    fun forEachElement(action: (JsonCursor) -> Unit) {
+        expect('[')
+        var i = index + 1
+        if (doc.charAt(i) == ']') return
+        while (true) {
+            doc.checkValue(i)
+            action(JsonCursor(doc, i))
+            i = doc.end(i)
+            when (doc.charAt(i)) {
+                ',' -> i++
+                ']' -> return
+                else -> throw JsonException("expected ',' or ']' at byte ${doc.position(i)}")
+            }
+        }
+    }
+
+    /** The member named [key], or null. Other members' values are skipped, not decoded. */
+    operator fun get(key: String): JsonCursor? {
+        expect('{')
+        val wanted = key.encodeToByteArray()
+        var i = index + 1
+        if (doc.charAt(i) == '}') return null
+        while (true) {
+            if (doc.charAt(i) != '"') throw JsonException("expected a member name at byte ${doc.position(i)}")
+            val matches = keyEquals(i, wanted, key)
+            i = member(i)
+            if (matches) return JsonCursor(doc, i)
+            i = doc.end(i)
+            when (doc.charAt(i)) {
+                ',' -> i++
+                '}' -> return null
+                else -> throw JsonException("expected ',' or '}' at byte ${doc.position(i)}")
+            }
+        }
+    }
+
+    /** Decodes the whole value into a tree, validating everything under it. */
+    fun toValue(): JsonValue = when (type) {
+        Type.Object -> {
+            val members = LinkedHashMap<String, JsonValue>()
+            forEachMember { key, value -> members[key] = value.toValue() }
+            JsonObject(members)
+        }
+        Type.Array -> {
+            val items = ArrayList<JsonValue>()
+            forEachElement { items += it.toValue() }
+            JsonArray(items)
+        }
+        Type.String -> JsonString(string())
+        Type.Number -> JsonNumber(double())
+        Type.Boolean -> JsonBoolean(boolean())
+        Type.Null -> if (isNull) JsonNull else throw JsonException("unexpected value at byte ${doc.position(index)}")
+    }
+
+    private fun expect(c: Char): Int {
+        if (doc.charAt(index) != c) throw JsonException("expected '$c' at byte ${doc.position(index)}")
+        return doc.position(index)
+    }
+
+    /** Checks the `:` after the member name at [i] and returns the index of its value. */
+    private fun member(i: Int): Int {
+        if (doc.charAt(i + 1) != ':') throw JsonException("expected ':' at byte ${doc.position(i + 1)}")
+        doc.checkValue(i + 2)
+        return i + 2
+    }
+
+    private fun keyEquals(i: Int, wanted: ByteArray, key: String): Boolean {
+        val bytes = doc.bytes
+        val start = doc.position(i) + 1
+        for (k in wanted.indices) {
+            val b = bytes[start + k]
+            if (b == '\\'.code.toByte()) return JsonCursor(doc, i).string() == key
+            if (b != wanted[k] || b == '"'.code.toByte()) return false
+        }
+        return bytes[start + wanted.size] == '"'.code.toByte()
+    }
+
+    private fun literal(word: String): Boolean {
+        val bytes = doc.bytes
+        val start = doc.position(index)
+        if (start + word.length > bytes.size) return false
+        for (k in word.indices) if (bytes[start + k].toInt() != word[k].code) return false
+        return start + word.length == bytes.size || isDelimiter(bytes[start + word.length].toInt())
+    }
+
+    /** Validates the number at [start] and returns the offset just past it. */
+    private fun numberEnd(start: Int): Int {
+        val bytes = doc.bytes
+        var i = start
+        fun at(): Int = if (i < bytes.size) bytes[i].toInt() else -1
+        fun digits(): Int {
+            val from = i
+            while (at() in '0'.code..'9'.code) i++
+            return i - from
+        }
+        if (at() == '-'.code) i++
+        val intStart = i
+        val intDigits = digits()
+        var valid = intDigits > 0 && !(intDigits > 1 && bytes[intStart] == '0'.code.toByte())
+        if (valid && at() == '.'.code) {
+            i++
+            valid = digits() > 0
+        }
+        if (valid && (at() == 'e'.code || at() == 'E'.code)) {
+            i++
+            if (at() == '+'.code || at() == '-'.code) i++
+            valid = digits() > 0
+        }
+        if (!valid || (i < bytes.size && !isDelimiter(bytes[i].toInt()))) {
+            throw JsonException("bad number at byte $start")
+        }
+        return i
+    }
+
+    private fun decodeEscaped(start: Int): String {
+        val bytes = doc.bytes
+        val out = StringBuilder()
+        var run = start
+        var i = start
+        while (true) {
+            if (i >= bytes.size) throw JsonException("unterminated string")
+            when (val b = bytes[i].toInt()) {
+                '"'.code -> {
+                    out.append(bytes.decodeToString(run, i))
+                    return out.toString()
+                }
+                '\\'.code -> {
+                    out.append(bytes.decodeToString(run, i))
+                    if (i + 1 >= bytes.size) throw JsonException("unterminated string")
+                    when (val e = bytes[i + 1].toInt().toChar()) {
+                        'n' -> out.append('\n')
+                        't' -> out.append('\t')
+                        'r' -> out.append('\r')
+                        'b' -> out.append('\b')
+                        'f' -> out.append('\u000C')
+                        '/', '\\', '"' -> out.append(e)
+                        'u' -> {
+                            if (i + 6 > bytes.size) throw JsonException("bad unicode escape")
+                            var code = 0
+                            for (k in i + 2 until i + 6) {
+                                val digit = bytes[k].toInt().toChar().digitToIntOrNull(16)
+                                    ?: throw JsonException("bad unicode escape")
+                                code = code * 16 + digit
+                            }
+                            out.append(code.toChar())
+                            i += 4
+                        }
+                        else -> throw JsonException("bad escape \\$e")
+                    }
+                    i += 2
+                    run = i
+                }
+                else -> {
+                    if (b in 0 until 0x20) throw JsonException("control character in string at byte $i")
+                    i++
+                }
+            }
+        }
+    }
+
+    private companion object {
+        fun isDelimiter(b: Int): Boolean = when (b.toChar()) {
+            ' ', '\n', '\r', '\t', ',', ':', '}', ']', '{', '[', '"' -> true
+            else -> false
+        }
+    }
+}
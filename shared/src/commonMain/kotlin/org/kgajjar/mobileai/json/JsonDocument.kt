@@ -0,0 +1,190 @@
+package org.kgajjar.mobileai.json
+
+import org.kgajjar.mobileai.collections.IntArrayList
+import org.kgajjar.mobileai.storage.getLongLe
+
+/**
+ * On-demand JSON over a UTF-8 buffer, in the style of simdjson.
+ *
+ * Opening a document runs one pass that finds every structural character (`{}[]:,`), string
+ * start and scalar start, eight bytes per machine word (SWAR) and 64 bytes per mask, with string
+ * interiors masked out by a prefix XOR over the unescaped quotes. A second pass over that much
+ * smaller index pairs up brackets, so any value can be skipped in O(1). Nothing is decoded until
+ * a [JsonCursor] asks for it, which lets callers walk a multi-megabyte file and only pay for
+ * the members they read.
+ *
+ * Bracket structure is validated on open; member syntax and scalars are validated as they are
+ * visited, so a document that is only partly read may be only partly validated.
+ */
+class JsonDocument private constructor(
+    internal val bytes: ByteArray,
+    private val positions: IntArray,
+    private val count: Int,
+    private val matching: IntArray,
+) {
+    fun root(): JsonCursor {
+        if (count == 0) throw JsonException("empty document")
+        checkValue(0)
+        if (end(0) != count) throw JsonException("trailing data after the document")
+        return JsonCursor(this, 0)
+    }
+
+    internal fun position(index: Int): Int = positions[index]
+
+    internal fun charAt(index: Int): Char {
+        if (index >= count) throw JsonException("unexpected end of input")
+        return bytes[positions[index]].toInt().toChar()
+    }
+
+    /** Index just past the value that starts at [index]. */
+    internal fun end(index: Int): Int = when (charAt(index)) {
+        '{', '[' -> matching[index] + 1
+        else -> index + 1
+    }
+
+    internal fun checkValue(index: Int) {
+        when (charAt(index)) {
+            ',', ':', '}', ']' -> throw JsonException("expected a value at byte ${positions[index]}")
+            else -> {}
+        }
+    }
+
+    companion object {
+        private const val ONES = 0x0101010101010101L
+        private const val LOWS = 0x7F7F7F7F7F7F7F7FL
+        private const val HIGHS = -0x7F7F7F7F7F7F7F80L // 0x8080808080808080
+        private const val GATHER = 0x0102040810204080L
+        private const val SPACES = 0x2020202020202020L
+
+        fun parse(bytes: ByteArray): JsonDocument {
+            val positions = index(bytes)
+            val count = positions.size
+            val indices = positions.toIntArray()
+            return JsonDocument(bytes, indices, count, match(bytes, indices, count))
+        }
+
+        /** One bit per byte of [word]: set where the byte equals [c]. */
+        private fun equalMask(word: Long, c: Int): Long {
+            val v = word xor (ONES * c)
+            val t = ((v and LOWS) + LOWS) or v
+            return ((t.inv() and HIGHS) ushr 7) * GATHER ushr 56
+        }
+
+        private fun prefixXor(bits: Long): Long {
+            var x = bits
+            x = x xor (x shl 1)
+            x = x xor (x shl 2)
+            x = x xor (x shl 4)
+            x = x xor (x shl 8)
+            x = x xor (x shl 16)
+            x = x xor (x shl 32)
+            return x
+        }
+
+        /** Stage 1: positions of structural characters, string starts and scalar starts. */
+        private fun index(bytes: ByteArray): IntArrayList {
+            val out = IntArrayList(maxOf(16, bytes.size / 8))
+            val tail = ByteArray(64)
+            var carryEscape = false
+            var carryInString = 0L
+            var carryBoundary = 1L
+            var block = 0
+            while (block < bytes.size) {
+                val source: ByteArray
+                val base: Int
+                if (block + 64 <= bytes.size) {
+                    source = bytes
+                    base = block
+                } else {
+                    // Pad the final block with spaces, which are never indexed.
+                    tail.fill(0x20)
+                    bytes.copyInto(tail, 0, block, bytes.size)
+                    source = tail
+                    base = 0
+                }
+                var quote = 0L
+                var backslash = 0L
+                var structural = 0L
+                var whitespace = 0L
+                for (w in 0 until 8) {
+                    val word = source.getLongLe(base + w * 8)
+                    val shift = w * 8
+                    quote = quote or (equalMask(word, '"'.code) shl shift)
+                    backslash = backslash or (equalMask(word, '\\'.code) shl shift)
+                    val s = equalMask(word, '{'.code) or equalMask(word, '}'.code) or
+                        equalMask(word, '['.code) or equalMask(word, ']'.code) or
+                        equalMask(word, ':'.code) or equalMask(word, ','.code)
+                    structural = structural or (s shl shift)
+                    val ws = if (word == SPACES) {
+                        0xFFL
+                    } else {
+                        equalMask(word, ' '.code) or equalMask(word, '\n'.code) or
+                            equalMask(word, '\r'.code) or equalMask(word, '\t'.code)
+                    }
+                    whitespace = whitespace or (ws shl shift)
+                }
+
+                // Escapes are rare, so they are resolved one backslash at a time.
+                var escaped = 0L
+                var pending = backslash
+                if (carryEscape) {
+                    escaped = 1L
+                    pending = pending and 1L.inv()
+                }
+                carryEscape = false
+                while (pending != 0L) {
+                    val bit = pending.countTrailingZeroBits()
+                    pending = pending and (pending - 1)
+                    if (bit == 63) {
+                        carryEscape = true
+                    } else {
+                        val next = 1L shl (bit + 1)
+                        escaped = escaped or next
+                        pending = pending and next.inv()
+                    }
+                }
+
+                val quotes = quote and escaped.inv()
+                // Set from an opening quote up to, not including, its closing quote.
+                val inString = prefixXor(quotes) xor carryInString
+                carryInString = inString shr 63
+                val outside = (inString or quotes).inv()
+                // A closing quote counts as a boundary so that junk glued to a string is indexed and rejected.
+                val boundary = whitespace or structural or (quotes and inString.inv())
+                val scalarStarts = outside and boundary.inv() and ((boundary shl 1) or carryBoundary)
+                carryBoundary = boundary ushr 63
+                var found = (structural and outside) or (quotes and inString) or scalarStarts
+                while (found != 0L) {
+                    val position = block + found.countTrailingZeroBits()
+                    if (position < bytes.size) out.add(position)
+                    found = found and (found - 1)
+                }
+                block += 64
+            }
+            if (carryInString != 0L) throw JsonException("unterminated string")
+            return out
+        }
+
+        /** Stage 2: pairs each `{` and `[` with its closing bracket. */
+        private fun match(bytes: ByteArray, positions: IntArray, count: Int): IntArray {
+            val matching = IntArray(count)
+            val stack = IntArrayList()
+            for (i in 0 until count) {
+                when (val c = bytes[positions[i]].toInt().toChar()) {
+                    '{', '[' -> stack.add(i)
+                    '}', ']' -> {
+                        if (stack.isEmpty()) throw JsonException("unbalanced '$c' at byte ${positions[i]}")
+                        val open = stack.removeLast()
+                        if ((bytes[positions[open]].toInt().toChar() == '{') != (c == '}')) {
+                            throw JsonException("mismatched '$c' at byte ${positions[i]}")
+                        }
+                        matching[open] = i
+                    }
+                    else -> {}
+                }
+            }
+            if (!stack.isEmpty()) throw JsonException("unexpected end of input")
+            return matching
+        }
+    }
+}
@@ -0,0 +1,235 @@
+package org.kgajjar.mobileai.json
+
+/**
+ * Push parser for JSON arriving in arbitrary chunks, such as tokens streamed from a model.
+ *
+ * Chunks may split a document anywhere, including inside strings, escapes and numbers. Every
+ * complete top-level value is passed to [onValue] as soon as its last character arrives; the
+ * elements of a top-level array are passed as soon as each one is complete, so the caller can act
+ * on the first element while the rest is still being generated. Several top-level values may
+ * follow each other, separated by whitespace. [onLeaf] reports every completed string, number,
+ * boolean and null at any depth together with its [path], and [partialString] exposes a string
+ * value that is still arriving, which is enough to render a document field by field.
+ *
+ * Not thread-safe; errors are reported as [JsonException].
+ */
+class JsonStreamParser(
+    private val onElement: ((index: Int, value: JsonValue) -> Unit)? = null,
+    private val onLeaf: ((path: String, value: JsonValue) -> Unit)? = null,
+    private val onValue: (JsonValue) -> Unit,
+) {
+    private sealed class Frame {
+        class Obj : Frame() {
+            val members = LinkedHashMap<String, JsonValue>()
+            var key: String? = null
+        }
+
+        class Arr : Frame() {
+            val items = ArrayList<JsonValue>()
+        }
+    }
+
+    private enum class State { Value, FirstValueOrEnd, AfterValue, Key, FirstKeyOrEnd, Colon, Str, Escape, Unicode, Number, Literal }
+
+    private val stack = ArrayList<Frame>()
+    private var state = State.Value
+    private val token = StringBuilder()
+    private var stringIsKey = false
+    private var unicode = 0
+    private var unicodeDigits = 0
+    private var literal = ""
+
+    /** The text so far of the string value being parsed, or null outside string values. */
+    val partialString: CharSequence?
+        get() = when (state) {
+            State.Str, State.Escape, State.Unicode -> if (stringIsKey) null else token
+            else -> null
+        }
+
+    /** Path of the value being parsed, such as `steps[2].title`; empty at the top level. */
+    fun path(): String = buildString {
+        for (frame in stack) {
+            when (frame) {
+                is Frame.Obj -> {
+                    if (isNotEmpty()) append('.')
+                    append(frame.key ?: "")
+                }
+                is Frame.Arr -> append('[').append(frame.items.size).append(']')
+            }
+        }
+    }
+
+    fun feed(chunk: CharSequence) {
+        for (c in chunk) accept(c)
+    }
+
+    /** Ends the stream; fails if a document is incomplete. */
+    fun finish() {
+        if (state == State.Number) completeNumber()
+        if (stack.isNotEmpty() || state != State.Value) throw JsonException("unexpected end of input")
+    }
+
+    private fun accept(c: Char) {
+        when (state) {
+            State.Str -> when (c) {
+                '"' -> completeString()
+                '\\' -> state = State.Escape
+                else -> token.append(c)
+            }
+            State.Escape -> {
+                state = State.Str
+                when (c) {
+                    'n' -> token.append('\n')
+                    't' -> token.append('\t')
+                    'r' -> token.append('\r')
+                    'b' -> token.append('\b')
+                    'f' -> token.append('\u000C')
+                    '/', '\\', '"' -> token.append(c)
+                    'u' -> {
+                        state = State.Unicode
+                        unicode = 0
+                        unicodeDigits = 0
+                    }
+                    else -> throw JsonException("bad escape \\$c")
+                }
+            }
+            State.Unicode -> {
+                val digit = c.digitToIntOrNull(16) ?: throw JsonException("bad unicode escape")
+                unicode = unicode * 16 + digit
+                if (++unicodeDigits == 4) {
+                    token.append(unicode.toChar())
+                    state = State.Str
+                }
+            }
+            State.Number -> {
+                if (c in '0'..'9' || c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-') {
+                    token.append(c)
+                } else {
+                    completeNumber()
+                    accept(c)
+                }
+            }
+            State.Literal -> {
+                token.append(c)
+                if (!literal.startsWith(token)) throw JsonException("unexpected '$token'")
+                if (token.length == literal.length) {
+                    complete(
+                        when (literal) {
+                            "true" -> JsonBoolean(true)
+                            "false" -> JsonBoolean(false)
+                            else -> JsonNull
+                        }
+                    )
+                }
+            }
+            else -> if (!c.isWhitespace()) structural(c)
+        }
+    }
+
+    private fun structural(c: Char) {
+        when (state) {
+            State.Value, State.FirstValueOrEnd -> when {
+                c == ']' && state == State.FirstValueOrEnd -> closeArray()
+                c == '{' -> {
+                    stack += Frame.Obj()
+                    state = State.FirstKeyOrEnd
+                }
+                c == '[' -> {
+                    stack += Frame.Arr()
+                    state = State.FirstValueOrEnd
+                }
+                c == '"' -> startString(isKey = false)
+                c == '-' || c in '0'..'9' -> {
+                    token.clear()
+                    token.append(c)
+                    state = State.Number
+                }
+                c == 't' || c == 'f' || c == 'n' -> {
+                    literal = when (c) {
+                        't' -> "true"
+                        'f' -> "false"
+                        else -> "null"
+                    }
+                    token.clear()
+                    token.append(c)
+                    state = State.Literal
+                }
+                else -> throw JsonException("unexpected '$c'")
+            }
+            State.FirstKeyOrEnd, State.Key -> when {
+                c == '}' && state == State.FirstKeyOrEnd -> closeObject()
+                c == '"' -> startString(isKey = true)
+                else -> throw JsonException("expected a member name, got '$c'")
+            }
+            State.Colon -> {
+                if (c != ':') throw JsonException("expected ':', got '$c'")
+                state = State.Value
+            }
+            State.AfterValue -> when (val frame = stack.lastOrNull()) {
+                is Frame.Obj -> when (c) {
+                    ',' -> state = State.Key
+                    '}' -> closeObject()
+                    else -> throw JsonException("expected ',' or '}', got '$c'")
+                }
+                is Frame.Arr -> when (c) {
+                    ',' -> state = State.Value
+                    ']' -> closeArray()
+                    else -> throw JsonException("expected ',' or ']', got '$c'")
+                }
+                null -> {
+                    // A new top-level value.
+                    state = State.Value
+                    structural(c)
+                }
+            }
+            else -> error("unreachable")
+        }
+    }
+
+    private fun startString(isKey: Boolean) {
+        token.clear()
+        stringIsKey = isKey
+        state = State.Str
+    }
+
+    private fun completeString() {
+        val text = token.toString()
+        if (stringIsKey) {
+            (stack.last() as Frame.Obj).key = text
+            state = State.Colon
+        } else {
+            complete(JsonString(text))
+        }
+    }
+
+    private fun completeNumber() {
+        val value = token.toString().toDoubleOrNull() ?: throw JsonException("bad number '$token'")
+        complete(JsonNumber(value))
+    }
+
+    private fun closeObject() {
+        val frame = stack.removeAt(stack.lastIndex) as Frame.Obj
+        complete(JsonObject(frame.members))
+    }
+
+    private fun closeArray() {
+        val frame = stack.removeAt(stack.lastIndex) as Frame.Arr
+        complete(JsonArray(frame.items))
+    }
+
+    private fun complete(value: JsonValue) {
+        if (onLeaf != null && value !is JsonObject && value !is JsonArray) onLeaf.invoke(path(), value)
+        state = State.AfterValue
+        when (val frame = stack.lastOrNull()) {
+            null -> {
+                onValue(value)
+                state = State.Value
+            }
+            is Frame.Obj -> frame.members[frame.key!!] = value
+            is Frame.Arr -> {
+                frame.items += value
+                if (stack.size == 1) onElement?.invoke(frame.items.lastIndex, value)
+            }
+        }
+    }
+}
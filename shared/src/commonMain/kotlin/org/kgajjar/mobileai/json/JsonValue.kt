@@ -0,0 +1,108 @@
+package org.kgajjar.mobileai.json
+
+/** Parsed JSON document tree. */
+sealed interface JsonValue {
+    /** Compact JSON text for this value. */
+    fun toJson(): String = StringBuilder().also { writeTo(it) }.toString()
+
+    fun writeTo(out: StringBuilder)
+}
+
+data class JsonString(val value: String) : JsonValue {
+    override fun writeTo(out: StringBuilder) = Json.quote(value, out)
+}
+
+data class JsonNumber(val value: Double) : JsonValue {
+    override fun writeTo(out: StringBuilder) {
+        if (value == value.toLong().toDouble() && value in -1e15..1e15) out.append(value.toLong()) else out.append(value)
+    }
+}
+
+data class JsonBoolean(val value: Boolean) : JsonValue {
+    override fun writeTo(out: StringBuilder) {
+        out.append(value)
+    }
+}
+
+data object JsonNull : JsonValue {
+    override fun writeTo(out: StringBuilder) {
+        out.append("null")
+    }
+}
+
+data class JsonArray(val items: List<JsonValue>) : JsonValue, List<JsonValue> by items {
+    override fun writeTo(out: StringBuilder) {
+        out.append('[')
+        items.forEachIndexed { i, item ->
+            if (i > 0) out.append(',')
+            item.writeTo(out)
+        }
+        out.append(']')
+    }
+}
+
+/** Members keep their document order. */
+data class JsonObject(val members: Map<String, JsonValue>) : JsonValue, Map<String, JsonValue> by members {
+    override fun writeTo(out: StringBuilder) {
+        out.append('{')
+        var first = true
+        for ((key, value) in members) {
+            if (!first) out.append(',')
+            first = false
+            Json.quote(key, out)
+            out.append(':')
+            value.writeTo(out)
+        }
+        out.append('}')
+    }
+}
+
+val JsonValue.stringOrNull: String? get() = (this as? JsonString)?.value
+
+val JsonValue.doubleOrNull: Double? get() = (this as? JsonNumber)?.value
+
+val JsonValue.booleanOrNull: Boolean? get() = (this as? JsonBoolean)?.value
+
+class JsonException(message: String) : RuntimeException(message)
+
+object Json {
+    /** Parses one complete JSON document. */
+    fun parse(text: CharSequence): JsonValue = parse(text.toString().encodeToByteArray())
+
+    /** Parses one complete UTF-8 JSON document. */
+    fun parse(bytes: ByteArray): JsonValue = JsonDocument.parse(bytes).root().toValue()
+
+    fun obj(vararg members: Pair<String, Any?>): JsonObject = JsonObject(members.associate { it.first to of(it.second) })
+
+    /** Wraps a Kotlin string, number, boolean, null, list, map or [JsonValue]. */
+    fun of(value: Any?): JsonValue = when (value) {
+        null -> JsonNull
+        is JsonValue -> value
+        is String -> JsonString(value)
+        is Number -> JsonNumber(value.toDouble())
+        is Boolean -> JsonBoolean(value)
+        is List<*> -> JsonArray(value.map { of(it) })
+        is Map<*, *> -> JsonObject(value.entries.associate { it.key.toString() to of(it.value) })
+        else -> throw IllegalArgumentException("no JSON form for ${value::class.simpleName}")
+    }
+
+    internal fun quote(value: String, out: StringBuilder) {
+        out.append('"')
+        for (c in value) {
+            when (c) {
+                '"' -> out.append("\\\"")
+                '\\' -> out.append("\\\\")
+                '\n' -> out.append("\\n")
+                '\r' -> out.append("\\r")
+                '\t' -> out.append("\\t")
+                else -> if (c < ' ') {
+                    out.append("\\u")
+                    out.append(c.code.toString(16).padStart(4, '0'))
+                } else {
+                    out.append(c)
+                }
+            }
+        }
+        out.append('"')
+    }
+}
@@ -0,0 +1,71 @@
+package org.kgajjar.mobileai.json
+
+/**
+ * A model reply that is a JSON document, followed as it streams in so that its fields can be
+ * shown as soon as each one is complete.
+ *
+ * Every character is parsed once: [update] takes the whole reply text so far but only feeds the
+ * part it has not seen. A Markdown code fence or other text before the document is skipped, and
+ * anything after it is ignored. If the reply turns out not to be valid JSON, [isBroken] is set
+ * and callers fall back to showing the text.
+ */
+class StructuredReply {
+    data class Field(val path: String, val value: JsonValue)
+
+    private val _fields = ArrayList<Field>()
+    private var consumed = 0
+    private var started = false
+
+    var isComplete = false
+        private set
+
+    var isBroken = false
+        private set
+
+    private val parser = JsonStreamParser(onLeaf = { path, value -> if (!isComplete) _fields += Field(path, value) }) {
+        isComplete = true
+    }
+
+    /** Completed fields in document order. */
+    val fields: List<Field> get() = _fields
+
+    /** The string field that is still arriving, with its text so far. */
+    val streaming: Field?
+        get() = if (isComplete || isBroken) null else parser.partialString?.let { Field(parser.path(), JsonString(it.toString())) }
+
+    /** Feeds the part of [text] beyond what was seen before; [text] must extend earlier input. */
+    fun update(text: CharSequence) {
+        if (text.length < consumed) {
+            isBroken = true
+            return
+        }
+        var from = consumed
+        consumed = text.length
+        if (isComplete || isBroken) return
+        if (!started) {
+            while (from < text.length && text[from] != '{' && text[from] != '[') from++
+            if (from == text.length) return
+            started = true
+        }
+        try {
+            parser.feed(text.subSequence(from, text.length))
+        } catch (e: JsonException) {
+            // Text after a complete document, such as a closing fence, is not an error.
+            if (!isComplete) isBroken = true
+        }
+    }
+
+    companion object {
+        /** Whether [text] starts, after whitespace and an optional code fence, like a JSON document. */
+        fun looksStructured(text: CharSequence): Boolean {
+            var i = 0
+            while (i < text.length && text[i].isWhitespace()) i++
+            if (text.startsWith("```", i)) {
+                i = text.indexOf('\n', i)
+                if (i < 0) return false
+                while (i < text.length && text[i].isWhitespace()) i++
+            }
+            return i < text.length && (text[i] == '{' || text[i] == '[')
+        }
+    }
+}
@@ -0,0 +1,139 @@
+package org.kgajjar.mobileai.metrics
+
+import kotlin.concurrent.atomics.AtomicLong
+import kotlin.concurrent.atomics.AtomicLongArray
+import kotlin.concurrent.atomics.ExperimentalAtomicApi
+import kotlin.math.ceil
+import kotlin.time.Duration
+import kotlin.time.TimeSource
+
+/**
+ * A high-dynamic-range histogram of values in `0..highest`, laid out like HdrHistogram: buckets
+ * double in width and each is split into the same number of linear sub-buckets, so any recorded
+ * value is kept to within `10^-significantDigits` of itself at a fixed memory cost. Recording is
+ * one atomic increment plus updates of the running totals, so any thread can record without
+ * taking a lock; values above [highest] are recorded as [highest].
+ */
+@OptIn(ExperimentalAtomicApi::class)
+class Histogram(val highest: Long, significantDigits: Int = 2) {
+    private val subBucketHalfCountMagnitude: Int
+    private val subBucketHalfCount: Int
+    private val subBucketMask: Long
+    private val counts: AtomicLongArray
+
+    private val total = AtomicLong(0L)
+    private val sum = AtomicLong(0L)
+    private val min = AtomicLong(Long.MAX_VALUE)
+    private val max = AtomicLong(0L)
+
+    init {
+        require(highest >= 2) { "highest must be at least 2" }
+        require(significantDigits in 1..4) { "significantDigits must be in 1..4" }
+        var largestSingleUnitResolution = 2L
+        repeat(significantDigits) { largestSingleUnitResolution *= 10 }
+        val subBucketCountMagnitude = 64 - (largestSingleUnitResolution - 1).countLeadingZeroBits()
+        subBucketHalfCountMagnitude = subBucketCountMagnitude - 1
+        val subBucketCount = 1 shl subBucketCountMagnitude
+        subBucketHalfCount = subBucketCount / 2
+        subBucketMask = subBucketCount - 1L
+
+        var bucketCount = 1
+        var smallestUntrackable = subBucketCount.toLong()
+        while (smallestUntrackable <= highest) {
+            if (smallestUntrackable > Long.MAX_VALUE / 2) {
+                bucketCount++
+                break
+            }
+            smallestUntrackable = smallestUntrackable shl 1
+            bucketCount++
+        }
+        counts = AtomicLongArray((bucketCount + 1) * subBucketHalfCount)
+    }
+
+    val count: Long get() = total.load()
+
+    fun record(value: Long) {
+        val v = value.coerceIn(0L, highest)
+        counts.fetchAndAddAt(indexOf(v), 1L)
+        total.fetchAndAdd(1L)
+        sum.fetchAndAdd(v)
+        while (true) {
+            val current = min.load()
+            if (v >= current || min.compareAndSet(current, v)) break
+        }
+        while (true) {
+            val current = max.load()
+            if (v <= current || max.compareAndSet(current, v)) break
+        }
+    }
+
+    /** Records [duration] in microseconds, the unit every latency histogram here uses. */
+    fun record(duration: Duration) = record(duration.inWholeMicroseconds)
+
+    /** Runs [block] and records how long it took, in microseconds. */
+    inline fun <T> time(block: () -> T): T {
+        val start = TimeSource.Monotonic.markNow()
+        try {
+            return block()
+        } finally {
+            record(start.elapsedNow())
+        }
+    }
+
+    /**
+     * A copy of the current state. Concurrent records may land in some fields and not yet in
+     * others, which moves a percentile by at most the few values in flight.
+     */
+    fun snapshot(): HistogramSnapshot {
+        val copy = LongArray(counts.size) { counts.loadAt(it) }
+        val n = copy.sum()
+        if (n == 0L) return HistogramSnapshot(0L, 0L, 0L, 0.0, 0L, 0L, 0L, 0L)
+        fun percentile(p: Double): Long {
+            val target = maxOf(1L, ceil(p / 100 * n).toLong())
+            var seen = 0L
+            for (i in copy.indices) {
+                seen += copy[i]
+                if (seen >= target) return minOf(highestEquivalent(i), max.load())
+            }
+            return max.load()
+        }
+        return HistogramSnapshot(
+            count = n,
+            min = min.load(),
+            max = max.load(),
+            mean = sum.load().toDouble() / n,
+            p50 = percentile(50.0),
+            p90 = percentile(90.0),
+            p99 = percentile(99.0),
+            p999 = percentile(99.9),
+        )
+    }
+
+    private fun indexOf(value: Long): Int {
+        val bucket = (64 - subBucketHalfCountMagnitude - 1) - (value or subBucketMask).countLeadingZeroBits()
+        val subBucket = (value ushr bucket).toInt()
+        return ((bucket + 1) shl subBucketHalfCountMagnitude) + (subBucket - subBucketHalfCount)
+    }
+
+    /** The largest value that [indexOf] maps to [index]. */
+    private fun highestEquivalent(index: Int): Long {
+        var bucket = (index shr subBucketHalfCountMagnitude) - 1
+        var subBucket = (index and (subBucketHalfCount - 1)) + subBucketHalfCount
+        if (bucket < 0) {
+            subBucket -= subBucketHalfCount
+            bucket = 0
+        }
+        return (subBucket.toLong() shl bucket) + (1L shl bucket) - 1
+    }
+}
+
+class HistogramSnapshot(
+    val count: Long,
+    val min: Long,
+    val max: Long,
+    val mean: Double,
+    val p50: Long,
+    val p90: Long,
+    val p99: Long,
+    val p999: Long,
+)
@@ -0,0 +1,22 @@
+package org.kgajjar.mobileai.metrics
+
+/**
+ * The app's metrics registry and the metrics the shared code reports into it. Latencies are in
+ * microseconds; names end in their unit.
+ */
+object Metrics {
+    val registry = MetricsRegistry()
+
+    /** From starting a reply to its first generated token, prompt processing included. */
+    val timeToFirstToken = registry.histogram("chat.ttft_us")
+    val interTokenLatency = registry.histogram("chat.inter_token_us")
+    val prefillLatency = registry.histogram("inference.prefill_us")
+
+    val historySearchLatency = registry.histogram("search.history_us")
+    val photoSearchLatency = registry.histogram("search.photos_us")
+    val photoTextSearchLatency = registry.histogram("search.photo_text_us")
+
+    val messagesIndexed = registry.counter("ingest.messages")
+    val photosEmbedded = registry.counter("ingest.photos")
+    val photosRead = registry.counter("ingest.photo_text")
+}
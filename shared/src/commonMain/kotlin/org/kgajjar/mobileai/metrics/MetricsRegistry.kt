@@ -0,0 +1,103 @@
+package org.kgajjar.mobileai.metrics
+
+import org.kgajjar.mobileai.epochMillis
+import org.kgajjar.mobileai.json.Json
+import kotlin.concurrent.atomics.AtomicLong
+import kotlin.concurrent.atomics.AtomicReference
+import kotlin.concurrent.atomics.ExperimentalAtomicApi
+
+/** A monotonically increasing count, e.g. photos indexed. */
+@OptIn(ExperimentalAtomicApi::class)
+class Counter internal constructor() {
+    private val value = AtomicLong(0L)
+
+    fun increment(by: Long = 1L) {
+        value.fetchAndAdd(by)
+    }
+
+    fun get(): Long = value.load()
+}
+
+/**
+ * Named counters, histograms and gauges. Lookups and updates take no lock; registering a name
+ * copies the table, which only happens the first time each name is used. Asking again for a
+ * name returns the metric already registered under it.
+ */
+@OptIn(ExperimentalAtomicApi::class)
+class MetricsRegistry {
+    private class Tables(
+        val counters: Map<String, Counter> = emptyMap(),
+        val histograms: Map<String, Histogram> = emptyMap(),
+        val gauges: Map<String, () -> Long> = emptyMap(),
+    )
+
+    private val tables = AtomicReference(Tables())
+
+    fun counter(name: String): Counter {
+        tables.load().counters[name]?.let { return it }
+        return register { t ->
+            t.counters[name]?.let { return it }
+            val counter = Counter()
+            Tables(t.counters + (name to counter), t.histograms, t.gauges) to counter
+        }
+    }
+
+    /** A histogram of values up to [highest]; latencies are recorded in microseconds. */
+    fun histogram(name: String, highest: Long = 60_000_000L): Histogram {
+        tables.load().histograms[name]?.let { return it }
+        return register { t ->
+            t.histograms[name]?.let { return it }
+            val histogram = Histogram(highest)
+            Tables(t.counters, t.histograms + (name to histogram), t.gauges) to histogram
+        }
+    }
+
+    /** Reports [read] under [name] in every snapshot, replacing any earlier gauge of that name. */
+    fun gauge(name: String, read: () -> Long) {
+        register { t -> Tables(t.counters, t.histograms, t.gauges + (name to read)) to Unit }
+    }
+
+    fun snapshot(): MetricsSnapshot {
+        val t = tables.load()
+        return MetricsSnapshot(
+            takenAt = epochMillis(),
+            counters = t.counters.mapValues { it.value.get() },
+            gauges = t.gauges.mapValues { it.value() },
+            histograms = t.histograms.mapValues { it.value.snapshot() },
+        )
+    }
+
+    private inline fun <T> register(update: (Tables) -> Pair<Tables, T>): T {
+        while (true) {
+            val current = tables.load()
+            val (next, result) = update(current)
+            if (tables.compareAndSet(current, next)) return result
+        }
+    }
+}
+
+class MetricsSnapshot(
+    val takenAt: Long,
+    val counters: Map<String, Long>,
+    val gauges: Map<String, Long>,
+    val histograms: Map<String, HistogramSnapshot>,
+) {
+    /** Per-second rate of [counter] since [earlier], e.g. photos indexed per second. */
+    fun rate(counter: String, earlier: MetricsSnapshot): Double {
+        val seconds = (takenAt - earlier.takenAt) / 1000.0
+        if (seconds <= 0) return 0.0
+        return ((counters[counter] ?: 0L) - (earlier.counters[counter] ?: 0L)) / seconds
+    }
+
+    fun toJson(): String = Json.obj(
+        "takenAt" to takenAt,
+        "counters" to counters,
+        "gauges" to gauges,
+        "histograms" to histograms.mapValues { (_, h) ->
+            mapOf(
+                "count" to h.count, "min" to h.min, "max" to h.max, "mean" to h.mean,
+                "p50" to h.p50, "p90" to h.p90, "p99" to h.p99, "p999" to h.p999,
+            )
+        },
+    ).toJson()
+}
@@ -0,0 +1,36 @@
+package org.kgajjar.mobileai.ocr
+
+import org.kgajjar.mobileai.vision.RgbImage
+
+class OcrWord(val text: String, val box: TextBox, val confidence: Float)
+
+/** Text detection followed by batched recognition of everything detected in an image. */
+class OcrPipeline(
+    private val detector: TextDetector,
+    private val recognizer: TextRecognizer,
+    private val minConfidence: Float = 0.5f,
+) {
+    /** The words read in [image] with at least [minConfidence], in no particular order. */
+    suspend fun words(image: RgbImage): List<OcrWord> {
+        val boxes = detector.detect(image)
+        if (boxes.isEmpty()) return emptyList()
+        return recognizer.recognize(image, boxes).mapIndexedNotNull { i, read ->
+            if (read.text.isBlank() || read.confidence < minConfidence) null else OcrWord(read.text, boxes[i], read.confidence)
+        }
+    }
+
+    /** The text of [image] in reading order: lines top to bottom, words left to right. */
+    suspend fun read(image: RgbImage): String = readingOrder(words(image))
+
+    internal fun readingOrder(words: List<OcrWord>): String {
+        val lines = ArrayList<MutableList<OcrWord>>()
+        for (word in words.sortedBy { it.box.top }) {
+            // A word joins the last line if it overlaps the line's band by half its height.
+            val line = lines.lastOrNull()
+            val band = line?.let { l -> l.minOf { it.box.top } until l.maxOf { it.box.bottom } }
+            val overlap = if (band == null) 0 else minOf(band.last + 1, word.box.bottom) - maxOf(band.first, word.box.top)
+            if (line != null && 2 * overlap >= word.box.height) line += word else lines += mutableListOf(word)
+        }
+        return lines.joinToString("\n") { line -> line.sortedBy { it.box.left }.joinToString(" ") { it.text } }
+    }
+}
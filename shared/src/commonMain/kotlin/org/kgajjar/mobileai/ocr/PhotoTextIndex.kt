@@ -0,0 +1,253 @@
+package org.kgajjar.mobileai.ocr
+
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.sync.Mutex
+import kotlinx.coroutines.sync.withLock
+import kotlinx.coroutines.withContext
+import kotlinx.coroutines.yield
+import org.kgajjar.mobileai.backgroundDispatcher
+import org.kgajjar.mobileai.metrics.Metrics
+import org.kgajjar.mobileai.search.ChatHistorySearch
+import org.kgajjar.mobileai.search.FullTextIndex
+import org.kgajjar.mobileai.search.TextAnalyzer
+import org.kgajjar.mobileai.storage.ByteBuilder
+import org.kgajjar.mobileai.storage.ByteFile
+import org.kgajjar.mobileai.storage.ByteReader
+import org.kgajjar.mobileai.storage.Crc32
+import org.kgajjar.mobileai.storage.Storage
+import org.kgajjar.mobileai.storage.getIntLe
+import org.kgajjar.mobileai.storage.readBytes
+import org.kgajjar.mobileai.vision.Photo
+import org.kgajjar.mobileai.vision.PhotoLibrary
+import kotlin.time.TimeSource
+
+data class PhotoTextHit(val uri: String, val modifiedAt: Long, val snippet: String, val score: Float) {
+    val photo: Photo get() = Photo(uri, modifiedAt)
+}
+
+/**
+ * Makes the text in photos searchable, which is mostly the text of screenshots.
+ *
+ * [sync] reads new and modified photos with an [OcrPipeline], one at a time on a single
+ * low-priority worker thread that yields between photos, so it never holds more than one core
+ * and gives way to the app's own work. What it reads is
+ * appended to `<name>.log` (photo, modification time, text) and indexed in a [FullTextIndex];
+ * hits read their text back from the log for snippets. The index's watermark is the log length
+ * it covers, so on open only records past it are indexed again. The log is rewritten without
+ * superseded records once they make up most of it.
+ */
+class PhotoTextIndex private constructor(
+    private val storage: Storage,
+    private val name: String,
+    private val pipeline: OcrPipeline,
+    private val index: FullTextIndex,
+    private var log: ByteFile,
+    private val minSide: Int,
+) {
+    private class Entry(val docId: Long, val modifiedAt: Long, val position: Long, val length: Int)
+
+    private val mutex = Mutex()
+    private val syncMutex = Mutex()
+    private val entries = HashMap<String, Entry>()
+    private val uris = HashMap<Long, String>()
+    private var nextDocId = 0L
+    private var liveBytes = 0L
+    private val record = ByteBuilder(1024)
+
+    /** Photos read so far, with or without text. */
+    suspend fun count(): Int = mutex.withLock { entries.size }
+
+    suspend fun search(query: String, limit: Int = 20): List<PhotoTextHit> {
+        if (query.isBlank()) return emptyList()
+        val terms = TextAnalyzer.terms(query)
+        val started = TimeSource.Monotonic.markNow()
+        return withContext(Dispatchers.Default) {
+            mutex.withLock {
+                index.search(query, limit).mapNotNull { hit ->
+                    val uri = uris[hit.docId] ?: return@mapNotNull null
+                    val entry = entries.getValue(uri)
+                    PhotoTextHit(uri, entry.modifiedAt, ChatHistorySearch.snippet(read(entry), terms), hit.score)
+                }
+            }
+        }.also { Metrics.photoTextSearchLatency.record(started.elapsedNow()) }
+    }
+
+    /**
+     * Brings the index in line with [library]: forgets deleted photos and reads new or modified
+     * ones. [onProgress] receives the photos done and to do.
+     */
+    suspend fun sync(library: PhotoLibrary, onProgress: ((done: Int, total: Int) -> Unit)? = null): Unit =
+        syncMutex.withLock {
+            withContext(worker) {
+                val photos = library.photos()
+                val todo = mutex.withLock {
+                    val present = photos.mapTo(HashSet()) { it.uri }
+                    for (uri in entries.keys.filter { it !in present }) {
+                        remove(uri)
+                        writeRecord { putByte(REMOVE).putString(uri) }
+                    }
+                    photos.filter { entries[it.uri]?.modifiedAt != it.modifiedAt }
+                }
+                for ((i, photo) in todo.withIndex()) {
+                    yield()
+                    // Unreadable photos are recorded with no text, so they are retried only once modified.
+                    val text = library.load(photo, minSide)?.let { pipeline.read(it) }.orEmpty()
+                    mutex.withLock {
+                        val docId = nextDocId++
+                        val position = writeRecord {
+                            putByte(ADD).putString(photo.uri).putLong(photo.modifiedAt).putLong(docId).putString(text)
+                        }
+                        add(photo.uri, photo.modifiedAt, docId, position, record.size, text)
+                        if ((i + 1) % FLUSH_EVERY == 0) log.flush()
+                    }
+                    Metrics.photosRead.increment()
+                    onProgress?.invoke(i + 1, todo.size)
+                }
+                mutex.withLock {
+                    log.flush()
+                    checkpoint()
+                    if (log.size > COMPACT_MIN_BYTES && liveBytes < log.size / 2) compact()
+                }
+            }
+        }
+
+    suspend fun close(): Unit = mutex.withLock {
+        checkpoint()
+        index.close()
+        log.close()
+    }
+
+    private fun add(uri: String, modifiedAt: Long, docId: Long, position: Long, length: Int, text: String) {
+        remove(uri)
+        entries[uri] = Entry(docId, modifiedAt, position, length)
+        liveBytes += length
+        if (text.isNotEmpty()) {
+            index.upsert(docId, text)
+            uris[docId] = uri
+        }
+        nextDocId = maxOf(nextDocId, docId + 1)
+    }
+
+    private fun remove(uri: String) {
+        val entry = entries.remove(uri) ?: return
+        liveBytes -= entry.length
+        if (uris.remove(entry.docId) != null) index.delete(entry.docId)
+    }
+
+    /** Appends a `[length][crc][body]` record and returns its position. */
+    private inline fun writeRecord(body: ByteBuilder.() -> Unit): Long {
+        record.clear()
+        record.putInt(0).putInt(0)
+        record.body()
+        record.setInt(0, record.size - 8)
+        record.setInt(4, Crc32.of(record.bytes, 8, record.size - 8))
+        return log.append(record.bytes, 0, record.size)
+    }
+
+    private fun read(entry: Entry): String {
+        val input = ByteReader(log.readBytes(entry.position + 8, entry.length - 8))
+        input.byte()
+        input.string()
+        input.long()
+        input.long()
+        return input.string()
+    }
+
+    /** Persists the index along with the length of the log it covers. */
+    private fun checkpoint() {
+        log.sync()
+        index.watermark = log.size
+        index.flush()
+    }
+
+    /**
+     * Rewrites the log with only the live records. Everything is indexed and checkpointed first,
+     * so if the process dies before the new watermark is written, the stale one only makes the
+     * next open index a few photos again or none at all.
+     */
+    private fun compact() {
+        val tmpName = "$name.log.tmp"
+        storage.delete(tmpName)
+        val tmp = storage.open(tmpName)
+        tmp.append(header())
+        for ((uri, entry) in entries.entries.toList()) {
+            val bytes = log.readBytes(entry.position, entry.length)
+            entries[uri] = Entry(entry.docId, entry.modifiedAt, tmp.append(bytes), entry.length)
+        }
+        tmp.sync()
+        tmp.close()
+        log.close()
+        storage.rename(tmpName, "$name.log")
+        log = storage.open("$name.log")
+        checkpoint()
+    }
+
+    /** Replays the log; records past the index's watermark are indexed again. Truncates a torn tail. */
+    private fun replay() {
+        val bytes = log.readBytes(0, log.size.toInt())
+        val watermark = index.watermark
+        var pos = LOG_HEADER_SIZE
+        while (pos + 8 <= bytes.size) {
+            val length = bytes.getIntLe(pos)
+            if (length <= 0 || pos + 8 + length > bytes.size) break
+            if (Crc32.of(bytes, pos + 8, length) != bytes.getIntLe(pos + 4)) break
+            val input = ByteReader(bytes, pos + 8, pos + 8 + length)
+            when (input.byte()) {
+                ADD -> {
+                    val uri = input.string()
+                    val modifiedAt = input.long()
+                    val docId = input.long()
+                    val text = input.string()
+                    if (pos >= watermark) {
+                        add(uri, modifiedAt, docId, pos.toLong(), 8 + length, text)
+                    } else {
+                        // Already in the index: only the bookkeeping is restored.
+                        entries.remove(uri)?.let { liveBytes -= it.length }
+                        entries[uri] = Entry(docId, modifiedAt, pos.toLong(), 8 + length)
+                        liveBytes += 8 + length
+                        if (text.isNotEmpty()) uris[docId] = uri
+                        nextDocId = maxOf(nextDocId, docId + 1)
+                    }
+                }
+                REMOVE -> {
+                    val uri = input.string()
+                    if (pos >= watermark) remove(uri) else entries.remove(uri)?.let { liveBytes -= it.length }
+                }
+            }
+            pos += 8 + length
+        }
+        uris.keys.retainAll(entries.values.mapTo(HashSet()) { it.docId })
+        if (pos < bytes.size) log.truncate(pos.toLong())
+    }
+
+    companion object {
+        private const val LOG_MAGIC = 0x54584850 // "PHXT"
+        private const val LOG_VERSION = 1
+        private const val LOG_HEADER_SIZE = 8
+        private const val ADD = 1
+        private const val REMOVE = 2
+        private const val FLUSH_EVERY = 16
+        private const val COMPACT_MIN_BYTES = 256 * 1024L
+
+        /** Reads photos one at a time, off the threads that search and render. */
+        private val worker = backgroundDispatcher("photo-text")
+
+        private fun header(): ByteArray = ByteBuilder(LOG_HEADER_SIZE).putInt(LOG_MAGIC).putInt(LOG_VERSION).toByteArray()
+
+        /** [minSide] is the resolution photos are decoded at; text needs more than thumbnails do. */
+        suspend fun open(storage: Storage, pipeline: OcrPipeline, name: String = "photo-text", minSide: Int = 720): PhotoTextIndex =
+            withContext(Dispatchers.Default) {
+                val log = storage.open("$name.log")
+                val photos = PhotoTextIndex(storage, name, pipeline, FullTextIndex.open(storage, name), log, minSide)
+                if (log.size >= LOG_HEADER_SIZE && log.readBytes(0, LOG_HEADER_SIZE).contentEquals(header())) {
+                    photos.replay()
+                } else {
+                    log.truncate(0)
+                    log.append(header())
+                    log.sync()
+                    photos.index.watermark = 0
+                }
+                photos
+            }
+    }
+}
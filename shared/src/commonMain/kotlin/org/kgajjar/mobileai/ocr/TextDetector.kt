@@ -0,0 +1,119 @@
+package org.kgajjar.mobileai.ocr
+
+import org.kgajjar.mobileai.collections.IntArrayList
+import org.kgajjar.mobileai.vision.ImageResizer
+import org.kgajjar.mobileai.vision.RgbImage
+import kotlin.math.roundToInt
+
+/** An axis-aligned text region in image pixels; [right] and [bottom] are exclusive. */
+data class TextBox(val left: Int, val top: Int, val right: Int, val bottom: Int, val score: Float) {
+    val width: Int get() = right - left
+    val height: Int get() = bottom - top
+}
+
+/** A segmentation text detector (DBNet-style): a per-pixel probability of lying inside text. */
+interface TextDetectionModel {
+    /** Longest input side; inputs are scaled down to it and to multiples of 32. */
+    val maxSide: Int
+
+    /** Per-channel RGB normalization the model was trained with, applied to values in [0, 1]. */
+    val mean: FloatArray
+    val std: FloatArray
+
+    /** Text probabilities of a planar RGB `width × height` input, row by row. */
+    suspend fun probabilities(pixels: FloatArray, width: Int, height: Int): FloatArray
+}
+
+/**
+ * Finds text boxes with a [TextDetectionModel]: thresholds its probability map at [threshold],
+ * takes the 4-connected regions, drops those smaller than [minSize] or whose mean probability
+ * is under [boxThreshold], and grows each by the usual DB "unclip" margin, `area × unclipRatio
+ * / perimeter`, since the model is trained to mark a shrunk core of every word.
+ */
+class TextDetector(
+    private val model: TextDetectionModel,
+    private val threshold: Float = 0.3f,
+    private val boxThreshold: Float = 0.5f,
+    private val unclipRatio: Float = 1.5f,
+    private val minSize: Int = 3,
+) {
+    suspend fun detect(image: RgbImage): List<TextBox> {
+        val scale = minOf(1f, model.maxSide.toFloat() / maxOf(image.width, image.height))
+        val width = roundTo32(image.width * scale)
+        val height = roundTo32(image.height * scale)
+        val input = if (width == image.width && height == image.height) image else ImageResizer.area(image, width, height)
+        val probabilities = model.probabilities(planar(input), width, height)
+        check(probabilities.size == width * height) { "expected ${width * height} probabilities, got ${probabilities.size}" }
+
+        val sx = image.width.toFloat() / width
+        val sy = image.height.toFloat() / height
+        return regions(probabilities, width, height).map { box ->
+            val margin = box.width * box.height * unclipRatio / (2 * (box.width + box.height))
+            TextBox(
+                left = ((box.left - margin) * sx).toInt().coerceAtLeast(0),
+                top = ((box.top - margin) * sy).toInt().coerceAtLeast(0),
+                right = ((box.right + margin) * sx).roundToInt().coerceAtMost(image.width),
+                bottom = ((box.bottom + margin) * sy).roundToInt().coerceAtMost(image.height),
+                score = box.score,
+            )
+        }
+    }
+
+    private fun planar(image: RgbImage): FloatArray {
+        val plane = image.width * image.height
+        val out = FloatArray(3 * plane)
+        for (ch in 0 until 3) {
+            val scale = 1f / (255f * model.std[ch])
+            val bias = -model.mean[ch] / model.std[ch]
+            val shift = 16 - 8 * ch
+            for (i in 0 until plane) out[ch * plane + i] = ((image.pixels[i] shr shift) and 0xFF) * scale + bias
+        }
+        return out
+    }
+
+    /** Bounding boxes of the connected regions above [threshold], in map pixels. */
+    private fun regions(map: FloatArray, width: Int, height: Int): List<TextBox> {
+        val seen = BooleanArray(map.size)
+        val stack = IntArrayList(64)
+        val boxes = ArrayList<TextBox>()
+        for (start in map.indices) {
+            if (seen[start] || map[start] <= threshold) continue
+            var left = width
+            var top = height
+            var right = 0
+            var bottom = 0
+            var sum = 0f
+            var count = 0
+            seen[start] = true
+            stack.add(start)
+            while (stack.size > 0) {
+                val p = stack.removeLast()
+                val x = p % width
+                val y = p / width
+                left = minOf(left, x)
+                right = maxOf(right, x + 1)
+                top = minOf(top, y)
+                bottom = maxOf(bottom, y + 1)
+                sum += map[p]
+                count++
+                if (x > 0) visit(p - 1, map, seen, stack)
+                if (x < width - 1) visit(p + 1, map, seen, stack)
+                if (y > 0) visit(p - width, map, seen, stack)
+                if (y < height - 1) visit(p + width, map, seen, stack)
+            }
+            val score = sum / count
+            if (minOf(right - left, bottom - top) >= minSize && score >= boxThreshold) {
+                boxes += TextBox(left, top, right, bottom, score)
+            }
+        }
+        return boxes
+    }
+
+    private fun visit(p: Int, map: FloatArray, seen: BooleanArray, stack: IntArrayList) {
+        if (seen[p] || map[p] <= threshold) return
+        seen[p] = true
+        stack.add(p)
+    }
+
+    private fun roundTo32(size: Float): Int = maxOf(32, (size / 32).roundToInt() * 32)
+}
@@ -0,0 +1,98 @@
+package org.kgajjar.mobileai.ocr
+
+import org.kgajjar.mobileai.vision.ImageResizer
+import org.kgajjar.mobileai.vision.RgbImage
+import kotlin.math.exp
+import kotlin.math.roundToInt
+
+/**
+ * A text-line recognizer (CRNN-style) trained with CTC: it reads a grey crop [height] pixels
+ * tall and emits one distribution per [stride] columns over the blank (class 0) and [alphabet].
+ */
+interface TextRecognitionModel {
+    val height: Int
+    val stride: Int
+    val alphabet: String
+
+    /** Crops per [logits] call that keep the model busiest. */
+    val batchSize: Int
+
+    /**
+     * Logits of [count] crops packed one after another in [pixels], each `height × width` grey
+     * values in [-1, 1], row by row. Each result holds `width / stride` steps of
+     * `alphabet.length + 1` classes.
+     */
+    suspend fun logits(pixels: FloatArray, width: Int, count: Int): List<FloatArray>
+}
+
+class RecognizedText(val text: String, val confidence: Float)
+
+/**
+ * Reads the text in boxes found by a [TextDetector]. Crops are scaled to the model's height and
+ * batched by similar width, so little of each batch is padding; padding repeats a crop's last
+ * column, which decodes as more of whatever ended the line. Output is greedy CTC: the best class
+ * per step, with repeats merged and blanks dropped.
+ */
+class TextRecognizer(private val model: TextRecognitionModel, private val maxWidth: Int = 1024) {
+    private class Crop(val index: Int, val grey: FloatArray, val width: Int)
+
+    suspend fun recognize(image: RgbImage, boxes: List<TextBox>): List<RecognizedText> {
+        val height = model.height
+        val crops = boxes.mapIndexedNotNull { i, box ->
+            if (box.width <= 0 || box.height <= 0) return@mapIndexedNotNull null
+            val width = (box.width.toFloat() * height / box.height).roundToInt().coerceIn(model.stride, maxWidth)
+            val cropped = crop(image, box)
+            val scaled = if (cropped.width == width && cropped.height == height) cropped else ImageResizer.area(cropped, width, height)
+            Crop(i, FloatArray(width * height) { grey(scaled.pixels[it]) }, width)
+        }.sortedBy { it.width }
+
+        val results = arrayOfNulls<RecognizedText>(boxes.size)
+        for (batch in crops.chunked(maxOf(1, model.batchSize))) {
+            val width = batch.last().width
+            val pixels = FloatArray(batch.size * height * width)
+            for ((b, crop) in batch.withIndex()) {
+                for (y in 0 until height) {
+                    val row = b * height * width + y * width
+                    crop.grey.copyInto(pixels, row, y * crop.width, (y + 1) * crop.width)
+                    pixels.fill(crop.grey[(y + 1) * crop.width - 1], row + crop.width, row + width)
+                }
+            }
+            val logits = model.logits(pixels, width, batch.size)
+            for ((b, crop) in batch.withIndex()) results[crop.index] = decode(logits[b], crop.width / model.stride)
+        }
+        return results.map { it ?: RecognizedText("", 0f) }
+    }
+
+    /** Greedy CTC decoding of the first [steps] steps; confidence is the mean best probability. */
+    internal fun decode(logits: FloatArray, steps: Int): RecognizedText {
+        val classes = model.alphabet.length + 1
+        val text = StringBuilder()
+        var previous = 0
+        var confidence = 0f
+        for (t in 0 until steps) {
+            val base = t * classes
+            var best = 0
+            for (c in 1 until classes) if (logits[base + c] > logits[base + best]) best = c
+            var sum = 0f
+            for (c in 0 until classes) sum += exp(logits[base + c] - logits[base + best])
+            confidence += 1f / sum
+            if (best != 0 && best != previous) text.append(model.alphabet[best - 1])
+            previous = best
+        }
+        return RecognizedText(text.toString(), if (steps == 0) 0f else confidence / steps)
+    }
+
+    private fun crop(image: RgbImage, box: TextBox): RgbImage {
+        val pixels = IntArray(box.width * box.height)
+        for (y in 0 until box.height) {
+            image.pixels.copyInto(pixels, y * box.width, (box.top + y) * image.width + box.left, (box.top + y) * image.width + box.right)
+        }
+        return RgbImage(box.width, box.height, pixels)
+    }
+
+    /** Luma scaled to [-1, 1]. */
+    private fun grey(p: Int): Float {
+        val luma = 0.299f * ((p shr 16) and 0xFF) + 0.587f * ((p shr 8) and 0xFF) + 0.114f * (p and 0xFF)
+        return luma / 127.5f - 1f
+    }
+}
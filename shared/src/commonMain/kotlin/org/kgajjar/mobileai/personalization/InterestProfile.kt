@@ -0,0 +1,99 @@
+package org.kgajjar.mobileai.personalization
+
+import org.kgajjar.mobileai.storage.ByteBuilder
+import org.kgajjar.mobileai.storage.ByteReader
+import kotlin.math.pow
+import kotlin.math.sqrt
+
+/**
+ * Exponentially decayed sum of the embeddings of things the user interacted with.
+ *
+ * The vector is kept as `values * scale`: decaying everything by a factor only multiplies
+ * [scale], so an event costs one O(d) pass to add its embedding (divided by the current scale)
+ * and refresh the cached squared norm. [values] is rescaled only when [scale] gets small enough
+ * to threaten float precision.
+ */
+class InterestProfile(val dimension: Int, val halfLifeMillis: Long = 14L * 24 * 60 * 60 * 1000) {
+    private val values = FloatArray(dimension)
+    private var scale = 1.0
+    private var squaredNorm = 0.0
+    private var weight = 0.0
+    private var updatedAt = 0L
+
+    /** Total event weight after decay, as of the last event; a rough measure of confidence. */
+    val mass: Double get() = weight * scale
+
+    fun record(embedding: FloatArray, eventWeight: Float, at: Long) {
+        require(embedding.size == dimension) { "expected $dimension dimensions, got ${embedding.size}" }
+        decayTo(at)
+        val w = eventWeight / scale
+        var sum = 0.0
+        for (i in 0 until dimension) {
+            val v = values[i] + (w * embedding[i]).toFloat()
+            values[i] = v
+            sum += v * v
+        }
+        squaredNorm = sum
+        weight += w
+    }
+
+    /** Cosine similarity with [embedding]; 0 while the profile is empty. Decay does not change direction. */
+    fun similarity(embedding: FloatArray): Float {
+        if (squaredNorm == 0.0) return 0f
+        var dot = 0.0
+        var embeddingNorm = 0.0
+        for (i in 0 until dimension) {
+            dot += values[i] * embedding[i]
+            embeddingNorm += embedding[i] * embedding[i]
+        }
+        if (embeddingNorm == 0.0) return 0f
+        return (dot / sqrt(squaredNorm * embeddingNorm)).toFloat()
+    }
+
+    /** The current direction of interest as a unit vector, or null while the profile is empty. */
+    fun direction(): FloatArray? {
+        if (squaredNorm == 0.0) return null
+        val inverse = 1.0 / sqrt(squaredNorm)
+        return FloatArray(dimension) { (values[it] * inverse).toFloat() }
+    }
+
+    fun writeTo(out: ByteBuilder) {
+        out.putInt(dimension).putLong(halfLifeMillis).putLong(updatedAt)
+        out.putLong(mass.toRawBits())
+        for (v in values) out.putFloat((v * scale).toFloat())
+    }
+
+    private fun decayTo(at: Long) {
+        if (updatedAt != 0L && at > updatedAt) {
+            scale *= 0.5.pow((at - updatedAt).toDouble() / halfLifeMillis)
+        }
+        if (at > updatedAt) updatedAt = at
+        if (scale < RESCALE_BELOW) {
+            var sum = 0.0
+            for (i in 0 until dimension) {
+                values[i] = (values[i] * scale).toFloat()
+                sum += values[i] * values[i]
+            }
+            squaredNorm = sum
+            weight *= scale
+            scale = 1.0
+        }
+    }
+
+    companion object {
+        private const val RESCALE_BELOW = 1e-6
+
+        fun readFrom(input: ByteReader): InterestProfile {
+            val profile = InterestProfile(input.int(), input.long())
+            profile.updatedAt = input.long()
+            profile.weight = Double.fromBits(input.long())
+            var sum = 0.0
+            for (i in 0 until profile.dimension) {
+                profile.values[i] = input.float()
+                sum += profile.values[i] * profile.values[i]
+            }
+            profile.squaredNorm = sum
+            return profile
+        }
+    }
+}
@@ -0,0 +1,161 @@
+package org.kgajjar.mobileai.personalization
+
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.Job
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.sync.Mutex
+import kotlinx.coroutines.sync.withLock
+import kotlinx.coroutines.withContext
+import org.kgajjar.mobileai.epochMillis
+import org.kgajjar.mobileai.ingest.HashingTextEncoder
+import org.kgajjar.mobileai.settings.UserSettings
+import org.kgajjar.mobileai.storage.ByteBuilder
+import org.kgajjar.mobileai.storage.ByteReader
+import org.kgajjar.mobileai.storage.Crc32
+import org.kgajjar.mobileai.storage.Storage
+import org.kgajjar.mobileai.storage.getIntLe
+import org.kgajjar.mobileai.storage.readBytes
+import kotlin.time.Duration
+import kotlin.time.Duration.Companion.seconds
+
+enum class Interaction(val weight: Float) {
+    OpenedResult(1f),
+    LikedAnswer(2f),
+    SentMessage(0.5f),
+}
+
+/**
+ * Learns what the user cares about from their interactions and blends it into rankings.
+ *
+ * Each interaction folds the embedding of the text involved into an [InterestProfile]; nothing is
+ * ever recomputed from history. The profile is persisted to `<name>.profile` in the background
+ * [saveDelay] after the first unsaved interaction, so a burst of interactions is one write.
+ * Rankings mix the caller's own relevance with profile affinity, and personalization fades in
+ * as the profile accumulates weight. Everything is skipped while the user has personalized
+ * suggestions turned off.
+ */
+class Personalizer private constructor(
+    private val storage: Storage,
+    private val name: String,
+    private val scope: CoroutineScope,
+    private val saveDelay: Duration,
+    private val settings: UserSettings,
+    private val encoder: HashingTextEncoder,
+    private val profile: InterestProfile,
+) {
+    private val mutex = Mutex()
+    private var pendingSave: Job? = null
+
+    suspend fun record(interaction: Interaction, text: String, at: Long = epochMillis()) {
+        if (!settings.personalizedSuggestions || text.isBlank()) return
+        withContext(Dispatchers.Default) {
+            val embedding = encoder.embed(text)
+            mutex.withLock {
+                profile.record(embedding, interaction.weight, at)
+                scheduleSave()
+            }
+        }
+    }
+
+    /** Saves any interactions recorded since the last save. */
+    suspend fun flush() = withContext(Dispatchers.Default) {
+        mutex.withLock {
+            val pending = pendingSave ?: return@withLock
+            pending.cancel()
+            pendingSave = null
+            save()
+        }
+    }
+
+    /** Embeds [text] in the profile's vector space. */
+    fun embed(text: String): FloatArray = encoder.embed(text)
+
+    /** Unit interest vector, or null when there is no profile yet or personalization is off. */
+    suspend fun interest(): FloatArray? {
+        if (!settings.personalizedSuggestions) return null
+        return mutex.withLock { profile.direction() }
+    }
+
+    /** Total decayed interaction weight behind [interest]. */
+    suspend fun confidence(): Double = mutex.withLock { profile.mass }
+
+    /**
+     * Reorders [items] by `(1 - a) * relevance / maxRelevance + a * affinity`, where `a` grows
+     * from 0 to [MAX_BLEND] with the profile's mass. Returns [items] unchanged when off.
+     */
+    suspend fun <T> rerank(items: List<T>, relevance: (T) -> Float, text: (T) -> String): List<T> {
+        if (!settings.personalizedSuggestions || items.size < 2) return items
+        return withContext(Dispatchers.Default) {
+            val embeddings = items.map { encoder.embed(text(it)) }
+            mutex.withLock {
+                val mass = profile.mass
+                if (mass == 0.0) return@withLock items
+                val blend = MAX_BLEND * (mass / (mass + HALF_CONFIDENCE_MASS)).toFloat()
+                val maxRelevance = items.maxOf(relevance).takeIf { it > 0f } ?: 1f
+                val scores = FloatArray(items.size) { i ->
+                    val affinity = profile.similarity(embeddings[i]).coerceAtLeast(0f)
+                    (1 - blend) * relevance(items[i]) / maxRelevance + blend * affinity
+                }
+                items.indices.sortedByDescending { scores[it] }.map { items[it] }
+            }
+        }
+    }
+
+    private fun scheduleSave() {
+        if (pendingSave != null) return
+        pendingSave = scope.launch(Dispatchers.Default) {
+            delay(saveDelay)
+            mutex.withLock {
+                // Interactions from here on are saved by the next write.
+                pendingSave = null
+                save()
+            }
+        }
+    }
+
+    private fun save() {
+        val out = ByteBuilder(64 + profile.dimension * 4)
+        out.putInt(MAGIC)
+        profile.writeTo(out)
+        out.putInt(Crc32.of(out.bytes, 0, out.size))
+        val tmpName = "$name.profile.tmp"
+        storage.delete(tmpName)
+        val file = storage.open(tmpName)
+        file.append(out.bytes, 0, out.size)
+        file.sync()
+        file.close()
+        storage.rename(tmpName, "$name.profile")
+    }
+
+    companion object {
+        private const val MAGIC = 0x5049414D // "MAIP"
+        private const val MAX_BLEND = 0.35f
+        private const val HALF_CONFIDENCE_MASS = 3.0
+
+        suspend fun open(
+            storage: Storage,
+            scope: CoroutineScope,
+            settings: UserSettings,
+            name: String = "interests",
+            saveDelay: Duration = 2.seconds,
+        ): Personalizer = withContext(Dispatchers.Default) {
+            val encoder = HashingTextEncoder()
+            val profile = load(storage, "$name.profile")?.takeIf { it.dimension == encoder.dimension }
+            Personalizer(storage, name, scope, saveDelay, settings, encoder, profile ?: InterestProfile(encoder.dimension))
+        }
+
+        /** The saved profile, or null if there is none or it is damaged. */
+        private fun load(storage: Storage, fileName: String): InterestProfile? {
+            if (!storage.exists(fileName)) return null
+            val file = storage.open(fileName)
+            val bytes = file.readBytes(0, file.size.toInt())
+            file.close()
+            if (bytes.size < 8 || Crc32.of(bytes, 0, bytes.size - 4) != bytes.getIntLe(bytes.size - 4)) return null
+            val input = ByteReader(bytes, limit = bytes.size - 4)
+            if (input.int() != MAGIC) return null
+            return InterestProfile.readFrom(input)
+        }
+    }
+}
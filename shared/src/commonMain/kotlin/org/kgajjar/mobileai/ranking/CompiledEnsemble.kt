@@ -0,0 +1,147 @@
+package org.kgajjar.mobileai.ranking
+
+/**
+ * [TreeEnsemble] compiled for fast batch scoring.
+ *
+ * Every tree is padded to a complete binary tree of its depth (a leaf above the bottom is
+ * copied into both subtrees), so nodes can be laid out implicitly in heap order: the children
+ * of node `i` are `2i + 1` and `2i + 2`, and a traversal is exactly `depth` steps of
+ * `i = 2i + 1 + (x >= t)` with no data-dependent branch and no child pointers. All trees'
+ * split features and thresholds share two flat arrays (struct of arrays), leaves a third.
+ *
+ * [scoreBatch] walks tree by tree over all rows, so one tree's nodes stay in cache while the
+ * rows stream past, and advances four rows at a time to keep independent loads in flight.
+ * Trees deeper than [MAX_DEPTH], whose padding would explode, are evaluated as-is.
+ */
+class CompiledEnsemble(ensemble: TreeEnsemble) {
+    val featureCount: Int = ensemble.featureCount
+    private val baseScore = ensemble.baseScore
+
+    private val depths: IntArray
+    private val splitOffsets: IntArray
+    private val leafOffsets: IntArray
+    private val features: IntArray
+    private val thresholds: FloatArray
+    private val leaves: FloatArray
+    private val deepTrees: List<TreeEnsemble.Tree>
+
+    init {
+        val (shallow, deep) = ensemble.trees.partition { depthOf(it, 0) <= MAX_DEPTH }
+        deepTrees = deep
+        depths = IntArray(shallow.size) { depthOf(shallow[it], 0) }
+        splitOffsets = IntArray(shallow.size)
+        leafOffsets = IntArray(shallow.size)
+        var splitCount = 0
+        var leafCount = 0
+        for (t in shallow.indices) {
+            splitOffsets[t] = splitCount
+            leafOffsets[t] = leafCount
+            splitCount += (1 shl depths[t]) - 1
+            leafCount += 1 shl depths[t]
+        }
+        features = IntArray(splitCount)
+        thresholds = FloatArray(splitCount)
+        leaves = FloatArray(leafCount)
+        for (t in shallow.indices) layOut(shallow[t], 0, 0, depths[t], splitOffsets[t], leafOffsets[t])
+    }
+
+    fun score(row: FloatArray, offset: Int = 0): Float {
+        var sum = baseScore
+        for (t in depths.indices) {
+            val splits = splitOffsets[t]
+            var i = 0
+            repeat(depths[t]) {
+                val s = splits + i
+                i = 2 * i + 1 + step(row[offset + features[s]], thresholds[s])
+            }
+            sum += leaves[leafOffsets[t] + i - ((1 shl depths[t]) - 1)]
+        }
+        for (tree in deepTrees) sum += tree.value[tree.leafFor(row, offset)]
+        return sum
+    }
+
+    /**
+     * Scores [rows] feature vectors stored back to back in [matrix] (row-major, [featureCount]
+     * floats each) into [out].
+     */
+    fun scoreBatch(matrix: FloatArray, rows: Int, out: FloatArray) {
+        require(matrix.size >= rows * featureCount && out.size >= rows) { "batch of $rows rows does not fit" }
+        out.fill(baseScore, 0, rows)
+        val stride = featureCount
+        for (t in depths.indices) {
+            val depth = depths[t]
+            val splits = splitOffsets[t]
+            val leafBase = leafOffsets[t] - ((1 shl depth) - 1)
+            var r = 0
+            while (r + 4 <= rows) {
+                val o0 = r * stride
+                val o1 = o0 + stride
+                val o2 = o1 + stride
+                val o3 = o2 + stride
+                var i0 = 0
+                var i1 = 0
+                var i2 = 0
+                var i3 = 0
+                repeat(depth) {
+                    val s0 = splits + i0
+                    val s1 = splits + i1
+                    val s2 = splits + i2
+                    val s3 = splits + i3
+                    i0 = 2 * i0 + 1 + step(matrix[o0 + features[s0]], thresholds[s0])
+                    i1 = 2 * i1 + 1 + step(matrix[o1 + features[s1]], thresholds[s1])
+                    i2 = 2 * i2 + 1 + step(matrix[o2 + features[s2]], thresholds[s2])
+                    i3 = 2 * i3 + 1 + step(matrix[o3 + features[s3]], thresholds[s3])
+                }
+                out[r] += leaves[leafBase + i0]
+                out[r + 1] += leaves[leafBase + i1]
+                out[r + 2] += leaves[leafBase + i2]
+                out[r + 3] += leaves[leafBase + i3]
+                r += 4
+            }
+            while (r < rows) {
+                val o = r * stride
+                var i = 0
+                repeat(depth) {
+                    val s = splits + i
+                    i = 2 * i + 1 + step(matrix[o + features[s]], thresholds[s])
+                }
+                out[r] += leaves[leafBase + i]
+                r++
+            }
+        }
+        for (tree in deepTrees) {
+            for (r in 0 until rows) out[r] += tree.value[tree.leafFor(matrix, r * stride)]
+        }
+    }
+
+    /** Writes the subtree at [node] into heap position [position] at [level] of a tree of [depth]. */
+    private fun layOut(tree: TreeEnsemble.Tree, node: Int, position: Int, depth: Int, splits: Int, leafBase: Int) {
+        val level = 31 - (position + 1).countLeadingZeroBits()
+        if (level == depth) {
+            leaves[leafBase + position - ((1 shl depth) - 1)] = tree.value[node]
+            return
+        }
+        if (tree.feature[node] < 0) {
+            // Padding: both ways lead to the same leaf value.
+            features[splits + position] = 0
+            thresholds[splits + position] = 0f
+            layOut(tree, node, 2 * position + 1, depth, splits, leafBase)
+            layOut(tree, node, 2 * position + 2, depth, splits, leafBase)
+        } else {
+            features[splits + position] = tree.feature[node]
+            thresholds[splits + position] = tree.threshold[node]
+            layOut(tree, tree.left[node], 2 * position + 1, depth, splits, leafBase)
+            layOut(tree, tree.right[node], 2 * position + 2, depth, splits, leafBase)
+        }
+    }
+
+    private companion object {
+        const val MAX_DEPTH = 12
+
+        /** 0 when `x < threshold`, else 1 (NaN included), matching [TreeEnsemble]. */
+        fun step(x: Float, threshold: Float): Int = if (x < threshold) 0 else 1
+
+        fun depthOf(tree: TreeEnsemble.Tree, node: Int): Int =
+            if (tree.feature[node] < 0) 0 else 1 + maxOf(depthOf(tree, tree.left[node]), depthOf(tree, tree.right[node]))
+    }
+}
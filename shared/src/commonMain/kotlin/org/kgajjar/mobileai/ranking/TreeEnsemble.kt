@@ -0,0 +1,113 @@
+package org.kgajjar.mobileai.ranking
+
+import org.kgajjar.mobileai.storage.ByteBuilder
+import org.kgajjar.mobileai.storage.ByteReader
+
+/**
+ * Additive ensemble of regression trees, as produced by gradient boosting: the score of a
+ * feature vector is [baseScore] plus the leaf value it reaches in every tree. A split sends
+ * `x < threshold` left and everything else, NaN included, right.
+ */
+class TreeEnsemble(val featureCount: Int, val trees: List<Tree>, val baseScore: Float = 0f) {
+    /** Nodes in parallel arrays; node 0 is the root and `feature[i] < 0` marks a leaf. */
+    class Tree(
+        val feature: IntArray,
+        val threshold: FloatArray,
+        val left: IntArray,
+        val right: IntArray,
+        val value: FloatArray,
+    ) {
+        val nodeCount: Int get() = feature.size
+
+        fun leafFor(features: FloatArray, offset: Int = 0): Int {
+            var node = 0
+            while (feature[node] >= 0) {
+                node = if (features[offset + feature[node]] < threshold[node]) left[node] else right[node]
+            }
+            return node
+        }
+    }
+
+    /** Tree under construction; see [tree]. */
+    sealed interface Node
+
+    class Split(val feature: Int, val threshold: Float, val left: Node, val right: Node) : Node
+
+    class Leaf(val value: Float) : Node
+
+    init {
+        for (tree in trees) {
+            for (f in tree.feature) require(f < featureCount) { "split on feature $f of $featureCount" }
+        }
+    }
+
+    fun score(features: FloatArray, offset: Int = 0): Float {
+        var sum = baseScore
+        for (tree in trees) sum += tree.value[tree.leafFor(features, offset)]
+        return sum
+    }
+
+    fun writeTo(out: ByteBuilder) {
+        out.putInt(featureCount).putFloat(baseScore).putInt(trees.size)
+        for (tree in trees) {
+            out.putInt(tree.nodeCount)
+            for (i in 0 until tree.nodeCount) {
+                out.putInt(tree.feature[i]).putFloat(tree.threshold[i])
+                out.putInt(tree.left[i]).putInt(tree.right[i]).putFloat(tree.value[i])
+            }
+        }
+    }
+
+    companion object {
+        fun readFrom(input: ByteReader): TreeEnsemble {
+            val featureCount = input.int()
+            val baseScore = input.float()
+            val trees = List(input.int()) {
+                val n = input.int()
+                val feature = IntArray(n)
+                val threshold = FloatArray(n)
+                val left = IntArray(n)
+                val right = IntArray(n)
+                val value = FloatArray(n)
+                for (i in 0 until n) {
+                    feature[i] = input.int()
+                    threshold[i] = input.float()
+                    left[i] = input.int()
+                    right[i] = input.int()
+                    value[i] = input.float()
+                }
+                Tree(feature, threshold, left, right, value)
+            }
+            return TreeEnsemble(featureCount, trees, baseScore)
+        }
+
+        /** Flattens a [Node] tree into the array layout, in preorder. */
+        fun tree(root: Node): Tree {
+            val feature = ArrayList<Int>()
+            val threshold = ArrayList<Float>()
+            val left = ArrayList<Int>()
+            val right = ArrayList<Int>()
+            val value = ArrayList<Float>()
+            fun visit(node: Node): Int {
+                val index = feature.size
+                feature += -1
+                threshold += 0f
+                left += -1
+                right += -1
+                value += 0f
+                when (node) {
+                    is Leaf -> value[index] = node.value
+                    is Split -> {
+                        feature[index] = node.feature
+                        threshold[index] = node.threshold
+                        left[index] = visit(node.left)
+                        right[index] = visit(node.right)
+                    }
+                }
+                return index
+            }
+            visit(root)
+            return Tree(feature.toIntArray(), threshold.toFloatArray(), left.toIntArray(), right.toIntArray(), value.toFloatArray())
+        }
+    }
+}
@@ -0,0 +1,126 @@
+package org.kgajjar.mobileai.sampling
+
+import org.kgajjar.mobileai.collections.IntArrayList
+import org.kgajjar.mobileai.tokenizer.Tokenizer
+import org.kgajjar.mobileai.tokenizer.encode
+
+/**
+ * Logit biases, banned tokens and words, and an optional allowed vocabulary, compiled once for
+ * a vocabulary of [vocabSize] tokens and then applied to the logits of every decoding step.
+ *
+ * Biases are a sparse `(id, bias)` list. Bans and the allowed set are dense bitsets of 64 tokens
+ * per word, applied a word at a time so that all-clear (or, for the allowed set, all-set) words
+ * cost one compare. A banned word that spans several tokens is a sparse sequence ban: its last
+ * token is masked only when the tokens before it were just generated. Nothing is detokenized
+ * while decoding.
+ */
+class LogitConstraints private constructor(
+    val vocabSize: Int,
+    private val biasIds: IntArray,
+    private val biasValues: FloatArray,
+    private val banned: LongArray,
+    private val allowed: LongArray?,
+    private val sequences: List<IntArray>,
+) {
+    /** Bits of the last allowed-set word that are inside the vocabulary. */
+    private val lastWordMask = if ((vocabSize and 63) == 0) -1L else (1L shl (vocabSize and 63)) - 1
+
+    /** Applies the constraints in place; [history] holds the tokens generated so far. */
+    fun apply(logits: FloatArray, history: IntArrayList? = null) {
+        require(logits.size >= vocabSize) { "expected $vocabSize logits, got ${logits.size}" }
+        for (i in biasIds.indices) logits[biasIds[i]] += biasValues[i]
+        for (w in banned.indices) {
+            var bits = banned[w]
+            while (bits != 0L) {
+                logits[(w shl 6) + bits.countTrailingZeroBits()] = Float.NEGATIVE_INFINITY
+                bits = bits and (bits - 1)
+            }
+        }
+        if (allowed != null) {
+            for (w in allowed.indices) {
+                var bits = allowed[w].inv()
+                if (bits == 0L) continue
+                if (w == allowed.lastIndex) bits = bits and lastWordMask
+                while (bits != 0L) {
+                    logits[(w shl 6) + bits.countTrailingZeroBits()] = Float.NEGATIVE_INFINITY
+                    bits = bits and (bits - 1)
+                }
+            }
+        }
+        if (history != null) {
+            for (sequence in sequences) {
+                if (endsWith(history, sequence)) logits[sequence.last()] = Float.NEGATIVE_INFINITY
+            }
+        }
+    }
+
+    /** Whether [history] ends with all but the last token of [sequence]. */
+    private fun endsWith(history: IntArrayList, sequence: IntArray): Boolean {
+        val prefix = sequence.size - 1
+        if (history.size < prefix) return false
+        val offset = history.size - prefix
+        for (i in 0 until prefix) if (history[offset + i] != sequence[i]) return false
+        return true
+    }
+
+    class Builder(private val vocabSize: Int) {
+        private val biases = LinkedHashMap<Int, Float>()
+        private val banned = LongArray((vocabSize + 63) ushr 6)
+        private var allowed: LongArray? = null
+        private val sequences = ArrayList<IntArray>()
+
+        /** Adds [bias] to the logit of [token]; biases for the same token add up. */
+        fun bias(token: Int, bias: Float) = apply {
+            checkToken(token)
+            biases[token] = (biases[token] ?: 0f) + bias
+        }
+
+        fun ban(token: Int) = apply {
+            checkToken(token)
+            banned[token ushr 6] = banned[token ushr 6] or (1L shl token)
+        }
+
+        /**
+         * Bans [word] as the tokenizer spells it on its own and after a space. Multi-token
+         * spellings are banned as sequences.
+         */
+        fun banWord(word: String, tokenizer: Tokenizer) = apply {
+            for (spelling in listOf(word, " $word")) {
+                val ids = tokenizer.encode(spelling)
+                when (ids.size) {
+                    0 -> {}
+                    1 -> ban(ids[0])
+                    else -> {
+                        ids.forEach { checkToken(it) }
+                        sequences += ids
+                    }
+                }
+            }
+        }
+
+        /** Restricts sampling to [tokens]; repeated calls widen the allowed set. */
+        fun allowOnly(tokens: Iterable<Int>) = apply {
+            val bits = allowed ?: LongArray(banned.size).also { allowed = it }
+            for (token in tokens) {
+                checkToken(token)
+                bits[token ushr 6] = bits[token ushr 6] or (1L shl token)
+            }
+        }
+
+        fun build(): LogitConstraints {
+            val entries = biases.entries.filter { it.value != 0f }.sortedBy { it.key }
+            return LogitConstraints(
+                vocabSize,
+                IntArray(entries.size) { entries[it].key },
+                FloatArray(entries.size) { entries[it].value },
+                banned.copyOf(),
+                allowed?.copyOf(),
+                sequences.toList(),
+            )
+        }
+
+        private fun checkToken(token: Int) {
+            require(token in 0 until vocabSize) { "token $token outside vocabulary of $vocabSize" }
+        }
+    }
+}
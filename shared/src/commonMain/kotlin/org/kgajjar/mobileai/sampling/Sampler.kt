@@ -0,0 +1,96 @@
+package org.kgajjar.mobileai.sampling
+
+import org.kgajjar.mobileai.collections.IntArrayList
+import org.kgajjar.mobileai.collections.ScoredHeap
+import kotlin.math.exp
+import kotlin.random.Random
+
+/**
+ * Picks the next token from a step's logits: [LogitConstraints] first, then temperature,
+ * top-k and nucleus (top-p) truncation. A [temperature] of 0 is greedy decoding.
+ *
+ * Top-k uses a bounded heap rather than a full sort, so a step costs one pass over the
+ * vocabulary plus `O(k log k)`. Not thread-safe; use one sampler per generation.
+ */
+class Sampler(
+    private val temperature: Float = 0.7f,
+    private val topK: Int = 40,
+    private val topP: Float = 0.95f,
+    seed: Long = Random.nextLong(),
+) {
+    private val random = Random(seed)
+    private val heap = ScoredHeap(maxFirst = false, topK.coerceAtLeast(1) + 1)
+    private var candidates = IntArray(0)
+    private var weights = FloatArray(0)
+
+    /**
+     * Samples from [logits] (modified in place by [constraints]). Returns -1 if the constraints
+     * leave no token possible.
+     */
+    fun sample(logits: FloatArray, constraints: LogitConstraints? = null, history: IntArrayList? = null): Int {
+        constraints?.apply(logits, history)
+        if (temperature <= 0f) return argMax(logits)
+
+        val k = if (topK <= 0) logits.size else minOf(topK, logits.size)
+        heap.clear()
+        for (i in logits.indices) {
+            val logit = logits[i]
+            if (logit == Float.NEGATIVE_INFINITY || logit.isNaN()) continue
+            if (heap.size < k) {
+                heap.push(logit, i)
+            } else if (logit > heap.topScore()) {
+                heap.pop()
+                heap.push(logit, i)
+            }
+        }
+        val count = heap.size
+        if (count == 0) return -1
+        if (candidates.size < count) {
+            candidates = IntArray(count)
+            weights = FloatArray(count)
+        }
+        // Drain worst-first, filling from the back so candidates end up best-first.
+        for (i in count - 1 downTo 0) {
+            weights[i] = heap.topScore()
+            candidates[i] = heap.pop()
+        }
+
+        val max = weights[0]
+        var total = 0f
+        for (i in 0 until count) {
+            weights[i] = exp((weights[i] - max) / temperature)
+            total += weights[i]
+        }
+        // Keep the smallest best-first prefix whose probability reaches topP.
+        var kept = count
+        if (topP < 1f) {
+            var mass = 0f
+            for (i in 0 until count) {
+                mass += weights[i]
+                if (mass >= topP * total) {
+                    kept = i + 1
+                    total = mass
+                    break
+                }
+            }
+        }
+        var target = random.nextFloat() * total
+        for (i in 0 until kept) {
+            target -= weights[i]
+            if (target <= 0f) return candidates[i]
+        }
+        return candidates[kept - 1]
+    }
+
+    private fun argMax(logits: FloatArray): Int {
+        var best = -1
+        var bestLogit = Float.NEGATIVE_INFINITY
+        for (i in logits.indices) {
+            if (logits[i] > bestLogit) {
+                bestLogit = logits[i]
+                best = i
+            }
+        }
+        return best
+    }
+}
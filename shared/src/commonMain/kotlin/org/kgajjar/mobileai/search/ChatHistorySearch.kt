@@ -0,0 +1,163 @@
+package org.kgajjar.mobileai.search
+
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.CoroutineStart
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.Job
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.sync.Mutex
+import kotlinx.coroutines.sync.withLock
+import kotlinx.coroutines.withContext
+import org.kgajjar.mobileai.chat.ConversationChange
+import org.kgajjar.mobileai.chat.ConversationStore
+import org.kgajjar.mobileai.epochMillis
+import org.kgajjar.mobileai.metrics.Metrics
+import org.kgajjar.mobileai.storage.Storage
+import org.kgajjar.mobileai.trace.Trace
+import kotlin.time.Duration
+import kotlin.time.Duration.Companion.milliseconds
+import kotlin.time.TimeSource
+
+data class ChatSearchHit(
+    val conversationId: Long,
+    val messageIndex: Int,
+    val title: String,
+    val snippet: String,
+    val score: Float,
+)
+
+/**
+ * Keeps a [FullTextIndex] of every chat message in step with a [ConversationStore].
+ *
+ * Store changes are collected into a dirty set and indexed [debounce] after the first one, so a
+ * streamed reply is re-indexed a few times rather than once per token; a search indexes whatever
+ * is still pending first, so results never lag what the user just typed. On open, conversations
+ * updated since the index's persisted watermark are re-indexed to recover what an unclean
+ * shutdown lost from the in-memory segment.
+ */
+class ChatHistorySearch private constructor(
+    private val store: ConversationStore,
+    private val index: FullTextIndex,
+    private val scope: CoroutineScope,
+    private val debounce: Duration,
+) {
+    private val mutex = Mutex()
+    private val dirty = LinkedHashSet<Long>()
+    private val removed = LinkedHashSet<Long>()
+    private var pendingIndexing: Job? = null
+    // Undispatched, so the subscription exists before catch-up reads the store.
+    private val collector: Job = scope.launch(start = CoroutineStart.UNDISPATCHED) {
+        store.changes.collect { change ->
+            mutex.withLock {
+                when (change) {
+                    is ConversationChange.MessageChanged -> dirty += docId(change.conversationId, change.messageIndex)
+                    is ConversationChange.Deleted -> repeat(change.messageCount) {
+                        val docId = docId(change.conversationId, it)
+                        dirty -= docId
+                        removed += docId
+                    }
+                    // The text was indexed as it changed.
+                    is ConversationChange.MessageFinished -> return@withLock
+                }
+                if (pendingIndexing == null) {
+                    pendingIndexing = scope.launch {
+                        delay(debounce)
+                        mutex.withLock {
+                            pendingIndexing = null
+                            indexPending()
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    suspend fun search(query: String, limit: Int = 20): List<ChatSearchHit> = withContext(Dispatchers.Default) {
+        Trace.span("search history", "search") {
+            val started = TimeSource.Monotonic.markNow()
+            val hits = mutex.withLock {
+                indexPending()
+                index.search(query, limit)
+            }
+            val terms = TextAnalyzer.terms(query)
+            hits.mapNotNull { hit ->
+                val conversationId = hit.docId ushr MESSAGE_BITS
+                val messageIndex = (hit.docId and MESSAGE_MASK).toInt()
+                // The index may still hold messages of a conversation deleted before an unclean shutdown.
+                val message = store.message(conversationId, messageIndex) ?: return@mapNotNull null
+                val title = store.conversation(conversationId)?.title ?: return@mapNotNull null
+                ChatSearchHit(conversationId, messageIndex, title, snippet(message.text, terms), hit.score)
+            }.also { Metrics.historySearchLatency.record(started.elapsedNow()) }
+        }
+    }
+
+    suspend fun close() {
+        collector.cancel()
+        mutex.withLock {
+            indexPending()
+            index.close()
+        }
+    }
+
+    /** Must be called with [mutex] held. */
+    private suspend fun indexPending() {
+        pendingIndexing?.cancel()
+        pendingIndexing = null
+        if (dirty.isEmpty() && removed.isEmpty()) return
+        val startedAt = epochMillis()
+        for (docId in removed) index.delete(docId)
+        removed.clear()
+        for (docId in dirty) {
+            val message = store.message(docId ushr MESSAGE_BITS, (docId and MESSAGE_MASK).toInt())
+            if (message == null) index.delete(docId) else index.upsert(docId, message.text)
+        }
+        Metrics.messagesIndexed.increment(dirty.size.toLong())
+        dirty.clear()
+        index.watermark = startedAt
+    }
+
+    private suspend fun catchUp() = mutex.withLock {
+        val since = index.watermark - CATCH_UP_MARGIN_MILLIS
+        val startedAt = epochMillis()
+        for (conversation in store.recent(Int.MAX_VALUE)) {
+            if (conversation.updatedAt < since) break
+            for (message in store.messages(conversation.id)) {
+                index.upsert(docId(message.conversationId, message.index), message.text)
+            }
+        }
+        index.watermark = startedAt
+        index.flush()
+    }
+
+    companion object {
+        private const val MESSAGE_BITS = 20
+        private const val MESSAGE_MASK = (1L shl MESSAGE_BITS) - 1
+        private const val CATCH_UP_MARGIN_MILLIS = 5_000L
+        private const val SNIPPET_CHARS = 160
+
+        suspend fun open(
+            store: ConversationStore,
+            storage: Storage,
+            scope: CoroutineScope,
+            debounce: Duration = 500.milliseconds,
+        ): ChatHistorySearch = withContext(Dispatchers.Default) {
+            ChatHistorySearch(store, FullTextIndex.open(storage, "history"), scope, debounce).also { it.catchUp() }
+        }
+
+        private fun docId(conversationId: Long, messageIndex: Int): Long =
+            (conversationId shl MESSAGE_BITS) or messageIndex.toLong()
+
+        /** A window of [text] around the first occurrence of any query term. */
+        internal fun snippet(text: String, terms: List<String>): String {
+            if (text.length <= SNIPPET_CHARS) return text
+            val match = terms.asSequence()
+                .map { text.indexOf(it, ignoreCase = true) }
+                .filter { it >= 0 }
+                .minOrNull() ?: 0
+            val start = (match - SNIPPET_CHARS / 4).coerceIn(0, text.length - SNIPPET_CHARS)
+            val end = start + SNIPPET_CHARS
+            return (if (start > 0) "…" else "") + text.substring(start, end).trim() + (if (end < text.length) "…" else "")
+        }
+    }
+}
@@ -0,0 +1,234 @@
+package org.kgajjar.mobileai.search
+
+import org.kgajjar.mobileai.storage.ByteBuilder
+import org.kgajjar.mobileai.storage.ByteReader
+import org.kgajjar.mobileai.storage.Crc32
+import org.kgajjar.mobileai.storage.Storage
+import org.kgajjar.mobileai.storage.getIntLe
+import org.kgajjar.mobileai.storage.readBytes
+import kotlin.math.ln
+
+/**
+ * Segmented inverted index with BM25 ranking.
+ *
+ * New and updated documents go to a small in-memory segment that is searchable immediately
+ * and sealed to an immutable segment file (`<name>.seg.<id>`) once it holds [flushThreshold]
+ * documents. The manifest (`<name>.manifest`) lists the sealed segments in order; when there
+ * are more than [MAX_SEGMENTS] of them they are merged into one, dropping superseded and
+ * deleted documents. A document's live version is tracked per id, so updates and deletes never
+ * rewrite sealed segments. Not thread-safe.
+ */
+class FullTextIndex private constructor(
+    private val storage: Storage,
+    private val name: String,
+    private val flushThreshold: Int,
+) : AutoCloseable {
+    data class Hit(val docId: Long, val score: Float)
+
+    private class DocRef(val segment: Int, val ordinal: Int, val length: Int)
+
+    private val live = HashMap<Long, DocRef>()
+    private var totalLength = 0L
+    private val sealed = ArrayList<DiskSegment>()
+    private var nextSegmentId = 1
+    private lateinit var memory: MemorySegment
+
+    /**
+     * Opaque progress marker persisted with the manifest on [flush]; owners use it to find
+     * what they still need to re-index after a crash.
+     */
+    var watermark = 0L
+
+    val documentCount: Int get() = live.size
+
+    fun upsert(docId: Long, text: String) {
+        remove(docId)
+        memory.deletes.remove(docId)
+        val terms = TextAnalyzer.terms(text)
+        val ordinal = memory.add(docId, terms)
+        live[docId] = DocRef(memory.id, ordinal, terms.size)
+        totalLength += terms.size
+        if (memory.docCount >= flushThreshold) flush()
+    }
+
+    fun delete(docId: Long) {
+        if (remove(docId)) memory.deletes += docId
+    }
+
+    /**
+     * Ranks live documents against [query]. Unless the query ends in whitespace its last term
+     * is treated as a prefix, for search-as-you-type.
+     */
+    fun search(query: String, limit: Int = 20): List<Hit> {
+        val queryTerms = TextAnalyzer.terms(query).distinct()
+        if (queryTerms.isEmpty() || live.isEmpty()) return emptyList()
+        val prefixLast = !query.last().isWhitespace()
+        val segments = sealed + memory
+
+        val terms = LinkedHashSet<String>()
+        queryTerms.forEachIndexed { i, term ->
+            if (prefixLast && i == queryTerms.lastIndex) {
+                terms += term
+                for (segment in segments) terms += segment.termsWithPrefix(term, MAX_PREFIX_EXPANSION)
+            } else {
+                terms += term
+            }
+        }
+
+        val averageLength = totalLength.toDouble() / live.size
+        val scores = HashMap<Long, Double>()
+        val matches = ArrayList<Long>()
+        val frequencies = ArrayList<Int>()
+        for (term in terms) {
+            matches.clear()
+            frequencies.clear()
+            for (segment in segments) {
+                segment.postings(term) { ordinal, tf ->
+                    val docId = segment.docId(ordinal)
+                    val ref = live[docId]
+                    if (ref != null && ref.segment == segment.id && ref.ordinal == ordinal) {
+                        matches += docId
+                        frequencies += tf
+                    }
+                }
+            }
+            if (matches.isEmpty()) continue
+            val df = matches.size.toDouble()
+            val idf = ln(1 + (live.size - df + 0.5) / (df + 0.5))
+            for (i in matches.indices) {
+                val tf = frequencies[i].toDouble()
+                val length = live.getValue(matches[i]).length
+                val norm = tf * (K1 + 1) / (tf + K1 * (1 - B + B * length / averageLength))
+                scores[matches[i]] = (scores[matches[i]] ?: 0.0) + idf * norm
+            }
+        }
+        return scores.entries
+            .sortedByDescending { it.value }
+            .take(limit)
+            .map { Hit(it.key, it.value.toFloat()) }
+    }
+
+    /** Seals the in-memory segment and persists the manifest with the current [watermark]. */
+    fun flush() {
+        if (memory.docCount > 0 || memory.deletes.isNotEmpty()) {
+            val segmentName = segmentName(memory.id)
+            storage.delete(segmentName)
+            val file = storage.open(segmentName)
+            memory.writeTo(file)
+            file.close()
+            sealed += DiskSegment(storage.open(segmentName))
+            memory = MemorySegment(nextSegmentId++)
+        }
+        if (sealed.size > MAX_SEGMENTS) mergeSealed()
+        writeManifest()
+    }
+
+    override fun close() {
+        flush()
+        sealed.forEach { it.close() }
+    }
+
+    private fun remove(docId: Long): Boolean {
+        val ref = live.remove(docId) ?: return false
+        totalLength -= ref.length
+        return true
+    }
+
+    /** Rewrites all sealed segments as one, keeping only live documents. */
+    private fun mergeSealed() {
+        val merged = MemorySegment(nextSegmentId++)
+        val remap = HashMap<Long, Int>()
+        for (segment in sealed) {
+            for (ordinal in 0 until segment.docCount) {
+                val docId = segment.docId(ordinal)
+                val ref = live[docId] ?: continue
+                if (ref.segment == segment.id && ref.ordinal == ordinal) {
+                    remap[key(segment.id, ordinal)] = merged.addDoc(docId, ref.length)
+                }
+            }
+        }
+        val terms = HashSet<String>()
+        for (segment in sealed) terms += segment.termsWithPrefix("", Int.MAX_VALUE)
+        for (term in terms) {
+            // Segments are visited in order and ordinals were assigned in that order too.
+            for (segment in sealed) {
+                segment.postings(term) { ordinal, tf ->
+                    remap[key(segment.id, ordinal)]?.let { merged.addPosting(term, it, tf) }
+                }
+            }
+        }
+
+        val segmentName = segmentName(merged.id)
+        storage.delete(segmentName)
+        val file = storage.open(segmentName)
+        merged.writeTo(file)
+        file.close()
+        for (ordinal in 0 until merged.docCount) {
+            val docId = merged.docId(ordinal)
+            live[docId] = DocRef(merged.id, ordinal, merged.docLength(ordinal))
+        }
+        val obsolete = sealed.toList()
+        sealed.clear()
+        sealed += DiskSegment(storage.open(segmentName))
+        writeManifest()
+        for (segment in obsolete) {
+            segment.close()
+            storage.delete(segmentName(segment.id))
+        }
+    }
+
+    private fun writeManifest() {
+        val out = ByteBuilder(64)
+        out.putInt(MANIFEST_MAGIC).putInt(nextSegmentId).putLong(watermark).putInt(sealed.size)
+        for (segment in sealed) out.putInt(segment.id)
+        out.putInt(Crc32.of(out.bytes, 0, out.size))
+        val tmpName = "$name.manifest.tmp"
+        storage.delete(tmpName)
+        val file = storage.open(tmpName)
+        file.append(out.bytes, 0, out.size)
+        file.sync()
+        file.close()
+        storage.rename(tmpName, "$name.manifest")
+    }
+
+    private fun load() {
+        val manifestName = "$name.manifest"
+        if (storage.exists(manifestName)) {
+            val file = storage.open(manifestName)
+            val bytes = file.readBytes(0, file.size.toInt())
+            file.close()
+            check(bytes.size >= 4 && Crc32.of(bytes, 0, bytes.size - 4) == bytes.getIntLe(bytes.size - 4)) {
+                "corrupt index manifest"
+            }
+            val input = ByteReader(bytes, limit = bytes.size - 4)
+            check(input.int() == MANIFEST_MAGIC) { "not an index manifest" }
+            nextSegmentId = input.int()
+            watermark = input.long()
+            repeat(input.int()) { sealed += DiskSegment(storage.open(segmentName(input.int()))) }
+        }
+        for (segment in sealed) {
+            for (ordinal in 0 until segment.docCount) {
+                remove(segment.docId(ordinal))
+                live[segment.docId(ordinal)] = DocRef(segment.id, ordinal, segment.docLength(ordinal))
+                totalLength += segment.docLength(ordinal)
+            }
+            for (docId in segment.deletes) remove(docId)
+        }
+        memory = MemorySegment(nextSegmentId++)
+    }
+
+    private fun segmentName(id: Int) = "$name.seg.$id"
+
+    private fun key(segment: Int, ordinal: Int): Long = (segment.toLong() shl 32) or ordinal.toLong()
+
+    companion object {
+        private const val MANIFEST_MAGIC = 0x4D46414D // "MAFM"
+        private const val MAX_SEGMENTS = 8
+        private const val MAX_PREFIX_EXPANSION = 16
+        private const val K1 = 1.2
+        private const val B = 0.75
+
+        fun open(storage: Storage, name: String = "search", flushThreshold: Int = 256): FullTextIndex =
+            FullTextIndex(storage, name, flushThreshold).also { it.load() }
+    }
+}
@@ -0,0 +1,176 @@
+package org.kgajjar.mobileai.search
+
+import org.kgajjar.mobileai.collections.IntArrayList
+import org.kgajjar.mobileai.storage.ByteBuilder
+import org.kgajjar.mobileai.storage.ByteFile
+import org.kgajjar.mobileai.storage.ByteReader
+import org.kgajjar.mobileai.storage.readBytes
+
+/** Receives the live postings of one term: the document's ordinal within its segment and its term frequency. */
+internal fun interface PostingVisitor {
+    fun visit(ordinal: Int, termFrequency: Int)
+}
+
+internal sealed class IndexSegment(val id: Int) {
+    abstract val docCount: Int
+
+    abstract fun docId(ordinal: Int): Long
+
+    abstract fun docLength(ordinal: Int): Int
+
+    /** Document ids deleted by the time this segment was sealed; they shadow older segments. */
+    abstract val deletes: Collection<Long>
+
+    abstract fun postings(term: String, visitor: PostingVisitor)
+
+    /** Terms starting with [prefix], at most [limit] of them. */
+    abstract fun termsWithPrefix(prefix: String, limit: Int): List<String>
+}
+
+/** The mutable segment that new documents go to until it is flushed. */
+internal class MemorySegment(id: Int) : IndexSegment(id) {
+    private val docIds = ArrayList<Long>()
+    private val lengths = IntArrayList()
+    val terms = HashMap<String, IntArrayList>()
+    override val deletes = LinkedHashSet<Long>()
+
+    override val docCount: Int get() = docIds.size
+
+    override fun docId(ordinal: Int): Long = docIds[ordinal]
+
+    override fun docLength(ordinal: Int): Int = lengths[ordinal]
+
+    /** Adds a document and returns its ordinal. */
+    fun add(docId: Long, terms: List<String>): Int {
+        val ordinal = addDoc(docId, terms.size)
+        val frequencies = HashMap<String, Int>()
+        for (term in terms) frequencies[term] = (frequencies[term] ?: 0) + 1
+        for ((term, tf) in frequencies) addPosting(term, ordinal, tf)
+        return ordinal
+    }
+
+    fun addDoc(docId: Long, length: Int): Int {
+        docIds += docId
+        lengths.add(length)
+        return docIds.size - 1
+    }
+
+    /** Postings of a term must be added in increasing ordinal order. */
+    fun addPosting(term: String, ordinal: Int, termFrequency: Int) {
+        val postings = terms.getOrPut(term) { IntArrayList(4) }
+        postings.add(ordinal)
+        postings.add(termFrequency)
+    }
+
+    override fun postings(term: String, visitor: PostingVisitor) {
+        val postings = terms[term] ?: return
+        for (i in 0 until postings.size step 2) visitor.visit(postings[i], postings[i + 1])
+    }
+
+    override fun termsWithPrefix(prefix: String, limit: Int): List<String> =
+        terms.keys.asSequence().filter { it.startsWith(prefix) }.take(limit).toList()
+
+    /**
+     * Serializes the segment: `header | docIds | lengths | deletes | postings | term dictionary`.
+     * Postings are varint (ordinal delta, tf) pairs in term order, so a term's postings end
+     * where the next term's begin.
+     */
+    fun writeTo(file: ByteFile) {
+        val sorted = terms.keys.sorted()
+        val out = ByteBuilder(64 + docCount * 12)
+        out.putInt(SEGMENT_MAGIC).putInt(id).putInt(docCount).putInt(deletes.size).putInt(sorted.size)
+        out.putInt(0) // term dictionary offset, patched below
+        for (i in 0 until docCount) out.putLong(docIds[i])
+        for (i in 0 until docCount) out.putInt(lengths[i])
+        for (docId in deletes) out.putLong(docId)
+
+        val offsets = LongArray(sorted.size)
+        sorted.forEachIndexed { t, term ->
+            offsets[t] = out.size.toLong()
+            val postings = terms.getValue(term)
+            var previous = 0
+            for (i in 0 until postings.size step 2) {
+                out.putVarint(postings[i] - previous).putVarint(postings[i + 1])
+                previous = postings[i]
+            }
+        }
+        val dictionaryOffset = out.size
+        sorted.forEachIndexed { t, term -> out.putString(term).putLong(offsets[t]) }
+        out.setInt(HEADER_DICTIONARY_OFFSET, dictionaryOffset)
+        file.append(out.bytes, 0, out.size)
+        file.sync()
+    }
+}
+
+/**
+ * A sealed segment. Document tables and the term dictionary are loaded on open; postings stay
+ * in the (memory-mapped) file and are decoded on demand.
+ */
+internal class DiskSegment(private val file: ByteFile) : IndexSegment(readId(file)) {
+    private val docIds: LongArray
+    private val lengths: IntArray
+    override val deletes: List<Long>
+    private val terms: List<String>
+    private val offsets: LongArray
+    private val dictionaryOffset: Long
+
+    init {
+        val header = ByteReader(file.readBytes(0, HEADER_SIZE))
+        check(header.int() == SEGMENT_MAGIC) { "not an index segment" }
+        header.int()
+        val docCount = header.int()
+        val deleteCount = header.int()
+        val termCount = header.int()
+        dictionaryOffset = header.int().toLong()
+
+        val tables = ByteReader(file.readBytes(HEADER_SIZE.toLong(), docCount * 12 + deleteCount * 8))
+        docIds = LongArray(docCount) { tables.long() }
+        lengths = IntArray(docCount) { tables.int() }
+        deletes = List(deleteCount) { tables.long() }
+
+        val dictionary = ByteReader(file.readBytes(dictionaryOffset, (file.size - dictionaryOffset).toInt()))
+        val termList = ArrayList<String>(termCount)
+        offsets = LongArray(termCount)
+        for (t in 0 until termCount) {
+            termList += dictionary.string()
+            offsets[t] = dictionary.long()
+        }
+        terms = termList
+    }
+
+    override val docCount: Int get() = docIds.size
+
+    override fun docId(ordinal: Int): Long = docIds[ordinal]
+
+    override fun docLength(ordinal: Int): Int = lengths[ordinal]
+
+    override fun postings(term: String, visitor: PostingVisitor) {
+        val t = terms.binarySearch(term)
+        if (t < 0) return
+        val end = if (t + 1 < terms.size) offsets[t + 1] else dictionaryOffset
+        val input = ByteReader(file.readBytes(offsets[t], (end - offsets[t]).toInt()))
+        var ordinal = 0
+        while (input.remaining > 0) {
+            ordinal += input.varint()
+            visitor.visit(ordinal, input.varint())
+        }
+    }
+
+    override fun termsWithPrefix(prefix: String, limit: Int): List<String> {
+        val start = terms.binarySearch(prefix).let { if (it < 0) -it - 1 else it }
+        val result = ArrayList<String>()
+        var t = start
+        while (t < terms.size && result.size < limit && terms[t].startsWith(prefix)) result += terms[t++]
+        return result
+    }
+
+    fun close() = file.close()
+
+    private companion object {
+        fun readId(file: ByteFile): Int = ByteReader(file.readBytes(4, 4)).int()
+    }
+}
+
+private const val SEGMENT_MAGIC = 0x5346414D // "MAFS"
+private const val HEADER_DICTIONARY_OFFSET = 20
+private const val HEADER_SIZE = 24
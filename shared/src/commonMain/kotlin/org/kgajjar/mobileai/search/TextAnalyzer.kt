@@ -0,0 +1,21 @@
+package org.kgajjar.mobileai.search
+
+/** Splits text into lowercase terms: maximal runs of letters and digits, capped in length. */
+object TextAnalyzer {
+    private const val MAX_TERM_LENGTH = 40
+
+    fun terms(text: CharSequence): List<String> {
+        val terms = ArrayList<String>()
+        val term = StringBuilder()
+        for (c in text) {
+            if (c.isLetterOrDigit()) {
+                if (term.length < MAX_TERM_LENGTH) term.append(c.lowercaseChar())
+            } else if (term.isNotEmpty()) {
+                terms += term.toString()
+                term.clear()
+            }
+        }
+        if (term.isNotEmpty()) terms += term.toString()
+        return terms
+    }
+}
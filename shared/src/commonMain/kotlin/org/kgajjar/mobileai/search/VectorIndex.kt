@@ -0,0 +1,210 @@
+package org.kgajjar.mobileai.search
+
+import org.kgajjar.mobileai.collections.IntArrayList
+import org.kgajjar.mobileai.collections.ScoredHeap
+import org.kgajjar.mobileai.storage.ByteBuilder
+import org.kgajjar.mobileai.storage.ByteReader
+import kotlin.math.ln
+import kotlin.random.Random
+
+/**
+ * Approximate nearest-neighbour index over L2-normalized vectors (HNSW), scored by dot product.
+ *
+ * Nodes live on a random number of layers with geometrically fewer nodes per layer; a query
+ * descends greedily through the sparse upper layers and then runs a bounded best-first search
+ * on layer 0. Re-adding an id or removing it only tombstones the old node, which keeps routing
+ * through the graph but is never returned. Not thread-safe.
+ */
+class VectorIndex(
+    val dimension: Int,
+    private val m: Int = 16,
+    private val efConstruction: Int = 64,
+    seed: Long = 0x5EED,
+) {
+    data class Neighbor(val id: Long, val score: Float)
+
+    private val ids = ArrayList<Long>()
+    private val vectors = ArrayList<FloatArray>()
+    private val links = ArrayList<Array<IntArrayList>>()
+    private val deleted = HashSet<Int>()
+    private val nodeOf = HashMap<Long, Int>()
+    private var entry = -1
+    private var topLevel = -1
+    private val random = Random(seed)
+    private val levelFactor = 1.0 / ln(m.toDouble())
+
+    private var visited = IntArray(0)
+    private var visitEpoch = 0
+
+    /** Live (not removed) vectors. */
+    val size: Int get() = nodeOf.size
+
+    operator fun contains(id: Long): Boolean = id in nodeOf
+
+    fun add(id: Long, vector: FloatArray) {
+        require(vector.size == dimension) { "expected $dimension dimensions, got ${vector.size}" }
+        remove(id)
+        val node = ids.size
+        val level = (-ln(1.0 - random.nextDouble()) * levelFactor).toInt()
+        ids += id
+        vectors += vector
+        links += Array(level + 1) { IntArrayList(if (it == 0) 2 * m else m) }
+        nodeOf[id] = node
+        if (entry < 0) {
+            entry = node
+            topLevel = level
+            return
+        }
+
+        var current = entry
+        for (layer in topLevel downTo level + 1) current = greedy(vector, current, layer)
+        val found = ScoredHeap(maxFirst = false)
+        for (layer in minOf(level, topLevel) downTo 0) {
+            searchLayer(vector, current, efConstruction, layer, found)
+            val neighbors = closest(found, maxLinks(layer))
+            for (neighbor in neighbors) {
+                links[node][layer].add(neighbor)
+                connect(neighbor, node, layer)
+            }
+            current = neighbors.first()
+        }
+        if (level > topLevel) {
+            entry = node
+            topLevel = level
+        }
+    }
+
+    fun remove(id: Long): Boolean {
+        val node = nodeOf.remove(id) ?: return false
+        deleted += node
+        return true
+    }
+
+    /** The [k] live vectors most similar to [query], best first. Larger [ef] trades speed for recall. */
+    fun search(query: FloatArray, k: Int, ef: Int = maxOf(k, 40)): List<Neighbor> {
+        if (entry < 0 || k <= 0) return emptyList()
+        var current = entry
+        for (layer in topLevel downTo 1) current = greedy(query, current, layer)
+        val found = ScoredHeap(maxFirst = false)
+        searchLayer(query, current, maxOf(ef, k), 0, found)
+        val result = ArrayList<Neighbor>(found.size)
+        while (!found.isEmpty()) {
+            val score = found.topScore()
+            val node = found.pop()
+            if (node !in deleted) result += Neighbor(ids[node], score)
+        }
+        result.reverse()
+        return if (result.size > k) result.subList(0, k).toList() else result
+    }
+
+    fun writeTo(out: ByteBuilder) {
+        out.putInt(dimension).putInt(m).putInt(efConstruction).putInt(ids.size).putInt(entry).putInt(topLevel)
+        for (node in ids.indices) {
+            out.putLong(ids[node]).putByte(if (node in deleted) 1 else 0).putByte(links[node].size)
+            for (v in vectors[node]) out.putFloat(v)
+            for (layer in links[node]) {
+                out.putVarint(layer.size)
+                for (i in 0 until layer.size) out.putVarint(layer[i])
+            }
+        }
+    }
+
+    private fun similarity(a: FloatArray, b: FloatArray): Float {
+        var dot = 0f
+        for (i in 0 until dimension) dot += a[i] * b[i]
+        return dot
+    }
+
+    private fun maxLinks(layer: Int) = if (layer == 0) 2 * m else m
+
+    private fun greedy(query: FloatArray, start: Int, layer: Int): Int {
+        var current = start
+        var best = similarity(query, vectors[current])
+        var improved = true
+        while (improved) {
+            improved = false
+            val neighbors = links[current][layer]
+            for (i in 0 until neighbors.size) {
+                val candidate = neighbors[i]
+                val score = similarity(query, vectors[candidate])
+                if (score > best) {
+                    best = score
+                    current = candidate
+                    improved = true
+                }
+            }
+        }
+        return current
+    }
+
+    /** Best-first search of one layer; leaves the [ef] best nodes in [results] (worst on top). */
+    private fun searchLayer(query: FloatArray, start: Int, ef: Int, layer: Int, results: ScoredHeap) {
+        if (visited.size < ids.size) visited = IntArray(maxOf(ids.size, visited.size * 2))
+        val epoch = ++visitEpoch
+        val candidates = ScoredHeap(maxFirst = true)
+        results.clear()
+        val startScore = similarity(query, vectors[start])
+        visited[start] = epoch
+        candidates.push(startScore, start)
+        results.push(startScore, start)
+        while (!candidates.isEmpty()) {
+            val score = candidates.topScore()
+            if (results.size >= ef && score < results.topScore()) break
+            val node = candidates.pop()
+            val neighbors = links[node][layer]
+            for (i in 0 until neighbors.size) {
+                val neighbor = neighbors[i]
+                if (visited[neighbor] == epoch) continue
+                visited[neighbor] = epoch
+                val s = similarity(query, vectors[neighbor])
+                if (results.size < ef || s > results.topScore()) {
+                    candidates.push(s, neighbor)
+                    results.push(s, neighbor)
+                    if (results.size > ef) results.pop()
+                }
+            }
+        }
+    }
+
+    /** Drains [found] and returns up to [count] nodes, most similar first. */
+    private fun closest(found: ScoredHeap, count: Int): List<Int> {
+        val nodes = ArrayList<Int>(found.size)
+        while (!found.isEmpty()) nodes += found.pop()
+        nodes.reverse()
+        return if (nodes.size > count) nodes.subList(0, count) else nodes
+    }
+
+    /** Adds `from -> to` on [layer], pruning [from]'s links to its closest ones when full. */
+    private fun connect(from: Int, to: Int, layer: Int) {
+        val neighbors = links[from][layer]
+        neighbors.add(to)
+        if (neighbors.size <= maxLinks(layer)) return
+        val origin = vectors[from]
+        val ranked = ScoredHeap(maxFirst = true, neighbors.size)
+        for (i in 0 until neighbors.size) ranked.push(similarity(origin, vectors[neighbors[i]]), neighbors[i])
+        neighbors.clear()
+        while (neighbors.size < maxLinks(layer)) neighbors.add(ranked.pop())
+    }
+
+    companion object {
+        fun readFrom(input: ByteReader): VectorIndex {
+            val index = VectorIndex(dimension = input.int(), m = input.int(), efConstruction = input.int())
+            val count = input.int()
+            index.entry = input.int()
+            index.topLevel = input.int()
+            for (node in 0 until count) {
+                val id = input.long()
+                val removed = input.byte() != 0
+                val levels = input.byte()
+                index.ids += id
+                index.vectors += FloatArray(index.dimension) { input.float() }
+                index.links += Array(levels) {
+                    val linkCount = input.varint()
+                    IntArrayList(linkCount).also { layer -> repeat(linkCount) { layer.add(input.varint()) } }
+                }
+                if (removed) index.deleted += node else index.nodeOf[id] = node
+            }
+            return index
+        }
+    }
+}
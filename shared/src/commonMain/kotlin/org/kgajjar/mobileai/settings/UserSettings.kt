@@ -0,0 +1,19 @@
+package org.kgajjar.mobileai.settings
+
+import org.kgajjar.mobileai.storage.KeyValueStore
+
+/** Typed view of the user's settings; getters are cheap enough to call during composition. */
+class UserSettings(private val store: KeyValueStore) {
+    val displayName: String get() = store.getString(DISPLAY_NAME) ?: ""
+
+    val personalizedSuggestions: Boolean get() = store.getBoolean(PERSONALIZED_SUGGESTIONS) ?: true
+
+    suspend fun setDisplayName(value: String) = store.putString(DISPLAY_NAME, value.trim())
+
+    suspend fun setPersonalizedSuggestions(value: Boolean) = store.putBoolean(PERSONALIZED_SUGGESTIONS, value)
+
+    private companion object {
+        const val DISPLAY_NAME = "profile.displayName"
+        const val PERSONALIZED_SUGGESTIONS = "home.personalizedSuggestions"
+    }
+}
@@ -0,0 +1,117 @@
+package org.kgajjar.mobileai.storage
+
+/** Growable little-endian byte buffer for assembling records. */
+class ByteBuilder(initialCapacity: Int = 64) {
+    var bytes = ByteArray(maxOf(initialCapacity, 8))
+        private set
+
+    var size: Int = 0
+        private set
+
+    fun putByte(value: Int): ByteBuilder = apply {
+        ensure(1)
+        bytes[size++] = value.toByte()
+    }
+
+    fun putInt(value: Int): ByteBuilder = apply {
+        ensure(4)
+        bytes.putIntLe(size, value)
+        size += 4
+    }
+
+    fun putLong(value: Long): ByteBuilder = apply {
+        ensure(8)
+        bytes.putLongLe(size, value)
+        size += 8
+    }
+
+    fun putFloat(value: Float): ByteBuilder = putInt(value.toRawBits())
+
+    fun putBytes(src: ByteArray, offset: Int = 0, length: Int = src.size - offset): ByteBuilder = apply {
+        ensure(length)
+        src.copyInto(bytes, size, offset, offset + length)
+        size += length
+    }
+
+    /** Unsigned LEB128; small values take one byte. */
+    fun putVarint(value: Int): ByteBuilder = apply {
+        var v = value
+        while ((v and 0x7F.inv()) != 0) {
+            putByte((v and 0x7F) or 0x80)
+            v = v ushr 7
+        }
+        putByte(v)
+    }
+
+    /** Length-prefixed UTF-8. */
+    fun putString(value: String): ByteBuilder {
+        val utf8 = value.encodeToByteArray()
+        putInt(utf8.size)
+        return putBytes(utf8)
+    }
+
+    fun setByte(offset: Int, value: Int) {
+        require(offset < size) { "offset $offset out of range" }
+        bytes[offset] = value.toByte()
+    }
+
+    /** Overwrites an int at [offset], for lengths and checksums known only after the body. */
+    fun setInt(offset: Int, value: Int) {
+        require(offset + 4 <= size) { "offset $offset out of range" }
+        bytes.putIntLe(offset, value)
+    }
+
+    fun clear() {
+        size = 0
+    }
+
+    fun toByteArray(): ByteArray = bytes.copyOf(size)
+
+    private fun ensure(extra: Int) {
+        if (size + extra > bytes.size) bytes = bytes.copyOf(maxOf(size + extra, bytes.size * 2))
+    }
+}
+
+/** Little-endian cursor over a byte array, the reading side of [ByteBuilder]. */
+class ByteReader(val bytes: ByteArray, var position: Int = 0, val limit: Int = bytes.size) {
+    val remaining: Int get() = limit - position
+
+    fun byte(): Int {
+        check(position < limit) { "read past end" }
+        return bytes[position++].toInt() and 0xFF
+    }
+
+    fun int(): Int {
+        check(position + 4 <= limit) { "read past end" }
+        return bytes.getIntLe(position).also { position += 4 }
+    }
+
+    fun long(): Long {
+        check(position + 8 <= limit) { "read past end" }
+        return bytes.getLongLe(position).also { position += 8 }
+    }
+
+    fun float(): Float = Float.fromBits(int())
+
+    fun varint(): Int {
+        var value = 0
+        var shift = 0
+        while (true) {
+            val b = byte()
+            value = value or ((b and 0x7F) shl shift)
+            if (b < 0x80) return value
+            shift += 7
+        }
+    }
+
+    fun bytes(length: Int): ByteArray {
+        check(position + length <= limit) { "read past end" }
+        return bytes.copyOfRange(position, position + length).also { position += length }
+    }
+
+    fun string(): String {
+        val length = int()
+        check(position + length <= limit) { "read past end" }
+        return bytes.decodeToString(position, position + length).also { position += length }
+    }
+}
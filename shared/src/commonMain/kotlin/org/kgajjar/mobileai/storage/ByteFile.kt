@@ -0,0 +1,38 @@
+package org.kgajjar.mobileai.storage
+
+/**
+ * Random-read, append-only file. Appends are buffered: they are visible to [read] immediately,
+ * reach the OS on [flush] and stable storage on [sync].
+ *
+ * Implementations are not thread-safe; owners serialize access.
+ */
+interface ByteFile : AutoCloseable {
+    /** Logical size, including appended bytes that have not been flushed yet. */
+    val size: Long
+
+    fun read(position: Long, dst: ByteArray, offset: Int = 0, length: Int = dst.size - offset)
+
+    /** Appends [length] bytes of [src] and returns the position they were written at. */
+    fun append(src: ByteArray, offset: Int = 0, length: Int = src.size - offset): Long
+
+    fun flush()
+
+    fun sync()
+
+    fun truncate(size: Long)
+}
+
+/** A flat namespace of [ByteFile]s, typically one directory of the app's private storage. */
+interface Storage {
+    fun open(name: String): ByteFile
+
+    fun exists(name: String): Boolean
+
+    fun delete(name: String)
+
+    /** Atomically replaces [to] with [from]. Neither file may be open. */
+    fun rename(from: String, to: String)
+}
+
+fun ByteFile.readBytes(position: Long, length: Int): ByteArray =
+    ByteArray(length).also { read(position, it) }
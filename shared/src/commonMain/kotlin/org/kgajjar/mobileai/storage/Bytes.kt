@@ -0,0 +1,28 @@
+package org.kgajjar.mobileai.storage
+
+// Little-endian accessors for the binary formats in this package.
+
+fun ByteArray.getIntLe(offset: Int): Int =
+    (this[offset].toInt() and 0xFF) or
+        ((this[offset + 1].toInt() and 0xFF) shl 8) or
+        ((this[offset + 2].toInt() and 0xFF) shl 16) or
+        ((this[offset + 3].toInt() and 0xFF) shl 24)
+
+fun ByteArray.putIntLe(offset: Int, value: Int) {
+    this[offset] = value.toByte()
+    this[offset + 1] = (value ushr 8).toByte()
+    this[offset + 2] = (value ushr 16).toByte()
+    this[offset + 3] = (value ushr 24).toByte()
+}
+
+fun ByteArray.getLongLe(offset: Int): Long =
+    (getIntLe(offset).toLong() and 0xFFFFFFFFL) or (getIntLe(offset + 4).toLong() shl 32)
+
+fun ByteArray.putLongLe(offset: Int, value: Long) {
+    putIntLe(offset, value.toInt())
+    putIntLe(offset + 4, (value ushr 32).toInt())
+}
+
+fun ByteArray.getFloatLe(offset: Int): Float = Float.fromBits(getIntLe(offset))
+
+fun ByteArray.putFloatLe(offset: Int, value: Float) = putIntLe(offset, value.toRawBits())
@@ -0,0 +1,62 @@
+package org.kgajjar.mobileai.storage
+
+/**
+ * 64-bit content hashes used as cache and dedup keys. Not cryptographic: FNV-1a accumulation
+ * followed by a murmur3 finalizer so that similar inputs spread over the whole key space.
+ */
+object ContentHash {
+    private const val FNV_OFFSET = -0x340d631b7bdddcdbL
+    private const val FNV_PRIME = 0x100000001b3L
+
+    fun of(bytes: ByteArray, seed: Long = 0, offset: Int = 0, length: Int = bytes.size - offset): Long {
+        var h = FNV_OFFSET xor seed
+        for (i in offset until offset + length) {
+            h = (h xor (bytes[i].toLong() and 0xFF)) * FNV_PRIME
+        }
+        return mix(h xor length.toLong())
+    }
+
+    fun of(text: CharSequence, seed: Long = 0): Long {
+        var h = FNV_OFFSET xor seed
+        for (c in text) h = (h xor c.code.toLong()) * FNV_PRIME
+        return mix(h xor text.length.toLong())
+    }
+
+    /** Hash of 32-bit words, e.g. packed pixels, a word per step. */
+    fun of(values: IntArray, seed: Long = 0): Long {
+        var h = FNV_OFFSET xor seed
+        for (v in values) h = (h xor (v.toLong() and 0xFFFFFFFFL)) * FNV_PRIME
+        return mix(h xor values.size.toLong())
+    }
+
+    /**
+     * Hash of [text] with leading and trailing whitespace removed and inner whitespace runs
+     * collapsed to a single space, computed without materializing the normalized string.
+     */
+    fun ofNormalized(text: CharSequence, seed: Long = 0): Long {
+        var h = FNV_OFFSET xor seed
+        var length = 0L
+        var pendingSpace = false
+        for (c in text) {
+            if (c.isWhitespace()) {
+                pendingSpace = length > 0
+                continue
+            }
+            if (pendingSpace) {
+                h = (h xor ' '.code.toLong()) * FNV_PRIME
+                length++
+                pendingSpace = false
+            }
+            h = (h xor c.code.toLong()) * FNV_PRIME
+            length++
+        }
+        return mix(h xor length)
+    }
+
+    fun mix(value: Long): Long {
+        var h = value
+        h = (h xor (h ushr 33)) * -0xae502812aa7333L
+        h = (h xor (h ushr 33)) * -0x3b314601e57a13adL
+        return h xor (h ushr 33)
+    }
+}
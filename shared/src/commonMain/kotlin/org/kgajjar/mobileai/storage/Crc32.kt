@@ -0,0 +1,21 @@
+package org.kgajjar.mobileai.storage
+
+/** CRC-32 (IEEE 802.3), as used by zip and most log formats. */
+object Crc32 {
+    private val table = IntArray(256) { n ->
+        var c = n
+        repeat(8) { c = if ((c and 1) != 0) (c ushr 1) xor -0x12477ce0 else c ushr 1 }
+        c
+    }
+
+    fun of(bytes: ByteArray, offset: Int = 0, length: Int = bytes.size - offset): Int =
+        update(0, bytes, offset, length)
+
+    fun update(crc: Int, bytes: ByteArray, offset: Int, length: Int): Int {
+        var c = crc.inv()
+        for (i in offset until offset + length) {
+            c = table[(c xor bytes[i].toInt()) and 0xFF] xor (c ushr 8)
+        }
+        return c.inv()
+    }
+}
@@ -0,0 +1,158 @@
+package org.kgajjar.mobileai.storage
+
+/**
+ * Per-record LZ77 compression against a shared, pre-trained dictionary.
+ *
+ * The block format follows LZ4: a varint decoded length, then sequences of
+ * `token | literal length ext | literals | offset:u16 | match length ext`, the last sequence
+ * carrying literals only. Match offsets may reach back past the start of the record into the
+ * end of [dictionary], which is what makes short records compressible at all. Records are
+ * independent of each other, so any one can be decoded on its own.
+ */
+class DictionaryCodec(val id: Int, val dictionary: ByteArray) {
+    init {
+        require(id in 0..255) { "dictionary id must fit in a byte" }
+        require(dictionary.size <= MAX_OFFSET) { "dictionary larger than the match window" }
+    }
+
+    /** Hash table pre-seeded with dictionary positions; copied per record. */
+    private val seededTable = IntArray(HASH_SIZE) { -1 }.also { table ->
+        for (i in 0..dictionary.size - MIN_MATCH) table[hash(read4(dictionary, i))] = i
+    }
+
+    fun compress(src: ByteArray, offset: Int = 0, length: Int = src.size - offset): ByteArray {
+        val out = ByteBuilder(length / 2 + 16)
+        putVarint(out, length)
+        val table = seededTable.copyOf()
+        val base = dictionary.size
+        val end = offset + length
+        var anchor = offset
+        var i = offset
+        while (i + MIN_MATCH <= end) {
+            val word = read4(src, i)
+            val h = hash(word)
+            val candidate = table[h]
+            val position = base + i - offset
+            table[h] = position
+            if (candidate < 0 || position - candidate > MAX_OFFSET || read4Virtual(src, offset, candidate) != word) {
+                i++
+                continue
+            }
+            var matchLength = MIN_MATCH
+            while (i + matchLength < end &&
+                virtualByte(src, offset, candidate + matchLength) == src[i + matchLength]
+            ) {
+                matchLength++
+            }
+            putSequence(out, src, anchor, i - anchor, position - candidate, matchLength)
+            i += matchLength
+            anchor = i
+        }
+        putSequence(out, src, anchor, end - anchor, 0, 0)
+        return out.toByteArray()
+    }
+
+    fun decompress(src: ByteArray, offset: Int = 0, length: Int = src.size - offset): ByteArray {
+        val end = offset + length
+        var ip = offset
+        var size = 0
+        var shift = 0
+        while (true) {
+            val b = src[ip++].toInt() and 0xFF
+            size = size or ((b and 0x7F) shl shift)
+            if (b < 0x80) break
+            shift += 7
+        }
+        val out = ByteArray(size)
+        var op = 0
+        while (ip < end) {
+            val token = src[ip++].toInt() and 0xFF
+            var literals = token ushr 4
+            if (literals == 15) {
+                do {
+                    val b = src[ip++].toInt() and 0xFF
+                    literals += b
+                } while (b == 255)
+            }
+            src.copyInto(out, op, ip, ip + literals)
+            ip += literals
+            op += literals
+            if (ip >= end) break
+
+            val distance = (src[ip].toInt() and 0xFF) or ((src[ip + 1].toInt() and 0xFF) shl 8)
+            ip += 2
+            var matchLength = (token and 15) + MIN_MATCH
+            if ((token and 15) == 15) {
+                do {
+                    val b = src[ip++].toInt() and 0xFF
+                    matchLength += b
+                } while (b == 255)
+            }
+            var from = op - distance
+            if (from < 0) {
+                // The match starts in the dictionary and may run on into the record.
+                val inDictionary = minOf(-from, matchLength)
+                dictionary.copyInto(out, op, dictionary.size + from, dictionary.size + from + inDictionary)
+                op += inDictionary
+                from += inDictionary
+                matchLength -= inDictionary
+            }
+            // Byte by byte: matches may overlap the bytes they produce.
+            repeat(matchLength) { out[op++] = out[from++] }
+        }
+        check(op == size) { "corrupt block: decoded $op of $size bytes" }
+        return out
+    }
+
+    private fun virtualByte(src: ByteArray, offset: Int, position: Int): Byte =
+        if (position < dictionary.size) dictionary[position] else src[offset + position - dictionary.size]
+
+    private fun read4Virtual(src: ByteArray, offset: Int, position: Int): Int {
+        if (position + MIN_MATCH <= dictionary.size) return read4(dictionary, position)
+        if (position >= dictionary.size) return read4(src, offset + position - dictionary.size)
+        var word = 0
+        for (k in 0 until MIN_MATCH) {
+            word = word or ((virtualByte(src, offset, position + k).toInt() and 0xFF) shl (8 * k))
+        }
+        return word
+    }
+
+    private fun putSequence(out: ByteBuilder, src: ByteArray, start: Int, literals: Int, distance: Int, matchLength: Int) {
+        val matchCode = if (matchLength == 0) 0 else matchLength - MIN_MATCH
+        out.putByte((minOf(literals, 15) shl 4) or minOf(matchCode, 15))
+        if (literals >= 15) putLengthExtension(out, literals - 15)
+        out.putBytes(src, start, literals)
+        if (matchLength == 0) return
+        out.putByte(distance and 0xFF).putByte(distance ushr 8)
+        if (matchCode >= 15) putLengthExtension(out, matchCode - 15)
+    }
+
+    private fun putLengthExtension(out: ByteBuilder, remaining: Int) {
+        var rest = remaining
+        while (rest >= 255) {
+            out.putByte(255)
+            rest -= 255
+        }
+        out.putByte(rest)
+    }
+
+    private fun putVarint(out: ByteBuilder, value: Int) {
+        var v = value
+        while (v >= 0x80) {
+            out.putByte((v and 0x7F) or 0x80)
+            v = v ushr 7
+        }
+        out.putByte(v)
+    }
+
+    private companion object {
+        const val MIN_MATCH = 4
+        const val MAX_OFFSET = 65535
+        const val HASH_BITS = 12
+        const val HASH_SIZE = 1 shl HASH_BITS
+
+        fun read4(bytes: ByteArray, i: Int): Int = bytes.getIntLe(i)
+
+        fun hash(word: Int): Int = (word * -0x61c88647) ushr (32 - HASH_BITS)
+    }
+}
@@ -0,0 +1,81 @@
+package org.kgajjar.mobileai.storage
+
+/**
+ * Builds a [DictionaryCodec] dictionary from sample records, in the spirit of zstd's COVER
+ * trainer: short byte n-grams are scored by how many samples contain them, fixed-size segments
+ * of the samples are ranked by the summed score of the n-grams they cover, and the best
+ * segments are concatenated greedily. Each n-gram only counts for the first segment that covers
+ * it, so the dictionary does not fill up with copies of the same boilerplate.
+ *
+ * The highest-scoring segments go last, where match offsets from the start of a record are
+ * shortest.
+ */
+object DictionaryTrainer {
+    private const val NGRAM = 6
+    private const val SEGMENT = 64
+
+    fun train(samples: List<ByteArray>, maxSize: Int = 16 * 1024): ByteArray {
+        require(maxSize in 1..65535) { "maxSize must be in 1..65535" }
+        val frequency = documentFrequencies(samples)
+
+        class Candidate(val sample: Int, val start: Int, val score: Long)
+
+        val candidates = ArrayList<Candidate>()
+        samples.forEachIndexed { s, sample ->
+            var start = 0
+            while (start + NGRAM <= sample.size) {
+                val score = segmentScore(sample, start, frequency)
+                if (score > 0) candidates += Candidate(s, start, score)
+                start += SEGMENT / 2
+            }
+        }
+        candidates.sortByDescending { it.score }
+
+        val chosen = ArrayList<ByteArray>()
+        var size = 0
+        for (candidate in candidates) {
+            if (size >= maxSize) break
+            val sample = samples[candidate.sample]
+            // Earlier picks may already cover much of this segment; re-score before taking it.
+            val score = segmentScore(sample, candidate.start, frequency)
+            if (score * 2 < candidate.score || score <= 1) continue
+            val end = minOf(candidate.start + SEGMENT, sample.size, candidate.start + maxSize - size)
+            chosen += sample.copyOfRange(candidate.start, end)
+            size += end - candidate.start
+            forEachNgram(sample, candidate.start, end) { frequency.remove(it) }
+        }
+
+        val dictionary = ByteBuilder(size)
+        for (segment in chosen.asReversed()) dictionary.putBytes(segment)
+        return dictionary.toByteArray()
+    }
+
+    /** Number of samples each n-gram occurs in. */
+    private fun documentFrequencies(samples: List<ByteArray>): HashMap<Long, Int> {
+        val frequency = HashMap<Long, Int>()
+        val seen = HashSet<Long>()
+        for (sample in samples) {
+            seen.clear()
+            forEachNgram(sample, 0, sample.size) { if (seen.add(it)) frequency[it] = (frequency[it] ?: 0) + 1 }
+        }
+        return frequency
+    }
+
+    private fun segmentScore(sample: ByteArray, start: Int, frequency: Map<Long, Int>): Long {
+        var score = 0L
+        forEachNgram(sample, start, minOf(start + SEGMENT, sample.size)) { ngram ->
+            // Singletons never help another record.
+            val f = frequency[ngram] ?: 0
+            if (f > 1) score += f
+        }
+        return score
+    }
+
+    private inline fun forEachNgram(bytes: ByteArray, start: Int, end: Int, action: (Long) -> Unit) {
+        for (i in start..end - NGRAM) {
+            var h = 0L
+            for (k in 0 until NGRAM) h = (h shl 8) or (bytes[i + k].toLong() and 0xFF)
+            action(h)
+        }
+    }
+}
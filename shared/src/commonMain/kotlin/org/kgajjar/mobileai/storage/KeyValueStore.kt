@@ -0,0 +1,288 @@
+package org.kgajjar.mobileai.storage
+
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.Job
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.sync.Mutex
+import kotlinx.coroutines.sync.withLock
+import kotlinx.coroutines.withContext
+import kotlin.concurrent.Volatile
+
+/**
+ * Small typed key-value store for settings and user state, readable from the UI thread.
+ *
+ * The bulk of the data lives in an immutable table file (`<name>.kv.<generation>`, the current
+ * generation recorded in `<name>.kvgen`): a header, fixed-width
+ * slots `hash:i64 | entryOffset:i32 | entryLength:i32` sorted by key hash, then the entries
+ * `keyLength:i32 | type:u8 | key | value`. A lookup binary-searches the slots in place, so
+ * opening the table parses nothing and, with [FileStorage], every read is served from the
+ * memory map. Writes are appended to a checksummed log (`<name>.kvlog`) and kept in a small
+ * in-memory overlay; once the log grows past [COMPACT_LOG_BYTES] the overlay is folded into a
+ * table of the next generation, which is made current by rewriting `<name>.kvgen` before the
+ * log is reset. Tables are never replaced while open; a retired one is deleted once closed.
+ *
+ * Reads never block: they see an immutable snapshot of table and overlay. Writes are
+ * serialized, run off the caller's thread and are synced before they return.
+ */
+class KeyValueStore private constructor(
+    private val storage: Storage,
+    private val name: String,
+    private val scope: CoroutineScope,
+) {
+    private class Value(val type: Int, val bytes: ByteArray)
+
+    /** The overlay maps removed keys to null so that they shadow the table. */
+    private class State(val table: Table, val overlay: Map<String, Value?>)
+
+    private val mutex = Mutex()
+    private val generationName = "$name.kvgen"
+    private val logName = "$name.kvlog"
+
+    @Volatile
+    private var state = State(Table(null), emptyMap())
+    private lateinit var log: ByteFile
+    private var generation = 0L
+    private var retired: Table? = null
+    private var compaction: Job? = null
+
+    fun getString(key: String): String? = lookup(key, TYPE_STRING)?.decodeToString()
+
+    fun getLong(key: String): Long? = lookup(key, TYPE_LONG)?.getLongLe(0)
+
+    fun getDouble(key: String): Double? = lookup(key, TYPE_DOUBLE)?.let { Double.fromBits(it.getLongLe(0)) }
+
+    fun getBoolean(key: String): Boolean? = lookup(key, TYPE_BOOLEAN)?.let { it[0].toInt() != 0 }
+
+    operator fun contains(key: String): Boolean {
+        val snapshot = state
+        return if (key in snapshot.overlay) snapshot.overlay[key] != null else snapshot.table.find(key) != null
+    }
+
+    suspend fun putString(key: String, value: String) = write(key, Value(TYPE_STRING, value.encodeToByteArray()))
+
+    suspend fun putLong(key: String, value: Long) = write(key, Value(TYPE_LONG, ByteArray(8).also { it.putLongLe(0, value) }))
+
+    suspend fun putDouble(key: String, value: Double) =
+        write(key, Value(TYPE_DOUBLE, ByteArray(8).also { it.putLongLe(0, value.toRawBits()) }))
+
+    suspend fun putBoolean(key: String, value: Boolean) = write(key, Value(TYPE_BOOLEAN, byteArrayOf(if (value) 1 else 0)))
+
+    suspend fun remove(key: String) = write(key, null)
+
+    /** Folds the log into a new table. Runs on its own once the log is large enough. */
+    suspend fun compact() = withContext(Dispatchers.Default) { mutex.withLock { compactLocked() } }
+
+    suspend fun close() {
+        compaction?.cancel()
+        mutex.withLock {
+            log.close()
+            state.table.close()
+            retireTable()
+        }
+    }
+
+    private fun lookup(key: String, type: Int): ByteArray? {
+        val snapshot = state
+        val value = if (key in snapshot.overlay) snapshot.overlay[key] else snapshot.table.find(key)
+        return value?.takeIf { it.type == type }?.bytes
+    }
+
+    private suspend fun write(key: String, value: Value?) = withContext(Dispatchers.Default) {
+        mutex.withLock {
+            val body = ByteBuilder(32 + (value?.bytes?.size ?: 0))
+            body.putByte(value?.type ?: TYPE_REMOVED).putString(key)
+            if (value != null) body.putBytes(value.bytes)
+            val header = ByteArray(8)
+            header.putIntLe(0, body.size)
+            header.putIntLe(4, Crc32.of(body.bytes, 0, body.size))
+            log.append(header)
+            log.append(body.bytes, 0, body.size)
+            log.sync()
+            val current = state
+            state = State(current.table, current.overlay + (key to value))
+            if (log.size > COMPACT_LOG_BYTES && compaction?.isActive != true) {
+                compaction = scope.launch(Dispatchers.Default) { compact() }
+            }
+        }
+    }
+
+    private fun compactLocked() {
+        val current = state
+        if (current.overlay.isEmpty()) return
+        val entries = HashMap<String, Value>()
+        current.table.forEach { key, value -> entries[key] = value }
+        for ((key, value) in current.overlay) {
+            if (value == null) entries.remove(key) else entries[key] = value
+        }
+
+        val next = generation + 1
+        storage.delete(tableName(next))
+        val file = storage.open(tableName(next))
+        Table.write(file, entries)
+        file.sync()
+        file.close()
+        writeGeneration(next)
+        // Readers may still hold the previous snapshot, so its table is closed one compaction later.
+        retireTable()
+        retired = current.table
+        generation = next
+        state = State(Table(storage.open(tableName(next))), emptyMap())
+        log.truncate(0)
+        log.sync()
+    }
+
+    private fun load() {
+        generation = readGeneration()
+        // Left behind when the process exited between compactions.
+        if (generation > 0) storage.delete(tableName(generation - 1))
+        val table = if (generation > 0) Table(storage.open(tableName(generation))) else Table(null)
+        val overlay = HashMap<String, Value?>()
+        log = storage.open(logName)
+        val header = ByteArray(8)
+        var body = ByteArray(64)
+        var position = 0L
+        while (position + 8 <= log.size) {
+            log.read(position, header)
+            val length = header.getIntLe(0)
+            if (length <= 0 || position + 8 + length > log.size) break
+            if (length > body.size) body = ByteArray(maxOf(length, body.size * 2))
+            log.read(position + 8, body, 0, length)
+            if (Crc32.of(body, 0, length) != header.getIntLe(4)) break
+            val input = ByteReader(body, limit = length)
+            val type = input.byte()
+            val key = input.string()
+            overlay[key] = if (type == TYPE_REMOVED) null else Value(type, input.bytes(input.remaining))
+            position += 8 + length
+        }
+        if (position < log.size) log.truncate(position)
+        state = State(table, overlay)
+    }
+
+    private fun tableName(generation: Long) = "$name.kv.$generation"
+
+    /** Closes the table retired by the last compaction, which is the previous generation, and deletes its file. */
+    private fun retireTable() {
+        val table = retired ?: return
+        table.close()
+        storage.delete(tableName(generation - 1))
+        retired = null
+    }
+
+    private fun readGeneration(): Long {
+        if (!storage.exists(generationName)) return 0L
+        val file = storage.open(generationName)
+        return try {
+            if (file.size == 8L) file.readBytes(0, 8).getLongLe(0) else 0L
+        } finally {
+            file.close()
+        }
+    }
+
+    /** Replaces the generation file by rename; unlike tables, it is never held open. */
+    private fun writeGeneration(generation: Long) {
+        val tmpName = "$generationName.tmp"
+        storage.delete(tmpName)
+        val file = storage.open(tmpName)
+        file.append(ByteArray(8).also { it.putLongLe(0, generation) })
+        file.sync()
+        file.close()
+        storage.rename(tmpName, generationName)
+    }
+
+    /** Read-only view of a table file; `file == null` is the empty table. */
+    private class Table(private val file: ByteFile?) {
+        private val count = file?.let {
+            val header = it.readBytes(0, HEADER_SIZE)
+            check(header.getIntLe(0) == TABLE_MAGIC) { "not a key-value table" }
+            header.getIntLe(8)
+        } ?: 0
+
+        fun find(key: String): Value? {
+            if (count == 0) return null
+            val hash = ContentHash.of(key)
+            val slot = ByteArray(SLOT_SIZE)
+            var low = 0
+            var high = count - 1
+            while (low <= high) {
+                val mid = (low + high) ushr 1
+                file!!.read(slotPosition(mid), slot)
+                val midHash = slot.getLongLe(0)
+                when {
+                    midHash < hash -> low = mid + 1
+                    midHash > hash -> high = mid - 1
+                    else -> {
+                        // Colliding keys sit next to each other; back up to the first one.
+                        var i = mid
+                        while (i > 0 && slotHash(i - 1) == hash) i--
+                        while (i < count && slotHash(i) == hash) {
+                            entry(i)?.takeIf { it.first == key }?.let { return it.second }
+                            i++
+                        }
+                        return null
+                    }
+                }
+            }
+            return null
+        }
+
+        fun forEach(action: (String, Value) -> Unit) {
+            for (i in 0 until count) entry(i)?.let { action(it.first, it.second) }
+        }
+
+        fun close() {
+            file?.close()
+        }
+
+        private fun slotPosition(i: Int): Long = HEADER_SIZE + i.toLong() * SLOT_SIZE
+
+        private fun slotHash(i: Int): Long = file!!.readBytes(slotPosition(i), 8).getLongLe(0)
+
+        private fun entry(i: Int): Pair<String, Value>? {
+            val slot = file!!.readBytes(slotPosition(i), SLOT_SIZE)
+            val bytes = file.readBytes(slot.getIntLe(8).toLong(), slot.getIntLe(12))
+            val keyLength = bytes.getIntLe(0)
+            val key = bytes.decodeToString(5, 5 + keyLength)
+            return key to Value(bytes[4].toInt(), bytes.copyOfRange(5 + keyLength, bytes.size))
+        }
+
+        companion object {
+            private const val TABLE_MAGIC = 0x564B414D // "MAKV"
+            private const val VERSION = 1
+            private const val HEADER_SIZE = 16
+            private const val SLOT_SIZE = 16
+
+            fun write(file: ByteFile, entries: Map<String, Value>) {
+                val sorted = entries.entries
+                    .map { Triple(ContentHash.of(it.key), it.key.encodeToByteArray(), it.value) }
+                    .sortedBy { it.first }
+                val out = ByteBuilder(HEADER_SIZE + sorted.size * (SLOT_SIZE + 32))
+                out.putInt(TABLE_MAGIC).putInt(VERSION).putInt(sorted.size).putInt(0)
+                var entryOffset = HEADER_SIZE + sorted.size * SLOT_SIZE
+                for ((hash, key, value) in sorted) {
+                    val length = 5 + key.size + value.bytes.size
+                    out.putLong(hash).putInt(entryOffset).putInt(length)
+                    entryOffset += length
+                }
+                for ((_, key, value) in sorted) {
+                    out.putInt(key.size).putByte(value.type).putBytes(key).putBytes(value.bytes)
+                }
+                file.append(out.bytes, 0, out.size)
+            }
+        }
+    }
+
+    companion object {
+        private const val TYPE_REMOVED = 0
+        private const val TYPE_STRING = 1
+        private const val TYPE_LONG = 2
+        private const val TYPE_DOUBLE = 3
+        private const val TYPE_BOOLEAN = 4
+        private const val COMPACT_LOG_BYTES = 16L shl 10
+
+        suspend fun open(storage: Storage, scope: CoroutineScope, name: String = "settings"): KeyValueStore =
+            withContext(Dispatchers.Default) {
+                KeyValueStore(storage, name, scope).also { it.load() }
+            }
+    }
+}
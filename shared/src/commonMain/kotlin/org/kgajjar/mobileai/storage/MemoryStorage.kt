@@ -0,0 +1,55 @@
+package org.kgajjar.mobileai.storage
+
+/** Heap-backed [Storage] for targets without a file system and for tests. */
+class MemoryStorage : Storage {
+    private class Contents {
+        var bytes = ByteArray(256)
+        var size = 0
+    }
+
+    private val files = HashMap<String, Contents>()
+
+    override fun open(name: String): ByteFile = MemoryByteFile(files.getOrPut(name) { Contents() })
+
+    override fun exists(name: String): Boolean = name in files
+
+    override fun delete(name: String) {
+        files.remove(name)
+    }
+
+    override fun rename(from: String, to: String) {
+        files[to] = files.remove(from) ?: throw IllegalArgumentException("no such file: $from")
+    }
+
+    private class MemoryByteFile(private val contents: Contents) : ByteFile {
+        override val size: Long get() = contents.size.toLong()
+
+        override fun read(position: Long, dst: ByteArray, offset: Int, length: Int) {
+            require(position >= 0 && position + length <= contents.size) {
+                "read [$position, ${position + length}) past end ${contents.size}"
+            }
+            contents.bytes.copyInto(dst, offset, position.toInt(), position.toInt() + length)
+        }
+
+        override fun append(src: ByteArray, offset: Int, length: Int): Long {
+            val position = contents.size
+            if (position + length > contents.bytes.size) {
+                contents.bytes = contents.bytes.copyOf(maxOf(position + length, contents.bytes.size * 2))
+            }
+            src.copyInto(contents.bytes, position, offset, offset + length)
+            contents.size += length
+            return position.toLong()
+        }
+
+        override fun flush() {}
+
+        override fun sync() {}
+
+        override fun truncate(size: Long) {
+            require(size in 0..contents.size) { "cannot truncate ${contents.size} bytes to $size" }
+            contents.size = size.toInt()
+        }
+
+        override fun close() {}
+    }
+}
@@ -0,0 +1,272 @@
+package org.kgajjar.mobileai.tokenizer
+
+import org.kgajjar.mobileai.collections.DoubleArrayTrie
+import org.kgajjar.mobileai.collections.PerfectHash
+import org.kgajjar.mobileai.json.JsonCursor
+import org.kgajjar.mobileai.json.JsonDocument
+import org.kgajjar.mobileai.storage.ByteBuilder
+import org.kgajjar.mobileai.storage.ByteReader
+import org.kgajjar.mobileai.storage.ContentHash
+import org.kgajjar.mobileai.storage.Crc32
+import org.kgajjar.mobileai.storage.getIntLe
+import org.kgajjar.mobileai.storage.getLongLe
+
+/**
+ * Byte-level BPE tables compiled into a single flat image that is used in place.
+ *
+ * Layout, all little-endian:
+ * `header | tokenOffsets[vocabSize + 1] | displacements[buckets] | slots[hashSize] |
+ * mergeDisplacements[mergeBuckets] | merges[mergeCount] | byteTokens[256] | specials | tokenBytes`.
+ * Token strings are stored as raw bytes (the byte-level alphabet already undone) and found
+ * through a [PerfectHash] over those bytes. Merges are `(left << 32 | right):i64, rank:i32,
+ * result:i32` records placed by a second perfect hash over the pair, so the lookup in the
+ * merge loop is two reads and one compare. Special tokens form a [DoubleArrayTrie] for
+ * longest-match splitting. Loading an image only checks its header: the file was written
+ * atomically by [compile], and reading it parses nothing.
+ */
+internal class BpeModel(private val image: ByteArray) {
+    val vocabSize = image.getIntLe(H_VOCAB_SIZE)
+    private val hashSize = image.getIntLe(H_HASH_SIZE)
+    private val bucketCount = image.getIntLe(H_BUCKET_COUNT)
+    private val mergeCount = image.getIntLe(H_MERGE_COUNT)
+    private val mergeBucketCount = image.getIntLe(H_MERGE_BUCKET_COUNT)
+    private val flags = image.getIntLe(H_FLAGS)
+    private val tokenOffsetsAt = image.getIntLe(H_TOKEN_OFFSETS)
+    private val displacementsAt = image.getIntLe(H_DISPLACEMENTS)
+    private val slotsAt = image.getIntLe(H_SLOTS)
+    private val mergeDisplacementsAt = image.getIntLe(H_MERGE_DISPLACEMENTS)
+    private val mergesAt = image.getIntLe(H_MERGES)
+    private val byteTokensAt = image.getIntLe(H_BYTE_TOKENS)
+    private val tokenBytesAt = image.getIntLe(H_TOKEN_BYTES)
+
+    /** Special token text to id. */
+    val specials: DoubleArrayTrie = DoubleArrayTrie.readFrom(ByteReader(image, image.getIntLe(H_SPECIALS)))
+
+    /** Whether a pre-tokenized piece that is itself a token skips merging (`ignore_merges`). */
+    val ignoreMerges: Boolean get() = (flags and FLAG_IGNORE_MERGES) != 0
+
+    fun tokenStart(id: Int): Int = tokenBytesAt + image.getIntLe(tokenOffsetsAt + id * 4)
+
+    fun tokenEnd(id: Int): Int = tokenBytesAt + image.getIntLe(tokenOffsetsAt + id * 4 + 4)
+
+    fun appendToken(id: Int, out: ByteBuilder) {
+        val start = tokenStart(id)
+        out.putBytes(image, start, tokenEnd(id) - start)
+    }
+
+    fun byteToken(b: Int): Int = image.getIntLe(byteTokensAt + b * 4)
+
+    /** The id of the token whose bytes are `bytes[from, to)`, or -1. */
+    fun idOf(bytes: ByteArray, from: Int, to: Int): Int {
+        if (hashSize == 0) return -1
+        val hash = ContentHash.of(bytes, offset = from, length = to - from)
+        val displacement = image.getIntLe(displacementsAt + PerfectHash.bucket(hash, bucketCount) * 4)
+        val id = image.getIntLe(slotsAt + PerfectHash.slot(hash, displacement, hashSize) * 4)
+        val start = tokenStart(id)
+        if (tokenEnd(id) - start != to - from) return -1
+        for (i in 0 until to - from) if (image[start + i] != bytes[from + i]) return -1
+        return id
+    }
+
+    /** `rank << 32 | result` for merging [left] and [right], or -1 if they do not merge. */
+    fun merge(left: Int, right: Int): Long {
+        if (mergeCount == 0) return -1
+        val key = pairKey(left, right)
+        val hash = ContentHash.mix(key)
+        val displacement = image.getIntLe(mergeDisplacementsAt + PerfectHash.bucket(hash, mergeBucketCount) * 4)
+        val at = mergesAt + PerfectHash.slot(hash, displacement, mergeCount) * MERGE_SIZE
+        if (image.getLongLe(at) != key) return -1
+        return (image.getIntLe(at + 8).toLong() shl 32) or (image.getIntLe(at + 12).toLong() and 0xFFFFFFFFL)
+    }
+
+    companion object {
+        private const val MAGIC = 0x4B54414D // "MATK"
+        private const val VERSION = 2
+        private const val MERGE_SIZE = 16
+        private const val FLAG_IGNORE_MERGES = 1
+
+        private const val H_FINGERPRINT = 8
+        private const val H_SIZE = 16
+        private const val H_VOCAB_SIZE = 20
+        private const val H_HASH_SIZE = 24
+        private const val H_BUCKET_COUNT = 28
+        private const val H_MERGE_COUNT = 32
+        private const val H_MERGE_BUCKET_COUNT = 36
+        private const val H_FLAGS = 40
+        private const val H_TOKEN_OFFSETS = 44
+        private const val H_DISPLACEMENTS = 48
+        private const val H_SLOTS = 52
+        private const val H_MERGE_DISPLACEMENTS = 56
+        private const val H_MERGES = 60
+        private const val H_BYTE_TOKENS = 64
+        private const val H_SPECIALS = 68
+        private const val H_TOKEN_BYTES = 72
+        private const val H_CRC = 76
+        private const val HEADER_SIZE = 80
+
+        private fun pairKey(left: Int, right: Int): Long = (left.toLong() shl 32) or (right.toLong() and 0xFFFFFFFFL)
+
+        /** The model in [image], or null if it is not a complete image built for [fingerprint]. */
+        fun load(image: ByteArray, fingerprint: Long): BpeModel? {
+            if (image.size < HEADER_SIZE || image.getIntLe(0) != MAGIC || image.getIntLe(4) != VERSION) return null
+            if (Crc32.of(image, 0, H_CRC) != image.getIntLe(H_CRC)) return null
+            if (image.getLongLe(H_FINGERPRINT) != fingerprint || image.getIntLe(H_SIZE) != image.size) return null
+            return BpeModel(image)
+        }
+
+        /**
+         * Compiles a Hugging Face `tokenizer.json` with a byte-level BPE model into an image.
+         * Added tokens marked `special` are matched verbatim before pre-tokenization.
+         */
+        fun compile(tokenizerJson: ByteArray, fingerprint: Long): ByteArray {
+            val root = JsonDocument.parse(tokenizerJson).root()
+            val model = root["model"] ?: throw IllegalArgumentException("tokenizer.json has no model")
+            val type = model["type"]?.string()
+            require(type == null || type == "BPE") { "unsupported tokenizer model $type" }
+
+            val tokens = HashMap<Int, ByteArray>()
+            val ids = HashMap<String, Int>()
+            model["vocab"]?.forEachMember { token, id ->
+                val tokenId = id.long().toInt()
+                tokens[tokenId] = ByteLevel.decode(token)
+                ids[token] = tokenId
+            }
+            val specials = LinkedHashMap<String, Int>()
+            root["added_tokens"]?.forEachElement { added ->
+                val id = added["id"]!!.long().toInt()
+                val content = added["content"]!!.string()
+                tokens[id] = content.encodeToByteArray()
+                if (added["special"]?.boolean() == true) specials.getOrPut(content) { id }
+            }
+            val vocabSize = (tokens.keys.maxOrNull() ?: -1) + 1
+
+            val merges = ArrayList<LongArray>()
+            val pairs = HashSet<Long>()
+            var rank = 0
+            model["merges"]?.forEachElement { merge ->
+                val (left, right) = mergePair(merge)
+                val l = ids[left] ?: throw IllegalArgumentException("merge of unknown token $left")
+                val r = ids[right] ?: throw IllegalArgumentException("merge of unknown token $right")
+                val result = ids[left + right] ?: throw IllegalArgumentException("merge into unknown token $left$right")
+                // A repeated pair keeps its first, best, rank.
+                if (pairs.add(pairKey(l, r))) merges += longArrayOf(pairKey(l, r), rank.toLong(), result.toLong())
+                rank++
+            }
+            val mergeTable = PerfectHash.build(LongArray(merges.size) { ContentHash.mix(merges[it][0]) })
+
+            // Ids with the same bytes (in practice only duplicated added tokens) resolve to the lowest.
+            val hashed = ArrayList<Int>()
+            val hashes = ArrayList<Long>()
+            val seen = HashSet<Long>()
+            for (id in 0 until vocabSize) {
+                val hash = ContentHash.of(tokens[id] ?: continue)
+                if (seen.add(hash)) {
+                    hashed += id
+                    hashes += hash
+                }
+            }
+            val table = PerfectHash.build(hashes.toLongArray())
+
+            val out = ByteBuilder(HEADER_SIZE + vocabSize * 12 + merges.size * MERGE_SIZE)
+            repeat(HEADER_SIZE / 4) { out.putInt(0) }
+            val tokenOffsetsAt = out.size
+            var offset = 0
+            out.putInt(0)
+            for (id in 0 until vocabSize) {
+                offset += tokens[id]?.size ?: 0
+                out.putInt(offset)
+            }
+            val displacementsAt = out.size
+            for (d in table.displacements) out.putInt(d)
+            val slotsAt = out.size
+            for (k in table.keys) out.putInt(hashed[k])
+            val mergeDisplacementsAt = out.size
+            for (d in mergeTable.displacements) out.putInt(d)
+            val mergesAt = out.size
+            for (k in mergeTable.keys) {
+                val m = merges[k]
+                out.putLong(m[0]).putInt(m[1].toInt()).putInt(m[2].toInt())
+            }
+            val byteTokensAt = out.size
+            for (b in 0 until 256) out.putInt(ids[ByteLevel.encode(b)] ?: -1)
+            val specialsAt = out.size
+            DoubleArrayTrie.build(specials.keys.toList(), specials.values.toIntArray()).writeTo(out)
+            val tokenBytesAt = out.size
+            for (id in 0 until vocabSize) tokens[id]?.let { out.putBytes(it) }
+
+            out.setInt(0, MAGIC)
+            out.setInt(4, VERSION)
+            out.setInt(H_FINGERPRINT, fingerprint.toInt())
+            out.setInt(H_FINGERPRINT + 4, (fingerprint ushr 32).toInt())
+            out.setInt(H_SIZE, out.size)
+            out.setInt(H_VOCAB_SIZE, vocabSize)
+            out.setInt(H_HASH_SIZE, hashed.size)
+            out.setInt(H_BUCKET_COUNT, table.displacements.size)
+            out.setInt(H_MERGE_COUNT, merges.size)
+            out.setInt(H_MERGE_BUCKET_COUNT, mergeTable.displacements.size)
+            out.setInt(H_FLAGS, if (model["ignore_merges"]?.boolean() == true) FLAG_IGNORE_MERGES else 0)
+            out.setInt(H_TOKEN_OFFSETS, tokenOffsetsAt)
+            out.setInt(H_DISPLACEMENTS, displacementsAt)
+            out.setInt(H_SLOTS, slotsAt)
+            out.setInt(H_MERGE_DISPLACEMENTS, mergeDisplacementsAt)
+            out.setInt(H_MERGES, mergesAt)
+            out.setInt(H_BYTE_TOKENS, byteTokensAt)
+            out.setInt(H_SPECIALS, specialsAt)
+            out.setInt(H_TOKEN_BYTES, tokenBytesAt)
+            out.setInt(H_CRC, Crc32.of(out.bytes, 0, H_CRC))
+            return out.toByteArray()
+        }
+
+        /** Merges are `"left right"` strings in older files and `["left", "right"]` in newer ones. */
+        private fun mergePair(merge: JsonCursor): Pair<String, String> =
+            if (merge.type == JsonCursor.Type.Array) {
+                val parts = ArrayList<String>(2)
+                merge.forEachElement { parts += it.string() }
+                require(parts.size == 2) { "bad merge $parts" }
+                parts[0] to parts[1]
+            } else {
+                val text = merge.string()
+                val space = text.indexOf(' ', startIndex = 1)
+                require(space > 0) { "bad merge '$text'" }
+                text.substring(0, space) to text.substring(space + 1)
+            }
+    }
+}
+
+/**
+ * GPT-2's reversible mapping between bytes and printable characters, which byte-level BPE
+ * vocabularies are written in.
+ */
+internal object ByteLevel {
+    private val byteToChar = CharArray(256)
+    private val charToByte = HashMap<Char, Int>()
+
+    init {
+        var next = 256
+        for (b in 0 until 256) {
+            val printable = b in '!'.code..'~'.code || b in 0xA1..0xAC || b in 0xAE..0xFF
+            byteToChar[b] = if (printable) b.toChar() else (next++).toChar()
+            charToByte[byteToChar[b]] = b
+        }
+    }
+
+    fun encode(b: Int): String = byteToChar[b].toString()
+
+    /** Token text back to bytes; characters outside the alphabet are kept as UTF-8. */
+    fun decode(token: String): ByteArray {
+        val out = ByteBuilder(token.length)
+        var i = 0
+        while (i < token.length) {
+            val b = charToByte[token[i]]
+            if (b != null) {
+                out.putByte(b)
+                i++
+            } else {
+                val width = if (token[i].isHighSurrogate() && i + 1 < token.length) 2 else 1
+                out.putBytes(token.substring(i, i + width).encodeToByteArray())
+                i += width
+            }
+        }
+        return out.toByteArray()
+    }
+}
@@ -0,0 +1,229 @@
+package org.kgajjar.mobileai.tokenizer
+
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.withContext
+import org.kgajjar.mobileai.collections.IntArrayList
+import org.kgajjar.mobileai.storage.ByteBuilder
+import org.kgajjar.mobileai.storage.ContentHash
+import org.kgajjar.mobileai.storage.Storage
+import org.kgajjar.mobileai.storage.readBytes
+import org.kgajjar.mobileai.trace.Trace
+
+/**
+ * Byte-level BPE tokenizer (GPT-2 family) over a compiled [BpeModel].
+ *
+ * Text is split around special tokens (longest match wins), pre-tokenized with GPT-2's rules
+ * (contractions, letter runs, digit runs, punctuation runs, whitespace), and each piece is
+ * encoded to UTF-8 bytes and merged pair by pair in rank order. Not thread-safe: encoding
+ * reuses scratch buffers.
+ */
+class BpeTokenizer private constructor(private val model: BpeModel) : Tokenizer {
+    override val vocabSize: Int get() = model.vocabSize
+
+    private var bytes = ByteArray(64)
+    private var charEnds = IntArray(64)
+    private var pieceIds = IntArray(64)
+    private var pieceEnds = IntArray(64)
+    private var pairMerges = LongArray(64)
+
+    /** The id of the token spelled exactly [token], or null. */
+    fun idOf(token: String): Int? {
+        val utf8 = token.encodeToByteArray()
+        return model.idOf(utf8, 0, utf8.size).takeIf { it >= 0 }
+    }
+
+    override fun encode(text: CharSequence, start: Int, end: Int, ids: IntArrayList, ends: IntArrayList?): Unit = Trace.span("tokenize", "text") {
+        val specials = model.specials
+        var ordinary = start
+        var pos = start
+        while (pos < end) {
+            val match = specials.longestMatch(text, pos, end)
+            if (match < 0) {
+                pos++
+                continue
+            }
+            encodeOrdinary(text, ordinary, pos, ids, ends)
+            pos += (match ushr 32).toInt()
+            ids.add(match.toInt())
+            ends?.add(pos)
+            ordinary = pos
+        }
+        encodeOrdinary(text, ordinary, end, ids, ends)
+    }
+
+    override fun decode(ids: IntArray, start: Int, end: Int): String {
+        val out = ByteBuilder(end - start)
+        for (i in start until end) model.appendToken(ids[i], out)
+        return out.bytes.decodeToString(0, out.size)
+    }
+
+    private fun encodeOrdinary(text: CharSequence, start: Int, end: Int, ids: IntArrayList, ends: IntArrayList?) {
+        var pos = start
+        while (pos < end) {
+            val pieceEnd = pieceEnd(text, pos, end)
+            encodePiece(text, pos, pieceEnd, ids, ends)
+            pos = pieceEnd
+        }
+    }
+
+    private fun encodePiece(text: CharSequence, start: Int, end: Int, ids: IntArrayList, ends: IntArrayList?) {
+        val n = utf8(text, start, end)
+        if (model.ignoreMerges) {
+            val whole = model.idOf(bytes, 0, n)
+            if (whole >= 0) {
+                ids.add(whole)
+                ends?.add(end)
+                return
+            }
+        }
+        if (pieceIds.size < n) {
+            pieceIds = IntArray(bytes.size)
+            pieceEnds = IntArray(bytes.size)
+            pairMerges = LongArray(bytes.size)
+        }
+        for (i in 0 until n) {
+            pieceIds[i] = model.byteToken(bytes[i].toInt() and 0xFF)
+            pieceEnds[i] = i + 1
+        }
+        // pairMerges[i] caches the merge of tokens i and i + 1 (-1 for none); a merge only
+        // invalidates the pairs on either side of it.
+        for (i in 0 until n - 1) pairMerges[i] = model.merge(pieceIds[i], pieceIds[i + 1])
+        var count = n
+        // Pieces are short, so a rescan per merge beats maintaining a priority queue.
+        while (count > 1) {
+            var best = -1
+            var bestMerge = Long.MAX_VALUE
+            for (i in 0 until count - 1) {
+                val merge = pairMerges[i]
+                if (merge >= 0 && merge < bestMerge) {
+                    bestMerge = merge
+                    best = i
+                }
+            }
+            if (best < 0) break
+            pieceIds[best] = bestMerge.toInt()
+            pieceEnds[best] = pieceEnds[best + 1]
+            pieceIds.copyInto(pieceIds, best + 1, best + 2, count)
+            pieceEnds.copyInto(pieceEnds, best + 1, best + 2, count)
+            pairMerges.copyInto(pairMerges, best + 1, best + 2, count - 1)
+            count--
+            if (best > 0) pairMerges[best - 1] = model.merge(pieceIds[best - 1], pieceIds[best])
+            if (best < count - 1) pairMerges[best] = model.merge(pieceIds[best], pieceIds[best + 1])
+        }
+        for (i in 0 until count) {
+            ids.add(pieceIds[i])
+            ends?.add(start + charEnds[pieceEnds[i] - 1])
+        }
+    }
+
+    /**
+     * Encodes `text[start, end)` into [bytes] and records for every byte the offset (relative
+     * to [start]) just past the character it belongs to. Returns the byte count.
+     */
+    private fun utf8(text: CharSequence, start: Int, end: Int): Int {
+        if (bytes.size < (end - start) * 3) {
+            bytes = ByteArray((end - start) * 3)
+            charEnds = IntArray(bytes.size)
+        }
+        var n = 0
+        var i = start
+        while (i < end) {
+            var code = text[i].code
+            var width = 1
+            if (text[i].isHighSurrogate() && i + 1 < end && text[i + 1].isLowSurrogate()) {
+                code = 0x10000 + ((code - 0xD800) shl 10) + (text[i + 1].code - 0xDC00)
+                width = 2
+            } else if (text[i].isSurrogate()) {
+                code = 0xFFFD
+            }
+            val from = n
+            when {
+                code < 0x80 -> bytes[n++] = code.toByte()
+                code < 0x800 -> {
+                    bytes[n++] = (0xC0 or (code shr 6)).toByte()
+                    bytes[n++] = (0x80 or (code and 0x3F)).toByte()
+                }
+                code < 0x10000 -> {
+                    bytes[n++] = (0xE0 or (code shr 12)).toByte()
+                    bytes[n++] = (0x80 or ((code shr 6) and 0x3F)).toByte()
+                    bytes[n++] = (0x80 or (code and 0x3F)).toByte()
+                }
+                else -> {
+                    bytes[n++] = (0xF0 or (code shr 18)).toByte()
+                    bytes[n++] = (0x80 or ((code shr 12) and 0x3F)).toByte()
+                    bytes[n++] = (0x80 or ((code shr 6) and 0x3F)).toByte()
+                    bytes[n++] = (0x80 or (code and 0x3F)).toByte()
+                }
+            }
+            i += width
+            charEnds.fill(i - start, from, n)
+        }
+        return n
+    }
+
+    companion object {
+        /**
+         * Opens the tokenizer compiled into [cacheName], first compiling the `tokenizer.json`
+         * returned by [source] if the cache is missing, damaged or was built for another
+         * [fingerprint] (for example a model id and revision). A warm open is one file read.
+         */
+        suspend fun open(
+            storage: Storage,
+            fingerprint: String,
+            cacheName: String = "tokenizer.bin",
+            source: suspend () -> ByteArray,
+        ): BpeTokenizer = withContext(Dispatchers.Default) {
+            val key = ContentHash.of(fingerprint)
+            if (storage.exists(cacheName)) {
+                val file = storage.open(cacheName)
+                val image = file.readBytes(0, file.size.toInt())
+                file.close()
+                BpeModel.load(image, key)?.let { return@withContext BpeTokenizer(it) }
+            }
+            val image = BpeModel.compile(source(), key)
+            val tmpName = "$cacheName.tmp"
+            storage.delete(tmpName)
+            val file = storage.open(tmpName)
+            file.append(image)
+            file.sync()
+            file.close()
+            storage.rename(tmpName, cacheName)
+            BpeTokenizer(BpeModel(image))
+        }
+
+        /** Compiles [tokenizerJson] in memory without caching it. */
+        fun fromJson(tokenizerJson: ByteArray): BpeTokenizer = BpeTokenizer(BpeModel(BpeModel.compile(tokenizerJson, 0)))
+
+        /** End of the GPT-2 pre-tokenizer piece that starts at [start]. */
+        internal fun pieceEnd(text: CharSequence, start: Int, end: Int): Int {
+            val c = text[start]
+            if (c == '\'' && start + 1 < end) {
+                val next = text[start + 1]
+                if (next == 's' || next == 't' || next == 'm' || next == 'd') return start + 2
+                if (start + 2 < end) {
+                    val last = text[start + 2]
+                    if ((next == 'r' || next == 'v') && last == 'e' || next == 'l' && last == 'l') return start + 3
+                }
+            }
+            var i = start
+            if (c == ' ' && start + 1 < end && !text[start + 1].isWhitespace()) i++
+            val first = text[i]
+            return when {
+                first.isLetter() -> run(text, i, end) { it.isLetter() }
+                first.isDigit() -> run(text, i, end) { it.isDigit() }
+                !first.isWhitespace() -> run(text, i, end) { !it.isWhitespace() && !it.isLetterOrDigit() }
+                else -> {
+                    // Whitespace, leaving the last space to the word after it.
+                    val runEnd = run(text, i, end) { it.isWhitespace() }
+                    if (runEnd < end && runEnd - i > 1) runEnd - 1 else runEnd
+                }
+            }
+        }
+
+        private inline fun run(text: CharSequence, start: Int, end: Int, predicate: (Char) -> Boolean): Int {
+            var i = start + 1
+            while (i < end && predicate(text[i])) i++
+            return i
+        }
+    }
+}
@@ -0,0 +1,22 @@
+package org.kgajjar.mobileai.tokenizer
+
+import org.kgajjar.mobileai.collections.IntArrayList
+
+interface Tokenizer {
+    val vocabSize: Int
+
+    /**
+     * Appends the token ids for `text[start, end)` to [ids]. When [ends] is given, the exclusive
+     * end offset (into [text]) of every emitted token is appended to it in lockstep, so callers
+     * can map token spans back to text without re-tokenizing.
+     */
+    fun encode(text: CharSequence, start: Int, end: Int, ids: IntArrayList, ends: IntArrayList? = null)
+
+    fun decode(ids: IntArray, start: Int = 0, end: Int = ids.size): String
+}
+
+fun Tokenizer.encode(text: CharSequence): IntArray {
+    val ids = IntArrayList(text.length / 3 + 1)
+    encode(text, 0, text.length, ids)
+    return ids.toIntArray()
+}
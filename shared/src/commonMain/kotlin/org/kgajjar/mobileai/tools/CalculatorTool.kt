@@ -0,0 +1,109 @@
+package org.kgajjar.mobileai.tools
+
+import org.kgajjar.mobileai.json.Json
+import org.kgajjar.mobileai.json.JsonNumber
+import org.kgajjar.mobileai.json.JsonObject
+import org.kgajjar.mobileai.json.JsonValue
+import kotlin.math.abs
+import kotlin.math.ln
+import kotlin.math.pow
+import kotlin.math.sqrt
+
+/** Evaluates arithmetic exactly as written, so the model does not have to do it in its head. */
+class CalculatorTool : Tool {
+    override val name = "calculator"
+    override val description = "Evaluates an arithmetic expression with + - * / % ^, parentheses, sqrt, abs and ln."
+    override val parameters = Json.obj(
+        "type" to "object",
+        "properties" to mapOf("expression" to mapOf("type" to "string")),
+        "required" to listOf("expression"),
+    )
+
+    override suspend fun invoke(arguments: JsonObject): JsonValue =
+        JsonNumber(evaluate(arguments.requireString("expression")))
+
+    companion object {
+        fun evaluate(expression: String): Double {
+            val parser = Parser(expression)
+            val value = parser.sum()
+            parser.skipSpaces()
+            if (parser.position < expression.length) throw ToolException("unexpected '${expression[parser.position]}'")
+            return value
+        }
+    }
+
+    /** Recursive descent: sum := product (('+'|'-') product)*, and so on down to atoms. */
+    private class Parser(val text: String) {
+        var position = 0
+
+        fun sum(): Double {
+            var value = product()
+            while (true) {
+                value = when {
+                    eat('+') -> value + product()
+                    eat('-') -> value - product()
+                    else -> return value
+                }
+            }
+        }
+
+        fun product(): Double {
+            var value = power()
+            while (true) {
+                value = when {
+                    eat('*') -> value * power()
+                    eat('/') -> value / power()
+                    eat('%') -> value % power()
+                    else -> return value
+                }
+            }
+        }
+
+        /** Right-associative, binding tighter than unary minus on its left: -2^2 is -4. */
+        fun power(): Double {
+            if (eat('-')) return -power()
+            if (eat('+')) return power()
+            val base = atom()
+            return if (eat('^')) base.pow(power()) else base
+        }
+
+        fun atom(): Double {
+            skipSpaces()
+            if (eat('(')) return sum().also { expect(')') }
+            val start = position
+            while (position < text.length && text[position].isLetter()) position++
+            if (position > start) {
+                val function = text.substring(start, position)
+                expect('(')
+                val argument = sum()
+                expect(')')
+                return when (function) {
+                    "sqrt" -> sqrt(argument)
+                    "abs" -> abs(argument)
+                    "ln" -> ln(argument)
+                    else -> throw ToolException("unknown function '$function'")
+                }
+            }
+            while (position < text.length && (text[position].isDigit() || text[position] == '.')) position++
+            if (position == start) throw ToolException("expected a number at position $start")
+            return text.substring(start, position).toDoubleOrNull() ?: throw ToolException("bad number at position $start")
+        }
+
+        fun skipSpaces() {
+            while (position < text.length && text[position].isWhitespace()) position++
+        }
+
+        fun eat(c: Char): Boolean {
+            skipSpaces()
+            if (position < text.length && text[position] == c) {
+                position++
+                return true
+            }
+            return false
+        }
+
+        fun expect(c: Char) {
+            if (!eat(c)) throw ToolException("expected '$c' at position $position")
+        }
+    }
+}
@@ -0,0 +1,27 @@
+package org.kgajjar.mobileai.tools
+
+import org.kgajjar.mobileai.json.Json
+import org.kgajjar.mobileai.json.JsonObject
+import org.kgajjar.mobileai.json.JsonValue
+import org.kgajjar.mobileai.json.doubleOrNull
+import org.kgajjar.mobileai.search.ChatHistorySearch
+
+/** Looks up what the user discussed in earlier conversations. */
+class ChatSearchTool(private val history: ChatHistorySearch) : Tool {
+    override val name = "search_history"
+    override val description = "Searches the user's past conversations and returns matching messages."
+    override val parameters = Json.obj(
+        "type" to "object",
+        "properties" to mapOf(
+            "query" to mapOf("type" to "string"),
+            "limit" to mapOf("type" to "integer", "minimum" to 1, "maximum" to 20),
+        ),
+        "required" to listOf("query"),
+    )
+
+    override suspend fun invoke(arguments: JsonObject): JsonValue {
+        val limit = (arguments["limit"]?.doubleOrNull?.toInt() ?: 5).coerceIn(1, 20)
+        val hits = history.search(arguments.requireString("query"), limit)
+        return Json.of(hits.map { mapOf("conversation" to it.title, "message" to it.snippet) })
+    }
+}
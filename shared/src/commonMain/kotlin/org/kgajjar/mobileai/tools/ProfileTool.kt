@@ -0,0 +1,18 @@
+package org.kgajjar.mobileai.tools
+
+import org.kgajjar.mobileai.json.Json
+import org.kgajjar.mobileai.json.JsonObject
+import org.kgajjar.mobileai.json.JsonValue
+import org.kgajjar.mobileai.settings.UserSettings
+
+/** Gives the model the user's name and preferences. */
+class ProfileTool(private val settings: UserSettings) : Tool {
+    override val name = "user_profile"
+    override val description = "Returns the user's display name and preferences."
+    override val parameters = Json.obj("type" to "object", "properties" to emptyMap<String, Any>())
+
+    override suspend fun invoke(arguments: JsonObject): JsonValue = Json.obj(
+        "displayName" to settings.displayName.ifBlank { null },
+        "personalizedSuggestions" to settings.personalizedSuggestions,
+    )
+}
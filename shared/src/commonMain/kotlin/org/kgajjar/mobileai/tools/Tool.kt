@@ -0,0 +1,47 @@
+package org.kgajjar.mobileai.tools
+
+import org.kgajjar.mobileai.json.Json
+import org.kgajjar.mobileai.json.JsonArray
+import org.kgajjar.mobileai.json.JsonObject
+import org.kgajjar.mobileai.json.JsonString
+import org.kgajjar.mobileai.json.JsonValue
+
+/** A function the model can call. */
+interface Tool {
+    val name: String
+
+    /** One or two sentences telling the model when to use the tool. */
+    val description: String
+
+    /** JSON Schema of the arguments object. */
+    val parameters: JsonObject
+
+    /** Runs the tool. Throwing [ToolException] reports a message back to the model. */
+    suspend fun invoke(arguments: JsonObject): JsonValue
+}
+
+class ToolException(message: String) : RuntimeException(message)
+
+/** Reads a required string argument. */
+fun JsonObject.requireString(name: String): String =
+    (this[name] as? JsonString)?.value ?: throw ToolException("missing string argument '$name'")
+
+class ToolRegistry(tools: List<Tool> = emptyList()) {
+    private val tools = LinkedHashMap<String, Tool>()
+
+    init {
+        tools.forEach { register(it) }
+    }
+
+    fun register(tool: Tool) {
+        require(tool.name !in tools) { "tool ${tool.name} is already registered" }
+        tools[tool.name] = tool
+    }
+
+    operator fun get(name: String): Tool? = tools[name]
+
+    /** Tool declarations in the shape function-calling prompts expect. */
+    fun describe(): JsonArray = JsonArray(
+        tools.values.map { Json.obj("name" to it.name, "description" to it.description, "parameters" to it.parameters) }
+    )
+}
@@ -0,0 +1,87 @@
+package org.kgajjar.mobileai.tools
+
+import kotlinx.coroutines.CancellationException
+import kotlinx.coroutines.Deferred
+import kotlinx.coroutines.TimeoutCancellationException
+import kotlinx.coroutines.async
+import kotlinx.coroutines.awaitAll
+import kotlinx.coroutines.coroutineScope
+import kotlinx.coroutines.flow.Flow
+import kotlinx.coroutines.withTimeout
+import org.kgajjar.mobileai.json.Json
+import org.kgajjar.mobileai.json.JsonArray
+import org.kgajjar.mobileai.json.JsonObject
+import org.kgajjar.mobileai.json.JsonStreamParser
+import org.kgajjar.mobileai.json.JsonString
+import org.kgajjar.mobileai.json.JsonValue
+import kotlin.time.Duration
+import kotlin.time.Duration.Companion.seconds
+
+data class ToolCall(val id: String, val name: String, val arguments: JsonObject)
+
+/** Outcome of one call: [output] on success, otherwise [error]. */
+data class ToolResult(val call: ToolCall, val output: JsonValue?, val error: String?) {
+    /** The message fed back to the model. */
+    fun toJson(): JsonObject = Json.obj(
+        "id" to call.id,
+        "name" to call.name,
+        if (error == null) "output" to output else "error" to error,
+    )
+}
+
+/**
+ * Executes tool calls while the model is still generating them.
+ *
+ * The model emits its calls as a JSON array of `{"id", "name", "arguments"}` objects (a single
+ * object is accepted too). The stream is parsed incrementally and each call is launched the
+ * moment its object closes, concurrently with the remaining generation and with each other;
+ * calls in one batch are independent by contract. A failing, unknown or slow call yields an
+ * error result instead of failing the batch.
+ */
+class ToolRuntime(private val registry: ToolRegistry, private val timeout: Duration = 10.seconds) {
+
+    /** Runs every call in [chunks] and returns their results in call order. */
+    suspend fun run(chunks: Flow<CharSequence>): List<ToolResult> = coroutineScope {
+        val started = ArrayList<Deferred<ToolResult>>()
+        fun start(value: JsonValue) {
+            val call = toCall(started.size, value)
+            started += async { execute(call) }
+        }
+        val parser = JsonStreamParser(
+            // Calls are numbered across the whole stream: a model may emit several arrays in a row.
+            onElement = { _, value -> start(value) },
+            onValue = { value -> if (value !is JsonArray) start(value) },
+        )
+        chunks.collect { parser.feed(it) }
+        parser.finish()
+        started.awaitAll()
+    }
+
+    private fun toCall(index: Int, value: JsonValue): ToolCall {
+        val obj = value as? JsonObject
+        val id = (obj?.get("id") as? JsonString)?.value ?: "call_$index"
+        val name = (obj?.get("name") as? JsonString)?.value ?: ""
+        val arguments = when (val raw = obj?.get("arguments")) {
+            is JsonObject -> raw
+            // Some models double-encode the arguments as a JSON string.
+            is JsonString -> runCatching { Json.parse(raw.value) as? JsonObject }.getOrNull() ?: JsonObject(emptyMap())
+            else -> JsonObject(emptyMap())
+        }
+        return ToolCall(id, name, arguments)
+    }
+
+    private suspend fun execute(call: ToolCall): ToolResult {
+        val tool = registry[call.name] ?: return ToolResult(call, null, "unknown tool '${call.name}'")
+        return try {
+            ToolResult(call, withTimeout(timeout) { tool.invoke(call.arguments) }, null)
+        } catch (e: ToolException) {
+            ToolResult(call, null, e.message)
+        } catch (e: TimeoutCancellationException) {
+            ToolResult(call, null, "timed out after $timeout")
+        } catch (e: CancellationException) {
+            throw e
+        } catch (e: Exception) {
+            ToolResult(call, null, e.message ?: e::class.simpleName)
+        }
+    }
+}
@@ -0,0 +1,192 @@
+package org.kgajjar.mobileai.trace
+
+import org.kgajjar.mobileai.json.Json
+import org.kgajjar.mobileai.storage.Storage
+import kotlin.concurrent.Volatile
+import kotlin.concurrent.atomics.AtomicLong
+import kotlin.concurrent.atomics.AtomicReference
+import kotlin.concurrent.atomics.ExperimentalAtomicApi
+import kotlin.time.TimeSource
+
+/**
+ * Process-wide tracing, exported in the Chrome trace event format that Perfetto and
+ * chrome://tracing open.
+ *
+ * While [enabled] is false a [span] costs one volatile read and runs its block inline. When on,
+ * every thread records into its own [TraceBuffer] without locking, keeping the last
+ * [bufferCapacity] events. A span that ends on the thread it started on is a slice on that
+ * thread's track; one that suspended and resumed elsewhere becomes an async slice, so coroutine
+ * work shows up whole rather than split across threads. Work timed outside Kotlin, such as an
+ * inference engine's own kernels, is reported with [record] from the thread it ran on.
+ *
+ * Buffers are only kept while they can still be exported: [clear] and turning tracing off
+ * release all of them, and a thread's buffer is dropped once the thread has exited.
+ */
+@OptIn(ExperimentalAtomicApi::class)
+object Trace {
+    /** Turning tracing off also [clear]s it, since nothing can be saved while it is off. */
+    @Volatile
+    var enabled = false
+        set(value) {
+            field = value
+            if (!value) clear()
+        }
+
+    /** Events kept per thread, for buffers created from now on. */
+    var bufferCapacity = 16_384
+
+    /** The registered buffers; [generation] changes whenever they are all released. */
+    private class Registry(val generation: Long, val buffers: List<TraceBuffer>)
+
+    private val origin = TimeSource.Monotonic.markNow()
+    private val registry = AtomicReference(Registry(0L, emptyList()))
+    private val nextThreadId = AtomicLong(1L)
+
+    /** Nanoseconds on the trace clock. */
+    fun now(): Long = origin.elapsedNow().inWholeNanoseconds
+
+    inline fun <T> span(name: String, category: String = "app", block: () -> T): T {
+        if (!enabled) return block()
+        val thread = currentBuffer()
+        val start = now()
+        try {
+            return block()
+        } finally {
+            end(name, category, start, thread)
+        }
+    }
+
+    /** Records work that ran on this thread from [start] for [durationNanos], both on the [now] clock. */
+    fun record(name: String, category: String, start: Long, durationNanos: Long) {
+        if (enabled) threadTraceBuffer().record(SLICE, name, category, start, durationNanos)
+    }
+
+    fun instant(name: String, category: String = "app") {
+        if (enabled) threadTraceBuffer().record(INSTANT, name, category, now(), 0L)
+    }
+
+    /** A sample of a value plotted over time, e.g. free KV blocks. */
+    fun counter(name: String, value: Long, category: String = "app") {
+        if (enabled) threadTraceBuffer().record(COUNTER, name, category, now(), value)
+    }
+
+    /** Drops everything recorded so far and releases the buffers it was recorded in. */
+    fun clear() {
+        while (true) {
+            val current = registry.load()
+            if (registry.compareAndSet(current, Registry(current.generation + 1, emptyList()))) return
+        }
+    }
+
+    /** Everything recorded since the last [clear], as Chrome trace JSON. */
+    fun export(): String {
+        val out = StringBuilder(1024)
+        out.append("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[")
+        var first = true
+        var asyncId = 0L
+        fun event(phase: Char, name: String, category: String, tid: Long, ts: Long) {
+            if (!first) out.append(',')
+            first = false
+            out.append("{\"ph\":\"").append(phase).append("\",\"name\":")
+            Json.quote(name, out)
+            out.append(",\"cat\":")
+            Json.quote(category, out)
+            out.append(",\"pid\":1,\"tid\":").append(tid).append(",\"ts\":")
+            micros(ts, out)
+        }
+
+        for (buffer in registry.load().buffers) {
+            event('M', "thread_name", "__metadata", buffer.threadId, 0L)
+            out.append(",\"args\":{\"name\":")
+            Json.quote(buffer.threadName, out)
+            out.append("}}")
+
+            for (e in snapshot(buffer)) {
+                when (e.kind) {
+                    SLICE -> {
+                        event('X', e.name, e.category, buffer.threadId, e.start)
+                        out.append(",\"dur\":")
+                        micros(e.value, out)
+                        out.append('}')
+                    }
+                    ASYNC -> {
+                        val id = asyncId++
+                        event('b', e.name, e.category, buffer.threadId, e.start)
+                        out.append(",\"id\":").append(id).append('}')
+                        event('e', e.name, e.category, buffer.threadId, e.start + e.value)
+                        out.append(",\"id\":").append(id).append('}')
+                    }
+                    INSTANT -> {
+                        event('i', e.name, e.category, buffer.threadId, e.start)
+                        out.append(",\"s\":\"t\"}")
+                    }
+                    COUNTER -> {
+                        event('C', e.name, e.category, buffer.threadId, e.start)
+                        out.append(",\"args\":{\"value\":").append(e.value).append("}}")
+                    }
+                }
+            }
+        }
+        return out.append("]}").toString()
+    }
+
+    /** Writes [export] to the file [name] in [storage], replacing it. */
+    fun save(storage: Storage, name: String) {
+        val bytes = export().encodeToByteArray()
+        storage.delete(name)
+        val file = storage.open(name)
+        file.append(bytes)
+        file.sync()
+        file.close()
+    }
+
+    @PublishedApi
+    internal fun currentBuffer(): TraceBuffer = threadTraceBuffer()
+
+    @PublishedApi
+    internal fun end(name: String, category: String, start: Long, startedOn: TraceBuffer) {
+        val buffer = threadTraceBuffer()
+        buffer.record(if (buffer === startedOn) SLICE else ASYNC, name, category, start, now() - start)
+    }
+
+    /** Whether [buffer] is still registered, i.e. not released by a [clear] since it was created. */
+    internal fun isCurrent(buffer: TraceBuffer): Boolean = buffer.generation == registry.load().generation
+
+    /** Registers a buffer for the calling thread, dropping those of threads no longer [alive]. */
+    internal fun newBuffer(threadName: String?, alive: () -> Boolean = { true }): TraceBuffer {
+        val id = nextThreadId.fetchAndAdd(1L)
+        while (true) {
+            val current = registry.load()
+            val buffer = TraceBuffer(id, threadName ?: "thread $id", bufferCapacity, current.generation, alive)
+            val next = Registry(current.generation, current.buffers.filter { it.isAlive } + buffer)
+            if (registry.compareAndSet(current, next)) return buffer
+        }
+    }
+
+    private class Event(val kind: Byte, val name: String, val category: String, val start: Long, val value: Long)
+
+    /** The buffer's events, minus any its thread overwrote while they were being copied. */
+    private fun snapshot(buffer: TraceBuffer): List<Event> {
+        val end = buffer.written.load()
+        // Read after the count, so these slots hold at least every event counted.
+        val slots = buffer.slots
+        val from = maxOf(0L, end - slots.size)
+        val events = ArrayList<Event>((end - from).toInt())
+        for (n in from until end) {
+            val slot = (n % slots.size).toInt()
+            events += Event(slots.kinds[slot], slots.names[slot] ?: "", slots.categories[slot] ?: "", slots.starts[slot], slots.values[slot])
+        }
+        val overwritten = buffer.written.load() - slots.size - from
+        return if (overwritten > 0) events.drop(overwritten.toInt()) else events
+    }
+
+    private fun micros(nanos: Long, out: StringBuilder) {
+        val n = maxOf(0L, nanos)
+        out.append(n / 1000).append('.').append((n % 1000).toString().padStart(3, '0'))
+    }
+
+    private const val SLICE: Byte = 1
+    private const val ASYNC: Byte = 2
+    private const val INSTANT: Byte = 3
+    private const val COUNTER: Byte = 4
+}
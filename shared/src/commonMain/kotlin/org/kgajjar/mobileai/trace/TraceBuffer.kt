@@ -0,0 +1,75 @@
+package org.kgajjar.mobileai.trace
+
+import kotlin.concurrent.Volatile
+import kotlin.concurrent.atomics.AtomicLong
+import kotlin.concurrent.atomics.ExperimentalAtomicApi
+
+/**
+ * The most recent [capacity] events of one thread. Only its own thread writes, so recording
+ * takes no lock: an event's fields are stored first and then published by bumping [written].
+ * [Trace] reads buffers concurrently and drops whatever the writer may have overwritten meanwhile.
+ *
+ * Storage starts at a few hundred events and doubles as needed, so threads that record little
+ * cost little. It only grows before the first wrap, which keeps every event in the slot it was
+ * written to for readers still holding the smaller arrays.
+ */
+@OptIn(ExperimentalAtomicApi::class)
+class TraceBuffer internal constructor(
+    val threadId: Long,
+    val threadName: String,
+    val capacity: Int,
+    internal val generation: Long = 0L,
+    private val alive: () -> Boolean = { true },
+) {
+    internal class Slots(val size: Int) {
+        val kinds = ByteArray(size)
+        val names = arrayOfNulls<String>(size)
+        val categories = arrayOfNulls<String>(size)
+        val starts = LongArray(size)
+        val values = LongArray(size)
+
+        fun grow(newSize: Int): Slots {
+            val grown = Slots(newSize)
+            kinds.copyInto(grown.kinds)
+            names.copyInto(grown.names)
+            categories.copyInto(grown.categories)
+            starts.copyInto(grown.starts)
+            values.copyInto(grown.values)
+            return grown
+        }
+    }
+
+    @Volatile
+    internal var slots = Slots(minOf(capacity, INITIAL_SLOTS))
+        private set
+    internal val written = AtomicLong(0L)
+
+    /** False once the owning thread is known to have exited. */
+    internal val isAlive: Boolean get() = alive()
+
+    internal fun record(kind: Byte, name: String, category: String, start: Long, value: Long) {
+        val n = written.load()
+        var s = slots
+        if (n >= s.size && s.size < capacity) {
+            s = s.grow(minOf(capacity, s.size * 2))
+            slots = s
+        }
+        val slot = (n % s.size).toInt()
+        s.kinds[slot] = kind
+        s.names[slot] = name
+        s.categories[slot] = category
+        s.starts[slot] = start
+        s.values[slot] = value
+        written.store(n + 1)
+    }
+
+    private companion object {
+        const val INITIAL_SLOTS = 256
+    }
+}
+
+/**
+ * This thread's buffer, created and registered with [Trace] on first use and again after
+ * [Trace.clear] released the previous one.
+ */
+internal expect fun threadTraceBuffer(): TraceBuffer
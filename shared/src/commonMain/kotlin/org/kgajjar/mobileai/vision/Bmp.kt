@@ -0,0 +1,30 @@
+package org.kgajjar.mobileai.vision
+
+import org.kgajjar.mobileai.storage.ByteBuilder
+
+/**
+ * Uncompressed 24-bit BMP, the cheapest container every platform image decoder accepts; used
+ * to hand in-memory thumbnails to UI toolkits that only take encoded images.
+ */
+object Bmp {
+    fun encode(image: RgbImage): ByteArray {
+        val rowSize = (image.width * 3 + 3) and 3.inv()
+        val dataSize = rowSize * image.height
+        val out = ByteBuilder(54 + dataSize)
+        out.putByte('B'.code).putByte('M'.code).putInt(54 + dataSize).putInt(0).putInt(54)
+        out.putInt(40).putInt(image.width).putInt(image.height)
+        out.putByte(1).putByte(0).putByte(24).putByte(0) // planes, bits
+        out.putInt(0).putInt(dataSize).putInt(2835).putInt(2835).putInt(0).putInt(0)
+        val padding = rowSize - image.width * 3
+        // Rows are stored bottom-up, pixels as B, G, R.
+        for (y in image.height - 1 downTo 0) {
+            val row = y * image.width
+            for (x in 0 until image.width) {
+                val p = image.pixels[row + x]
+                out.putByte(p).putByte(p shr 8).putByte(p shr 16)
+            }
+            repeat(padding) { out.putByte(0) }
+        }
+        return out.toByteArray()
+    }
+}
@@ -0,0 +1,22 @@
+package org.kgajjar.mobileai.vision
+
+/**
+ * Decodes compressed images (JPEG, PNG, ...) for [PhotoLibrary] implementations.
+ *
+ * Thumbnails and encoder input need a few hundred pixels a side, so decoding a 12-megapixel
+ * photo at full size wastes most of the work. Implementations decode at the smallest reduced
+ * scale the codec offers (JPEG's DCT-domain 1/2, 1/4 and 1/8 scaling, or subsampling where
+ * that is all there is) that still leaves the shorter side at least `minSide`, and leave the
+ * exact size to [ImageResizer].
+ */
+interface ImageDecoder {
+    /** The decoded image, or null if [bytes] are not an image this decoder reads. */
+    fun decode(bytes: ByteArray, minSide: Int): RgbImage?
+}
+
+/** The largest power-of-two reduction that keeps the shorter side of a [width] × [height] image at [minSide] or more. */
+fun reductionFor(width: Int, height: Int, minSide: Int): Int {
+    var factor = 1
+    while (minOf(width, height) / (factor * 2) >= minSide && factor < 8) factor *= 2
+    return factor
+}
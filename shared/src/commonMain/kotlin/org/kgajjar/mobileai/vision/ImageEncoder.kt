@@ -0,0 +1,34 @@
+package org.kgajjar.mobileai.vision
+
+import org.kgajjar.mobileai.ingest.TextEncoder
+
+/**
+ * The image tower of a contrastive image-text model (CLIP-style). Vectors are [dimension]
+ * floats, L2-normalized, in the same space as [textEncoder]'s, so a text query can be matched
+ * against photos directly.
+ */
+interface ImageEncoder {
+    /** Identifies the weights; embeddings from different model ids are never interchangeable. */
+    val modelId: String
+
+    val dimension: Int
+
+    /** Side of the square input, in pixels. */
+    val inputSize: Int
+
+    /** Per-channel RGB normalization the model was trained with, applied to values in [0, 1]. */
+    val mean: FloatArray
+    val std: FloatArray
+
+    /** Images per [encode] call that keep the model busiest. */
+    val batchSize: Int
+
+    /** The paired text tower. */
+    val textEncoder: TextEncoder
+
+    /**
+     * Embeds [count] preprocessed images packed one after another in [pixels], each planar RGB
+     * (`3 × inputSize × inputSize`, see [ImagePreprocessor]).
+     */
+    suspend fun encode(pixels: FloatArray, count: Int): List<FloatArray>
+}
@@ -0,0 +1,74 @@
+package org.kgajjar.mobileai.vision
+
+/**
+ * Turns a decoded image into model input: a centered square crop, resized to [size] × [size]
+ * with bilinear filtering, normalized per channel and laid out planar (all R, then G, then B).
+ *
+ * Source coordinates and weights depend only on the output column or row, so they are computed
+ * once per image rather than once per pixel, and normalization is folded into one multiply-add
+ * per sample. Not thread-safe; use one per worker.
+ */
+class ImagePreprocessor(val size: Int, mean: FloatArray, std: FloatArray) {
+    constructor(encoder: ImageEncoder) : this(encoder.inputSize, encoder.mean, encoder.std)
+
+    init {
+        require(size > 0 && mean.size == 3 && std.size == 3) { "bad preprocessing parameters" }
+    }
+
+    /** Floats one image occupies in a batch. */
+    val floatsPerImage: Int = 3 * size * size
+
+    // (v / 255 - mean) / std as v * scale + bias.
+    private val scale = FloatArray(3) { 1f / (255f * std[it]) }
+    private val bias = FloatArray(3) { -mean[it] / std[it] }
+
+    private val x0 = IntArray(size)
+    private val x1 = IntArray(size)
+    private val wx = FloatArray(size)
+    private val y0 = IntArray(size)
+    private val y1 = IntArray(size)
+    private val wy = FloatArray(size)
+
+    fun process(image: RgbImage, out: FloatArray, offset: Int = 0) {
+        require(out.size - offset >= floatsPerImage) { "output too small" }
+        val side = minOf(image.width, image.height)
+        taps((image.width - side) / 2, side, x0, x1, wx)
+        taps((image.height - side) / 2, side, y0, y1, wy)
+        val plane = size * size
+        val pixels = image.pixels
+        val width = image.width
+        for (oy in 0 until size) {
+            val top = y0[oy] * width
+            val bottom = y1[oy] * width
+            val fy = wy[oy]
+            for (ox in 0 until size) {
+                val fx = wx[ox]
+                val a = pixels[top + x0[ox]]
+                val b = pixels[top + x1[ox]]
+                val c = pixels[bottom + x0[ox]]
+                val d = pixels[bottom + x1[ox]]
+                val o = offset + oy * size + ox
+                for (ch in 0 until 3) {
+                    val shift = 16 - 8 * ch
+                    val upper = lerp((a shr shift) and 0xFF, (b shr shift) and 0xFF, fx)
+                    val lower = lerp((c shr shift) and 0xFF, (d shr shift) and 0xFF, fx)
+                    out[o + ch * plane] = (upper + (lower - upper) * fy) * scale[ch] + bias[ch]
+                }
+            }
+        }
+    }
+
+    /** Neighbouring source indices and the weight of the second, for each output index. */
+    private fun taps(start: Int, length: Int, first: IntArray, second: IntArray, weight: FloatArray) {
+        val step = length.toFloat() / size
+        for (i in 0 until size) {
+            val position = ((i + 0.5f) * step - 0.5f).coerceIn(0f, (length - 1).toFloat())
+            val lower = position.toInt()
+            first[i] = start + lower
+            second[i] = start + minOf(lower + 1, length - 1)
+            weight[i] = position - lower
+        }
+    }
+
+    private fun lerp(a: Int, b: Int, t: Float): Float = a + (b - a) * t
+}
@@ -0,0 +1,160 @@
+package org.kgajjar.mobileai.vision
+
+import kotlin.math.PI
+import kotlin.math.abs
+import kotlin.math.ceil
+import kotlin.math.floor
+import kotlin.math.roundToInt
+import kotlin.math.sin
+
+/**
+ * Separable resampling of [RgbImage]s. [area] averages every source pixel an output pixel
+ * covers, which is what large reductions (thumbnails, encoder input) need to avoid aliasing;
+ * [lanczos] keeps edges sharper for mild reductions and for enlargements.
+ *
+ * Each axis gets a table of source ranges and weights per output column or row, built once per
+ * call, so both passes are plain multiply-adds over contiguous arrays. Weights are clipped at
+ * the image edges and renormalized, so borders keep their brightness. Output is opaque.
+ */
+object ImageResizer {
+    fun area(image: RgbImage, width: Int, height: Int): RgbImage =
+        resize(image, width, height) { src, dst -> areaTaps(src, dst) }
+
+    fun lanczos(image: RgbImage, width: Int, height: Int, lobes: Int = 3): RgbImage =
+        resize(image, width, height) { src, dst -> lanczosTaps(src, dst, lobes) }
+
+    /** Shrinks [image] with [area] until its shorter side is [side]; smaller images are returned as is. */
+    fun fitShorterSide(image: RgbImage, side: Int): RgbImage {
+        val shorter = minOf(image.width, image.height)
+        if (shorter <= side) return image
+        val width = maxOf(1, (image.width.toLong() * side / shorter).toInt())
+        val height = maxOf(1, (image.height.toLong() * side / shorter).toInt())
+        return area(image, width, height)
+    }
+
+    /** Output index `i` reads `count` source indices from `start[i]` with `weights[i * count + k]`. */
+    private class Taps(val start: IntArray, val count: Int, val weights: FloatArray)
+
+    private inline fun resize(image: RgbImage, width: Int, height: Int, taps: (Int, Int) -> Taps): RgbImage {
+        require(width > 0 && height > 0) { "bad target size ${width}x$height" }
+        val columns = taps(image.width, width)
+        val rows = taps(image.height, height)
+
+        // Horizontal pass: every source row to the output width, 3 floats per pixel.
+        val pixels = image.pixels
+        val wide = FloatArray(image.height * width * 3)
+        for (y in 0 until image.height) {
+            val row = y * image.width
+            var o = y * width * 3
+            for (x in 0 until width) {
+                var r = 0f
+                var g = 0f
+                var b = 0f
+                val first = row + columns.start[x]
+                val w = x * columns.count
+                for (k in 0 until columns.count) {
+                    val weight = columns.weights[w + k]
+                    val p = pixels[first + k]
+                    r += weight * ((p shr 16) and 0xFF)
+                    g += weight * ((p shr 8) and 0xFF)
+                    b += weight * (p and 0xFF)
+                }
+                wide[o] = r
+                wide[o + 1] = g
+                wide[o + 2] = b
+                o += 3
+            }
+        }
+
+        // Vertical pass.
+        val out = IntArray(width * height)
+        val stride = width * 3
+        val sum = FloatArray(stride)
+        for (y in 0 until height) {
+            sum.fill(0f)
+            val w = y * rows.count
+            for (k in 0 until rows.count) {
+                val weight = rows.weights[w + k]
+                if (weight == 0f) continue
+                val from = (rows.start[y] + k) * stride
+                for (i in 0 until stride) sum[i] += weight * wide[from + i]
+            }
+            for (x in 0 until width) {
+                out[y * width + x] = (0xFF shl 24) or (channel(sum[3 * x]) shl 16) or
+                    (channel(sum[3 * x + 1]) shl 8) or channel(sum[3 * x + 2])
+            }
+        }
+        return RgbImage(width, height, out)
+    }
+
+    private fun channel(v: Float): Int = v.roundToInt().coerceIn(0, 255)
+
+    /** Each output pixel is the coverage-weighted mean of the source pixels under it. */
+    private fun areaTaps(src: Int, dst: Int): Taps {
+        val scale = src.toDouble() / dst
+        val count = ceil(scale).toInt() + 1
+        val start = IntArray(dst)
+        val weights = FloatArray(dst * count)
+        for (i in 0 until dst) {
+            val from = i * scale
+            val to = minOf((i + 1) * scale, src.toDouble())
+            val first = minOf(floor(from).toInt(), src - 1)
+            start[i] = minOf(first, src - count).coerceAtLeast(0)
+            var total = 0.0
+            for (k in 0 until count) {
+                val j = start[i] + k
+                if (j >= src) break
+                val overlap = minOf(to, j + 1.0) - maxOf(from, j.toDouble())
+                if (overlap > 0) {
+                    weights[i * count + k] = overlap.toFloat()
+                    total += overlap
+                }
+            }
+            normalize(weights, i * count, count, total)
+        }
+        return Taps(start, minOf(count, src), weights.compact(dst, count, minOf(count, src)))
+    }
+
+    private fun lanczosTaps(src: Int, dst: Int, lobes: Int): Taps {
+        val scale = src.toDouble() / dst
+        // When shrinking, stretch the kernel to the output spacing so it also low-passes.
+        val filterScale = maxOf(scale, 1.0)
+        val radius = lobes * filterScale
+        val count = minOf(ceil(2 * radius).toInt() + 1, src)
+        val start = IntArray(dst)
+        val weights = FloatArray(dst * count)
+        for (i in 0 until dst) {
+            val center = (i + 0.5) * scale
+            val first = floor(center - radius).toInt().coerceIn(0, src - count)
+            start[i] = first
+            var total = 0.0
+            for (k in 0 until count) {
+                val j = first + k
+                val weight = lanczos((j + 0.5 - center) / filterScale, lobes)
+                weights[i * count + k] = weight.toFloat()
+                total += weight
+            }
+            normalize(weights, i * count, count, total)
+        }
+        return Taps(start, count, weights)
+    }
+
+    private fun lanczos(x: Double, lobes: Int): Double {
+        val ax = abs(x)
+        if (ax < 1e-9) return 1.0
+        if (ax >= lobes) return 0.0
+        val px = PI * x
+        return lobes * sin(px) * sin(px / lobes) / (px * px)
+    }
+
+    private fun normalize(weights: FloatArray, offset: Int, count: Int, total: Double) {
+        if (total <= 0) return
+        for (k in offset until offset + count) weights[k] = (weights[k] / total).toFloat()
+    }
+
+    /** Re-lays [dst] rows of `from` weights as rows of `to`, for sources narrower than the window. */
+    private fun FloatArray.compact(dst: Int, from: Int, to: Int): FloatArray {
+        if (from == to) return this
+        return FloatArray(dst * to) { this[(it / to) * from + it % to] }
+    }
+}
@@ -0,0 +1,265 @@
+package org.kgajjar.mobileai.vision
+
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Deferred
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.async
+import kotlinx.coroutines.awaitAll
+import kotlinx.coroutines.coroutineScope
+import kotlinx.coroutines.sync.Mutex
+import kotlinx.coroutines.sync.withLock
+import kotlinx.coroutines.withContext
+import org.kgajjar.mobileai.metrics.Metrics
+import org.kgajjar.mobileai.search.VectorIndex
+import org.kgajjar.mobileai.storage.ByteBuilder
+import org.kgajjar.mobileai.storage.ByteFile
+import org.kgajjar.mobileai.storage.ByteReader
+import org.kgajjar.mobileai.storage.ContentHash
+import org.kgajjar.mobileai.storage.Crc32
+import org.kgajjar.mobileai.storage.Storage
+import org.kgajjar.mobileai.storage.getIntLe
+import org.kgajjar.mobileai.storage.readBytes
+import kotlin.time.TimeSource
+
+data class PhotoHit(val uri: String, val modifiedAt: Long, val score: Float) {
+    val photo: Photo get() = Photo(uri, modifiedAt)
+}
+
+/**
+ * Finds photos by what they show, e.g. "receipts", using a CLIP-style [ImageEncoder].
+ *
+ * Photo embeddings live in a [VectorIndex] of their own, in the model's joint image-text space,
+ * and queries are embedded with the paired text tower to search it. The index holds photos only:
+ * the app's text embeddings come from a different encoder and space, so they are not mixed in.
+ *
+ * [sync] embeds only photos that are new or modified since they were last seen, a batch at a
+ * time, decoding and preprocessing the next batch while the encoder runs the current one. Each
+ * finished batch is appended to `<name>.log`, so an interrupted sync resumes where it stopped;
+ * the log is folded into the `<name>.vec` snapshot when a sync completes.
+ */
+class PhotoIndex private constructor(
+    private val storage: Storage,
+    private val name: String,
+    private val encoder: ImageEncoder,
+    private var index: VectorIndex,
+    private val log: ByteFile,
+) {
+    private class Entry(val id: Long, val modifiedAt: Long)
+
+    private val mutex = Mutex()
+    private val syncMutex = Mutex()
+    private val entries = HashMap<String, Entry>()
+    private val uris = HashMap<Long, String>()
+    private var nextSerial = 0L
+    private val modelHash = ContentHash.of(encoder.modelId)
+    private val record = ByteBuilder(64 + 4 * encoder.dimension)
+
+    /** Photos embedded and searchable. */
+    suspend fun count(): Int = mutex.withLock { uris.size }
+
+    /** Photos matching [query] best first, down to [minScore] (tuned for CLIP-style models). */
+    suspend fun search(query: String, limit: Int = 20, minScore: Float = 0.2f): List<PhotoHit> {
+        if (query.isBlank()) return emptyList()
+        val started = TimeSource.Monotonic.markNow()
+        return withContext(Dispatchers.Default) {
+            val vector = encoder.textEncoder.encode(listOf(query)).single()
+            mutex.withLock {
+                index.search(vector, limit).mapNotNull { neighbor ->
+                    if (neighbor.score < minScore) return@mapNotNull null
+                    uris[neighbor.id]?.let { PhotoHit(it, entries.getValue(it).modifiedAt, neighbor.score) }
+                }
+            }
+        }.also { Metrics.photoSearchLatency.record(started.elapsedNow()) }
+    }
+
+    /**
+     * Brings the index in line with [library]: forgets deleted photos and embeds new or modified
+     * ones. [onProgress] receives the photos done and to do.
+     */
+    suspend fun sync(library: PhotoLibrary, onProgress: ((done: Int, total: Int) -> Unit)? = null): Unit = syncMutex.withLock {
+        val photos = library.photos()
+        val todo = mutex.withLock {
+            val present = photos.mapTo(HashSet()) { it.uri }
+            for (uri in entries.keys.filter { it !in present }) {
+                remove(uri)
+                logRemove(uri)
+            }
+            photos.filter { entries[it.uri]?.modifiedAt != it.modifiedAt }
+        }
+        coroutineScope {
+            val batches = todo.chunked(maxOf(1, encoder.batchSize))
+            var next = batches.firstOrNull()?.let { prepare(it, library) }
+            var done = 0
+            for ((b, batch) in batches.withIndex()) {
+                val prepared = next!!.await()
+                next = batches.getOrNull(b + 1)?.let { prepare(it, library) }
+                val vectors = if (prepared.count == 0) emptyList() else encoder.encode(prepared.pixels, prepared.count)
+                mutex.withLock {
+                    var v = 0
+                    for ((i, photo) in batch.withIndex()) {
+                        // Unreadable photos are remembered too, so they are retried only once modified.
+                        val vector = if (prepared.readable[i]) vectors[v++] else null
+                        val id = if (vector == null) NO_VECTOR else nextSerial++
+                        add(photo.uri, photo.modifiedAt, id, vector)
+                        logAdd(photo.uri, photo.modifiedAt, id, vector)
+                    }
+                    log.flush()
+                }
+                Metrics.photosEmbedded.increment(batch.size.toLong())
+                done += batch.size
+                onProgress?.invoke(done, todo.size)
+            }
+        }
+        mutex.withLock { if (todo.isNotEmpty() || log.size > LOG_HEADER_SIZE) checkpoint() }
+    }
+
+    suspend fun close(): Unit = mutex.withLock {
+        log.sync()
+        log.close()
+    }
+
+    private class Prepared(val pixels: FloatArray, val count: Int, val readable: BooleanArray)
+
+    /** Decodes and preprocesses [batch] in parallel, packing the readable photos in order. */
+    private fun CoroutineScope.prepare(batch: List<Photo>, library: PhotoLibrary): Deferred<Prepared> = async {
+        val images = batch.map { photo ->
+            async(Dispatchers.Default) {
+                val loaded = library.load(photo, encoder.inputSize) ?: return@async null
+                // Decoders stop at a power-of-two reduction; bilinear alone would alias from there.
+                val image = ImageResizer.fitShorterSide(loaded, encoder.inputSize)
+                val preprocessor = ImagePreprocessor(encoder)
+                FloatArray(preprocessor.floatsPerImage).also { preprocessor.process(image, it) }
+            }
+        }.awaitAll()
+        val readable = BooleanArray(batch.size) { images[it] != null }
+        val floats = 3 * encoder.inputSize * encoder.inputSize
+        val pixels = FloatArray(images.count { it != null } * floats)
+        var count = 0
+        for (image in images) if (image != null) image.copyInto(pixels, floats * count++)
+        Prepared(pixels, count, readable)
+    }
+
+    private fun add(uri: String, modifiedAt: Long, id: Long, vector: FloatArray?) {
+        remove(uri)
+        entries[uri] = Entry(id, modifiedAt)
+        if (vector != null) {
+            index.add(id, vector)
+            uris[id] = uri
+            nextSerial = maxOf(nextSerial, id + 1)
+        }
+    }
+
+    private fun remove(uri: String) {
+        val entry = entries.remove(uri) ?: return
+        if (entry.id != NO_VECTOR) {
+            index.remove(entry.id)
+            uris.remove(entry.id)
+        }
+    }
+
+    private fun logAdd(uri: String, modifiedAt: Long, id: Long, vector: FloatArray?) = writeRecord {
+        putByte(ADD).putString(uri).putLong(modifiedAt).putLong(id)
+        vector?.forEach { putFloat(it) }
+    }
+
+    private fun logRemove(uri: String) = writeRecord { putByte(REMOVE).putString(uri) }
+
+    private inline fun writeRecord(body: ByteBuilder.() -> Unit) {
+        record.clear()
+        record.putInt(0).putInt(0)
+        record.body()
+        record.setInt(0, record.size - 8)
+        record.setInt(4, Crc32.of(record.bytes, 8, record.size - 8))
+        log.append(record.bytes, 0, record.size)
+    }
+
+    /** Replays log records after the snapshot; truncates a torn tail. */
+    private fun replay() {
+        val bytes = log.readBytes(0, log.size.toInt())
+        var pos = LOG_HEADER_SIZE
+        while (pos + 8 <= bytes.size) {
+            val length = bytes.getIntLe(pos)
+            if (length <= 0 || pos + 8 + length > bytes.size) break
+            if (Crc32.of(bytes, pos + 8, length) != bytes.getIntLe(pos + 4)) break
+            val input = ByteReader(bytes, pos + 8, pos + 8 + length)
+            when (input.byte()) {
+                ADD -> {
+                    val uri = input.string()
+                    val modifiedAt = input.long()
+                    val id = input.long()
+                    add(uri, modifiedAt, id, if (id == NO_VECTOR) null else FloatArray(encoder.dimension) { input.float() })
+                }
+                REMOVE -> remove(input.string())
+            }
+            pos += 8 + length
+        }
+        if (pos < bytes.size) log.truncate(pos.toLong())
+    }
+
+    /** Writes the snapshot, then empties the log it now covers. */
+    private fun checkpoint() {
+        val out = ByteBuilder(1024 + uris.size * (24 + 4 * encoder.dimension))
+        out.putInt(MAGIC).putLong(modelHash).putInt(encoder.dimension).putLong(nextSerial)
+        out.putInt(entries.size)
+        for ((uri, entry) in entries) out.putString(uri).putLong(entry.modifiedAt).putLong(entry.id)
+        index.writeTo(out)
+        out.putInt(Crc32.of(out.bytes, 0, out.size))
+        val tmpName = "$name.vec.tmp"
+        storage.delete(tmpName)
+        val file = storage.open(tmpName)
+        file.append(out.bytes, 0, out.size)
+        file.sync()
+        file.close()
+        storage.rename(tmpName, "$name.vec")
+        log.truncate(LOG_HEADER_SIZE.toLong())
+        log.sync()
+    }
+
+    /** Restores the snapshot if there is a valid one for this model. */
+    private fun loadSnapshot() {
+        val fileName = "$name.vec"
+        if (!storage.exists(fileName)) return
+        val file = storage.open(fileName)
+        val bytes = file.readBytes(0, file.size.toInt())
+        file.close()
+        if (bytes.size < 8 || Crc32.of(bytes, 0, bytes.size - 4) != bytes.getIntLe(bytes.size - 4)) return
+        val input = ByteReader(bytes, limit = bytes.size - 4)
+        if (input.int() != MAGIC || input.long() != modelHash || input.int() != encoder.dimension) return
+        nextSerial = input.long()
+        repeat(input.int()) {
+            val uri = input.string()
+            val modifiedAt = input.long()
+            val id = input.long()
+            entries[uri] = Entry(id, modifiedAt)
+            if (id != NO_VECTOR) uris[id] = uri
+        }
+        index = VectorIndex.readFrom(input)
+    }
+
+    companion object {
+        private const val MAGIC = 0x58494850 // "PHIX"
+        private const val LOG_MAGIC = 0x474C4850 // "PHLG"
+        private const val LOG_HEADER_SIZE = 12
+        private const val ADD = 1
+        private const val REMOVE = 2
+        private const val NO_VECTOR = -1L
+
+        suspend fun open(storage: Storage, encoder: ImageEncoder, name: String = "photos"): PhotoIndex =
+            withContext(Dispatchers.Default) {
+                val log = storage.open("$name.log")
+                val photos = PhotoIndex(storage, name, encoder, VectorIndex(encoder.dimension), log)
+                val header = ByteBuilder(LOG_HEADER_SIZE).putInt(LOG_MAGIC).putLong(photos.modelHash)
+                photos.loadSnapshot()
+                // Log records are self-contained, so they also apply without a snapshot (a first
+                // sync that never finished); anything they don't cover is simply indexed again.
+                if (log.size >= LOG_HEADER_SIZE && log.readBytes(0, LOG_HEADER_SIZE).contentEquals(header.toByteArray())) {
+                    photos.replay()
+                } else {
+                    log.truncate(0)
+                    log.append(header.toByteArray())
+                    log.sync()
+                }
+                photos
+            }
+    }
+}
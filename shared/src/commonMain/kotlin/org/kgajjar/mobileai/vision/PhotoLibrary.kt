@@ -0,0 +1,15 @@
+package org.kgajjar.mobileai.vision
+
+/** A photo on the device; [modifiedAt] changes whenever its pixels may have. */
+class Photo(val uri: String, val modifiedAt: Long)
+
+/** The user's photos, as exposed by the platform's media store or a folder. */
+interface PhotoLibrary {
+    suspend fun photos(): List<Photo>
+
+    /**
+     * Decodes [photo] at a resolution whose shorter side is at least [minSide] where the source
+     * allows, or returns null if it can't be read.
+     */
+    suspend fun load(photo: Photo, minSide: Int): RgbImage?
+}
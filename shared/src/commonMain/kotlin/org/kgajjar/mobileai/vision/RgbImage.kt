@@ -0,0 +1,10 @@
+package org.kgajjar.mobileai.vision
+
+/** A decoded image as packed `0xAARRGGBB` pixels, row by row. */
+class RgbImage(val width: Int, val height: Int, val pixels: IntArray = IntArray(width * height)) {
+    init {
+        require(width > 0 && height > 0 && pixels.size >= width * height) { "bad image geometry ${width}x$height" }
+    }
+
+    operator fun get(x: Int, y: Int): Int = pixels[y * width + x]
+}
@@ -0,0 +1,155 @@
+package org.kgajjar.mobileai.vision
+
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.sync.Mutex
+import kotlinx.coroutines.sync.withLock
+import kotlinx.coroutines.withContext
+import org.kgajjar.mobileai.storage.ByteFile
+import org.kgajjar.mobileai.storage.ContentHash
+import org.kgajjar.mobileai.storage.getIntLe
+import org.kgajjar.mobileai.storage.getLongLe
+import org.kgajjar.mobileai.storage.putIntLe
+import org.kgajjar.mobileai.storage.putLongLe
+
+/**
+ * Two-tier cache of photo thumbnails whose shorter side is [side], keyed by (uri, modification
+ * time) so an edited photo never shows a stale thumbnail.
+ *
+ * The memory tier is an LRU bounded by [memoryBytes] of decoded pixels. The optional disk tier
+ * is a pack of records, `key:i64 | width:i32 | height:i32 | rgb:u8[3 × width × height]`, behind
+ * a small header; on open only the record headers are read to rebuild the offset index, and
+ * reads go through the file's memory map. The pack is a cache, not a store: when it would grow
+ * past [maxDiskBytes] it is emptied and refills with whatever is viewed next.
+ */
+class ThumbnailCache(
+    private val library: PhotoLibrary,
+    val side: Int = 160,
+    private val memoryBytes: Long = 16L shl 20,
+    private val maxDiskBytes: Long = 128L shl 20,
+    private val file: ByteFile? = null,
+) {
+    private class Located(val position: Long, val width: Int, val height: Int)
+
+    private val mutex = Mutex()
+
+    /** Iteration order is recency order: reads re-insert their entry at the end. */
+    private val memory = LinkedHashMap<Long, RgbImage>()
+    private var memoryUsed = 0L
+
+    private val diskIndex = HashMap<Long, Located>()
+
+    /** Decoded pixels held in memory, in bytes; read without the lock, so only approximate. */
+    val memoryUsedBytes: Long get() = memoryUsed
+
+    init {
+        require(side > 0) { "side must be positive" }
+        if (file != null) openDiskTier(file)
+    }
+
+    /**
+     * The thumbnail of [photo], decoding and caching it on a miss; null if it can't be read.
+     * Disk reads, decoding and resizing all run on [Dispatchers.Default].
+     */
+    suspend fun get(photo: Photo): RgbImage? = withContext(Dispatchers.Default) {
+        val key = ContentHash.of(photo.uri, seed = photo.modifiedAt)
+        mutex.withLock { lookup(key) }?.let { return@withContext it }
+        // Decode outside the lock; two callers racing on one photo just both decode it.
+        val image = library.load(photo, side) ?: return@withContext null
+        val thumbnail = ImageResizer.fitShorterSide(image, side)
+        mutex.withLock {
+            remember(key, thumbnail)
+            write(key, thumbnail)
+        }
+        thumbnail
+    }
+
+    suspend fun close() = mutex.withLock { file?.close() }
+
+    private fun lookup(key: Long): RgbImage? {
+        memory.remove(key)?.let {
+            memory[key] = it
+            return it
+        }
+        val located = diskIndex[key] ?: return null
+        val rgb = ByteArray(3 * located.width * located.height)
+        file!!.read(located.position + RECORD_HEADER, rgb)
+        val pixels = IntArray(located.width * located.height) {
+            (0xFF shl 24) or ((rgb[3 * it].toInt() and 0xFF) shl 16) or
+                ((rgb[3 * it + 1].toInt() and 0xFF) shl 8) or (rgb[3 * it + 2].toInt() and 0xFF)
+        }
+        return RgbImage(located.width, located.height, pixels).also { remember(key, it) }
+    }
+
+    private fun remember(key: Long, image: RgbImage) {
+        memory.remove(key)?.let { memoryUsed -= bytesOf(it) }
+        memory[key] = image
+        memoryUsed += bytesOf(image)
+        val eldest = memory.values.iterator()
+        while (memoryUsed > memoryBytes && memory.size > 1) {
+            memoryUsed -= bytesOf(eldest.next())
+            eldest.remove()
+        }
+    }
+
+    private fun write(key: Long, image: RgbImage) {
+        if (file == null || key in diskIndex) return
+        val record = ByteArray(RECORD_HEADER + 3 * image.width * image.height)
+        if (file.size + record.size > maxDiskBytes) {
+            file.truncate(HEADER_SIZE.toLong())
+            diskIndex.clear()
+            if (HEADER_SIZE + record.size > maxDiskBytes) return
+        }
+        record.putLongLe(0, key)
+        record.putIntLe(8, image.width)
+        record.putIntLe(12, image.height)
+        var o = RECORD_HEADER
+        for (i in 0 until image.width * image.height) {
+            val p = image.pixels[i]
+            record[o++] = (p shr 16).toByte()
+            record[o++] = (p shr 8).toByte()
+            record[o++] = p.toByte()
+        }
+        diskIndex[key] = Located(file.append(record), image.width, image.height)
+    }
+
+    private fun openDiskTier(file: ByteFile) {
+        val header = ByteArray(HEADER_SIZE)
+        val valid = file.size >= HEADER_SIZE && run {
+            file.read(0, header)
+            header.getIntLe(0) == MAGIC && header.getIntLe(4) == VERSION && header.getIntLe(8) == side
+        }
+        if (!valid) {
+            file.truncate(0)
+            header.fill(0)
+            header.putIntLe(0, MAGIC)
+            header.putIntLe(4, VERSION)
+            header.putIntLe(8, side)
+            file.append(header)
+            file.sync()
+            return
+        }
+        val scratch = ByteArray(RECORD_HEADER)
+        var position = HEADER_SIZE.toLong()
+        while (position + RECORD_HEADER <= file.size) {
+            file.read(position, scratch)
+            val width = scratch.getIntLe(8)
+            val height = scratch.getIntLe(12)
+            if (width <= 0 || height <= 0) break
+            val end = position + RECORD_HEADER + 3L * width * height
+            if (end > file.size) break
+            diskIndex[scratch.getLongLe(0)] = Located(position, width, height)
+            position = end
+        }
+        // Drop a record torn by a crash mid-append.
+        if (position != file.size) file.truncate(position)
+    }
+
+    private fun bytesOf(image: RgbImage): Long = 4L * image.width * image.height
+
+    private companion object {
+        const val MAGIC = 0x4E485450 // "PTHN"
+        const val VERSION = 1
+        const val HEADER_SIZE = 16
+        const val RECORD_HEADER = 16
+    }
+}
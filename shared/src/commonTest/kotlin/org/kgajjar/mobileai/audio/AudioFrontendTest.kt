@@ -0,0 +1,67 @@
+package org.kgajjar.mobileai.audio
+
+import kotlin.math.PI
+import kotlin.math.abs
+import kotlin.math.cos
+import kotlin.math.sin
+import kotlin.random.Random
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFailsWith
+import kotlin.test.assertTrue
+
+class AudioFrontendTest {
+    @Test
+    fun powerSpectrumMatchesNaiveDft() {
+        val random = Random(7)
+        val frame = FloatArray(64) { random.nextFloat() * 2 - 1 }
+        val power = FloatArray(33)
+        Fft(64).powerSpectrum(frame, power)
+        for (k in 0..32) {
+            var re = 0.0
+            var im = 0.0
+            for (n in 0 until 64) {
+                re += frame[n] * cos(2 * PI * k * n / 64)
+                im -= frame[n] * sin(2 * PI * k * n / 64)
+            }
+            val expected = re * re + im * im
+            assertTrue(abs(power[k] - expected) < 1e-3 * (1 + expected), "bin $k: ${power[k]} vs $expected")
+        }
+    }
+
+    @Test
+    fun resamplesWithoutDistortingATone() {
+        val input = FloatArray(44_100 / 2) { 0.5f * sin(2 * PI * 1000 * it / 44_100).toFloat() }
+        val resampler = Resampler(44_100, 16_000)
+        val chunks = (input.indices step 1000).map { resampler.process(input, it, minOf(1000, input.size - it)) }
+        val output = (chunks + listOf(resampler.flush())).flatMap { it.asList() }
+        assertEquals(8000, output.size)
+        for (i in 200 until output.size - 200) {
+            val expected = 0.5 * sin(2 * PI * 1000 * i / 16_000)
+            assertTrue(abs(output[i] - expected) < 1e-3, "sample $i: ${output[i]} vs $expected")
+        }
+    }
+
+    @Test
+    fun wavRoundTripsAndRejectsGarbage() {
+        val audio = PcmAudio(FloatArray(1000) { sin(it / 10f) * 0.8f }, 22_050)
+        val decoded = Wav.decode(Wav.encode(audio))
+        assertEquals(22_050, decoded.sampleRate)
+        assertEquals(1000, decoded.samples.size)
+        for (i in audio.samples.indices) assertTrue(abs(audio.samples[i] - decoded.samples[i]) < 1e-4f)
+        assertFailsWith<IllegalArgumentException> { Wav.decode("RIFF....WAVEjunk".encodeToByteArray()) }
+    }
+
+    @Test
+    fun logMelPeaksAtTheToneFrequency() {
+        val frontend = LogMelFrontend()
+        val tone = FloatArray(16_000) { sin(2 * PI * 1000 * it / 16_000).toFloat() }
+        val peaks = ArrayList<Int>()
+        frontend.accept(tone, 0, 7000) { peaks += it.indices.maxBy { m -> it[m] } }
+        frontend.accept(tone, 7000, 9000) { peaks += it.indices.maxBy { m -> it[m] } }
+        frontend.flush { peaks += it.indices.maxBy { m -> it[m] } }
+        assertEquals(99, peaks.size)
+        // 1 kHz is mel 1000; the 80 bins split mel 0..2840 into steps of about 35.
+        assertTrue(peaks.all { it in 26..28 }, "peaks $peaks")
+    }
+}
@@ -0,0 +1,75 @@
+package org.kgajjar.mobileai.audio
+
+import kotlinx.coroutines.CompletableDeferred
+import kotlinx.coroutines.flow.flow
+import kotlinx.coroutines.test.runTest
+import org.kgajjar.mobileai.storage.MemoryStorage
+import org.kgajjar.mobileai.storage.readBytes
+import kotlin.math.abs
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertTrue
+
+class SpeechPipelineTest {
+    /** Renders sentence k as 10 samples per character at level (k + 1) / 10, in 64-sample buffers. */
+    private class LevelSynthesizer : SpeechSynthesizer {
+        override val sampleRate = 1000
+        val sentences = ArrayList<String>()
+        val firstStarted = CompletableDeferred<Unit>()
+
+        override suspend fun synthesize(sentence: String, onAudio: suspend (FloatArray, Int) -> Unit) {
+            sentences += sentence
+            firstStarted.complete(Unit)
+            val level = sentences.size / 10f
+            val buffer = FloatArray(64)
+            var left = sentence.length * 10
+            while (left > 0) {
+                val n = minOf(left, buffer.size)
+                buffer.fill(level, 0, n)
+                onAudio(buffer, n)
+                left -= n
+            }
+        }
+    }
+
+    @Test
+    fun splitsStreamedTextIntoSpeakableSentences() {
+        val splitter = SentenceSplitter()
+        val text = "Hello there! Dr. Smith paid $3.50 today. **Really?** Yes…\n1. First step\nDone"
+        val sentences = text.flatMap { splitter.append(it.toString()) } + listOfNotNull(splitter.finish())
+        assertEquals(listOf("Hello there!", "Dr. Smith paid $3.50 today.", "Really?", "Yes…", "1. First step", "Done"), sentences)
+
+        // A run-on sentence is cut at word breaks rather than held back.
+        val runOn = SentenceSplitter(maxLength = 40)
+        val pieces = runOn.append("word ".repeat(20)) + listOfNotNull(runOn.finish())
+        assertEquals(3, pieces.size)
+        assertTrue(pieces.all { it.length <= 40 })
+        assertEquals("word ".repeat(20).trim(), pieces.joinToString(" "))
+    }
+
+    @Test
+    fun startsSpeakingBeforeTheReplyIsComplete() = runTest {
+        val synthesizer = LevelSynthesizer()
+        val storage = MemoryStorage()
+        val reply = flow<CharSequence> {
+            emit("Hello there. ")
+            // Only continues once the first sentence is being synthesized.
+            synthesizer.firstStarted.await()
+            emit("This is the ")
+            emit("rest.")
+        }
+        SpeechPipeline(synthesizer, WavSink(storage, "reply.wav", 1000), bufferSeconds = 0.1f).speak(reply)
+
+        assertEquals(listOf("Hello there.", "This is the rest."), synthesizer.sentences)
+        val file = storage.open("reply.wav")
+        val audio = Wav.decode(file.readBytes(0, file.size.toInt()))
+        file.close()
+        assertEquals(1000, audio.sampleRate)
+        assertEquals(120 + 170, audio.samples.size)
+        for (i in audio.samples.indices) {
+            val expected = if (i < 120) 0.1f else 0.2f
+            assertTrue(abs(audio.samples[i] - expected) < 1e-3f, "sample $i")
+        }
+        assertTrue(!storage.exists("reply.wav.tmp"))
+    }
+}
@@ -0,0 +1,78 @@
+package org.kgajjar.mobileai.audio
+
+import kotlinx.coroutines.flow.toList
+import kotlinx.coroutines.test.runTest
+import kotlin.math.PI
+import kotlin.math.sin
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertTrue
+
+class StreamingTranscriberTest {
+    /**
+     * Hears tones as words: every run of loud frames is "low" or "high" depending on its loudest
+     * mel bin, including a run still going at the end of the window.
+     */
+    private class ToneModel : AsrModel {
+        override val sampleRate = 16_000
+        override val melBins = 80
+        override val maxFrames = 3000
+        val prompts = ArrayList<String>()
+
+        override suspend fun transcribe(features: FloatArray, frameCount: Int, prompt: String): List<AsrWord> {
+            prompts += prompt
+            val words = ArrayList<AsrWord>()
+            var runPeak = -1
+            for (f in 0..frameCount) {
+                val peak = if (f == frameCount) -1 else loudestBin(features, f)
+                if (peak < 0 && runPeak >= 0) words += AsrWord(if (runPeak < 28) "low" else "high", f)
+                runPeak = if (peak < 0) -1 else maxOf(runPeak, peak)
+            }
+            return words
+        }
+
+        private fun loudestBin(features: FloatArray, frame: Int): Int {
+            var best = -1
+            var bestValue = 0f // silence is ln(1e-10)
+            for (m in 0 until melBins) {
+                val value = features[frame * melBins + m]
+                if (value > bestValue) {
+                    best = m
+                    bestValue = value
+                }
+            }
+            return best
+        }
+    }
+
+    @Test
+    fun streamsPartialsAndCommitsAgreedWords() = runTest {
+        val wav = Wav.encode(PcmAudio(tones(44_100), 44_100))
+        val model = ToneModel()
+        val updates = StreamingTranscriber(model, 44_100, chunkFrames = 50)
+            .transcribe(PcmAudioSource(Wav.decode(wav)))
+            .toList()
+
+        val last = updates.last()
+        assertTrue(last.final)
+        assertEquals("low high", last.text)
+        assertTrue(updates.dropLast(1).none { it.final })
+        // "low" was shown while the audio was still playing, first as a guess, then committed.
+        assertTrue(updates.any { !it.final && it.partial == "low" && it.committed.isEmpty() })
+        assertTrue(updates.any { !it.final && it.committed == "low" })
+        // Committed text only ever grows.
+        updates.zipWithNext { a, b -> assertTrue(b.committed.startsWith(a.committed)) }
+        // Decodes after the first commit continue from it.
+        assertTrue("low" in model.prompts)
+    }
+
+    /** 0.3 s silence, 0.4 s at 440 Hz, 0.3 s silence, 0.4 s at 2 kHz, 0.3 s silence. */
+    private fun tones(rate: Int): FloatArray {
+        val segments = listOf(0.3 to 0.0, 0.4 to 440.0, 0.3 to 0.0, 0.4 to 2000.0, 0.3 to 0.0)
+        val out = ArrayList<Float>()
+        for ((seconds, hz) in segments) {
+            repeat((seconds * rate).toInt()) { out += if (hz == 0.0) 0f else 0.5f * sin(2 * PI * hz * it / rate).toFloat() }
+        }
+        return out.toFloatArray()
+    }
+}
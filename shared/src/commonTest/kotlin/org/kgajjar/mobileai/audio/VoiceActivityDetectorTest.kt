@@ -0,0 +1,45 @@
+package org.kgajjar.mobileai.audio
+
+import kotlin.random.Random
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertTrue
+
+class VoiceActivityDetectorTest {
+    private val random = Random(1)
+
+    private fun noise() = FloatArray(80) { -5f + (random.nextFloat() - 0.5f) * 0.6f }
+
+    private fun speech() = noise().also { for (m in 10 until 30) it[m] = 1f }
+
+    @Test
+    fun ignoresClicksAndShortPausesAndFindsTheEndpoint() {
+        val frames = ArrayList<FloatArray>()
+        repeat(50) { frames += noise() }
+        repeat(2) { frames += speech() } // a click
+        repeat(30) { frames += noise() }
+        repeat(20) { frames += speech() }
+        repeat(10) { frames += noise() } // a pause between words
+        repeat(20) { frames += speech() }
+        repeat(100) { frames += noise() }
+
+        val vad = VoiceActivityDetector()
+        val events = ArrayList<Pair<Int, VadEvent>>()
+        frames.forEachIndexed { i, f -> vad.accept(f)?.let { events += i to it } }
+
+        assertEquals(3, events.size, "events ${events.map { it.second::class.simpleName to it.second.frame }}")
+        val (startAt, start) = events[0]
+        assertTrue(start is VadEvent.SpeechStart)
+        assertEquals(82L, start.frame)
+        assertEquals(84, startAt)
+        val (endAt, end) = events[1]
+        assertTrue(end is VadEvent.SpeechEnd)
+        assertEquals(131L, end.frame)
+        assertEquals(151, endAt)
+        val (endpointAt, endpoint) = events[2]
+        assertTrue(endpoint is VadEvent.Endpoint)
+        assertEquals(131L, endpoint.frame)
+        assertEquals(211, endpointAt)
+        assertTrue(!vad.speaking)
+    }
+}
@@ -0,0 +1,167 @@
+package org.kgajjar.mobileai.chat
+
+import kotlinx.coroutines.async
+import kotlinx.coroutines.flow.MutableSharedFlow
+import kotlinx.coroutines.flow.toList
+import kotlinx.coroutines.test.runCurrent
+import kotlinx.coroutines.test.runTest
+import org.kgajjar.mobileai.storage.MemoryStorage
+import org.kgajjar.mobileai.vision.Photo
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+import kotlin.test.assertTrue
+
+class ConversationStoreTest {
+
+    @Test
+    fun chunksAreReassembledAfterReopen() = runTest {
+        val storage = MemoryStorage()
+        val store = ConversationStore.open(storage, backgroundScope)
+        val id = store.create("Trip planning")
+        store.appendMessage(id, Role.User, "Where should I go?")
+        val reply = store.appendMessage(id, Role.Assistant, "Try ")
+        store.appendChunk(id, reply, "Lisbon")
+        store.appendChunk(id, reply, " in spring.")
+        store.awaitDurable()
+        store.close()
+
+        val reopened = ConversationStore.open(storage, backgroundScope)
+        assertEquals(
+            listOf("Where should I go?", "Try Lisbon in spring."),
+            reopened.messages(id).map { it.text },
+        )
+    }
+
+    @Test
+    fun recentListsMostRecentlyUpdatedFirst() = runTest {
+        val store = ConversationStore.open(MemoryStorage(), backgroundScope)
+        val first = store.create("first")
+        val second = store.create("second")
+        store.appendMessage(first, Role.User, "bump")
+
+        assertEquals(listOf(first, second), store.recent().map { it.id })
+        assertEquals(listOf(first), store.recent(limit = 1).map { it.id })
+    }
+
+    @Test
+    fun attachedPhotosRoundTripThroughMessageText() = runTest {
+        val store = ConversationStore.open(MemoryStorage(), backgroundScope)
+        val id = store.create("receipt")
+        val photos = listOf(Photo("content://media/12", 1700000000L), Photo("/sdcard/My Photos/a.jpg", 5L))
+        store.appendMessage(id, Role.User, MessageImages.attach(photos, "What was the total?\n![photo](not an attachment)"))
+
+        val (attached, text) = MessageImages.split(store.messages(id).single().text)
+        assertEquals(photos.map { it.uri to it.modifiedAt }, attached.map { it.uri to it.modifiedAt })
+        assertEquals("What was the total?\n![photo](not an attachment)", text)
+        assertEquals(emptyList<Photo>() to "plain", MessageImages.split("plain"))
+    }
+
+    @Test
+    fun followStreamsAppendedTextUntilFinished() = runTest {
+        val store = ConversationStore.open(MemoryStorage(), backgroundScope)
+        val id = store.create("chat")
+        val reply = store.appendMessage(id, Role.Assistant, "Hel", streaming = true)
+        val pieces = async { store.follow(id, reply).toList() }
+        runCurrent()
+        store.appendChunk(id, reply, "lo")
+        runCurrent()
+        store.appendChunk(id, reply, " world")
+        runCurrent()
+        assertFalse(pieces.isCompleted)
+        store.finishMessage(id, reply)
+
+        assertEquals(listOf("Hel", "lo", " world"), pieces.await().map { it.toString() })
+        assertEquals(listOf("Hello world"), store.follow(id, reply).toList().map { it.toString() })
+    }
+
+    @Test
+    fun followCatchesUpFromTheStoreWhenChangesArriveOutOfOrder() = runTest {
+        val store = ConversationStore.open(MemoryStorage(), backgroundScope)
+        val id = store.create("chat")
+        val reply = store.appendMessage(id, Role.Assistant, "Hel", streaming = true)
+        val source = MutableSharedFlow<ConversationChange>(extraBufferCapacity = 8)
+        val pieces = async { store.follow(id, reply, source).toList() }
+        runCurrent()
+        store.appendChunk(id, reply, "lo")
+        store.appendChunk(id, reply, " world")
+        store.appendChunk(id, reply, "!")
+
+        source.emit(ConversationChange.MessageChanged(id, reply, " world", 11))
+        source.emit(ConversationChange.MessageChanged(id, reply, "lo", 5))
+        source.emit(ConversationChange.MessageChanged(id, reply, "!", 12))
+        source.emit(ConversationChange.MessageFinished(id, reply))
+
+        assertEquals(listOf("Hel", "lo world!"), pieces.await().map { it.toString() })
+    }
+
+    @Test
+    fun tornTailIsTruncatedOnRecovery() = runTest {
+        val storage = MemoryStorage()
+        val store = ConversationStore.open(storage, backgroundScope)
+        val id = store.create("chat")
+        store.appendMessage(id, Role.User, "kept")
+        store.close()
+        storage.delete("conversations.idx")
+        storage.open("conversations.log").append(byteArrayOf(40, 0, 0, 0, 1, 2, 3))
+
+        val reopened = ConversationStore.open(storage, backgroundScope)
+        reopened.appendMessage(id, Role.User, "after recovery")
+        assertEquals(listOf("kept", "after recovery"), reopened.messages(id).map { it.text })
+    }
+
+    @Test
+    fun compactionMergesChunksAndDropsDeletedConversations() = runTest {
+        val storage = MemoryStorage()
+        val store = ConversationStore.open(storage, backgroundScope)
+        val kept = store.create("kept")
+        val message = store.appendMessage(kept, Role.Assistant, "")
+        repeat(100) { store.appendChunk(kept, message, "token$it ") }
+        val dropped = store.create("dropped")
+        store.appendMessage(dropped, Role.User, "x".repeat(1000))
+        store.delete(dropped)
+        val before = storage.open("conversations.log").size
+
+        store.compact()
+
+        assertTrue(storage.open("conversations.log").size < before / 2)
+        assertEquals(listOf(kept), store.recent().map { it.id })
+        val text = store.messages(kept).single().text
+        assertTrue(text.startsWith("token0 token1 ") && text.endsWith("token99 "))
+    }
+
+    @Test
+    fun idsOfDeletedConversationsAreNotReusedAfterCompaction() = runTest {
+        val storage = MemoryStorage()
+        val store = ConversationStore.open(storage, backgroundScope)
+        val kept = store.create("kept")
+        val deleted = store.create("deleted")
+        store.delete(deleted)
+
+        store.compact()
+        val created = store.create("new")
+        store.close()
+
+        assertTrue(created > deleted)
+        val reopened = ConversationStore.open(storage, backgroundScope)
+        assertEquals(listOf(created, kept), reopened.recent().map { it.id })
+        assertTrue(reopened.create("another") > created)
+    }
+
+    @Test
+    fun trainedDictionaryCompressesHistoryAndStaysReadable() = runTest {
+        val storage = MemoryStorage()
+        val store = ConversationStore.open(storage, backgroundScope)
+        val id = store.create("notes")
+        val texts = (0 until 200).map { "Reminder $it: the weekly planning meeting moves to the large conference room." }
+        texts.forEach { store.appendMessage(id, Role.User, it) }
+        val before = storage.open("conversations.log").size
+
+        store.trainDictionary()
+        store.close()
+
+        val reopened = ConversationStore.open(storage, backgroundScope)
+        assertEquals(texts, reopened.messages(id).map { it.text })
+        assertTrue(storage.open("conversations.log").size < before / 2)
+    }
+}
@@ -0,0 +1,42 @@
+package org.kgajjar.mobileai.collections
+
+import org.kgajjar.mobileai.storage.ByteBuilder
+import org.kgajjar.mobileai.storage.ByteReader
+import org.kgajjar.mobileai.storage.ContentHash
+import kotlin.test.Test
+import kotlin.test.assertEquals
+
+class DoubleArrayTrieTest {
+    @Test
+    fun findsExactKeysAndLongestPrefixes() {
+        val keys = listOf("<s>", "<s>>", "</s>", "<|end|>", "é", "a")
+        val trie = DoubleArrayTrie.build(keys, IntArray(keys.size) { it * 10 })
+        keys.forEachIndexed { i, key -> assertEquals(i * 10, trie[key]) }
+        assertEquals(-1, trie["<"])
+        assertEquals(-1, trie["<|end"])
+
+        val text = "x<s>>y"
+        assertEquals((4L shl 32) or 10L, trie.longestMatch(text, 1, text.length))
+        assertEquals((3L shl 32) or 0L, trie.longestMatch(text, 1, 4))
+        assertEquals(-1L, trie.longestMatch(text, 0, text.length))
+
+        val out = ByteBuilder()
+        trie.writeTo(out)
+        val copy = DoubleArrayTrie.readFrom(ByteReader(out.toByteArray()))
+        keys.forEachIndexed { i, key -> assertEquals(i * 10, copy[key]) }
+    }
+
+    @Test
+    fun perfectHashPlacesEveryKeyInItsOwnSlot() {
+        val hashes = LongArray(5000) { ContentHash.of("token$it") }
+        val table = PerfectHash.build(hashes)
+        val seen = BooleanArray(hashes.size)
+        hashes.forEachIndexed { k, hash ->
+            val d = table.displacements[PerfectHash.bucket(hash, table.displacements.size)]
+            val slot = PerfectHash.slot(hash, d, hashes.size)
+            assertEquals(k, table.keys[slot])
+            seen[slot] = true
+        }
+        assertEquals(hashes.size, seen.count { it })
+    }
+}
@@ -0,0 +1,89 @@
+package org.kgajjar.mobileai.feed
+
+import kotlinx.coroutines.test.runTest
+import org.kgajjar.mobileai.chat.ConversationStore
+import org.kgajjar.mobileai.personalization.Interaction
+import org.kgajjar.mobileai.personalization.Personalizer
+import org.kgajjar.mobileai.ranking.TreeEnsemble
+import org.kgajjar.mobileai.ranking.TreeEnsemble.Leaf
+import org.kgajjar.mobileai.ranking.TreeEnsemble.Split
+import org.kgajjar.mobileai.settings.UserSettings
+import org.kgajjar.mobileai.storage.KeyValueStore
+import org.kgajjar.mobileai.storage.MemoryStorage
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertTrue
+
+class HomeFeedTest {
+    /** Affinity above 0.5 first, then conversations ahead of prompts. */
+    private val ranker = TreeEnsemble(
+        FeedFeatures.COUNT,
+        listOf(
+            TreeEnsemble.tree(
+                Split(
+                    FeedFeatures.AFFINITY, 0.5f,
+                    Split(FeedFeatures.IS_PROMPT, 0.5f, Leaf(0.1f), Leaf(0f)),
+                    Split(FeedFeatures.IS_PROMPT, 0.5f, Leaf(1f), Leaf(0.9f)),
+                )
+            )
+        ),
+    )
+    private val prompts = listOf("Plan a weekend trip", "Review a piece of code")
+
+    private fun FeedItem.label(): String = when (this) {
+        is FeedItem.Conversation -> summary.title
+        is FeedItem.Prompt -> text
+    }
+
+    @Test
+    fun withoutProfileRecentConversationsAndEveryPromptAreCandidates() = runTest {
+        val storage = MemoryStorage()
+        val store = ConversationStore.open(storage, backgroundScope)
+        for (title in listOf("Tax return paperwork", "Lisbon restaurants", "Weekend hiking trip plan")) store.create(title)
+        val settings = UserSettings(KeyValueStore.open(storage, backgroundScope))
+        val personalizer = Personalizer.open(storage, backgroundScope, settings)
+
+        val feed = HomeFeed(store, personalizer, storage, ranker, prompts).compute()
+
+        assertEquals(
+            listOf("Weekend hiking trip plan", "Lisbon restaurants", "Tax return paperwork") + prompts,
+            feed.map { it.label() },
+        )
+    }
+
+    @Test
+    fun candidatesCloseToInterestsRankFirst() = runTest {
+        val storage = MemoryStorage()
+        val store = ConversationStore.open(storage, backgroundScope)
+        for (title in listOf("Tax return paperwork", "Lisbon restaurants", "Weekend hiking trip plan")) store.create(title)
+        val settings = UserSettings(KeyValueStore.open(storage, backgroundScope))
+        val personalizer = Personalizer.open(storage, backgroundScope, settings)
+        personalizer.record(Interaction.OpenedResult, "weekend trip plan")
+
+        val feed = HomeFeed(store, personalizer, storage, ranker, prompts).compute()
+
+        val labels = feed.map { it.label() }
+        assertEquals(listOf("Weekend hiking trip plan", "Plan a weekend trip"), labels.take(2))
+        // Unrelated conversations tie, and the index returns ties in no particular order.
+        assertEquals(setOf("Lisbon restaurants", "Tax return paperwork"), labels.subList(2, 4).toSet())
+        assertEquals("Review a piece of code", labels.last())
+    }
+
+    @Test
+    fun savedIndexDropsDeletedConversations() = runTest {
+        val storage = MemoryStorage()
+        val store = ConversationStore.open(storage, backgroundScope)
+        val tax = store.create("Tax return paperwork")
+        store.create("Weekend hiking trip plan")
+        val settings = UserSettings(KeyValueStore.open(storage, backgroundScope))
+        val personalizer = Personalizer.open(storage, backgroundScope, settings)
+        personalizer.record(Interaction.OpenedResult, "weekend trip plan")
+        HomeFeed(store, personalizer, storage, ranker, prompts).compute()
+        assertTrue(storage.exists("feed.vec"))
+
+        store.delete(tax)
+        val feed = HomeFeed(store, personalizer, storage, ranker, prompts).compute()
+
+        assertEquals(listOf("Weekend hiking trip plan", "Plan a weekend trip", "Review a piece of code"), feed.map { it.label() })
+    }
+}
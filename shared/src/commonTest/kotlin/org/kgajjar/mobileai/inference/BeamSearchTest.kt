@@ -0,0 +1,83 @@
+package org.kgajjar.mobileai.inference
+
+import kotlin.math.ln
+import kotlin.test.Test
+import kotlin.test.assertContentEquals
+import kotlin.test.assertEquals
+import kotlin.test.assertTrue
+
+class BeamSearchTest {
+    /**
+     * Tokens a = 0, b = 1, c = 2 and end = 3, with probabilities that depend on the last token.
+     * The KV cache stores the tokens themselves, and every step reads the whole history back
+     * through it, so a block shared or copied wrongly shows up as a wrong history.
+     */
+    private class ToyModel(blocks: Int, private val blockSize: Int) : LanguageModel {
+        override val vocabSize = 4
+        val kv = IntArray(blocks * blockSize)
+        val histories = ArrayList<List<Int>>()
+        var copies = 0
+
+        override fun step(sequences: List<KvSequence>, tokens: IntArray, logits: Array<FloatArray>) {
+            sequences.forEachIndexed { i, sequence ->
+                kv[sequence.slot(sequence.length - 1)] = tokens[i]
+                val history = (0 until sequence.length).map { kv[sequence.slot(it)] }
+                histories += history
+                val probabilities = when (history.last()) {
+                    A -> floatArrayOf(0.001f, 0.55f, 0.449f, 0f)
+                    B -> floatArrayOf(0.34f, 0f, 0.33f, 0.33f)
+                    else -> floatArrayOf(0.05f, 0.05f, 0f, 0.9f)
+                }
+                for (t in 0 until vocabSize) logits[i][t] = ln(probabilities[t])
+            }
+        }
+
+        override fun copyBlock(fromBlock: Int, toBlock: Int, positions: Int) {
+            copies++
+            kv.copyInto(kv, toBlock * blockSize, fromBlock * blockSize, fromBlock * blockSize + positions)
+        }
+    }
+
+    @Test
+    fun findsTheBestSequenceThatGreedyDecodingMisses() {
+        val model = ToyModel(blocks = 32, blockSize = 2)
+        val pool = KvBlockPool(32, 2, model::copyBlock)
+        val results = BeamSearch(model, pool, beamWidth = 2).search(intArrayOf(A, A, A), endToken = END, maxTokens = 6)
+
+        assertContentEquals(intArrayOf(C, END), results[0].tokens)
+        assertTrue(results[0].finished)
+        assertEquals(2, results.size)
+        assertTrue(results[0].score >= results[1].score)
+        assertEquals(32, pool.freeBlocks)
+        // Histories read back through the cache always start with the prompt.
+        assertTrue(model.histories.all { it.size < 3 || it.subList(0, 3) == listOf(A, A, A) })
+    }
+
+    @Test
+    fun forksShareBlocksUntilTheyDiverge() {
+        val model = ToyModel(blocks = 8, blockSize = 4)
+        val pool = KvBlockPool(8, 4, model::copyBlock)
+        val parent = pool.newSequence()
+        repeat(6) { model.kv[pool.append(parent)] = it }
+        val child = pool.fork(parent)
+        assertEquals(6, pool.freeBlocks)
+
+        model.kv[pool.append(parent)] = 100
+        model.kv[pool.append(child)] = 200
+        assertEquals(1, model.copies)
+        assertEquals(parent.slot(0), child.slot(0))
+        assertEquals(listOf(0, 1, 2, 3, 4, 5, 100), (0 until 7).map { model.kv[parent.slot(it)] })
+        assertEquals(listOf(0, 1, 2, 3, 4, 5, 200), (0 until 7).map { model.kv[child.slot(it)] })
+
+        pool.release(parent)
+        pool.release(child)
+        assertEquals(8, pool.freeBlocks)
+    }
+
+    private companion object {
+        const val A = 0
+        const val B = 1
+        const val C = 2
+        const val END = 3
+    }
+}
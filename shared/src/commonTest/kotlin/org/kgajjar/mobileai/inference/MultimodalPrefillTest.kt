@@ -0,0 +1,130 @@
+package org.kgajjar.mobileai.inference
+
+import kotlinx.coroutines.test.runTest
+import org.kgajjar.mobileai.vision.RgbImage
+import kotlin.math.roundToInt
+import kotlin.test.Test
+import kotlin.test.assertEquals
+
+class MultimodalPrefillTest {
+    /**
+     * The KV cache stores the inputs themselves: text tokens as is, and vision tokens as the
+     * first float of their embedding. Every text step records the history it reads back.
+     */
+    private class ToyModel(blocks: Int, private val blockSize: Int) : MultimodalModel {
+        override val vocabSize = 10
+        override val embeddingSize = 2
+        val kv = IntArray(blocks * blockSize)
+        val histories = ArrayList<List<Int>>()
+        var prefills = 0
+
+        override fun step(sequences: List<KvSequence>, tokens: IntArray, logits: Array<FloatArray>) {
+            sequences.forEachIndexed { i, sequence ->
+                kv[sequence.slot(sequence.length - 1)] = tokens[i]
+                histories += read(sequence)
+                logits[i].fill(0f)
+            }
+        }
+
+        override fun prefill(sequence: KvSequence, embeddings: FloatArray, count: Int) {
+            prefills++
+            for (t in 0 until count) {
+                kv[sequence.slot(sequence.length - count + t)] = embeddings[t * embeddingSize].roundToInt()
+            }
+        }
+
+        override fun copyBlock(fromBlock: Int, toBlock: Int, positions: Int) {
+            kv.copyInto(kv, toBlock * blockSize, fromBlock * blockSize, fromBlock * blockSize + positions)
+        }
+
+        fun read(sequence: KvSequence): List<Int> = (0 until sequence.length).map { kv[sequence.slot(it)] }
+    }
+
+    /** Three vision tokens per image: 10 × its grey level, plus the token index. */
+    private class GreyVision : VisionTower {
+        var encoded = 0
+
+        override val modelId = "grey-v1"
+        override val inputSize = 4
+        override val mean = floatArrayOf(0f, 0f, 0f)
+        override val std = floatArrayOf(1f, 1f, 1f)
+        override val tokensPerImage = 3
+
+        override suspend fun encode(pixels: FloatArray): FloatArray {
+            encoded++
+            val grey = (pixels[0] * 255).roundToInt()
+            return FloatArray(tokensPerImage * 2) { (10 * grey + it / 2).toFloat() }
+        }
+    }
+
+    private fun grey(level: Int) = RgbImage(8, 6, IntArray(48) { (0xFF shl 24) or (level * 0x010101) })
+
+    private class Setup(maxBlocks: Int = 16) {
+        val model = ToyModel(blocks = 16, blockSize = 2)
+        val vision = GreyVision()
+        val pool = KvBlockPool(16, 2, model::copyBlock)
+        val cache = ImagePrefixCache(pool, maxBlocks)
+        val prefill = MultimodalPrefill(model, vision, pool, cache)
+        val logits = FloatArray(10)
+    }
+
+    @Test
+    fun followUpQuestionReusesTheImagePrefix() = runTest {
+        val s = Setup()
+        val first = s.prefill.prefill(listOf(grey(1)), intArrayOf(5, 6), s.logits)
+        val second = s.prefill.prefill(listOf(grey(1)), intArrayOf(7), s.logits)
+
+        assertEquals(1, s.vision.encoded)
+        assertEquals(1, s.model.prefills)
+        assertEquals(1L, s.cache.hits)
+        assertEquals(listOf(10, 11, 12, 7), s.model.histories.last())
+        // The second question forked the prefix; the first conversation is untouched.
+        assertEquals(listOf(10, 11, 12, 5, 6), s.model.read(first))
+        assertEquals(listOf(10, 11, 12, 7), s.model.read(second))
+    }
+
+    @Test
+    fun addingAnImageEncodesOnlyTheNewOne() = runTest {
+        val s = Setup()
+        s.prefill.prefill(listOf(grey(1)), intArrayOf(5), s.logits)
+        s.prefill.prefill(listOf(grey(1), grey(2)), intArrayOf(6), s.logits)
+
+        assertEquals(2, s.vision.encoded)
+        assertEquals(listOf(10, 11, 12, 20, 21, 22, 6), s.model.histories.last())
+    }
+
+    @Test
+    fun evictedPrefixesAreEncodedAgainAndFreed() = runTest {
+        // One image prefix is three positions, two blocks.
+        val s = Setup(maxBlocks = 2)
+        val sequences = listOf(
+            s.prefill.prefill(listOf(grey(1)), intArrayOf(5), s.logits),
+            s.prefill.prefill(listOf(grey(2)), intArrayOf(5), s.logits),
+            s.prefill.prefill(listOf(grey(1)), intArrayOf(6), s.logits),
+        )
+        assertEquals(3, s.vision.encoded)
+        assertEquals(1, s.cache.size)
+
+        sequences.forEach(s.pool::release)
+        s.cache.clear()
+        assertEquals(16, s.pool.freeBlocks)
+    }
+
+    @Test
+    fun blocksSharedByChainedPrefixesCountOnce() = runTest {
+        // The one-image prefix holds two blocks; the two-image one shares the first of them and
+        // adds two more, four distinct blocks in all.
+        val s = Setup(maxBlocks = 4)
+        val first = s.prefill.prefill(listOf(grey(1), grey(2)), intArrayOf(5), s.logits)
+        assertEquals(2, s.cache.size)
+
+        val second = s.prefill.prefill(listOf(grey(1), grey(3)), intArrayOf(6), s.logits)
+        assertEquals(3, s.vision.encoded)
+        assertEquals(listOf(10, 11, 12, 30, 31, 32, 6), s.model.histories.last())
+
+        s.pool.release(first)
+        s.pool.release(second)
+        s.cache.clear()
+        assertEquals(16, s.pool.freeBlocks)
+    }
+}
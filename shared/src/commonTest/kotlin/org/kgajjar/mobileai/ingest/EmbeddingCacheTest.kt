@@ -0,0 +1,54 @@
+package org.kgajjar.mobileai.ingest
+
+import kotlinx.coroutines.test.runTest
+import org.kgajjar.mobileai.storage.MemoryStorage
+import kotlin.test.Test
+import kotlin.test.assertContentEquals
+import kotlin.test.assertEquals
+
+class EmbeddingCacheTest {
+
+    private class CountingEncoder(override val modelId: String = "test-encoder") : TextEncoder {
+        val encoded = ArrayList<String>()
+
+        override val dimension: Int = 4
+
+        override suspend fun encode(texts: List<String>): List<FloatArray> {
+            encoded += texts
+            return texts.map { text -> FloatArray(dimension) { text.length.toFloat() + it } }
+        }
+    }
+
+    @Test
+    fun duplicateTextIsEncodedOnce() = runTest {
+        val encoder = CountingEncoder()
+        val cache = EmbeddingCache(encoder.modelId, encoder.dimension)
+
+        cache.embed(listOf("hello world", "  hello   world ", "other"), encoder)
+        cache.embed(listOf("hello world"), encoder)
+
+        assertEquals(listOf("hello world", "other"), encoder.encoded)
+    }
+
+    @Test
+    fun diskTierSurvivesReopen() = runTest {
+        val storage = MemoryStorage()
+        val encoder = CountingEncoder()
+        val first = EmbeddingCache(encoder.modelId, encoder.dimension, file = storage.open("emb"))
+        val vector = first.embed(listOf("persisted chunk"), encoder).single()
+        first.close()
+
+        val reopened = EmbeddingCache(encoder.modelId, encoder.dimension, file = storage.open("emb"))
+        assertContentEquals(vector, reopened.embed(listOf("persisted chunk"), encoder).single())
+        assertEquals(1, encoder.encoded.size)
+    }
+
+    @Test
+    fun otherModelInvalidatesDiskTier() = runTest {
+        val storage = MemoryStorage()
+        EmbeddingCache("model-a", 4, file = storage.open("emb")).put("text", FloatArray(4))
+
+        val cache = EmbeddingCache("model-b", 4, file = storage.open("emb"))
+        assertEquals(null, cache["text"])
+    }
+}
@@ -0,0 +1,75 @@
+package org.kgajjar.mobileai.ingest
+
+import org.kgajjar.mobileai.collections.IntArrayList
+import org.kgajjar.mobileai.tokenizer.Tokenizer
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertTrue
+
+class TokenAwareChunkerTest {
+
+    /** One token per word, leading whitespace attached; ids are word lengths. */
+    private class WordTokenizer : Tokenizer {
+        var charsEncoded = 0
+
+        override val vocabSize: Int = 1024
+
+        override fun encode(text: CharSequence, start: Int, end: Int, ids: IntArrayList, ends: IntArrayList?) {
+            charsEncoded += end - start
+            var i = start
+            while (i < end) {
+                val tokenStart = i
+                while (i < end && text[i].isWhitespace()) i++
+                while (i < end && !text[i].isWhitespace()) i++
+                ids.add(i - tokenStart)
+                ends?.add(i)
+            }
+        }
+
+        override fun decode(ids: IntArray, start: Int, end: Int): String = ""
+    }
+
+    private val text = "One two three four. Five six seven. Eight nine ten eleven twelve.\n" +
+        "# Heading\nThirteen fourteen. Fifteen sixteen seventeen."
+
+    @Test
+    fun tokenizesEachCharacterOnce() {
+        val tokenizer = WordTokenizer()
+        TokenAwareChunker(tokenizer, maxTokens = 6, overlapTokens = 3).chunk(text)
+        assertEquals(text.length, tokenizer.charsEncoded)
+    }
+
+    @Test
+    fun chunksRespectBudgetAndShareOverlapTokens() {
+        val doc = TokenAwareChunker(WordTokenizer(), maxTokens = 6, overlapTokens = 3).chunk(text)
+        assertTrue(doc.chunks.size > 2)
+        for (chunk in doc.chunks) {
+            assertTrue(chunk.tokenCount <= 6, "chunk $chunk exceeds budget")
+        }
+        for (i in 1 until doc.chunks.size) {
+            val prev = doc.chunks[i - 1]
+            val chunk = doc.chunks[i]
+            if (chunk.overlapTokens > 0) {
+                assertEquals(prev.tokenEnd, chunk.tokenStart + chunk.overlapTokens)
+            }
+        }
+        assertEquals(text.length, doc.chunks.last().textEnd)
+    }
+
+    @Test
+    fun headingStartsChunkWithoutOverlap() {
+        val doc = TokenAwareChunker(WordTokenizer(), maxTokens = 20, overlapTokens = 3).chunk(text)
+        assertEquals(2, doc.chunks.size)
+        assertTrue(doc.textOf(doc.chunks[1]).startsWith("# Heading"))
+        assertEquals(0, doc.chunks[1].overlapTokens)
+    }
+
+    @Test
+    fun splitsSentencesLongerThanBudget() {
+        val long = (1..25).joinToString(" ") { "w$it" }
+        val doc = TokenAwareChunker(WordTokenizer(), maxTokens = 10, overlapTokens = 2).chunk(long)
+        assertEquals(25, doc.tokens.size)
+        assertEquals(listOf(0, 8, 16), doc.chunks.map { it.tokenStart })
+        assertEquals(25, doc.chunks.last().tokenEnd)
+    }
+}
@@ -0,0 +1,68 @@
+package org.kgajjar.mobileai.json
+
+import kotlin.random.Random
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFailsWith
+import kotlin.test.assertNull
+
+class JsonDocumentTest {
+    @Test
+    fun agreesWithTheStreamingParser() {
+        val random = Random(7)
+        repeat(200) {
+            val text = randomValue(random, 0).toJson()
+            val expected = ArrayList<JsonValue>()
+            JsonStreamParser { expected += it }.apply { feed(text) }.finish()
+            assertEquals(expected.single(), Json.parse(text), text)
+        }
+    }
+
+    @Test
+    fun handlesEscapesAcrossBlockBoundaries() {
+        // Shift a quote, an escaped quote and a run of backslashes across every offset of a 64-byte block.
+        for (pad in 0 until 70) {
+            val value = "x".repeat(pad) + "\\\"q\\\\\\\\" + "é\\u00e9"
+            val text = """{"a":"$value","b":[1,{"c":"\\\\"}]}"""
+            val obj = Json.parse(text) as JsonObject
+            assertEquals("x".repeat(pad) + "\"q\\\\éé", obj["a"]?.stringOrNull)
+            assertEquals("""[1,{"c":"\\\\"}]""", obj["b"]?.toJson())
+        }
+    }
+
+    @Test
+    fun readsMembersOnDemand() {
+        val doc = JsonDocument.parse(
+            """{"skip":{"deep":[1,2,{"x":"}"}]},"n":-9223372036854775808,"pi":3.25,"ok":false,"z":null,"k\"q":1}"""
+                .encodeToByteArray()
+        )
+        val root = doc.root()
+        assertEquals(Long.MIN_VALUE, root["n"]?.long())
+        assertEquals(3.25, root["pi"]?.double())
+        assertEquals(false, root["ok"]?.boolean())
+        assertEquals(true, root["z"]?.isNull)
+        assertEquals(1L, root["k\"q"]?.long())
+        assertNull(root["missing"])
+        assertEquals(JsonCursor.Type.Object, root["skip"]?.type)
+        val keys = ArrayList<String>()
+        root.forEachMember { key, _ -> keys += key }
+        assertEquals(listOf("skip", "n", "pi", "ok", "z", "k\"q"), keys)
+        assertFailsWith<JsonException> { root["pi"]?.long() }
+    }
+
+    @Test
+    fun rejectsMalformedInput() {
+        for (text in listOf("", "[1 2]", "{\"a\":1,}", "[01]", "[1.]", "\"abc", "[1]]", "{]", "truex", "[\"a\"x]", "1 2")) {
+            assertFailsWith<JsonException>(text) { Json.parse(text) }
+        }
+    }
+
+    private fun randomValue(random: Random, depth: Int): JsonValue = when (if (depth > 3) random.nextInt(4) else random.nextInt(6)) {
+        0 -> JsonNumber((random.nextInt(2000) - 1000) / 8.0)
+        1 -> JsonString(buildString { repeat(random.nextInt(80)) { append("ab\"\\é\n ".random(random)) } })
+        2 -> JsonBoolean(random.nextBoolean())
+        3 -> JsonNull
+        4 -> JsonArray(List(random.nextInt(6)) { randomValue(random, depth + 1) })
+        else -> JsonObject(List(random.nextInt(6)) { "k$it" to randomValue(random, depth + 1) }.toMap())
+    }
+}
@@ -0,0 +1,45 @@
+package org.kgajjar.mobileai.json
+
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFailsWith
+
+class JsonStreamParserTest {
+    private val document =
+        """{"name":"café \"x\"","n":[1,-2.5e3,0.25],"ok":true,"none":null,"nested":{"a":[],"b":{}}}"""
+
+    @Test
+    fun parsesWhenFedOneCharacterAtATime() {
+        val values = ArrayList<JsonValue>()
+        val parser = JsonStreamParser { values += it }
+        document.forEach { parser.feed(it.toString()) }
+        parser.finish()
+
+        val expected = Json.parse(document)
+        assertEquals(listOf(expected), values)
+        val obj = expected as JsonObject
+        assertEquals("café \"x\"", obj["name"]?.stringOrNull)
+        assertEquals(JsonArray(listOf(JsonNumber(1.0), JsonNumber(-2500.0), JsonNumber(0.25))), obj["n"])
+        assertEquals(expected, Json.parse(expected.toJson()))
+    }
+
+    @Test
+    fun reportsArrayElementsAsSoonAsTheyClose() {
+        val seen = ArrayList<String>()
+        val parser = JsonStreamParser(onElement = { i, v -> seen += "$i:${v.toJson()}" }) {}
+        parser.feed("[{\"a\":1},")
+        assertEquals(listOf("0:{\"a\":1}"), seen)
+        parser.feed(" 42 ")
+        parser.feed(",\"s\"]")
+        parser.finish()
+        assertEquals(listOf("0:{\"a\":1}", "1:42", "2:\"s\""), seen)
+    }
+
+    @Test
+    fun rejectsMalformedInput() {
+        assertFailsWith<JsonException> { Json.parse("[1,]") }
+        assertFailsWith<JsonException> { Json.parse("{\"a\" 1}") }
+        assertFailsWith<JsonException> { Json.parse("{\"a\":1") }
+        assertFailsWith<JsonException> { Json.parse("nul") }
+    }
+}
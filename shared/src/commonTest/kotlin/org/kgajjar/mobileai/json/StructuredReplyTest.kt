@@ -0,0 +1,40 @@
+package org.kgajjar.mobileai.json
+
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+import kotlin.test.assertNull
+import kotlin.test.assertTrue
+
+class StructuredReplyTest {
+    @Test
+    fun fieldsAppearAsTheyComplete() {
+        val reply = StructuredReply()
+        var text = "```json\n{\"title\":\"Pasta\",\"steps\":[{\"do\":\"Boil wa"
+        reply.update(text)
+        assertEquals(listOf(StructuredReply.Field("title", JsonString("Pasta"))), reply.fields)
+        assertEquals(StructuredReply.Field("steps[0].do", JsonString("Boil wa")), reply.streaming)
+
+        text += "ter\"},{\"do\":\"Add salt\",\"minutes\":2}],\"vegan\":true}\n```"
+        reply.update(text)
+        assertTrue(reply.isComplete)
+        assertFalse(reply.isBroken)
+        assertNull(reply.streaming)
+        assertEquals(
+            listOf("title", "steps[0].do", "steps[1].do", "steps[1].minutes", "vegan"),
+            reply.fields.map { it.path }
+        )
+        assertEquals(JsonNumber(2.0), reply.fields[3].value)
+    }
+
+    @Test
+    fun malformedRepliesAreMarkedBroken() {
+        assertTrue(StructuredReply.looksStructured("  ```json\n[1]"))
+        assertFalse(StructuredReply.looksStructured("Sure! {\"a\":1}"))
+
+        val reply = StructuredReply()
+        reply.update("{\"a\":1,")
+        reply.update("{\"a\":1,}")
+        assertTrue(reply.isBroken)
+    }
+}
@@ -0,0 +1,73 @@
+package org.kgajjar.mobileai.metrics
+
+import org.kgajjar.mobileai.json.Json
+import org.kgajjar.mobileai.json.JsonObject
+import org.kgajjar.mobileai.json.doubleOrNull
+import kotlin.math.abs
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertSame
+import kotlin.test.assertTrue
+
+class MetricsRegistryTest {
+    @Test
+    fun smallValuesAreExact() {
+        val histogram = Histogram(highest = 1_000_000L)
+        for (v in 1L..100L) histogram.record(v)
+        val s = histogram.snapshot()
+        assertEquals(100L, s.count)
+        assertEquals(1L, s.min)
+        assertEquals(100L, s.max)
+        assertEquals(50L, s.p50)
+        assertEquals(99L, s.p99)
+        assertEquals(50.5, s.mean)
+    }
+
+    @Test
+    fun largeValuesStayWithinTheRelativeError() {
+        val histogram = Histogram(highest = 60_000_000L)
+        for (v in 1L..100_000L) histogram.record(v * 10)
+        val s = histogram.snapshot()
+        for ((expected, actual) in listOf(500_000L to s.p50, 900_000L to s.p90, 990_000L to s.p99)) {
+            assertTrue(abs(actual - expected) <= expected / 100, "expected about $expected, got $actual")
+        }
+        assertEquals(1_000_000L, s.max)
+    }
+
+    @Test
+    fun valuesAboveTheRangeAreClamped() {
+        val histogram = Histogram(highest = 1000L)
+        histogram.record(5_000L)
+        assertEquals(1000L, histogram.snapshot().max)
+    }
+
+    @Test
+    fun namesResolveToOneMetric() {
+        val registry = MetricsRegistry()
+        assertSame(registry.counter("ingest.photos"), registry.counter("ingest.photos"))
+        assertSame(registry.histogram("search.latency_us"), registry.histogram("search.latency_us"))
+    }
+
+    @Test
+    fun snapshotReportsRatesAndSerializes() {
+        val registry = MetricsRegistry()
+        val photos = registry.counter("ingest.photos")
+        var used = 2048L
+        registry.gauge("memory.cache_bytes") { used }
+        registry.histogram("search.latency_us").record(1200L)
+
+        photos.increment(10L)
+        val earlier = registry.snapshot()
+        photos.increment(30L)
+        used = 4096L
+        val later = registry.snapshot()
+        val moved = MetricsSnapshot(earlier.takenAt + 2000L, later.counters, later.gauges, later.histograms)
+
+        assertEquals(15.0, moved.rate("ingest.photos", earlier))
+        assertEquals(4096L, later.gauges["memory.cache_bytes"])
+        val json = Json.parse(later.toJson()) as JsonObject
+        val latency = (json.getValue("histograms") as JsonObject).getValue("search.latency_us") as JsonObject
+        assertEquals(1.0, latency.getValue("count").doubleOrNull)
+        assertEquals(40.0, (json.getValue("counters") as JsonObject).getValue("ingest.photos").doubleOrNull)
+    }
+}
@@ -0,0 +1,122 @@
+package org.kgajjar.mobileai.ocr
+
+import kotlinx.coroutines.test.runTest
+import org.kgajjar.mobileai.storage.MemoryStorage
+import org.kgajjar.mobileai.vision.Photo
+import org.kgajjar.mobileai.vision.PhotoLibrary
+import org.kgajjar.mobileai.vision.RgbImage
+import kotlin.math.abs
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertTrue
+
+class OcrPipelineTest {
+
+    /** Everything darker than white is text. */
+    private class InkDetector : TextDetectionModel {
+        var calls = 0
+
+        override val maxSide = 64
+        override val mean = floatArrayOf(0f, 0f, 0f)
+        override val std = floatArrayOf(1f, 1f, 1f)
+
+        override suspend fun probabilities(pixels: FloatArray, width: Int, height: Int): FloatArray {
+            calls++
+            return FloatArray(width * height) { 1f - pixels[it] }
+        }
+    }
+
+    /** Reads the middle row: white is blank, grey 40 is 'a' and grey 100 is 'b'. */
+    private class GreyReader : TextRecognitionModel {
+        override val height = 8
+        override val stride = 2
+        override val alphabet = "ab"
+        override val batchSize = 2
+
+        override suspend fun logits(pixels: FloatArray, width: Int, count: Int): List<FloatArray> = List(count) { b ->
+            val steps = width / stride
+            FloatArray(steps * 3).also { logits ->
+                for (t in 0 until steps) {
+                    val grey = (pixels[b * height * width + (height / 2) * width + t * stride] + 1f) * 127.5f
+                    val best = when {
+                        grey > 230f -> 0
+                        abs(grey - 40f) < abs(grey - 100f) -> 1
+                        else -> 2
+                    }
+                    logits[t * 3 + best] = 10f
+                }
+            }
+        }
+    }
+
+    private fun screenshot(): RgbImage {
+        val pixels = IntArray(64 * 32) { 0xFFFFFFFF.toInt() }
+        fun fill(left: Int, top: Int, right: Int, bottom: Int, grey: Int) {
+            for (y in top until bottom) for (x in left until right) pixels[y * 64 + x] = (0xFF shl 24) or (grey * 0x010101)
+        }
+        fill(4, 4, 20, 12, 40)
+        fill(24, 4, 36, 12, 100)
+        fill(4, 20, 28, 28, 40)
+        return RgbImage(64, 32, pixels)
+    }
+
+    private fun blank() = RgbImage(64, 32, IntArray(64 * 32) { 0xFFFFFFFF.toInt() })
+
+    private class Setup {
+        val detector = InkDetector()
+        val recognizer = TextRecognizer(GreyReader())
+        val pipeline = OcrPipeline(TextDetector(detector, unclipRatio = 0f), recognizer)
+    }
+
+    private class FakeLibrary(private val image: (uri: String) -> RgbImage) : PhotoLibrary {
+        val photos = LinkedHashMap<String, Long>()
+
+        override suspend fun photos(): List<Photo> = photos.map { Photo(it.key, it.value) }
+
+        override suspend fun load(photo: Photo, minSide: Int): RgbImage = image(photo.uri)
+    }
+
+    @Test
+    fun readsWordsInReadingOrder() = runTest {
+        assertEquals("a b\na", Setup().pipeline.read(screenshot()))
+    }
+
+    @Test
+    fun greedyDecodingMergesRepeatsBetweenBlanks() {
+        val recognizer = Setup().recognizer
+        // Steps: a a blank a b b
+        val best = intArrayOf(1, 1, 0, 1, 2, 2)
+        val logits = FloatArray(best.size * 3).also { l -> best.forEachIndexed { t, c -> l[t * 3 + c] = 10f } }
+        val read = recognizer.decode(logits, best.size)
+        assertEquals("aab", read.text)
+        assertTrue(read.confidence > 0.99f)
+    }
+
+    @Test
+    fun indexesOnlyNewPhotosAcrossReopens() = runTest {
+        val storage = MemoryStorage()
+        val s = Setup()
+        val library = FakeLibrary { if ("shot" in it) screenshot() else blank() }
+        library.photos["dcim/shot-1.png"] = 1L
+        library.photos["dcim/beach.png"] = 1L
+
+        val first = PhotoTextIndex.open(storage, s.pipeline)
+        first.sync(library)
+        assertEquals(2, s.detector.calls)
+        val hit = first.search("b").single()
+        assertEquals("dcim/shot-1.png", hit.uri)
+        assertEquals("a b\na", hit.snippet)
+        first.close()
+
+        library.photos["dcim/shot-2.png"] = 5L
+        val second = PhotoTextIndex.open(storage, s.pipeline)
+        assertEquals(2, second.count())
+        second.sync(library)
+        assertEquals(3, s.detector.calls)
+        assertEquals(setOf("dcim/shot-1.png", "dcim/shot-2.png"), second.search("a").map { it.uri }.toSet())
+
+        library.photos.remove("dcim/shot-1.png")
+        second.sync(library)
+        assertEquals(listOf("dcim/shot-2.png"), second.search("b").map { it.uri })
+    }
+}
@@ -0,0 +1,41 @@
+package org.kgajjar.mobileai.personalization
+
+import org.kgajjar.mobileai.ingest.HashingTextEncoder
+import org.kgajjar.mobileai.storage.ByteBuilder
+import org.kgajjar.mobileai.storage.ByteReader
+import kotlin.math.abs
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertTrue
+
+class InterestProfileTest {
+    private val encoder = HashingTextEncoder()
+    private val day = 24L * 60 * 60 * 1000
+
+    @Test
+    fun recentInterestsOutweighDecayedOnes() {
+        val profile = InterestProfile(encoder.dimension, halfLifeMillis = day)
+        val cooking = encoder.embed("pasta recipe with garlic and basil")
+        val running = encoder.embed("marathon training plan for beginners")
+        repeat(3) { profile.record(cooking, 1f, at = day + it) }
+        profile.record(running, 1f, at = 10 * day)
+
+        assertTrue(profile.similarity(running) > profile.similarity(cooking))
+        assertTrue(abs(profile.mass - (1 + 3 * 0.5 * 0.5 * 0.5 * 0.5 * 0.5 * 0.5 * 0.5 * 0.5 * 0.5)) < 1e-3)
+    }
+
+    @Test
+    fun survivesRescalingAndSerialization() {
+        val profile = InterestProfile(encoder.dimension, halfLifeMillis = 1000)
+        val topic = encoder.embed("astronomy telescopes and planets")
+        // Long gaps push the lazy scale below the rescale threshold several times.
+        repeat(10) { profile.record(topic, 1f, at = 1 + it * 30_000L) }
+        assertTrue(profile.similarity(topic) > 0.99f)
+
+        val out = ByteBuilder(2048)
+        profile.writeTo(out)
+        val restored = InterestProfile.readFrom(ByteReader(out.toByteArray()))
+        assertEquals(profile.similarity(topic), restored.similarity(topic), 1e-5f)
+        assertEquals(profile.mass, restored.mass, 1e-9)
+    }
+}
@@ -0,0 +1,41 @@
+package org.kgajjar.mobileai.ranking
+
+import kotlin.random.Random
+import kotlin.test.Test
+import kotlin.test.assertEquals
+
+class CompiledEnsembleTest {
+    private val random = Random(11)
+
+    private fun randomNode(depth: Int, maxDepth: Int, featureCount: Int): TreeEnsemble.Node =
+        if (depth == maxDepth || (depth > 0 && random.nextInt(4) == 0)) {
+            TreeEnsemble.Leaf(random.nextFloat() - 0.5f)
+        } else {
+            TreeEnsemble.Split(
+                random.nextInt(featureCount),
+                random.nextFloat(),
+                randomNode(depth + 1, maxDepth, featureCount),
+                randomNode(depth + 1, maxDepth, featureCount),
+            )
+        }
+
+    @Test
+    fun matchesReferenceEvaluation() {
+        val featureCount = 10
+        val trees = List(60) { TreeEnsemble.tree(randomNode(0, if (it % 20 == 0) 16 else 6, featureCount)) } +
+            TreeEnsemble.tree(TreeEnsemble.Leaf(0.25f))
+        val ensemble = TreeEnsemble(featureCount, trees, baseScore = 0.5f)
+        val compiled = CompiledEnsemble(ensemble)
+
+        val rows = 1003
+        val matrix = FloatArray(rows * featureCount) { if (random.nextInt(50) == 0) Float.NaN else random.nextFloat() }
+        val out = FloatArray(rows)
+        compiled.scoreBatch(matrix, rows, out)
+
+        for (r in 0 until rows) {
+            val expected = ensemble.score(matrix, r * featureCount)
+            assertEquals(expected, out[r], 1e-4f)
+            assertEquals(expected, compiled.score(matrix, r * featureCount), 1e-4f)
+        }
+    }
+}
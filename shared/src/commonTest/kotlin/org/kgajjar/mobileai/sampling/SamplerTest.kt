@@ -0,0 +1,69 @@
+package org.kgajjar.mobileai.sampling
+
+import org.kgajjar.mobileai.collections.IntArrayList
+import org.kgajjar.mobileai.tokenizer.Tokenizer
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertTrue
+
+class SamplerTest {
+    /** One token per character, id = char code. */
+    private object CharTokenizer : Tokenizer {
+        override val vocabSize = 130
+
+        override fun encode(text: CharSequence, start: Int, end: Int, ids: IntArrayList, ends: IntArrayList?) {
+            for (i in start until end) {
+                ids.add(text[i].code)
+                ends?.add(i + 1)
+            }
+        }
+
+        override fun decode(ids: IntArray, start: Int, end: Int): String =
+            (start until end).map { ids[it].toChar() }.joinToString("")
+    }
+
+    @Test
+    fun constraintsMaskBiasAndRestrict() {
+        val constraints = LogitConstraints.Builder(130)
+            .bias(5, 2f)
+            .bias(5, 1f)
+            .ban(64)
+            .banWord("z", CharTokenizer)
+            .banWord("ab", CharTokenizer)
+            .build()
+        val logits = FloatArray(130)
+        constraints.apply(logits, IntArrayList().apply { add(97) })
+        assertEquals(3f, logits[5])
+        assertEquals(Float.NEGATIVE_INFINITY, logits[64])
+        assertEquals(Float.NEGATIVE_INFINITY, logits['z'.code])
+        assertEquals(Float.NEGATIVE_INFINITY, logits['b'.code]) // "a" was just generated
+        assertEquals(0f, logits['a'.code])
+
+        val restricted = LogitConstraints.Builder(130).allowOnly(listOf(1, 129)).build()
+        val all = FloatArray(130)
+        restricted.apply(all)
+        assertEquals(listOf(1, 129), all.indices.filter { all[it] == 0f })
+    }
+
+    @Test
+    fun samplesOnlyFromAllowedTopCandidates() {
+        val constraints = LogitConstraints.Builder(130).ban(10).build()
+        assertEquals(11, Sampler(temperature = 0f).sample(logitsFavoring(10, 11), constraints))
+
+        val sampler = Sampler(temperature = 1f, topK = 3, topP = 1f, seed = 42)
+        val seen = HashSet<Int>()
+        repeat(500) { seen += sampler.sample(logitsFavoring(10, 11, 12, 13), constraints) }
+        assertEquals(setOf(11, 12, 13), seen)
+
+        val nucleus = Sampler(temperature = 1f, topK = 0, topP = 0.5f, seed = 42)
+        repeat(100) { assertEquals(20, nucleus.sample(FloatArray(130).also { it[20] = 10f })) }
+
+        val none = LogitConstraints.Builder(130).allowOnly(listOf(3)).ban(3).build()
+        assertTrue(Sampler(seed = 1).sample(FloatArray(130), none) < 0)
+    }
+
+    /** Logits where [tokens] are far ahead of the rest, in descending order. */
+    private fun logitsFavoring(vararg tokens: Int) = FloatArray(130).also { logits ->
+        tokens.forEachIndexed { rank, token -> logits[token] = 20f - rank * 0.1f }
+    }
+}
@@ -0,0 +1,67 @@
+package org.kgajjar.mobileai.search
+
+import kotlinx.coroutines.test.runCurrent
+import kotlinx.coroutines.test.runTest
+import org.kgajjar.mobileai.chat.ConversationStore
+import org.kgajjar.mobileai.chat.Role
+import org.kgajjar.mobileai.storage.MemoryStorage
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertTrue
+
+class FullTextIndexTest {
+
+    @Test
+    fun ranksByRelevanceAndExpandsTheLastTermAsAPrefix() {
+        val index = FullTextIndex.open(MemoryStorage())
+        index.upsert(1, "Packing list for the hiking trip to the mountains")
+        index.upsert(2, "Hiking boots, hiking poles and a hiking map")
+        index.upsert(3, "Recipe for lemon cake")
+
+        assertEquals(listOf(2L, 1L), index.search("hiking").map { it.docId })
+        assertEquals(listOf(1L), index.search("mount").map { it.docId })
+        assertEquals(emptyList(), index.search("mount ").map { it.docId })
+    }
+
+    @Test
+    fun updatesAndDeletesSurviveFlushMergeAndReopen() {
+        val storage = MemoryStorage()
+        val index = FullTextIndex.open(storage, flushThreshold = 4)
+        repeat(50) { index.upsert(it.toLong(), "note number $it about gardening") }
+        index.upsert(7, "note about sailing")
+        index.delete(8)
+        index.watermark = 1234
+        index.close()
+
+        val reopened = FullTextIndex.open(storage, flushThreshold = 4)
+        assertEquals(49, reopened.documentCount)
+        assertEquals(1234L, reopened.watermark)
+        val gardening = reopened.search("gardening", limit = 100).map { it.docId }.toSet()
+        assertEquals((0L until 50L).toSet() - 7L - 8L, gardening)
+        assertEquals(listOf(7L), reopened.search("sailing").map { it.docId })
+        assertTrue(storage.exists("search.manifest"))
+    }
+
+    @Test
+    fun chatHistoryFollowsTheConversationStore() = runTest {
+        val storage = MemoryStorage()
+        val store = ConversationStore.open(storage, backgroundScope)
+        val search = ChatHistorySearch.open(store, storage, backgroundScope)
+        val trip = store.create("Trip")
+        store.appendMessage(trip, Role.User, "Suggest a weekend in Lisbon")
+        val reply = store.appendMessage(trip, Role.Assistant, "Visit the ")
+        store.appendChunk(trip, reply, "Belém tower")
+        val other = store.create("Other")
+        store.appendMessage(other, Role.User, "Lisbon weather")
+        runCurrent()
+
+        val hits = search.search("belém")
+        assertEquals(listOf(trip to reply), hits.map { it.conversationId to it.messageIndex })
+        assertEquals("Trip", hits.single().title)
+
+        store.delete(other)
+        runCurrent()
+        assertEquals(listOf(trip), search.search("lisbon").map { it.conversationId })
+        search.close()
+    }
+}
@@ -0,0 +1,63 @@
+package org.kgajjar.mobileai.search
+
+import org.kgajjar.mobileai.storage.ByteBuilder
+import org.kgajjar.mobileai.storage.ByteReader
+import kotlin.math.sqrt
+import kotlin.random.Random
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+import kotlin.test.assertTrue
+
+class VectorIndexTest {
+    private val random = Random(7)
+
+    private fun unitVector(dimension: Int) = FloatArray(dimension) { random.nextFloat() - 0.5f }.also { v ->
+        val norm = sqrt(v.sumOf { (it * it).toDouble() }).toFloat()
+        for (i in v.indices) v[i] /= norm
+    }
+
+    private fun dot(a: FloatArray, b: FloatArray) = a.indices.sumOf { (a[it] * b[it]).toDouble() }
+
+    @Test
+    fun recallAgainstExactSearch() {
+        val vectors = List(2000) { unitVector(32) }
+        val index = VectorIndex(32)
+        vectors.forEachIndexed { i, v -> index.add(i.toLong(), v) }
+
+        var hits = 0
+        repeat(50) {
+            val query = unitVector(32)
+            val exact = vectors.indices.sortedByDescending { dot(query, vectors[it]) }.take(10).map { it.toLong() }.toSet()
+            hits += index.search(query, 10, ef = 100).count { it.id in exact }
+        }
+        assertTrue(hits >= 450, "recall@10 was ${hits / 500.0}")
+    }
+
+    @Test
+    fun removedAndReplacedVectorsAreNotReturned() {
+        val index = VectorIndex(8)
+        val vectors = List(100) { unitVector(8) }
+        vectors.forEachIndexed { i, v -> index.add(i.toLong(), v) }
+        index.remove(5)
+        index.add(6, vectors[7])
+
+        assertEquals(99, index.size)
+        assertFalse(index.search(vectors[5], 5).any { it.id == 5L })
+        assertEquals(setOf(6L, 7L), index.search(vectors[7], 2).map { it.id }.toSet())
+    }
+
+    @Test
+    fun roundTripsThroughBytes() {
+        val index = VectorIndex(16)
+        repeat(300) { index.add(it.toLong(), unitVector(16)) }
+        index.remove(3)
+        val out = ByteBuilder(1 shl 16)
+        index.writeTo(out)
+
+        val restored = VectorIndex.readFrom(ByteReader(out.toByteArray()))
+        val query = unitVector(16)
+        assertEquals(index.search(query, 10), restored.search(query, 10))
+        assertEquals(299, restored.size)
+    }
+}
@@ -0,0 +1,40 @@
+package org.kgajjar.mobileai.storage
+
+import kotlin.test.Test
+import kotlin.test.assertContentEquals
+import kotlin.test.assertTrue
+
+class DictionaryCodecTest {
+
+    private val samples = (0 until 200).map { i ->
+        "{\"role\":\"assistant\",\"text\":\"Here is a summary of document $i. The key points are listed below.\"}"
+            .encodeToByteArray()
+    }
+
+    @Test
+    fun roundTripsWithAndWithoutDictionary() {
+        val inputs = listOf(
+            ByteArray(0),
+            "a".encodeToByteArray(),
+            "abcabcabcabcabcabcabcabcabcabcabcabc".encodeToByteArray(),
+            ByteArray(5000) { (it * 7 % 251).toByte() },
+        ) + samples.take(3)
+        val codecs = listOf(DictionaryCodec(0, ByteArray(0)), DictionaryCodec(1, DictionaryTrainer.train(samples)))
+        for (codec in codecs) {
+            for (input in inputs) {
+                assertContentEquals(input, codec.decompress(codec.compress(input)))
+            }
+        }
+    }
+
+    @Test
+    fun dictionaryShrinksSmallRecords() {
+        val plain = DictionaryCodec(0, ByteArray(0))
+        val trained = DictionaryCodec(1, DictionaryTrainer.train(samples.drop(1)))
+        val record = samples.first()
+
+        val withoutDictionary = plain.compress(record).size
+        val withDictionary = trained.compress(record).size
+        assertTrue(withDictionary * 2 < withoutDictionary, "$withDictionary vs $withoutDictionary")
+    }
+}
@@ -0,0 +1,78 @@
+package org.kgajjar.mobileai.storage
+
+import kotlinx.coroutines.test.runTest
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+import kotlin.test.assertNull
+import kotlin.test.assertTrue
+
+class KeyValueStoreTest {
+
+    @Test
+    fun typedValuesSurviveCompactionAndReopen() = runTest {
+        val storage = MemoryStorage()
+        val store = KeyValueStore.open(storage, backgroundScope)
+        store.putString("name", "Ada")
+        store.putLong("launches", 3)
+        store.putDouble("scale", 1.25)
+        store.putBoolean("beta", true)
+        store.compact()
+        store.putLong("launches", 4)
+        store.remove("beta")
+        store.close()
+
+        val reopened = KeyValueStore.open(storage, backgroundScope)
+        assertEquals("Ada", reopened.getString("name"))
+        assertEquals(4L, reopened.getLong("launches"))
+        assertEquals(1.25, reopened.getDouble("scale"))
+        assertNull(reopened.getBoolean("beta"))
+        assertFalse("beta" in reopened)
+        assertNull(reopened.getString("launches"))
+    }
+
+    @Test
+    fun largeTablesAreSearchedInPlace() = runTest {
+        val storage = MemoryStorage()
+        val store = KeyValueStore.open(storage, backgroundScope)
+        repeat(500) { store.putLong("key$it", it.toLong()) }
+        store.compact()
+        store.close()
+
+        val reopened = KeyValueStore.open(storage, backgroundScope)
+        repeat(500) { assertEquals(it.toLong(), reopened.getLong("key$it")) }
+        assertNull(reopened.getLong("key500"))
+    }
+
+    @Test
+    fun compactionWritesNewTablesAndDeletesRetiredOnes() = runTest {
+        val storage = MemoryStorage()
+        val store = KeyValueStore.open(storage, backgroundScope)
+        store.putString("name", "Ada")
+        store.compact()
+        store.putString("name", "Grace")
+        store.compact()
+        assertTrue(storage.exists("settings.kv.1"))
+        store.close()
+
+        assertFalse(storage.exists("settings.kv.1"))
+        assertTrue(storage.exists("settings.kv.2"))
+        assertEquals("Grace", KeyValueStore.open(storage, backgroundScope).getString("name"))
+    }
+
+    @Test
+    fun tornLogTailIsDropped() = runTest {
+        val storage = MemoryStorage()
+        val store = KeyValueStore.open(storage, backgroundScope)
+        store.putString("kept", "yes")
+        store.close()
+        storage.open("settings.kvlog").append(byteArrayOf(30, 0, 0, 0, 1, 2))
+
+        val reopened = KeyValueStore.open(storage, backgroundScope)
+        reopened.putString("after", "recovery")
+        reopened.close()
+        val again = KeyValueStore.open(storage, backgroundScope)
+        assertEquals("yes", again.getString("kept"))
+        assertEquals("recovery", again.getString("after"))
+    }
+}
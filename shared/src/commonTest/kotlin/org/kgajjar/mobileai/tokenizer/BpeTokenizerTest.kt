@@ -0,0 +1,60 @@
+package org.kgajjar.mobileai.tokenizer
+
+import kotlinx.coroutines.test.runTest
+import org.kgajjar.mobileai.collections.IntArrayList
+import org.kgajjar.mobileai.json.Json
+import org.kgajjar.mobileai.storage.MemoryStorage
+import kotlin.test.Test
+import kotlin.test.assertContentEquals
+import kotlin.test.assertEquals
+import kotlin.test.assertNull
+
+class BpeTokenizerTest {
+    /** Byte tokens 0..255 (id = byte value), five merges and one special token. */
+    private val tokenizerJson: ByteArray = run {
+        val vocab = LinkedHashMap<String, Int>()
+        for (b in 0 until 256) vocab[ByteLevel.encode(b)] = b
+        val merged = listOf("he", "ll", "hell", "hello", "Ġt")
+        merged.forEachIndexed { i, token -> vocab[token] = 256 + i }
+        Json.obj(
+            "model" to mapOf("type" to "BPE", "vocab" to vocab, "merges" to listOf("h e", "l l", "he ll", "hell o", "Ġ t")),
+            "added_tokens" to listOf(mapOf("id" to 261, "content" to "<|end|>", "special" to true)),
+        ).toJson().encodeToByteArray()
+    }
+
+    @Test
+    fun mergesInRankOrderAndSplitsOnSpecialTokens() {
+        val tokenizer = BpeTokenizer.fromJson(tokenizerJson)
+        val text = "hello there<|end|>"
+        val ids = IntArrayList()
+        val ends = IntArrayList()
+        tokenizer.encode(text, 0, text.length, ids, ends)
+
+        assertContentEquals(intArrayOf(259, 260, 256, 'r'.code, 'e'.code, 261), ids.toIntArray())
+        assertContentEquals(intArrayOf(5, 7, 9, 10, 11, 18), ends.toIntArray())
+        assertEquals(text, tokenizer.decode(ids.toIntArray()))
+        assertEquals(259, tokenizer.idOf("hello"))
+        assertNull(tokenizer.idOf("hellox"))
+
+        val unicode = "héllo  wörld 👋\n\n'll"
+        assertEquals(unicode, tokenizer.decode(tokenizer.encode(unicode)))
+    }
+
+    @Test
+    fun compiledCacheIsReusedUntilTheFingerprintChanges() = runTest {
+        val storage = MemoryStorage()
+        var compiles = 0
+        val source: suspend () -> ByteArray = {
+            compiles++
+            tokenizerJson
+        }
+        val first = BpeTokenizer.open(storage, fingerprint = "model@1", source = source)
+        val reopened = BpeTokenizer.open(storage, fingerprint = "model@1", source = source)
+        assertEquals(1, compiles)
+        assertContentEquals(first.encode("hello there"), reopened.encode("hello there"))
+        assertEquals(262, reopened.vocabSize)
+
+        BpeTokenizer.open(storage, fingerprint = "model@2", source = source)
+        assertEquals(2, compiles)
+    }
+}
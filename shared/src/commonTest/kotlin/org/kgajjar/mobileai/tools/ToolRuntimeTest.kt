@@ -0,0 +1,76 @@
+package org.kgajjar.mobileai.tools
+
+import kotlinx.coroutines.CompletableDeferred
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.flow.flow
+import kotlinx.coroutines.test.currentTime
+import kotlinx.coroutines.test.runTest
+import org.kgajjar.mobileai.json.Json
+import org.kgajjar.mobileai.json.JsonNumber
+import org.kgajjar.mobileai.json.JsonObject
+import org.kgajjar.mobileai.json.JsonString
+import org.kgajjar.mobileai.json.JsonValue
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertTrue
+
+class ToolRuntimeTest {
+
+    private class SlowTool(override val name: String, private val millis: Long) : Tool {
+        val started = CompletableDeferred<Unit>()
+        override val description = "waits"
+        override val parameters = Json.obj("type" to "object")
+
+        override suspend fun invoke(arguments: JsonObject): JsonValue {
+            started.complete(Unit)
+            delay(millis)
+            return JsonString(name)
+        }
+    }
+
+    @Test
+    fun callsStartBeforeGenerationEndsAndRunConcurrently() = runTest {
+        val first = SlowTool("first", 1000)
+        val second = SlowTool("second", 1000)
+        val runtime = ToolRuntime(ToolRegistry(listOf(first, second, CalculatorTool())))
+        val stream = """[{"id":"a","name":"first","arguments":{}},{"id":"b","name":"second","arguments":{}},""" +
+            """{"id":"c","name":"calculator","arguments":{"expression":"2 * (3 + 4) ^ 2"}},{"id":"d","name":"missing"}]"""
+
+        var firstStartedMidStream = false
+        val results = runtime.run(
+            flow {
+                for (chunk in stream.chunked(7)) {
+                    emit(chunk)
+                    delay(10)
+                    if (first.started.isCompleted && !second.started.isCompleted) firstStartedMidStream = true
+                }
+            }
+        )
+
+        assertTrue(firstStartedMidStream)
+        // Generation takes ~300 ms of virtual time; both slow calls overlap it and each other.
+        assertTrue(currentTime < 1600, "took $currentTime ms")
+        assertEquals(listOf("a", "b", "c", "d"), results.map { it.call.id })
+        assertEquals(JsonNumber(98.0), results[2].output)
+        assertEquals("unknown tool 'missing'", results[3].error)
+    }
+
+    @Test
+    fun callsWithoutIdsAreNumberedAcrossArrays() = runTest {
+        val runtime = ToolRuntime(ToolRegistry(listOf(CalculatorTool())))
+        val stream = """[{"name":"calculator","arguments":{"expression":"1 + 1"}},{"name":"calculator","arguments":{"expression":"2 + 2"}}]""" +
+            """ [{"name":"calculator","arguments":{"expression":"3 + 3"}}] {"name":"calculator","arguments":{"expression":"4 + 4"}}"""
+
+        val results = runtime.run(flow { for (chunk in stream.chunked(5)) emit(chunk) })
+
+        assertEquals(listOf("call_0", "call_1", "call_2", "call_3"), results.map { it.call.id })
+        assertEquals(listOf(2.0, 4.0, 6.0, 8.0).map(::JsonNumber), results.map { it.output })
+    }
+
+    @Test
+    fun calculatorFollowsPrecedence() {
+        assertEquals(-4.0, CalculatorTool.evaluate("-2^2"))
+        assertEquals(7.0, CalculatorTool.evaluate("1 + 2 * 3"))
+        assertEquals(3.0, CalculatorTool.evaluate("sqrt(16) - 10 % 3"))
+    }
+}
@@ -0,0 +1,95 @@
+package org.kgajjar.mobileai.trace
+
+import org.kgajjar.mobileai.json.Json
+import org.kgajjar.mobileai.json.JsonArray
+import org.kgajjar.mobileai.json.JsonObject
+import org.kgajjar.mobileai.json.doubleOrNull
+import org.kgajjar.mobileai.json.stringOrNull
+import kotlin.test.AfterTest
+import kotlin.test.BeforeTest
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertTrue
+
+class TraceTest {
+    @BeforeTest
+    fun start() {
+        Trace.clear()
+        Trace.enabled = true
+    }
+
+    @AfterTest
+    fun stop() {
+        Trace.enabled = false
+        Trace.clear()
+    }
+
+    private fun events(): List<JsonObject> {
+        val root = Json.parse(Trace.export()) as JsonObject
+        return (root.getValue("traceEvents") as JsonArray).map { it as JsonObject }.filter { it["ph"]?.stringOrNull != "M" }
+    }
+
+    private fun JsonObject.string(key: String) = getValue(key).stringOrNull
+    private fun JsonObject.number(key: String) = getValue(key).doubleOrNull!!
+
+    @Test
+    fun nestedSpansExportAsSlicesOnOneThread() {
+        val result = Trace.span("outer", "test") {
+            Trace.span("inner \"quoted\"", "test") { 6 * 7 }
+        }
+        Trace.counter("free blocks", 12L)
+
+        assertEquals(42, result)
+        val events = events()
+        val outer = events.single { it.string("name") == "outer" }
+        val inner = events.single { it.string("name") == "inner \"quoted\"" }
+        assertEquals("X", outer.string("ph"))
+        assertEquals(outer.number("tid"), inner.number("tid"))
+        assertTrue(inner.number("ts") >= outer.number("ts"))
+        assertTrue(inner.number("ts") + inner.number("dur") <= outer.number("ts") + outer.number("dur"))
+        val counter = events.single { it.string("ph") == "C" }
+        assertEquals(12.0, (counter.getValue("args") as JsonObject).getValue("value").doubleOrNull)
+    }
+
+    @Test
+    fun disabledSpansRecordNothing() {
+        Trace.enabled = false
+        assertEquals("done", Trace.span("skipped") { "done" })
+        Trace.instant("skipped")
+        assertTrue(events().isEmpty())
+    }
+
+    @Test
+    fun clearDropsEarlierEvents() {
+        Trace.instant("before")
+        Trace.clear()
+        Trace.instant("after")
+        assertEquals(listOf("after"), events().map { it.string("name") })
+    }
+
+    @Test
+    fun clearReleasesBuffers() {
+        Trace.instant("before")
+        Trace.clear()
+        val root = Json.parse(Trace.export()) as JsonObject
+        assertTrue((root.getValue("traceEvents") as JsonArray).isEmpty())
+    }
+
+    @Test
+    fun ringKeepsTheNewestEvents() {
+        val buffer = TraceBuffer(99L, "test", capacity = 4)
+        repeat(6) { buffer.record(1, "e$it", "test", it.toLong(), 0L) }
+        assertEquals(setOf("e2", "e3", "e4", "e5"), buffer.slots.names.toSet())
+    }
+
+    @Test
+    fun bufferGrowsUpToItsCapacity() {
+        val buffer = TraceBuffer(99L, "test", capacity = 1000)
+        repeat(300) { buffer.record(1, "e$it", "test", it.toLong(), 0L) }
+        assertEquals(512, buffer.slots.size)
+        assertEquals((0 until 300).map { "e$it" }, buffer.slots.names.take(300))
+        repeat(900) { buffer.record(1, "f$it", "test", it.toLong(), 0L) }
+        assertEquals(1000, buffer.slots.size)
+        assertEquals(((200 until 300).map { "e$it" } + (0 until 900).map { "f$it" }).toSet(), buffer.slots.names.toSet())
+    }
+}
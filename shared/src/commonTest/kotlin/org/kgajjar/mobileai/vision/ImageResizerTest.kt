@@ -0,0 +1,88 @@
+package org.kgajjar.mobileai.vision
+
+import kotlinx.coroutines.test.runTest
+import org.kgajjar.mobileai.storage.MemoryStorage
+import kotlin.test.Test
+import kotlin.test.assertContentEquals
+import kotlin.test.assertEquals
+import kotlin.test.assertNotNull
+
+class ImageResizerTest {
+
+    private fun grey(vararg values: Int) = IntArray(values.size) { (0xFF shl 24) or (values[it] * 0x010101) }
+
+    @Test
+    fun areaAveragesCoveredPixels() {
+        val halved = ImageResizer.area(RgbImage(4, 1, grey(0, 0, 255, 255)), 2, 1)
+        assertContentEquals(grey(0, 255), halved.pixels)
+
+        // 3 -> 2: each output covers one and a half source pixels.
+        val fractional = ImageResizer.area(RgbImage(3, 1, grey(0, 90, 180)), 2, 1)
+        assertContentEquals(grey(30, 150), fractional.pixels)
+    }
+
+    @Test
+    fun lanczosKeepsFlatImagesFlat() {
+        val flat = RgbImage(10, 7, IntArray(70) { 0xFF4D2A80.toInt() })
+        for ((width, height) in listOf(4 to 3, 23 to 9, 1 to 1)) {
+            val resized = ImageResizer.lanczos(flat, width, height)
+            assertEquals(width * height, resized.pixels.size)
+            assertEquals(setOf(0xFF4D2A80.toInt()), resized.pixels.toSet())
+        }
+    }
+
+    @Test
+    fun fitShorterSideKeepsAspectRatio() {
+        val image = ImageResizer.fitShorterSide(RgbImage(400, 300), 150)
+        assertEquals(200, image.width)
+        assertEquals(150, image.height)
+        assertEquals(8, reductionFor(4000, 3000, 224))
+        assertEquals(2, reductionFor(4000, 3000, 1000))
+    }
+
+    private class CountingLibrary : PhotoLibrary {
+        var loads = 0
+
+        override suspend fun photos(): List<Photo> = emptyList()
+
+        override suspend fun load(photo: Photo, minSide: Int): RgbImage {
+            loads++
+            return RgbImage(640, 480, IntArray(640 * 480) { 0xFF000000.toInt() or photo.uri.length * 0x0A0B0C })
+        }
+    }
+
+    @Test
+    fun thumbnailsSurviveReopenUntilPhotoChanges() = runTest {
+        val storage = MemoryStorage()
+        val library = CountingLibrary()
+        val first = ThumbnailCache(library, side = 160, file = storage.open("thumbs"))
+        val thumbnail = assertNotNull(first.get(Photo("a.jpg", 1L)))
+        first.get(Photo("a.jpg", 1L))
+        assertEquals(213, thumbnail.width)
+        assertEquals(160, thumbnail.height)
+        assertEquals(1, library.loads)
+
+        val reopened = ThumbnailCache(library, side = 160, file = storage.open("thumbs"))
+        assertContentEquals(thumbnail.pixels, reopened.get(Photo("a.jpg", 1L))?.pixels)
+        assertEquals(1, library.loads)
+
+        reopened.get(Photo("a.jpg", 2L))
+        assertEquals(2, library.loads)
+    }
+
+    @Test
+    fun fullPackStartsOver() = runTest {
+        val storage = MemoryStorage()
+        val library = CountingLibrary()
+        // Room for one 213x160 thumbnail.
+        val cache = ThumbnailCache(library, side = 160, maxDiskBytes = 150_000, file = storage.open("thumbs"))
+        cache.get(Photo("a.jpg", 1L))
+        cache.get(Photo("bb.jpg", 1L))
+
+        val reopened = ThumbnailCache(library, side = 160, maxDiskBytes = 150_000, file = storage.open("thumbs"))
+        reopened.get(Photo("bb.jpg", 1L))
+        assertEquals(2, library.loads)
+        reopened.get(Photo("a.jpg", 1L))
+        assertEquals(3, library.loads)
+    }
+}
@@ -0,0 +1,138 @@
+package org.kgajjar.mobileai.vision
+
+import kotlinx.coroutines.test.runTest
+import org.kgajjar.mobileai.ingest.TextEncoder
+import org.kgajjar.mobileai.storage.MemoryStorage
+import kotlin.math.sqrt
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFailsWith
+import kotlin.test.assertTrue
+
+class PhotoIndexTest {
+
+    /** Embeds an image as its mean color, and the words "red", "green" and "blue" as pure colors. */
+    private class ColorEncoder(override val batchSize: Int = 2, private val failAfter: Int = Int.MAX_VALUE) : ImageEncoder {
+        var encoded = 0
+
+        override val modelId = "color-v1"
+        override val dimension = 3
+        override val inputSize = 4
+        override val mean = floatArrayOf(0f, 0f, 0f)
+        override val std = floatArrayOf(1f, 1f, 1f)
+
+        override val textEncoder = object : TextEncoder {
+            override val modelId = "color-text-v1"
+            override val dimension = 3
+
+            override suspend fun encode(texts: List<String>): List<FloatArray> =
+                texts.map { text -> FloatArray(3) { if (COLORS[it] in text) 1f else 0f } }
+        }
+
+        override suspend fun encode(pixels: FloatArray, count: Int): List<FloatArray> {
+            if (encoded + count > failAfter) throw IllegalStateException("encoder crashed")
+            encoded += count
+            val plane = inputSize * inputSize
+            return List(count) { image ->
+                val v = FloatArray(3) { ch -> (0 until plane).sumOf { pixels[(image * 3 + ch) * plane + it].toDouble() }.toFloat() }
+                val norm = sqrt(v.sumOf { (it * it).toDouble() }).toFloat()
+                FloatArray(3) { v[it] / norm }
+            }
+        }
+    }
+
+    private class FakeLibrary : PhotoLibrary {
+        val colors = LinkedHashMap<String, Int>()
+        val modified = HashMap<String, Long>()
+
+        fun put(uri: String, color: Int, modifiedAt: Long = 1L) {
+            colors[uri] = color
+            modified[uri] = modifiedAt
+        }
+
+        override suspend fun photos(): List<Photo> = colors.keys.map { Photo(it, modified.getValue(it)) }
+
+        override suspend fun load(photo: Photo, minSide: Int): RgbImage? {
+            if (photo.uri.endsWith(".broken")) return null
+            val color = colors.getValue(photo.uri)
+            return RgbImage(12, 8, IntArray(12 * 8) { color })
+        }
+    }
+
+    private fun library() = FakeLibrary().apply {
+        put("dcim/red.jpg", 0xFFE01010.toInt())
+        put("dcim/green.jpg", 0xFF10D020.toInt())
+        put("dcim/blue.jpg", 0xFF1020F0.toInt())
+        put("dcim/scan.broken", 0)
+        put("dcim/crimson.jpg", 0xFFB00020.toInt())
+    }
+
+    @Test
+    fun preprocessorCropsCenterSquareIntoPlanarChannels() {
+        // 4x2: the centered 2x2 crop is columns 1 and 2, red then blue.
+        val red = 0xFFFF0000.toInt()
+        val blue = 0xFF0000FF.toInt()
+        val image = RgbImage(4, 2, intArrayOf(0, red, blue, 0, 0, red, blue, 0))
+        val out = FloatArray(12)
+        ImagePreprocessor(2, floatArrayOf(0.5f, 0.5f, 0.5f), floatArrayOf(0.5f, 0.5f, 0.5f)).process(image, out)
+
+        val expected = floatArrayOf(
+            1f, -1f, 1f, -1f, // R
+            -1f, -1f, -1f, -1f, // G
+            -1f, 1f, -1f, 1f, // B
+        )
+        for (i in expected.indices) assertEquals(expected[i], out[i], 1e-5f, "sample $i")
+    }
+
+    @Test
+    fun textQueryFindsMatchingPhotos() = runTest {
+        val index = PhotoIndex.open(MemoryStorage(), ColorEncoder())
+        index.sync(library())
+
+        assertEquals(4, index.count())
+        val hits = index.search("photos of something red", minScore = 0.5f)
+        assertEquals(listOf("dcim/red.jpg", "dcim/crimson.jpg"), hits.map { it.uri })
+        assertEquals("dcim/blue.jpg", index.search("blue", limit = 1).single().uri)
+    }
+
+    @Test
+    fun reopenedIndexOnlyEmbedsChanges() = runTest {
+        val storage = MemoryStorage()
+        val library = library()
+        PhotoIndex.open(storage, ColorEncoder()).apply {
+            sync(library)
+            close()
+        }
+
+        val encoder = ColorEncoder()
+        val index = PhotoIndex.open(storage, encoder)
+        index.sync(library)
+        assertEquals(0, encoder.encoded)
+
+        library.put("dcim/green.jpg", 0xFFE02020.toInt(), modifiedAt = 2L)
+        library.colors.remove("dcim/crimson.jpg")
+        index.sync(library)
+        assertEquals(1, encoder.encoded)
+        assertEquals(listOf("dcim/green.jpg", "dcim/red.jpg"), index.search("red", minScore = 0.5f).map { it.uri }.sorted())
+    }
+
+    @Test
+    fun interruptedSyncResumesFromLog() = runTest {
+        val storage = MemoryStorage()
+        val library = library()
+        val crashing = PhotoIndex.open(storage, ColorEncoder(batchSize = 1, failAfter = 2))
+        assertFailsWith<IllegalStateException> { crashing.sync(library) }
+
+        val encoder = ColorEncoder(batchSize = 1)
+        val index = PhotoIndex.open(storage, encoder)
+        assertEquals(2, index.count())
+        index.sync(library)
+        assertEquals(2, encoder.encoded) // the broken photo needs no encoding
+        assertEquals(4, index.count())
+        assertTrue(index.search("green").any { it.uri == "dcim/green.jpg" })
+    }
+
+    private companion object {
+        val COLORS = listOf("red", "green", "blue")
+    }
+}
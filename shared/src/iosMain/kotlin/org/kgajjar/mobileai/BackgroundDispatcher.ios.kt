@@ -0,0 +1,21 @@
+package org.kgajjar.mobileai
+
+import kotlinx.coroutines.CoroutineDispatcher
+import kotlinx.coroutines.Runnable
+import platform.darwin.QOS_CLASS_BACKGROUND
+import platform.darwin.dispatch_async
+import platform.darwin.dispatch_queue_attr_make_with_qos_class
+import platform.darwin.dispatch_queue_create
+import platform.darwin.dispatch_queue_t
+import kotlin.coroutines.CoroutineContext
+
+// A serial queue (null base attributes) at background QoS, which iOS runs only when nothing more
+// urgent does.
+internal actual fun backgroundDispatcher(name: String): CoroutineDispatcher =
+    QueueDispatcher(dispatch_queue_create(name, dispatch_queue_attr_make_with_qos_class(null, QOS_CLASS_BACKGROUND, 0)))
+
+private class QueueDispatcher(private val queue: dispatch_queue_t) : CoroutineDispatcher() {
+    override fun dispatch(context: CoroutineContext, block: Runnable) {
+        dispatch_async(queue) { block.run() }
+    }
+}
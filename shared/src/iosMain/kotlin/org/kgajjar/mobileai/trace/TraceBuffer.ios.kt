@@ -0,0 +1,16 @@
+package org.kgajjar.mobileai.trace
+
+import platform.Foundation.NSThread
+import kotlin.native.concurrent.ThreadLocal
+
+@ThreadLocal
+private var buffer: TraceBuffer? = null
+
+internal actual fun threadTraceBuffer(): TraceBuffer {
+    buffer?.let { if (Trace.isCurrent(it)) return it }
+    val thread = NSThread.currentThread
+    return Trace.newBuffer(threadName()) { !thread.finished }.also { buffer = it }
+}
+
+private fun threadName(): String? =
+    if (NSThread.isMainThread) "main" else NSThread.currentThread.name?.takeIf { it.isNotEmpty() }
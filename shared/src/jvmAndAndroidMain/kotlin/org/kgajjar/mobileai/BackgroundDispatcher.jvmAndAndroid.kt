@@ -0,0 +1,14 @@
+package org.kgajjar.mobileai
+
+import kotlinx.coroutines.CoroutineDispatcher
+import kotlinx.coroutines.asCoroutineDispatcher
+import java.util.concurrent.Executors
+
+// Android maps the lowest Java priority to its background nice level; desktop JVMs may ignore it.
+internal actual fun backgroundDispatcher(name: String): CoroutineDispatcher =
+    Executors.newSingleThreadExecutor { task ->
+        Thread(task, name).apply {
+            isDaemon = true
+            priority = Thread.MIN_PRIORITY
+        }
+    }.asCoroutineDispatcher()
@@ -0,0 +1,28 @@
+package org.kgajjar.mobileai.storage
+
+import java.io.File
+import java.io.IOException
+
+/** [Storage] over one directory; files are read through memory maps. */
+class FileStorage(private val directory: File) : Storage {
+    constructor(path: String) : this(File(path))
+
+    init {
+        directory.mkdirs()
+    }
+
+    override fun open(name: String): ByteFile = MappedByteFile(File(directory, name))
+
+    override fun exists(name: String): Boolean = File(directory, name).exists()
+
+    override fun delete(name: String) {
+        File(directory, name).delete()
+    }
+
+    override fun rename(from: String, to: String) {
+        // rename(2) replaces the target atomically on the POSIX file systems we ship on.
+        if (!File(directory, from).renameTo(File(directory, to))) {
+            throw IOException("failed to rename $from to $to in $directory")
+        }
+    }
+}
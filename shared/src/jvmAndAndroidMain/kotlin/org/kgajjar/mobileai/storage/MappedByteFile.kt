@@ -0,0 +1,108 @@
+package org.kgajjar.mobileai.storage
+
+import java.io.File
+import java.io.RandomAccessFile
+import java.nio.Buffer
+import java.nio.ByteBuffer
+import java.nio.MappedByteBuffer
+import java.nio.channels.FileChannel
+
+/**
+ * [ByteFile] that serves reads from a read-only memory map of the flushed prefix and buffers
+ * appends in a small heap buffer, so appending a few bytes is a copy rather than a syscall.
+ */
+class MappedByteFile(file: File, bufferSize: Int = 64 * 1024) : ByteFile {
+    private val raf = RandomAccessFile(file, "rw")
+    private val channel: FileChannel = raf.channel
+    private var flushedSize = channel.size()
+
+    private val pending = ByteArray(bufferSize)
+    private var pendingSize = 0
+
+    private var mapped: MappedByteBuffer? = null
+    private var mappedSize = 0L
+
+    override val size: Long get() = flushedSize + pendingSize
+
+    override fun read(position: Long, dst: ByteArray, offset: Int, length: Int) {
+        require(position >= 0 && position + length <= size) {
+            "read [$position, ${position + length}) past end $size"
+        }
+        if (position >= flushedSize) {
+            val start = (position - flushedSize).toInt()
+            pending.copyInto(dst, offset, start, start + length)
+            return
+        }
+        if (position + length > flushedSize) flush()
+        if (position + length > Int.MAX_VALUE) {
+            readFromChannel(position, dst, offset, length)
+            return
+        }
+        val view = mapping(position + length).duplicate()
+        (view as Buffer).position(position.toInt())
+        view.get(dst, offset, length)
+    }
+
+    override fun append(src: ByteArray, offset: Int, length: Int): Long {
+        val position = size
+        if (length > pending.size - pendingSize) flush()
+        if (length > pending.size) {
+            write(ByteBuffer.wrap(src, offset, length))
+        } else {
+            src.copyInto(pending, pendingSize, offset, offset + length)
+            pendingSize += length
+        }
+        return position
+    }
+
+    override fun flush() {
+        if (pendingSize == 0) return
+        write(ByteBuffer.wrap(pending, 0, pendingSize))
+        pendingSize = 0
+    }
+
+    override fun sync() {
+        flush()
+        channel.force(false)
+    }
+
+    override fun truncate(size: Long) {
+        require(size in 0..this.size) { "cannot truncate ${this.size} bytes to $size" }
+        flush()
+        mapped = null
+        mappedSize = 0
+        channel.truncate(size)
+        flushedSize = size
+    }
+
+    override fun close() {
+        flush()
+        mapped = null
+        channel.close()
+        raf.close()
+    }
+
+    private fun write(buffer: ByteBuffer) {
+        while (buffer.hasRemaining()) {
+            flushedSize += channel.write(buffer, flushedSize)
+        }
+    }
+
+    private fun mapping(end: Long): MappedByteBuffer {
+        val current = mapped
+        if (current != null && end <= mappedSize) return current
+        // Map everything flushed so far; reads of older data never have to remap again.
+        mappedSize = minOf(flushedSize, Int.MAX_VALUE.toLong())
+        return channel.map(FileChannel.MapMode.READ_ONLY, 0, mappedSize).also { mapped = it }
+    }
+
+    private fun readFromChannel(position: Long, dst: ByteArray, offset: Int, length: Int) {
+        val buffer = ByteBuffer.wrap(dst, offset, length)
+        var at = position
+        while (buffer.hasRemaining()) {
+            val n = channel.read(buffer, at)
+            check(n >= 0) { "unexpected end of file at $at" }
+            at += n
+        }
+    }
+}
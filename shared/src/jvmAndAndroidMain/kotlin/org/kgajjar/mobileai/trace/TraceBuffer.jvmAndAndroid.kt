@@ -0,0 +1,11 @@
+package org.kgajjar.mobileai.trace
+
+import java.lang.ref.WeakReference
+
+private val buffer = ThreadLocal<TraceBuffer?>()
+
+internal actual fun threadTraceBuffer(): TraceBuffer {
+    buffer.get()?.let { if (Trace.isCurrent(it)) return it }
+    val thread = WeakReference(Thread.currentThread())
+    return Trace.newBuffer(Thread.currentThread().name) { thread.get()?.isAlive == true }.also { buffer.set(it) }
+}
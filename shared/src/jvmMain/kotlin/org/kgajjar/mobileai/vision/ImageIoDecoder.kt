@@ -0,0 +1,32 @@
+package org.kgajjar.mobileai.vision
+
+import java.io.ByteArrayInputStream
+import java.io.IOException
+import javax.imageio.ImageIO
+
+/**
+ * [ImageDecoder] over ImageIO. Its JPEG reader can't scale in the DCT domain, so reductions are
+ * source subsampling: skipped rows and columns are never color-converted or stored.
+ */
+class ImageIoDecoder : ImageDecoder {
+    override fun decode(bytes: ByteArray, minSide: Int): RgbImage? {
+        val input = ImageIO.createImageInputStream(ByteArrayInputStream(bytes)) ?: return null
+        input.use {
+            val readers = ImageIO.getImageReaders(input)
+            if (!readers.hasNext()) return null
+            val reader = readers.next()
+            return try {
+                reader.input = input
+                val factor = reductionFor(reader.getWidth(0), reader.getHeight(0), minSide)
+                val param = reader.defaultReadParam
+                param.setSourceSubsampling(factor, factor, 0, 0)
+                val image = reader.read(0, param)
+                RgbImage(image.width, image.height, image.getRGB(0, 0, image.width, image.height, null, 0, image.width))
+            } catch (e: IOException) {
+                null
+            } finally {
+                reader.dispose()
+            }
+        }
+    }
+}
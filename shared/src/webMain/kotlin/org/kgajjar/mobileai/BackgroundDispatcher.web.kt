@@ -0,0 +1,7 @@
+package org.kgajjar.mobileai
+
+import kotlinx.coroutines.CoroutineDispatcher
+import kotlinx.coroutines.Dispatchers
+
+// The browser runs all of our code on one thread; background work relies on yielding instead.
+internal actual fun backgroundDispatcher(name: String): CoroutineDispatcher = Dispatchers.Default
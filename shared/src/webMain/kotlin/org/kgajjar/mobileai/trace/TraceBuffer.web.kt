@@ -0,0 +1,9 @@
+package org.kgajjar.mobileai.trace
+
+// The browser runs all of our code on one thread.
+private var buffer: TraceBuffer? = null
+
+internal actual fun threadTraceBuffer(): TraceBuffer {
+    buffer?.let { if (Trace.isCurrent(it)) return it }
+    return Trace.newBuffer("main").also { buffer = it }
+}